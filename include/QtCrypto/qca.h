@@ -41,6 +41,8 @@
 #include "qca_keystore.h"
 #include "qca_securelayer.h"
 #include "qca_securemessage.h"
+#include "qca_async.h"
+#include "qca_device.h"
 #include "qcaprovider.h"
 #include "qpipe.h"
 #include "qca_safetimer.h"
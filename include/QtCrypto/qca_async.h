@@ -0,0 +1,207 @@
+/*
+ * qca_async.h - Qt Cryptographic Architecture
+ * Copyright (C) 2026  Forkworks
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301  USA
+ *
+ */
+
+/**
+   \file qca_async.h
+
+   Header file for the asynchronous versions of the expensive operations
+
+   Each function here starts an operation on the shared ThreadPool and
+   returns at once with a QFuture for the result.  Use a QFutureWatcher
+   to be notified through a signal when the result is ready, or call
+   QFuture::result() to block until it is.
+
+   \code
+QFutureWatcher<QByteArray> *watcher = new QFutureWatcher<QByteArray>(this);
+connect(watcher, SIGNAL(finished()), SLOT(signed()));
+watcher->setFuture(QCA::signMessageAsync(key, message, QCA::EMSA3_SHA256));
+   \endcode
+
+   The arguments are copied before the function returns, so they may be
+   changed or destroyed while the operation runs.  Calling
+   QFuture::cancel() before the operation has started prevents it from
+   running.
+
+   \note Avoid blocking on one of these futures from within a pool
+   thread, since the operation may be queued behind the blocked thread.
+
+   \note You should not use this header directly from an
+   application. You should just use <tt> \#include \<QtCrypto>
+   </tt> instead.
+*/
+
+#ifndef QCA_ASYNC_H
+#define QCA_ASYNC_H
+
+#include <QFuture>
+#include "qca_basic.h"
+#include "qca_publickey.h"
+#include "qca_cert.h"
+
+namespace QCA {
+
+/**
+   Sign a message without blocking
+
+   \sa PrivateKey::signMessage
+
+   \param key the private key to sign with
+   \param a the message to sign
+   \param alg the signature algorithm to use
+   \param format the signature format to use, for DSA
+
+   \ingroup UserAPI
+*/
+QCA_EXPORT QFuture<QByteArray> signMessageAsync(const PrivateKey &key, const MemoryRegion &a, SignatureAlgorithm alg, SignatureFormat format = DefaultFormat);
+
+/**
+   Verify a message signature without blocking
+
+   \sa PublicKey::verifyMessage
+
+   \param key the public key to verify with
+   \param a the message to check the signature on
+   \param sig the signature to be checked
+   \param alg the signature algorithm to use
+   \param format the signature format to use, for DSA
+
+   \ingroup UserAPI
+*/
+QCA_EXPORT QFuture<bool> verifyMessageAsync(const PublicKey &key, const MemoryRegion &a, const QByteArray &sig, SignatureAlgorithm alg, SignatureFormat format = DefaultFormat);
+
+/**
+   Generate an RSA key without blocking
+
+   The result is a null key if generation failed.
+
+   \sa KeyGenerator::createRSA
+
+   \param bits the length of the key in bits
+   \param exp the public exponent
+   \param provider the provider to use, if a particular provider is
+   required
+
+   \ingroup UserAPI
+*/
+QCA_EXPORT QFuture<PrivateKey> createRSAAsync(int bits, int exp = 65537, const QString &provider = QString());
+
+/**
+   Generate a DSA key without blocking
+
+   The result is a null key if generation failed.
+
+   \sa KeyGenerator::createDSA
+
+   \param domain the discrete logarithm group to use
+   \param provider the provider to use, if a particular provider is
+   required
+
+   \ingroup UserAPI
+*/
+QCA_EXPORT QFuture<PrivateKey> createDSAAsync(const DLGroup &domain, const QString &provider = QString());
+
+/**
+   Generate a Diffie-Hellman key without blocking
+
+   The result is a null key if generation failed.
+
+   \sa KeyGenerator::createDH
+
+   \param domain the discrete logarithm group to use
+   \param provider the provider to use, if a particular provider is
+   required
+
+   \ingroup UserAPI
+*/
+QCA_EXPORT QFuture<PrivateKey> createDHAsync(const DLGroup &domain, const QString &provider = QString());
+
+/**
+   Generate a discrete logarithm group without blocking
+
+   The result is a null group if generation failed.
+
+   \sa KeyGenerator::createDLGroup
+
+   \param set the set of discrete logarithm parameters to generate from
+   \param provider the provider to use, if a particular provider is
+   required
+
+   \ingroup UserAPI
+*/
+QCA_EXPORT QFuture<DLGroup> createDLGroupAsync(DLGroupSet set, const QString &provider = QString());
+
+/**
+   Validate a certificate without blocking
+
+   \sa Certificate::validate
+
+   \param cert the certificate to validate
+   \param trusted the set of trusted certificates that may be used
+   \param untrusted the set of untrusted certificates that may be used
+   \param u the usage mode to validate against
+   \param vf the conditions to validate
+
+   \ingroup UserAPI
+*/
+QCA_EXPORT QFuture<Validity> validateAsync(const Certificate &cert, const CertificateCollection &trusted, const CertificateCollection &untrusted, UsageMode u = UsageAny, ValidateFlags vf = ValidateAll);
+
+/**
+   Derive a key without blocking
+
+   Any key derivation function may be used, for example PBKDF2.
+
+   \code
+QFuture<QCA::SymmetricKey> f = QCA::makeKeyAsync(QCA::PBKDF2("sha256"), password, salt, 32, 100000);
+   \endcode
+
+   \sa KeyDerivationFunction::makeKey
+
+   \param kdf the key derivation function to use
+   \param secret the secret (password) to derive the key from
+   \param salt the salt to use
+   \param keyLength the length of the key to derive, in bytes
+   \param iterationCount the number of iterations of the derivation
+   function to use
+
+   \ingroup UserAPI
+*/
+QCA_EXPORT QFuture<SymmetricKey> makeKeyAsync(const KeyDerivationFunction &kdf, const SecureArray &secret, const InitializationVector &salt, unsigned int keyLength, unsigned int iterationCount);
+
+/**
+   Import a key bundle (PKCS#12) without blocking
+
+   The result is a null bundle if the import failed.  Use
+   KeyBundle::fromArray() if the reason for the failure is needed.
+
+   \sa KeyBundle::fromArray
+
+   \param a the array to import from
+   \param passphrase the passphrase for the encoded bundle
+   \param provider the provider to use, if a particular provider is
+   required
+
+   \ingroup UserAPI
+*/
+QCA_EXPORT QFuture<KeyBundle> keyBundleFromArrayAsync(const QByteArray &a, const SecureArray &passphrase = SecureArray(), const QString &provider = QString());
+
+}
+
+#endif
@@ -312,9 +312,12 @@ public:
 
 	   \param file an I/O device
 
+	   The device is read from its current position to the end.
+	   A QFile is memory mapped where possible, rather than read.
+
 	   If you are trying to calculate the hash of
 	   a whole file (and it isn't already open), you
-	   might want to use code like this:
+	   might want to use hashFile(), or code like this:
 	   \code
 QFile f( "file.dat" );
 if ( f.open( QIODevice::ReadOnly ) )
@@ -342,6 +345,28 @@ if ( f.open( QIODevice::ReadOnly ) )
 	*/
 	virtual MemoryRegion final();
 
+	/**
+	   Finalises input and returns a hash result of the given
+	   length
+
+	   This is only for extendable-output functions, such as
+	   "shake128", "shake256" and "blake3", which can produce
+	   as much output as is asked for.  A shorter output is a
+	   prefix of a longer one.
+
+	   \code
+QCA::Hash shake("shake256");
+shake.update(data);
+QByteArray key = shake.final(64).toByteArray();
+	   \endcode
+
+	   \param outLen the number of bytes to return
+
+	   \return the hash, or an empty array if the hash type
+	   is not an extendable-output function
+	*/
+	MemoryRegion final(int outLen);
+
 	/**
 	   %Hash a byte array, returning it as another
 	   byte array
@@ -380,6 +405,88 @@ SecureArray outputArray = QCA::Hash("md2")::hash(sampleArray);
 	*/
 	QString hashToString(const MemoryRegion &array);
 
+	/**
+	   %Hash the contents of a file
+
+	   This is a convenience method that clears the hash, feeds it
+	   the whole file and returns the result.  The file is memory
+	   mapped where possible, and read in large blocks otherwise.
+
+	   \param fileName the name of the file to hash
+
+	   \return the hash, or an empty region if the file could not
+	   be opened
+	*/
+	MemoryRegion hashFile(const QString &fileName);
+
+	/**
+	   Compute several hashes of a file in a single pass
+
+	   Each hash is cleared and then fed the whole file, which is
+	   only read once.  Call final() on each of them afterwards.
+
+	   \code
+QCA::Hash md5("md5"), sha256("sha256");
+if(QCA::Hash::hashFile("image.iso", QList<QCA::Hash*>() << &md5 << &sha256))
+{
+	QString md5sum = QCA::arrayToHex(md5.final().toByteArray());
+	QString sha256sum = QCA::arrayToHex(sha256.final().toByteArray());
+}
+	   \endcode
+
+	   \param fileName the name of the file to hash
+	   \param hashes the hashes to compute
+
+	   \return false if the file could not be opened
+	*/
+	static bool hashFile(const QString &fileName, const QList<Hash*> &hashes);
+
+	/**
+	   Save the state of the hash computation
+
+	   The state is a small blob, from which restoreState() can
+	   continue the computation later, even in another process.  Use
+	   it to hash many messages with a common prefix without hashing
+	   the prefix each time, or to resume hashing a large file:
+
+	   \code
+QCA::Hash sha256("sha256");
+QFile file("image.iso");
+file.open(QIODevice::ReadOnly);
+// ... update() with part of the file ...
+QByteArray checkpoint = sha256.saveState();
+qint64 offset = file.pos();
+
+// later, after a restart
+sha256.restoreState(checkpoint);
+file.seek(offset);
+sha256.update(&file);
+	   \endcode
+
+	   \note The state reveals as much about the data hashed so far
+	   as the data itself would, once it is combined with a guess of
+	   the rest.  Keep it as secret as the data.
+
+	   \return the state, or an empty array if the provider cannot
+	   save it
+	*/
+	QByteArray saveState() const;
+
+	/**
+	   Continue a hash computation from a saved state
+
+	   The state has to come from saveState() on a hash of the same
+	   type and provider.  Data given to update() afterwards is
+	   hashed as if it followed the data hashed before the state was
+	   saved.
+
+	   \param state the state returned by saveState()
+
+	   \return false if the state could not be restored, in which
+	   case the hash is unchanged
+	*/
+	bool restoreState(const QByteArray &state);
+
 private:
 	class Private;
 	Private *d;
@@ -511,6 +618,25 @@ private:
    http://paginas.terra.com.br/informatica/paulobarreto/WhirlpoolPage.html
    or ISO/IEC 10118-3:2004. The label for Whirlpool is
    "whirlpool".
+
+   SHA-3 is the Keccak sponge of Federal Information Processing
+   Standard Publication 202, "SHA-3 Standard: Permutation-Based Hash
+   and Extendable-Output Functions", available from
+   http://csrc.nist.gov/publications/. The labels for the 224, 256,
+   384 and 512 bit versions are "sha3-224", "sha3-256", "sha3-384"
+   and "sha3-512". The extendable-output functions of the same
+   standard are "shake128" and "shake256". Their final() returns
+   128 and 256 bits respectively, and Hash::final(int) gives any
+   other length.
+
+   BLAKE2b and BLAKE2s output 512 bit (64 byte) and 256 bit (32 byte)
+   message digests respectively, and are described in RFC 7693. Their
+   labels are "blake2b" and "blake2s". BLAKE2bp is a tree of four
+   BLAKE2b instances whose 512 bit digest differs from that of BLAKE2b,
+   and BLAKE3 is a tree hash with a 256 bit digest. Since the branches of
+   a tree can be hashed independently, large updates to these two are
+   spread over several threads. Their labels are "blake2bp" and
+   "blake3". BLAKE3 is also an extendable-output function.
 */
 
 /**
@@ -582,6 +708,14 @@ private:
    the cipher name followed by "-cbc" (e.g. "blowfish-cbc"
    or "aes256-cbc"). 
 
+   Stream ciphers have no mode, so they are just the cipher
+   name (e.g. "chacha20", with the Stream mode). The AEAD
+   versions of ChaCha20 are "chacha20-poly1305" and
+   "xchacha20-poly1305", with the Poly1305 mode. They take
+   a 12 and a 24 byte nonce respectively as the
+   InitializationVector, and their 16 byte AuthTag is handled
+   the same way as for GCM.
+
    \ingroup UserAPI
 */
 
@@ -603,7 +737,9 @@ public:
 		OFB, ///< operate in Output FeedBack Mode
 		CTR, ///< operate in CounTer Mode
 		GCM, ///< operate in Galois Counter Mode
-		CCM  ///< operate in Counter with CBC-MAC
+		CCM, ///< operate in Counter with CBC-MAC
+		Stream,  ///< a stream cipher, which has no mode (e.g. "chacha20")
+		Poly1305 ///< a stream cipher authenticated with Poly1305, as in RFC 8439 (e.g. "chacha20-poly1305")
 	};
 
 	/**
@@ -651,7 +787,7 @@ public:
 	   encryption, Decode for decryption)
 	   \param key the SymmetricKey array that is the key
 	   \param iv the InitializationVector to use (not used for ECB mode)
-	   \param tag the AuthTag to use (only for GCM and CCM modes)
+	   \param tag the AuthTag to use (only for GCM, CCM and Poly1305 modes)
 	   \param provider the name of the Provider to use
 
 	   \note Padding only applies to CBC and ECB modes.  CFB and OFB
@@ -665,6 +801,14 @@ public:
 	/**
 	   Standard copy constructor
 
+	   The copy carries on from the same point of the message.  Some
+	   providers can't copy their state once data has been processed,
+	   and would have to start the message again with the same IV,
+	   which in the stream modes reuses the keystream.  A copy from
+	   such a provider fails instead (update() and final() return
+	   nothing and ok() is false) until it is given a new IV with
+	   setIV(), or set up again.
+
 	   \param from the Cipher to copy state from
 	*/
 	Cipher(const Cipher &from);
@@ -674,6 +818,8 @@ public:
 	/**
 	   Assignment operator
 
+	   The same as the copy constructor for the state of a message.
+
 	   \param from the Cipher to copy state from
 	*/
 	Cipher & operator=(const Cipher &from);
@@ -782,12 +928,77 @@ public:
 	   encryption, Decode for decryption)
 	   \param key the SymmetricKey array that is the key
 	   \param iv the InitializationVector to use (not used for ECB Mode)
-	   \param tag the AuthTag to use (only for GCM and CCM modes)
+	   \param tag the AuthTag to use (only for GCM, CCM and Poly1305 modes)
 
 	   \note You should not leave iv empty for any Mode except ECB.
 	*/
 	void setup(Direction dir, const SymmetricKey &key, const InitializationVector &iv, const AuthTag &tag);
 
+	/**
+	   Start a new message with a different InitializationVector
+
+	   This keeps the Direction and SymmetricKey of the last setup(),
+	   and is cheaper than calling setup() again, because the provider
+	   does not have to prepare the key again. It suits protocols that
+	   encrypt each packet under the same key with its own IV.
+
+	   In GCM and CCM modes the AuthTag keeps the size it had, so an
+	   encrypting Cipher goes on making tags of that length. To decrypt
+	   in these modes, use the version that takes the AuthTag of the
+	   next message.
+
+	   \param iv the InitializationVector to use for the next message
+
+	   \note The Cipher must have been set up with a key.
+	*/
+	void setIV(const InitializationVector &iv);
+
+	/**
+	   Start a new message with a different InitializationVector
+
+	   This keeps the Direction and SymmetricKey of the last setup(),
+	   and is cheaper than calling setup() again, because the provider
+	   does not have to prepare the key again.
+
+	   \param iv the InitializationVector to use for the next message
+	   \param tag the AuthTag to use (only for GCM, CCM and Poly1305 modes)
+
+	   \note The Cipher must have been set up with a key.
+	*/
+	void setIV(const InitializationVector &iv, const AuthTag &tag);
+
+	/**
+	   Spread large updates over several threads
+
+	   In CTR and GCM modes every block of the key stream depends only
+	   on the key and the counter, so a large update can be split into
+	   segments that are encrypted at the same time, each starting at
+	   its own counter. For GCM the authentication of each segment is
+	   computed separately and then combined. The output and the tag are
+	   the same as without this setting. It is ignored for other modes,
+	   and for providers that do not have the cipher in CTR mode (and,
+	   for GCM, in ECB mode).
+
+	   For GCM the authentication is then computed by QCA rather than by
+	   the provider, for every update. On processors without a
+	   carry-less multiply instruction (PCLMULQDQ on x86) this is done
+	   bit by bit, to keep its timing independent of the key, and can
+	   be slower than the provider's own GCM.
+
+	   This is off by default, and takes effect at the next setup() or
+	   clear().
+
+	   \param enable true to use several threads, false to use one
+	*/
+	void setParallel(bool enable);
+
+	/**
+	   Test if large updates are spread over several threads
+
+	   \sa setParallel()
+	*/
+	bool isParallel() const;
+
 	/**
 	   Construct a Cipher type string
 
@@ -926,10 +1137,31 @@ public:
 	/**
 	   Initialise the MAC algorithm
 
+	   The key is set up once, and clear() reuses it afterwards, so
+	   only call this when the key changes.
+
 	   \param key the key to use for the algorithm
 	*/
 	void setup(const SymmetricKey &key);
 
+	/**
+	   Compute the MAC of a whole message in one call
+
+	   This is clear(), update() and final() in one.  Keep a
+	   %MessageAuthenticationCode for each key and use this for each
+	   message: the key schedule from setup() is reused, so small
+	   messages cost little more than hashing them.
+
+	   \code
+QCA::MessageAuthenticationCode hmac("hmac(sha256)", key);
+foreach(const QByteArray &request, requests)
+	check(request, hmac.mac(request));
+	   \endcode
+
+	   \param message the whole message
+	*/
+	MemoryRegion mac(const MemoryRegion &message);
+
 private:
 	class Private;
 	Private *d;
@@ -1004,6 +1236,41 @@ public:
 						 int msecInterval,
 						 unsigned int *iterationCount);
 
+	/**
+	   Generate keys for many secret and salt pairs at once
+
+	   The keys are derived in parallel on the shared ThreadPool, which
+	   is much faster than one makeKey() after the other when there are
+	   many of them, for example when checking a list of stored
+	   password hashes.
+
+	   \param secrets the secrets (passwords or passphrases)
+	   \param salts the salts to use, one for each secret
+	   \param keyLength the length of the keys to return
+	   \param iterationCount the number of iterations to perform
+
+	   \return the derived keys, in the order of the secrets.  This
+	   is empty if the lists are not of the same length.
+	*/
+	QList<SymmetricKey> makeKeys(const QList<SecureArray> &secrets, const QList<InitializationVector> &salts, unsigned int keyLength, unsigned int iterationCount);
+
+	/**
+	   Check many secrets against the keys derived from them earlier
+
+	   This derives a key for each secret and salt pair, of the same
+	   length as the expected key, in parallel on the shared
+	   ThreadPool.  The keys are compared in constant time.
+
+	   \param secrets the secrets (passwords or passphrases)
+	   \param salts the salts to use, one for each secret
+	   \param keys the expected keys, one for each secret
+	   \param iterationCount the number of iterations to perform
+
+	   \return whether each secret matches its key.  This is empty if
+	   the lists are not of the same length.
+	*/
+	QList<bool> verifyKeys(const QList<SecureArray> &secrets, const QList<InitializationVector> &salts, const QList<SymmetricKey> &keys, unsigned int iterationCount);
+
 	/**
 	   Construct the name of the algorithm
 
@@ -1078,6 +1345,225 @@ public:
 		: KeyDerivationFunction(withAlgorithm(QStringLiteral("pbkdf2"), algorithm), provider) {}
 };
 
+/**
+   \class SCRYPT qca_basic.h QtCrypto
+
+   The scrypt password based key derivation function
+
+   This class implements scrypt, as specified in RFC7914.  Unlike
+   PBKDF2, it needs a large amount of memory for each key, which makes
+   guessing passwords with dedicated hardware expensive.
+
+   The costs are set with setParameters().  The memory needed is
+   128 * cost * blockSize * parallelism bytes.  The parallel lanes are
+   computed on the shared ThreadPool, so parallelism speeds up the
+   derivation as well as making it more expensive.  The defaults are a
+   cost of 16384, a block size of 8 and a parallelism of 1, which take
+   16 MiB.
+
+   The work memory is kept from one key to the next, and wiped after
+   each.  Copies of a SCRYPT object do not share it.
+
+   \ingroup UserAPI
+*/
+class QCA_EXPORT SCRYPT : public KeyDerivationFunction
+{
+public:
+	/**
+	   Standard constructor
+
+	   \param provider the name of the provider to use, if available
+	*/
+	explicit SCRYPT(const QString &provider = QString());
+
+	/**
+	   Set the costs of the derivation
+
+	   \param cost the CPU and memory cost N, a power of two greater
+	   than 1
+	   \param blockSize the block size r
+	   \param parallelism the parallelization parameter p
+	*/
+	void setParameters(unsigned int cost, unsigned int blockSize, unsigned int parallelism);
+
+	/**
+	   Generate a key from a secret and a salt
+
+	   \param secret the secret (password or passphrase)
+	   \param salt the salt to use
+	   \param keyLength the length of key to return
+
+	   \return the derived key, or an empty key if the parameters are
+	   not valid or the memory cannot be allocated
+	*/
+	SymmetricKey makeKey(const SecureArray &secret, const InitializationVector &salt, unsigned int keyLength);
+
+	using KeyDerivationFunction::makeKey;
+};
+
+/**
+   \class Argon2id qca_basic.h QtCrypto
+
+   The Argon2id password based key derivation function
+
+   This class implements Argon2id, as specified in RFC9106, without a
+   secret key or associated data.  Like SCRYPT, it needs a large amount
+   of memory for each key.
+
+   The costs are set with setParameters().  The lanes are filled in
+   parallel on the shared ThreadPool.  The defaults are the second
+   recommendation of RFC9106: 64 MiB of memory, 3 passes and 4 lanes.
+
+   The work memory is kept from one key to the next, and wiped after
+   each.  Copies of an Argon2id object do not share it.
+
+   \ingroup UserAPI
+*/
+class QCA_EXPORT Argon2id : public KeyDerivationFunction
+{
+public:
+	/**
+	   Standard constructor
+
+	   \param provider the name of the provider to use, if available
+	*/
+	explicit Argon2id(const QString &provider = QString());
+
+	/**
+	   Set the costs of the derivation
+
+	   \param memoryCost the memory to use, in kibibytes.  It is at
+	   least 8 times the number of lanes.
+	   \param timeCost the number of passes over the memory
+	   \param lanes the degree of parallelism
+	*/
+	void setParameters(unsigned int memoryCost, unsigned int timeCost, unsigned int lanes);
+
+	/**
+	   Generate a key from a secret and a salt
+
+	   \param secret the secret (password or passphrase)
+	   \param salt the salt to use, at least 8 bytes long
+	   \param keyLength the length of key to return, at least 4
+
+	   \return the derived key, or an empty key if the parameters are
+	   not valid or the memory cannot be allocated
+	*/
+	SymmetricKey makeKey(const SecureArray &secret, const InitializationVector &salt, unsigned int keyLength);
+
+	using KeyDerivationFunction::makeKey;
+};
+
+/**
+   \class HKDF qca_basic.h QtCrypto
+
+   HMAC-based extract-and-expand key derivation function
+
+   This class implements HKDF, as specified in RFC5869.  It is meant for
+   deriving keys from a secret that is already random, such as a master
+   key or the result of a key agreement, not from passwords.  Use PBKDF2
+   for those.
+
+   The derivation has two steps.  extract() condenses the secret and the
+   salt into a pseudorandom key, which the HKDF object keeps.  expand()
+   then derives a key for each purpose, distinguished by its info.  Once
+   the pseudorandom key is set, each expand() only runs the HMAC over the
+   info, so deriving many subkeys from one secret is cheap:
+
+   \code
+QCA::HKDF hkdf("sha256");
+hkdf.extract(masterSecret, sessionSalt);
+QCA::SymmetricKey encKey = hkdf.expand(QCA::InitializationVector(QByteArray("encryption")), 32);
+QCA::SymmetricKey macKey = hkdf.expand(QCA::InitializationVector(QByteArray("authentication")), 32);
+   \endcode
+
+   \ingroup UserAPI
+*/
+class QCA_EXPORT HKDF : public Algorithm
+{
+public:
+	/**
+	   Standard constructor
+
+	   The default is SHA-1, like PBKDF1 and PBKDF2, because the
+	   built-in provider has it.  Stronger hashes such as "sha256"
+	   need a provider plugin.
+
+	   \param algorithm the name of the hashing algorithm to use
+	   \param provider the name of the provider to use, if available
+	*/
+	explicit HKDF(const QString &algorithm = QStringLiteral("sha1"), const QString &provider = QString());
+
+	/**
+	   Standard copy constructor
+
+	   The copy keeps the pseudorandom key.
+
+	   \param from the HKDF to copy from
+	*/
+	HKDF(const HKDF &from);
+
+	~HKDF();
+
+	/**
+	   Assignment operator
+
+	   \param from the HKDF to assign from
+	*/
+	HKDF & operator=(const HKDF &from);
+
+	/**
+	   Compute the pseudorandom key from a secret and a salt
+
+	   The key is kept for subsequent calls to expand().
+
+	   \param secret the input keying material
+	   \param salt the salt.  It may be empty, but a random salt makes
+	   the derivation considerably stronger.
+
+	   \return the pseudorandom key
+	*/
+	SymmetricKey extract(const SecureArray &secret, const InitializationVector &salt);
+
+	/**
+	   Set the pseudorandom key for expand()
+
+	   Use this to skip the extract step, for example with a key that
+	   was extracted earlier, or one that is already uniformly random.
+
+	   \param prk the pseudorandom key
+	*/
+	void setPrk(const SymmetricKey &prk);
+
+	/**
+	   Derive a key from the pseudorandom key
+
+	   \param info the context and application specific information,
+	   which distinguishes the keys derived from the same secret
+	   \param keyLength the length of the key to return, at most 255
+	   times the length of the hash output
+
+	   \return the derived key, or an empty key if no pseudorandom key
+	   has been set or keyLength is too long
+	*/
+	SymmetricKey expand(const InitializationVector &info, unsigned int keyLength);
+
+	/**
+	   Derive a single key from a secret
+
+	   This is extract() followed by expand(), so it also replaces the
+	   pseudorandom key.
+
+	   \param secret the input keying material
+	   \param salt the salt
+	   \param info the context and application specific information
+	   \param keyLength the length of the key to return
+
+	   \return the derived key
+	*/
+	SymmetricKey makeKey(const SecureArray &secret, const InitializationVector &salt, const InitializationVector &info, unsigned int keyLength);
+};
+
 }
 
 #endif
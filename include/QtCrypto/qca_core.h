@@ -44,6 +44,8 @@
 #include "qca_tools.h"
 #include "qca_version.h"
 
+class QIODevice;
+
 /**
    The current version of %QCA.
 
@@ -1135,6 +1137,141 @@ public:
 	MemoryRegion process(const MemoryRegion &a);
 };
 
+/**
+   \class FilterChain qca_core.h QtCrypto
+
+   A pipeline of Filter stages
+
+   Data given to update() is passed through each stage in turn, and the
+   output of the last stage is returned.  Each chunk goes through the
+   whole pipeline before the next is taken, and nothing is buffered
+   between the stages, so a stream of any size is processed in a single
+   pass and in constant memory.
+
+   A BufferedComputation, such as a Hash or a MessageAuthenticationCode,
+   can be attached as a tap.  It sees the data at its point in the chain
+   without changing it.  For example, to check the MAC of a Base64
+   encoded ciphertext while decrypting it:
+
+   \code
+QCA::Base64 decoder(QCA::Decode);
+decoder.setLineBreaksEnabled(true);
+QCA::MessageAuthenticationCode mac("hmac(sha256)", macKey);
+QCA::Cipher cipher("aes128", QCA::Cipher::CBC, QCA::Cipher::DefaultPadding, QCA::Decode, key, iv);
+
+QCA::FilterChain chain;
+chain.append(&decoder);
+chain.tap(&mac);
+chain.append(&cipher);
+if(chain.process(&inFile, &outFile) && mac.final() == expectedMac)
+{
+	// the plaintext in outFile can be trusted
+}
+   \endcode
+
+   The stages and taps are not owned by the chain, and must outlive it.
+   clear() clears them all.  final() completes the stages, but not the
+   taps: call their final() once the chain is done.
+
+   \note The chain stops at the first stage that fails, and ok() returns
+   false from then on.
+
+   \ingroup UserAPI
+*/
+class QCA_EXPORT FilterChain : public Filter
+{
+public:
+	/**
+	   Constructs an empty chain, which passes data through unchanged
+	*/
+	FilterChain();
+
+	~FilterChain();
+
+	/**
+	   Add a stage to the end of the chain
+
+	   \param filter the stage to add
+	*/
+	void append(Filter *filter);
+
+	/**
+	   Attach a tap at the end of the chain as it is now
+
+	   The tap is given the output of the last stage added so far, or
+	   the input of the chain if no stage has been added yet.  Stages
+	   added later do not affect what the tap sees.
+
+	   \param computation the computation to give the data to
+	*/
+	void tap(BufferedComputation *computation);
+
+	/**
+	   The number of stages in the chain
+	*/
+	int count() const;
+
+	/**
+	   Reset the chain, and all of its stages and taps
+	*/
+	virtual void clear();
+
+	/**
+	   Process more data through the chain
+
+	   \param a the data to process
+
+	   \return the output of the last stage
+	*/
+	virtual MemoryRegion update(const MemoryRegion &a);
+
+	/**
+	   Complete each stage in turn
+
+	   The output of each stage's final() is passed through the stages
+	   after it.
+
+	   \return the remaining output of the last stage
+	*/
+	virtual MemoryRegion final();
+
+	/**
+	   Test if all stages succeeded so far
+	*/
+	virtual bool ok() const;
+
+	using Filter::process;
+
+	/**
+	   Process a whole stream through the chain
+
+	   The chain is cleared, then fed from \a in until there is no more
+	   data to read, and completed.  The output is written to \a out.
+	   For a sequential device, such as a socket or a pipe, this blocks
+	   waiting for more data until waitForReadyRead() reports that no
+	   more will arrive (for example because the peer closed the
+	   connection).
+	   A single buffer is used for reading, so only stages that do not
+	   keep a reference to their input may be used.  This holds for all
+	   of the filters in %QCA.
+
+	   \param in the device to read from
+	   \param out the device to write to, or 0 to discard the output,
+	   for example when only the taps are of interest
+	   \param bufferSize the number of bytes to read at a time
+
+	   \return true if all stages succeeded and the output was
+	   written, otherwise false
+	*/
+	bool process(QIODevice *in, QIODevice *out, int bufferSize = 65536);
+
+private:
+	Q_DISABLE_COPY(FilterChain)
+
+	class Private;
+	Private *d;
+};
+
 /**
    \class Algorithm qca_core.h QtCrypto
 
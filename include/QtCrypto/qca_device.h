@@ -0,0 +1,333 @@
+/*
+ * qca_device.h - Qt Cryptographic Architecture
+ * Copyright (C) 2026  Forkworks
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301  USA
+ *
+ */
+
+/**
+   \file qca_device.h
+
+   Header file for the QIODevice adapters that filter or digest a stream
+
+   \note You should not use this header directly from an
+   application. You should just use <tt> \#include \<QtCrypto>
+   </tt> instead.
+*/
+
+#ifndef QCA_DEVICE_H
+#define QCA_DEVICE_H
+
+#include <QIODevice>
+#include "qca_basic.h"
+
+namespace QCA {
+
+/**
+   \class FilterDevice qca_device.h QtCrypto
+
+   Runs a Filter over the data read from or written to another device
+
+   Open a FilterDevice with QIODevice::ReadOnly to read the filtered data
+   of the underlying device, or with QIODevice::WriteOnly to filter data
+   on its way to the underlying device.  The underlying device has to be
+   open already, in a compatible mode.  It is not closed along with the
+   FilterDevice.
+
+   The underlying device is read from, and written to, in blocks of
+   blockSize() bytes.  When reading, the filter is completed at the end
+   of the underlying device.  When writing, the filter is completed by
+   close(), so be sure to call it.
+
+   If read-ahead is enabled, the next block is read and filtered on the
+   shared ThreadPool while the current one is consumed.  This overlaps
+   the I/O with the computation.  It is only done when the underlying
+   device is a QFile that is not sequential, since other devices may
+   emit signals or use objects of the thread they belong to when they
+   are read.  The underlying device must not be used by anyone else
+   while the FilterDevice is open.
+
+   The filter is not owned by the FilterDevice.  See CipherDevice,
+   HashDevice and MACDevice for the common cases.
+
+   \ingroup UserAPI
+*/
+class QCA_EXPORT FilterDevice : public QIODevice
+{
+	Q_OBJECT
+public:
+	/**
+	   Standard constructor
+
+	   \param filter the filter to run
+	   \param device the underlying device
+	   \param parent the parent object for this object
+	*/
+	FilterDevice(Filter *filter, QIODevice *device, QObject *parent = 0);
+
+	~FilterDevice();
+
+	/**
+	   The underlying device
+	*/
+	QIODevice *device() const;
+
+	/**
+	   The number of bytes read from, or written to, the underlying
+	   device at a time.  The default is 64 kilobytes.
+	*/
+	int blockSize() const;
+
+	/**
+	   Set the number of bytes to read or write at a time
+
+	   This only takes effect the next time the device is opened.
+
+	   \param size the block size, in bytes
+	*/
+	void setBlockSize(int size);
+
+	/**
+	   Returns true if read-ahead is enabled.  It is disabled by
+	   default.
+	*/
+	bool readAhead() const;
+
+	/**
+	   Enable or disable read-ahead on the ThreadPool
+
+	   This only takes effect the next time the device is opened.
+
+	   \param enabled whether to read ahead
+	*/
+	void setReadAhead(bool enabled);
+
+	/**
+	   Test if the filter has succeeded so far
+
+	   If it fails, reading or writing returns -1 from then on.
+	*/
+	bool ok() const;
+
+	/**
+	   Open the device
+
+	   \param mode either QIODevice::ReadOnly or QIODevice::WriteOnly
+	*/
+	virtual bool open(OpenMode mode);
+
+	/**
+	   Close the device
+
+	   When writing, this completes the filter and writes the rest of
+	   its output to the underlying device.
+	*/
+	virtual void close();
+
+	/**
+	   Always returns true, since the size of the output is not known
+	   in advance
+	*/
+	virtual bool isSequential() const;
+
+	/**
+	   Returns true if all of the filtered data has been read
+	*/
+	virtual bool atEnd() const;
+
+	/**
+	   The number of filtered bytes that can be read without blocking
+	*/
+	virtual qint64 bytesAvailable() const;
+
+protected:
+	/**
+	   Provides the filtered data
+
+	   \param data the buffer to fill
+	   \param maxSize the size of the buffer
+	*/
+	virtual qint64 readData(char *data, qint64 maxSize);
+
+	/**
+	   Filters data and writes it to the underlying device
+
+	   \param data the data to write
+	   \param maxSize the number of bytes of data
+	*/
+	virtual qint64 writeData(const char *data, qint64 maxSize);
+
+	/**
+	   Set the filter to run, for subclasses that own it
+
+	   \param filter the filter to run
+	*/
+	void setFilter(Filter *filter);
+
+	/**
+	   Bring the filter up to date with the underlying device, without
+	   completing it
+
+	   When writing, the data that is held back until there is a whole
+	   block is filtered and written out.  When reading, this waits for
+	   a block that is being read ahead.
+
+	   \return false if the filter or the underlying device failed
+	*/
+	bool flushFilter();
+
+private:
+	Q_DISABLE_COPY(FilterDevice)
+
+	class Private;
+	friend class Private;
+	Private *d;
+};
+
+/**
+   \class CipherDevice qca_device.h QtCrypto
+
+   Encrypts or decrypts the data read from or written to another device
+
+   \code
+QFile file("secret.bin");
+file.open(QIODevice::WriteOnly);
+QCA::CipherDevice dev(QCA::Cipher("aes256", QCA::Cipher::CBC, QCA::Cipher::DefaultPadding, QCA::Encode, key, iv), &file);
+dev.open(QIODevice::WriteOnly);
+QDataStream stream(&dev);
+stream << document;
+dev.close();
+   \endcode
+
+   \ingroup UserAPI
+*/
+class QCA_EXPORT CipherDevice : public FilterDevice
+{
+	Q_OBJECT
+public:
+	/**
+	   Standard constructor
+
+	   \param cipher the cipher to run, which is copied.  Whether
+	   the data is encrypted or decrypted depends on its direction.
+	   \param device the underlying device
+	   \param parent the parent object for this object
+	*/
+	CipherDevice(const Cipher &cipher, QIODevice *device, QObject *parent = 0);
+
+	~CipherDevice();
+
+	/**
+	   The cipher, for example to get the tag() of an authenticated
+	   mode once the device has been closed or read to the end
+	*/
+	Cipher *cipher();
+
+private:
+	Q_DISABLE_COPY(CipherDevice)
+
+	class Private;
+	Private *d;
+};
+
+/**
+   \class HashDevice qca_device.h QtCrypto
+
+   Computes a hash of the data read from or written to another device
+
+   The data itself passes through unchanged.
+
+   \ingroup UserAPI
+*/
+class QCA_EXPORT HashDevice : public FilterDevice
+{
+	Q_OBJECT
+public:
+	/**
+	   Standard constructor
+
+	   \param hash the hash to compute, which is copied
+	   \param device the underlying device
+	   \param parent the parent object for this object
+	*/
+	HashDevice(const Hash &hash, QIODevice *device, QObject *parent = 0);
+
+	~HashDevice();
+
+	/**
+	   Returns the hash of the data that has passed through, and
+	   starts over
+
+	   Data written is included even if the device has not been
+	   closed yet.  When reading, the hash is of the data read from
+	   the underlying device, which may be ahead of what has been read
+	   from this one.
+	*/
+	MemoryRegion final();
+
+private:
+	Q_DISABLE_COPY(HashDevice)
+
+	class Private;
+	Private *d;
+};
+
+/**
+   \class MACDevice qca_device.h QtCrypto
+
+   Computes a message authentication code of the data read from or
+   written to another device
+
+   The data itself passes through unchanged.
+
+   \ingroup UserAPI
+*/
+class QCA_EXPORT MACDevice : public FilterDevice
+{
+	Q_OBJECT
+public:
+	/**
+	   Standard constructor
+
+	   \param mac the message authentication code to compute, which
+	   is copied.  It must have its key set already.
+	   \param device the underlying device
+	   \param parent the parent object for this object
+	*/
+	MACDevice(const MessageAuthenticationCode &mac, QIODevice *device, QObject *parent = 0);
+
+	~MACDevice();
+
+	/**
+	   Returns the code of the data that has passed through, and
+	   starts over
+
+	   As with HashDevice::final(), data written is included even if
+	   the device has not been closed yet.
+	*/
+	MemoryRegion final();
+
+private:
+	Q_DISABLE_COPY(MACDevice)
+
+	class Private;
+	Private *d;
+};
+
+}
+
+#endif
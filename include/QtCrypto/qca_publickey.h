@@ -1534,6 +1534,303 @@ public:
 	*/
 	BigInteger x() const;
 };
+
+/**
+   \class Signer qca_publickey.h QtCrypto
+
+   Reusable signing object
+
+   A Signer binds a private key and a signature algorithm once, and can
+   then be used to sign any number of messages.  The key is prepared for
+   the provider a single time when the Signer is created, and between
+   messages only the digest is reset, so any per-key state (converted
+   keys, precomputed values, blinding) is kept across signatures.  This
+   makes it much cheaper than calling PrivateKey::signMessage() in a
+   loop.
+
+   \code
+QCA::Signer signer(privkey, QCA::EMSA3_SHA256);
+foreach(const QByteArray &message, messages)
+	signatures += signer.signMessage(message);
+   \endcode
+
+   A Signer is not thread safe, but copies of a Signer are independent
+   and may be used from different threads.
+
+   \ingroup UserAPI
+*/
+class QCA_EXPORT Signer
+{
+public:
+	/**
+	   Create a signer
+
+	   \param key the private key to sign with
+	   \param alg the signature algorithm to use
+	   \param format the signature format to use, for DSA
+	*/
+	Signer(const PrivateKey &key, SignatureAlgorithm alg, SignatureFormat format = DefaultFormat);
+
+	/**
+	   Standard copy constructor
+
+	   \param from the Signer to copy from
+	*/
+	Signer(const Signer &from);
+
+	~Signer();
+
+	/**
+	   Standard assignment operator
+
+	   \param from the Signer to copy from
+	*/
+	Signer & operator=(const Signer &from);
+
+	/**
+	   Test if the Signer can be used.  This is false if the key is
+	   null or cannot sign.
+	*/
+	bool isNull() const;
+
+	/**
+	   The signature algorithm in use
+	*/
+	SignatureAlgorithm signatureAlgorithm() const;
+
+	/**
+	   The signature format in use
+	*/
+	SignatureFormat signatureFormat() const;
+
+	/**
+	   Add data to the message being signed
+
+	   This can be called multiple times before signature().
+
+	   \param a the data to add
+	*/
+	void update(const MemoryRegion &a);
+
+	/**
+	   Complete the signature of the data given to update()
+
+	   After this call, the Signer is ready for the next message.
+	*/
+	QByteArray signature();
+
+	/**
+	   Sign a complete message in one step
+
+	   \param a the message to sign
+	*/
+	QByteArray signMessage(const MemoryRegion &a);
+
+private:
+	class Private;
+	Private *d;
+};
+
+/**
+   \class Verifier qca_publickey.h QtCrypto
+
+   Reusable verification object
+
+   This is the verification counterpart of Signer.  The public key and
+   signature algorithm are bound once, and only the digest is reset
+   between messages.
+
+   \code
+QCA::Verifier verifier(pubkey, QCA::EMSA3_SHA256);
+for(int n = 0; n < messages.count(); ++n)
+{
+	if(!verifier.verifyMessage(messages[n], signatures[n]))
+		...
+}
+   \endcode
+
+   \ingroup UserAPI
+*/
+class QCA_EXPORT Verifier
+{
+public:
+	/**
+	   Create a verifier
+
+	   \param key the public key to verify with
+	   \param alg the signature algorithm to use
+	   \param format the signature format to use, for DSA
+	*/
+	Verifier(const PublicKey &key, SignatureAlgorithm alg, SignatureFormat format = DefaultFormat);
+
+	/**
+	   Standard copy constructor
+
+	   \param from the Verifier to copy from
+	*/
+	Verifier(const Verifier &from);
+
+	~Verifier();
+
+	/**
+	   Standard assignment operator
+
+	   \param from the Verifier to copy from
+	*/
+	Verifier & operator=(const Verifier &from);
+
+	/**
+	   Test if the Verifier can be used.  This is false if the key is
+	   null or cannot verify.
+	*/
+	bool isNull() const;
+
+	/**
+	   The signature algorithm in use
+	*/
+	SignatureAlgorithm signatureAlgorithm() const;
+
+	/**
+	   The signature format in use
+	*/
+	SignatureFormat signatureFormat() const;
+
+	/**
+	   Add data to the message being verified
+
+	   This can be called multiple times before validSignature().
+
+	   \param a the data to add
+	*/
+	void update(const MemoryRegion &a);
+
+	/**
+	   Check the signature of the data given to update()
+
+	   After this call, the Verifier is ready for the next message.
+
+	   \param sig the signature to check
+
+	   \return true if the signature is correct
+	*/
+	bool validSignature(const QByteArray &sig);
+
+	/**
+	   Verify a complete message in one step
+
+	   \param a the message to check the signature on
+	   \param sig the signature to be checked
+
+	   \return true if the signature is valid for the message
+	*/
+	bool verifyMessage(const MemoryRegion &a, const QByteArray &sig);
+
+private:
+	class Private;
+	Private *d;
+};
+
+/**
+   \class VerifyBatchItem qca_publickey.h QtCrypto
+
+   A single signature check, for use with verifyBatch()
+
+   This holds the public key, the message, the signature and the
+   algorithm needed to check one signature.  It is a lightweight,
+   implicitly shared value class, so lists of these can be built up and
+   copied cheaply.
+
+   \ingroup UserAPI
+*/
+class QCA_EXPORT VerifyBatchItem
+{
+public:
+	/**
+	   Create an empty item
+	*/
+	VerifyBatchItem();
+
+	/**
+	   Create an item describing one signature check
+
+	   \param key the public key to verify with
+	   \param message the message that was signed
+	   \param signature the signature to check
+	   \param alg the signature algorithm to use
+	   \param format the signature format to use, for DSA
+	*/
+	VerifyBatchItem(const PublicKey &key, const MemoryRegion &message, const QByteArray &signature, SignatureAlgorithm alg, SignatureFormat format = DefaultFormat);
+
+	/**
+	   Standard copy constructor
+
+	   \param from the source item
+	*/
+	VerifyBatchItem(const VerifyBatchItem &from);
+
+	~VerifyBatchItem();
+
+	/**
+	   Standard assignment operator
+
+	   \param from the source item
+	*/
+	VerifyBatchItem & operator=(const VerifyBatchItem &from);
+
+	/**
+	   The public key to verify with
+	*/
+	PublicKey key() const;
+
+	/**
+	   The message that was signed
+	*/
+	MemoryRegion message() const;
+
+	/**
+	   The signature to check
+	*/
+	QByteArray signature() const;
+
+	/**
+	   The signature algorithm
+	*/
+	SignatureAlgorithm signatureAlgorithm() const;
+
+	/**
+	   The signature format
+	*/
+	SignatureFormat signatureFormat() const;
+
+private:
+	class Private;
+	QSharedDataPointer<Private> d;
+};
+
+/**
+   Verify many signatures at once
+
+   Each item is checked exactly as PublicKey::verifyMessage() would
+   check it, but the work is spread over the shared ThreadPool, with the
+   calling thread taking part.  Items that
+   use the same key share one key context per thread, so the key is only
+   converted for the provider once per thread rather than once per item.
+
+   \code
+QList<QCA::VerifyBatchItem> batch;
+for(int n = 0; n < messages.count(); ++n)
+	batch += QCA::VerifyBatchItem(pubkey, messages[n], signatures[n], QCA::EMSA3_SHA1);
+QList<bool> results = QCA::verifyBatch(batch);
+   \endcode
+
+   \param items the signatures to check
+   \param maxThreads the maximum number of threads to use, or -1 to use
+   as many as ThreadPool::maxThreadCount()
+
+   \return a list with one entry per item, in the same order, that is
+   true if the corresponding signature is valid
+*/
+QCA_EXPORT QList<bool> verifyBatch(const QList<VerifyBatchItem> &items, int maxThreads = -1);
 /*@}*/
 }
 
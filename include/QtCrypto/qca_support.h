@@ -45,6 +45,7 @@
 #include <QList>
 #include <QMetaObject>
 #include <QThread>
+#include <QRunnable>
 #include "qca_export.h"
 #include "qca_tools.h"
 
@@ -383,6 +384,240 @@ private:
 	Private *d;
 };
 
+/**
+   \class ThreadPool qca_support.h QtCrypto
+
+   Library-wide pool of worker threads
+
+   %QCA runs all of its background work (key generation, secure message
+   operations, keystore access, batch operations) on a single shared
+   pool, instead of creating a thread per operation.  This keeps the
+   number of threads bounded and avoids the cost of thread creation for
+   short operations.
+
+   Work is queued in three priority classes.  Idle workers always take
+   the oldest item of the highest priority that has work queued.  A
+   thread that needs the result of queued work can take it back with
+   tryTake() and run it itself, which is what ThreadPoolJob::wait()
+   does, so waiting on the pool from within the pool cannot deadlock.
+
+   Workers are created on demand, up to maxThreadCount(), and exit again
+   after being idle for expiryTimeout() milliseconds.
+
+   \ingroup UserAPI
+*/
+class QCA_EXPORT ThreadPool
+{
+public:
+	/**
+	   Priority classes for queued work
+	*/
+	enum Priority
+	{
+		LowPriority,    ///< Long running background work, such as key generation
+		NormalPriority, ///< Ordinary cryptographic operations
+		HighPriority    ///< Short, latency sensitive operations
+	};
+
+	/**
+	   Returns the shared pool used by %QCA
+	*/
+	static ThreadPool *instance();
+
+	/**
+	   The maximum number of worker threads.  This defaults to the
+	   number of processor cores, but is never less than two.
+	*/
+	int maxThreadCount() const;
+
+	/**
+	   Set the maximum number of worker threads
+
+	   Lowering the limit does not stop busy threads; the pool shrinks
+	   as they finish their current work.
+
+	   \param count the new maximum, at least 1
+	*/
+	void setMaxThreadCount(int count);
+
+	/**
+	   The time in milliseconds after which an idle worker exits
+	*/
+	int expiryTimeout() const;
+
+	/**
+	   Set the time after which an idle worker exits
+
+	   \param msecs the timeout, or -1 to keep idle workers forever
+	*/
+	void setExpiryTimeout(int msecs);
+
+	/**
+	   The number of worker threads currently alive
+	*/
+	int threadCount() const;
+
+	/**
+	   The number of worker threads currently running work
+	*/
+	int activeThreadCount() const;
+
+	/**
+	   The number of items waiting in the queue, over all priorities
+	*/
+	int queueDepth() const;
+
+	/**
+	   The number of items waiting in the queue for one priority
+
+	   \param priority the priority class to report
+	*/
+	int queueDepth(Priority priority) const;
+
+	/**
+	   The largest queue depth seen since the pool was created, or
+	   since the last call to resetStatistics()
+	*/
+	int peakQueueDepth() const;
+
+	/**
+	   The number of items that have been run to completion since the
+	   pool was created, or since the last call to resetStatistics()
+	*/
+	qint64 completedCount() const;
+
+	/**
+	   Reset peakQueueDepth() and completedCount()
+	*/
+	void resetStatistics();
+
+	/**
+	   Queue work on the pool
+
+	   If the runnable has autoDelete() set, the pool deletes it after
+	   it has run.
+
+	   \param runnable the work to run
+	   \param priority the priority class of the work
+	*/
+	void start(QRunnable *runnable, Priority priority = NormalPriority);
+
+	/**
+	   Remove work from the queue, if it has not started yet
+
+	   The runnable is not deleted, even if it has autoDelete() set.
+
+	   \param runnable the work to remove
+
+	   \return true if the runnable was removed from the queue
+	*/
+	bool tryTake(QRunnable *runnable);
+
+	/**
+	   Wait until the queue is empty and all workers are idle
+
+	   \param msecs the time to wait.  The default value (-1) waits
+	   indefinitely.
+
+	   \return true if the pool is idle
+	*/
+	bool waitForDone(int msecs = -1);
+
+private:
+	ThreadPool();
+	~ThreadPool();
+	Q_DISABLE_COPY(ThreadPool)
+
+	class Private;
+	friend class Private;
+	Private *d;
+};
+
+/**
+   \class ThreadPoolJob qca_support.h QtCrypto
+
+   A unit of work for the shared ThreadPool
+
+   This offers the familiar start()/wait()/finished() interface of
+   QThread, but runs the work on a pool thread.  Reimplement run() with
+   the work to be done.  The finished() signal is emitted from the pool
+   thread after run() returns, so connect to it with a queued connection
+   if the receiver is not thread safe.
+
+   \note Subclasses should call wait() in their own destructor, for the
+   same reasons a QThread subclass must not be destroyed while running.
+
+   \ingroup UserAPI
+*/
+class QCA_EXPORT ThreadPoolJob : public QObject
+{
+	Q_OBJECT
+public:
+	/**
+	   Standard constructor
+
+	   \param parent the parent object for this object
+	*/
+	ThreadPoolJob(QObject *parent = 0);
+
+	/**
+	   Waits for the job and then destructs
+	*/
+	~ThreadPoolJob();
+
+	/**
+	   Queue the job on the shared pool.  A job may be started again
+	   once it has finished.
+
+	   \param priority the priority class of the job
+	*/
+	void start(ThreadPool::Priority priority = ThreadPool::NormalPriority);
+
+	/**
+	   Returns true if the job has been started and has not finished yet
+	*/
+	bool isRunning() const;
+
+	/**
+	   Returns true if the job has run to completion
+	*/
+	bool isFinished() const;
+
+	/**
+	   Wait for the job to finish
+
+	   If the job is still queued and \a msecs is -1, it is taken off
+	   the queue and run in the calling thread.  With a timeout, the job
+	   is left to the pool, and this returns false if no worker has
+	   finished it in time.
+
+	   \param msecs the time to wait.  The default value (-1) waits
+	   indefinitely.
+
+	   \return true if the job has finished, or was never started
+	*/
+	bool wait(int msecs = -1);
+
+Q_SIGNALS:
+	/**
+	   Emitted from the pool thread when run() has returned
+	*/
+	void finished();
+
+protected:
+	/**
+	   Reimplement this with the work to be done
+	*/
+	virtual void run() = 0;
+
+private:
+	Q_DISABLE_COPY(ThreadPoolJob)
+
+	class Private;
+	friend class Private;
+	Private *d;
+};
+
 /**
    \class DirWatch qca_support.h QtCrypto
 
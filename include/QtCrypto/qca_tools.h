@@ -38,6 +38,7 @@
 
 #include <QSharedData>
 #include <QSharedDataPointer>
+#include <QList>
 #include <QMetaType>
 #include "qca_export.h"
 
@@ -150,6 +151,16 @@ public:
 	*/
 	bool isSecure() const;
 
+	/**
+	   Test if the MemoryRegion refers to memory it doesn't own,
+	   such as a MemoryView or the result of mid()
+
+	   The data of a view is only valid for as long as the memory
+	   it refers to.  Anything that keeps the data for later
+	   should make a copy of its own.
+	*/
+	bool isView() const;
+
 	/**
 	   Convert this memory region to a byte array.
 
@@ -203,6 +214,27 @@ public:
 	*/
 	const char & at(int index) const;
 
+	/**
+	   Returns a region holding part of this one, without copying
+
+	   The result shares the memory of this region, which is kept
+	   alive for as long as the result exists.  The memory is only
+	   copied if either one is changed later.  This makes it cheap
+	   to pass a sub-range of a large buffer to Hash::update(),
+	   Cipher::update() and the like.
+
+	   \note Unlike other regions, the data of the result is not
+	   followed by a null terminator, unless it extends to the end
+	   of this region.
+
+	   \param pos the offset of the first byte
+	   \param len the number of bytes, or -1 (the default) for all
+	   bytes up to the end of this region
+
+	   \sa MemoryView
+	*/
+	MemoryRegion mid(int pos, int len = -1) const;
+
 protected:
 	/**
 	   Create a memory region, optionally using secure
@@ -268,6 +300,26 @@ protected:
 	*/
 	bool resize(int size);
 
+	/**
+	   Allocate room for at least the specified number of bytes,
+	   without changing the size of the region.
+
+	   \param size the number of bytes to make room for
+	*/
+	bool reserve(int size);
+
+	/**
+	   Returns the number of bytes the region can hold without
+	   reallocating.
+	*/
+	int capacity() const;
+
+	/**
+	   Release any room that is not needed for the current
+	   contents.
+	*/
+	void squeeze();
+
 	/**
 	   Modify the memory region to match a specified
 	   byte array. This resizes the memory region
@@ -296,6 +348,55 @@ private:
 	bool _secure;
 	class Private;
 	QSharedDataPointer<Private> d;
+
+	friend class MemoryView;
+};
+
+/**
+   \class MemoryView qca_tools.h QtCrypto
+
+   Memory region that refers to bytes it doesn't own
+
+   %MemoryView lets existing memory, such as a mapped file or part of a
+   larger region, be passed anywhere a MemoryRegion is accepted without
+   copying it first.
+
+   \code
+// hash the second half of a mapped file
+uchar *map = file.map(0, file.size());
+QCA::Hash hash("sha256");
+hash.update(QCA::MemoryView((const char *)map + file.size() / 2, file.size() / 2));
+   \endcode
+
+   A view of raw data is not secure, and the data must stay valid for
+   as long as the view (or any copy of it) exists.  The data is copied
+   if the view is changed, which is only possible after converting it
+   to a SecureArray.  A view is not followed by a null terminator.
+
+   \ingroup UserAPI
+*/
+class QCA_EXPORT MemoryView : public MemoryRegion
+{
+public:
+	/**
+	   Refer to raw data
+
+	   \param data the first byte to refer to
+	   \param size the number of bytes, or -1 if data is null
+	   terminated
+	*/
+	MemoryView(const char *data, int size);
+
+	/**
+	   Refer to part of another region, without copying it.  This is
+	   the same as from.mid(pos, len).
+
+	   \param from the region to refer to
+	   \param pos the offset of the first byte
+	   \param len the number of bytes, or -1 (the default) for all
+	   bytes up to the end of the region
+	*/
+	MemoryView(const MemoryRegion &from, int pos, int len = -1);
 };
 
 /**
@@ -469,6 +570,39 @@ public:
 	*/
 	bool resize(int size);
 
+	/**
+	   Allocate room for at least the specified number of bytes
+
+	   Growing the array up to that size, such as by append(),
+	   then doesn't need to reallocate.  The size of the array is
+	   not changed.
+
+	   The array grows geometrically by itself as well, so this is
+	   only needed when the final size is known in advance.
+
+	   \param size the number of bytes to make room for
+
+	   \sa capacity(), squeeze()
+	*/
+	bool reserve(int size);
+
+	/**
+	   Returns the number of bytes the array can hold without
+	   reallocating
+
+	   \sa reserve(), squeeze()
+	*/
+	int capacity() const;
+
+	/**
+	   Release any room that is not needed for the current contents
+
+	   The old storage is wiped.
+
+	   \sa reserve(), capacity()
+	*/
+	void squeeze();
+
 	/**
 	   Fill the data array with a specified character
 
@@ -551,6 +685,134 @@ protected:
 */
 QCA_EXPORT const SecureArray operator+(const SecureArray &a, const SecureArray &b);
 
+class SecureMemoryStatistics;
+
+/**
+   Returns the usage of the secure memory allocators
+
+   There is one entry for the pool that secure memory is taken from
+   (for example, "locking" when the memory is locked into RAM), and one
+   entry, called "arena", for the per-thread arenas that serve small
+   allocations from the pool.  The list is empty if %QCA has not been
+   initialized.
+
+   \code
+foreach(const QCA::SecureMemoryStatistics &s, QCA::secureMemoryStatistics())
+	printf("%s: %d of %d bytes in use\n", qPrintable(s.name()), s.inUse(), s.poolSize());
+   \endcode
+
+   \sa growSecureMemory
+*/
+QCA_EXPORT QList<SecureMemoryStatistics> secureMemoryStatistics();
+
+/**
+   Add memory to the secure memory pool
+
+   The pool grows on its own when it runs out, but an application
+   that knows it is about to need a lot of secure memory can use this
+   to take it up front, and to find out early whether the memory can
+   be locked.
+
+   \param size the amount of memory to add, in kilobytes
+
+   \return true if the memory was added, or false if %QCA is not
+   initialized or the memory could not be obtained
+*/
+QCA_EXPORT bool growSecureMemory(int size);
+
+/**
+   \class SecureMemoryStatistics qca_tools.h QtCrypto
+
+   Usage of a secure memory allocator
+
+   This is a snapshot, as returned by secureMemoryStatistics().  All
+   sizes are in bytes.
+
+   \ingroup UserAPI
+*/
+class QCA_EXPORT SecureMemoryStatistics
+{
+public:
+	/**
+	   Constructs an empty set of statistics
+	*/
+	SecureMemoryStatistics();
+
+	/**
+	   Standard copy constructor
+
+	   \param from the statistics to copy from
+	*/
+	SecureMemoryStatistics(const SecureMemoryStatistics &from);
+
+	~SecureMemoryStatistics();
+
+	/**
+	   Standard assignment operator
+
+	   \param from the statistics to copy from
+	*/
+	SecureMemoryStatistics & operator=(const SecureMemoryStatistics &from);
+
+	/**
+	   The name of the allocator
+	*/
+	QString name() const;
+
+	/**
+	   The amount of memory the allocator holds
+	*/
+	int poolSize() const;
+
+	/**
+	   The amount of memory currently handed out
+	*/
+	int inUse() const;
+
+	/**
+	   The largest amount of memory handed out at one time
+
+	   For the arenas, this is sampled whenever an arena grows.
+	*/
+	int peakInUse() const;
+
+	/**
+	   The number of allocations made so far
+	*/
+	qint64 allocations() const;
+
+	/**
+	   The number of times memory could not be obtained in the
+	   preferred way, and ordinary memory was used instead
+
+	   For the "locking" pool, this counts the blocks that could not be
+	   locked into RAM, for example because the process reached its
+	   locked memory limit.  Memory in such blocks may be swapped out.
+	*/
+	int fallbacks() const;
+
+	/**
+	   The number of separate free ranges in the pool
+
+	   Together with largestFreeRun(), this shows how fragmented the
+	   pool is.  A pool with many small free ranges has to grow to
+	   satisfy a large allocation, even if enough memory is free in
+	   total.
+	*/
+	int freeRuns() const;
+
+	/**
+	   The size of the largest free range in the pool
+	*/
+	int largestFreeRun() const;
+
+private:
+	class Private;
+	QSharedDataPointer<Private> d;
+
+	friend QList<SecureMemoryStatistics> secureMemoryStatistics();
+};
+
 /**
    \class BigInteger qca_tools.h QtCrypto
 
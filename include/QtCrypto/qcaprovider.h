@@ -197,10 +197,56 @@ public:
 	*/
 	virtual void update(const MemoryRegion &a) = 0;
 
+	/**
+	   Process a chunk of data that may be a view of memory the
+	   caller owns (see MemoryRegion::isView())
+
+	   The data of a view is only valid until this call returns, and
+	   is not followed by a null byte.  The default implementation
+	   passes update() a copy of a view, and any other region as is.
+	   A context that never keeps the data after update() returns
+	   can reimplement this to call update() directly.
+
+	   \param a the input data to process
+	*/
+	virtual void updateView(const MemoryRegion &a);
+
 	/**
 	   Return the computed hash
 	*/
 	virtual MemoryRegion final() = 0;
+
+	/**
+	   Return the computed hash of an extendable-output function,
+	   with the given length
+
+	   \param outLen the number of bytes to return
+
+	   The default implementation returns an empty array, meaning
+	   that the hash is not an extendable-output function.
+	*/
+	virtual MemoryRegion xofFinal(int outLen) { Q_UNUSED(outLen); return MemoryRegion(); }
+
+	/**
+	   Returns the internal state of the hash, from which
+	   restoreState() can continue it
+
+	   The state only has to be understood by the same context type
+	   of the same provider.  The default implementation returns an
+	   empty array, meaning that saving the state is not supported.
+	*/
+	virtual QByteArray saveState() const { return QByteArray(); }
+
+	/**
+	   Continue the hash from a state returned by saveState()
+
+	   \param state the saved state
+
+	   \return false if the state is not valid for this context, in
+	   which case the hash is unchanged.  The default implementation
+	   always returns false.
+	*/
+	virtual bool restoreState(const QByteArray &state) { Q_UNUSED(state); return false; }
 };
 
 /**
@@ -234,10 +280,22 @@ public:
 	   \param dir the direction for the cipher (encryption/decryption)
 	   \param key the symmetric key to use for the cipher
 	   \param iv the initialization vector to use for the cipher (not used in ECB mode)
-	   \param tag the AuthTag to use (only for GCM and CCM modes)
+	   \param tag the AuthTag to use (only for GCM, CCM and Poly1305 modes)
 	*/
 	virtual void setup(Direction dir, const SymmetricKey &key, const InitializationVector &iv, const AuthTag &tag) = 0;
 
+	/**
+	   Start a new message with the direction and key of the last
+	   setup(), without preparing the key again
+
+	   Returns true if successful.  The default implementation returns
+	   false, and the caller then uses setup() instead.
+
+	   \param iv the initialization vector to use for the cipher (not used in ECB mode)
+	   \param tag the AuthTag to use (only for GCM, CCM and Poly1305 modes)
+	*/
+	virtual bool setIV(const InitializationVector &iv, const AuthTag &tag) { Q_UNUSED(iv); Q_UNUSED(tag); return false; }
+
 	/**
 	   Returns the KeyLength for this cipher
 	*/
@@ -310,6 +368,14 @@ public:
 	*/
 	virtual void update(const MemoryRegion &in) = 0;
 
+	/**
+	   Process a chunk of data that may be a view of memory the
+	   caller owns, as with HashContext::updateView()
+
+	   \param in the input data to process
+	*/
+	virtual void updateView(const MemoryRegion &in);
+
 	/**
 	   Compute the result after processing all data
 
@@ -317,6 +383,20 @@ public:
 	*/
 	virtual void final(MemoryRegion *out) = 0;
 
+	/**
+	   Start a new MAC with the key given to setup() last
+
+	   Contexts that keep the keyed state of the MAC, such as the inner
+	   and outer hash states of an HMAC, can restore it here, which is
+	   much cheaper than setting up the key again.  This may be called
+	   after final(), or part way through a message.
+
+	   \return true if the context has been reset, or false if setup()
+	   has to be called again instead.  The default implementation
+	   returns false.
+	*/
+	virtual bool reset() { return false; }
+
 protected:
 	/**
 	   Returns a KeyLength that supports any length
@@ -379,6 +459,107 @@ public:
 								 unsigned int *iterationCount) = 0;
 };
 
+/**
+   \class MemoryHardKDFContext qcaprovider.h QtCrypto
+
+   Memory-hard password based key derivation function provider
+
+   The costs are kept by the context and used for every key until they
+   are changed.  Their meaning depends on the function:
+
+   - for scrypt, memoryCost is the cost parameter N, timeCost is the
+     block size r and lanes is the parallelization parameter p
+   - for argon2id, memoryCost is the memory in kibibytes, timeCost is
+     the number of passes and lanes is the degree of parallelism
+
+   The iteration count of makeKey() is not used, and neither is the
+   time limit.  Keys are always derived with the set costs, and the
+   time limited makeKey() stores 1 as the iteration count.
+
+   \note This class is part of the provider plugin interface and should not
+   be used directly by applications.  You probably want SCRYPT or Argon2id
+   instead.
+
+   \ingroup ProviderAPI
+*/
+class QCA_EXPORT MemoryHardKDFContext : public KDFContext
+{
+	Q_OBJECT
+public:
+	/**
+	   Standard constructor
+
+	   \param p the provider associated with this context
+	   \param type the name of the KDF provided by this context
+	*/
+	MemoryHardKDFContext(Provider *p, const QString &type) : KDFContext(p, type) {}
+
+	/**
+	   Set the costs of the derivation
+
+	   \param memoryCost the memory cost
+	   \param timeCost the time cost
+	   \param lanes the number of lanes, which may be computed in
+	   parallel
+	*/
+	virtual void setParameters(unsigned int memoryCost, unsigned int timeCost, unsigned int lanes) = 0;
+};
+
+/**
+   \class HKDFContext qcaprovider.h QtCrypto
+
+   HMAC-based extract-and-expand key derivation function provider
+
+   The context keeps the pseudorandom key set by extract() or setPrk(),
+   so that expand() can be called many times without setting up the
+   HMAC key again.
+
+   \note This class is part of the provider plugin interface and should not
+   be used directly by applications.  You probably want HKDF instead.
+
+   \ingroup ProviderAPI
+*/
+class QCA_EXPORT HKDFContext : public BasicContext
+{
+	Q_OBJECT
+public:
+	/**
+	   Standard constructor
+
+	   \param p the provider associated with this context
+	   \param type the name of the KDF provided by this context (including algorithm)
+	*/
+	HKDFContext(Provider *p, const QString &type) : BasicContext(p, type) {}
+
+	/**
+	   Compute the pseudorandom key, keep it for expand() and return it
+
+	   \param secret the input keying material
+	   \param salt the salt.  If it is empty, a string of zero bytes as
+	   long as the hash output is used instead.
+	*/
+	virtual SymmetricKey extract(const SecureArray &secret, const InitializationVector &salt) = 0;
+
+	/**
+	   Set the pseudorandom key to use for expand()
+
+	   \param prk the pseudorandom key
+	*/
+	virtual void setPrk(const SymmetricKey &prk) = 0;
+
+	/**
+	   Expand the pseudorandom key into a key
+
+	   \param info the context and application specific information
+	   \param keyLength the length of the key to be produced, at most
+	   255 times the length of the hash output
+
+	   \return the key, or an empty key if there is no pseudorandom
+	   key or keyLength is too long
+	*/
+	virtual SymmetricKey expand(const InitializationVector &info, unsigned int keyLength) = 0;
+};
+
 /**
    \class DLGroupContext qcaprovider.h QtCrypto
 
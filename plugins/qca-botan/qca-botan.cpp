@@ -93,6 +93,11 @@ public:
 	m_hashObj->update( (const Botan::byte*)a.data(), a.size() );
     }
 
+    void updateView(const QCA::MemoryRegion &a)
+    {
+	update(a);
+    }
+
     QCA::MemoryRegion final()
     {
 #if BOTAN_VERSION_CODE < BOTAN_VERSION_CODE_FOR(1,9,0)
@@ -110,11 +115,16 @@ private:
 
 
 //-----------------------------------------------------------
+// Botan's HMAC goes back to its keyed starting state in final(), but
+// clear() forgets the key, so part way through a message reset()
+// finishes the message and throws the result away instead.
 class BotanHMACContext : public QCA::MACContext
 {
 public:
     BotanHMACContext( const QString &hashName, QCA::Provider *p, const QString &type) : QCA::MACContext(p, type)
     {
+	m_keyed = false;
+	m_dirty = false;
 #if BOTAN_VERSION_CODE < BOTAN_VERSION_CODE_FOR(1,8,0)
 	m_hashObj = new Botan::HMAC(hashName.toStdString());
 #else
@@ -125,8 +135,20 @@ public:
 	}
     }
 
+    // Botan can't copy the state of a message in progress, so a copy
+    // starts over with the same key
+    BotanHMACContext(const BotanHMACContext &from) : QCA::MACContext(from)
+    {
+	m_hashObj = static_cast<Botan::HMAC *>(from.m_hashObj->clone());
+	m_keyed = false;
+	m_dirty = false;
+	if (from.m_keyed)
+	    setup(from.m_key);
+    }
+
     ~BotanHMACContext()
     {
+	delete m_hashObj;
     }
 
     void setup(const QCA::SymmetricKey &key)
@@ -136,6 +158,9 @@ public:
 	// that happening.
 	if (key.size() > 0) {
 	    m_hashObj->set_key( (const Botan::byte *)key.data(), key.size() );
+	    m_key = key;
+	    m_keyed = true;
+	    m_dirty = false;
 	}
     }
 
@@ -144,9 +169,15 @@ public:
 	return new BotanHMACContext(*this);
     }
 
-    void clear()
+    bool reset()
     {
-	m_hashObj->clear();
+	if (!m_keyed)
+	    return false;
+	if (m_dirty) {
+	    QCA::MemoryRegion discard;
+	    final(&discard);
+	}
+	return true;
     }
 
     QCA::KeyLength keyLength() const
@@ -157,6 +188,12 @@ public:
     void update(const QCA::MemoryRegion &a)
     {
 	m_hashObj->update( (const Botan::byte*)a.data(), a.size() );
+	m_dirty = true;
+    }
+
+    void updateView(const QCA::MemoryRegion &a)
+    {
+	update(a);
     }
 
     void final( QCA::MemoryRegion *out)
@@ -167,11 +204,119 @@ public:
 	QCA::SecureArray sa( m_hashObj->output_length(), 0 );
 #endif
 	m_hashObj->final( (Botan::byte *)sa.data() );
+	m_dirty = false;
 	*out = sa;
     }
 
 protected:
     Botan::HMAC *m_hashObj;
+    QCA::SymmetricKey m_key;
+    bool m_keyed;
+    bool m_dirty;
+};
+
+
+//-----------------------------------------------------------
+// The HMAC object is keyed with the pseudorandom key once, and
+// final() leaves it keyed, so each block of expand() only hashes
+// the data.
+class BotanHKDFContext : public QCA::HKDFContext
+{
+public:
+    BotanHKDFContext( const QString &hashName, QCA::Provider *p, const QString &type) : QCA::HKDFContext(p, type)
+    {
+	m_hashName = hashName;
+	m_hmac = makeHMAC();
+	m_keyed = false;
+    }
+
+    BotanHKDFContext( const BotanHKDFContext &from ) : QCA::HKDFContext(from)
+    {
+	m_hashName = from.m_hashName;
+	m_hmac = makeHMAC();
+	m_keyed = false;
+	if (from.m_keyed)
+	    setPrk(from.m_prk);
+    }
+
+    ~BotanHKDFContext()
+    {
+	delete m_hmac;
+    }
+
+    Context *clone() const
+    {
+	return new BotanHKDFContext(*this);
+    }
+
+    QCA::SymmetricKey extract(const QCA::SecureArray &secret, const QCA::InitializationVector &salt)
+    {
+	QCA::SecureArray key = salt;
+	if (key.isEmpty())
+	    key = QCA::SecureArray(hashLength(), 0);
+
+	Botan::HMAC *hmac = makeHMAC();
+	hmac->set_key( (const Botan::byte *)key.data(), key.size() );
+	hmac->update( (const Botan::byte *)secret.data(), secret.size() );
+	QCA::SymmetricKey prk( hashLength() );
+	hmac->final( (Botan::byte *)prk.data() );
+	delete hmac;
+
+	setPrk(prk);
+	return prk;
+    }
+
+    void setPrk(const QCA::SymmetricKey &prk)
+    {
+	m_hmac->set_key( (const Botan::byte *)prk.data(), prk.size() );
+	m_prk = prk;
+	m_keyed = true;
+    }
+
+    QCA::SymmetricKey expand(const QCA::InitializationVector &info, unsigned int keyLength)
+    {
+	unsigned int length = hashLength();
+	if (!m_keyed || keyLength > 255 * length)
+	    return QCA::SymmetricKey();
+
+	QCA::SymmetricKey out( keyLength );
+	QCA::SecureArray t( length, 0 );
+	unsigned int tLength = 0;
+	Botan::byte counter = 1;
+	for (unsigned int at = 0; at < keyLength; at += length, ++counter) {
+	    m_hmac->update( (const Botan::byte *)t.data(), tLength );
+	    m_hmac->update( (const Botan::byte *)info.data(), info.size() );
+	    m_hmac->update( counter );
+	    m_hmac->final( (Botan::byte *)t.data() );
+	    tLength = length;
+	    memcpy( out.data() + at, t.data(), qMin( length, keyLength - at ) );
+	}
+	return out;
+    }
+
+protected:
+    Botan::HMAC *makeHMAC() const
+    {
+#if BOTAN_VERSION_CODE < BOTAN_VERSION_CODE_FOR(1,8,0)
+	return new Botan::HMAC(m_hashName.toStdString());
+#else
+	return new Botan::HMAC(Botan::global_state().algorithm_factory().make_hash_function(m_hashName.toStdString()));
+#endif
+    }
+
+    unsigned int hashLength() const
+    {
+#if BOTAN_VERSION_CODE < BOTAN_VERSION_CODE_FOR(1,9,0)
+	return m_hmac->OUTPUT_LENGTH;
+#else
+	return m_hmac->output_length();
+#endif
+    }
+
+    QString m_hashName;
+    Botan::HMAC *m_hmac;
+    QCA::SymmetricKey m_prk;
+    bool m_keyed;
 };
 
 
@@ -184,6 +329,11 @@ public:
 	m_s2k = Botan::get_s2k(kdfName.toStdString());
     }
 
+    BotanPBKDFContext( const BotanPBKDFContext &from ) : QCA::KDFContext(from)
+    {
+	m_s2k = from.m_s2k->clone();
+    }
+
     ~BotanPBKDFContext()
     {
 	delete m_s2k;
@@ -249,6 +399,91 @@ protected:
 };
 
 
+//-----------------------------------------------------------
+// PBKDF2 with a time bound runs the real iterations until the
+// time is up, instead of measuring first and deriving afterwards.
+// The HMAC object stays keyed with the password across final().
+class BotanPBKDF2Context: public BotanPBKDFContext
+{
+public:
+    BotanPBKDF2Context( const QString &hashName, QCA::Provider *p, const QString &type) : BotanPBKDFContext(QString("PBKDF2(%1)").arg(hashName), p, type)
+    {
+	m_hashName = hashName;
+    }
+
+    Context *clone() const
+    {
+	return new BotanPBKDF2Context( *this );
+    }
+
+    using BotanPBKDFContext::makeKey;
+
+    QCA::SymmetricKey makeKey(const QCA::SecureArray &secret,
+			      const QCA::InitializationVector &salt,
+			      unsigned int keyLength,
+			      int msecInterval,
+			      unsigned int *iterationCount)
+    {
+	Q_ASSERT(iterationCount != NULL);
+	if (keyLength == 0)
+	    return QCA::SymmetricKey();
+
+#if BOTAN_VERSION_CODE < BOTAN_VERSION_CODE_FOR(1,8,0)
+	Botan::HMAC hmac(m_hashName.toStdString());
+#else
+	Botan::HMAC hmac(Botan::global_state().algorithm_factory().make_hash_function(m_hashName.toStdString()));
+#endif
+#if BOTAN_VERSION_CODE < BOTAN_VERSION_CODE_FOR(1,9,0)
+	unsigned int hashLength = hmac.OUTPUT_LENGTH;
+#else
+	unsigned int hashLength = hmac.output_length();
+#endif
+	hmac.set_key( (const Botan::byte *)secret.data(), secret.size() );
+
+	// every block needs the same number of iterations, so the first
+	// one only gets its share of the time
+	unsigned int blocks = (keyLength + hashLength - 1) / hashLength;
+	int msecFirst = qMax(msecInterval, 0) / blocks;
+
+	QCA::SymmetricKey out( keyLength );
+	QCA::SecureArray u( hashLength, 0 );
+	QCA::SecureArray t( hashLength, 0 );
+	Botan::byte *up = (Botan::byte *)u.data();
+	Botan::byte *tp = (Botan::byte *)t.data();
+	unsigned int iterations = 0;
+	QTime timer;
+	timer.start();
+	Botan::u32bit block = 1;
+	for (unsigned int at = 0; at < keyLength; at += hashLength, ++block) {
+	    Botan::byte index[4] = { Botan::byte(block >> 24), Botan::byte(block >> 16), Botan::byte(block >> 8), Botan::byte(block) };
+	    hmac.update( (const Botan::byte *)salt.data(), salt.size() );
+	    hmac.update( index, 4 );
+	    hmac.final( up );
+	    memcpy( tp, up, hashLength );
+
+	    // the clock is only looked at every 64 iterations
+	    unsigned int n = 1;
+	    while (block == 1 ? (n % 64 != 0 || timer.elapsed() < msecFirst) : n < iterations) {
+		hmac.update( up, hashLength );
+		hmac.final( up );
+		for (unsigned int k = 0; k < hashLength; ++k)
+		    tp[k] ^= up[k];
+		++n;
+	    }
+	    iterations = n;
+
+	    memcpy( out.data() + at, tp, qMin( hashLength, keyLength - at ) );
+	}
+
+	*iterationCount = iterations;
+	return out;
+    }
+
+protected:
+    QString m_hashName;
+};
+
+
 //-----------------------------------------------------------
 class BotanCipherContext : public QCA::CipherContext
 {
@@ -259,6 +494,33 @@ public:
 	m_algoName = algo.toStdString();
 	m_algoMode = mode.toStdString();
 	m_algoPadding = padding.toStdString();
+	m_cipher = 0;
+	m_crypter = 0;
+	m_inMessage = false;
+	m_written = false;
+	m_lost = false;
+    }
+
+    // a pipe can't be copied, so the copy builds its own from the same
+    // key and IV.  that is only right before any data was written: a
+    // copy made later would start the message over, and in the stream
+    // modes use the same keystream again, so it fails until it is set
+    // up again or given a new IV
+    BotanCipherContext( const BotanCipherContext &from ) : QCA::CipherContext(from)
+    {
+	m_dir = from.m_dir;
+	m_algoName = from.m_algoName;
+	m_algoMode = from.m_algoMode;
+	m_algoPadding = from.m_algoPadding;
+	m_key = from.m_key;
+	m_iv = from.m_iv;
+	m_cipher = 0;
+	m_crypter = 0;
+	m_inMessage = false;
+	m_written = false;
+	if (from.m_crypter)
+	    setup(m_dir, m_key, m_iv, QCA::AuthTag());
+	m_lost = from.m_written;
     }
 
     void setup(QCA::Direction dir,
@@ -269,32 +531,64 @@ public:
 	Q_UNUSED(tag);
 	try {
 	m_dir = dir;
+	m_key = key;
+	m_iv = iv;
 	Botan::SymmetricKey keyCopy((Botan::byte*)key.data(), key.size());
 
 	if (iv.size() == 0) {
 	    if (QCA::Encode == dir) {
-		m_crypter = new Botan::Pipe(Botan::get_cipher(m_algoName+'/'+m_algoMode+'/'+m_algoPadding,
-							      keyCopy, Botan::ENCRYPTION));
+		m_cipher = Botan::get_cipher(m_algoName+'/'+m_algoMode+'/'+m_algoPadding,
+					     keyCopy, Botan::ENCRYPTION);
 	    }
 	    else {
-		m_crypter = new Botan::Pipe(Botan::get_cipher(m_algoName+'/'+m_algoMode+'/'+m_algoPadding,
-							      keyCopy, Botan::DECRYPTION));
+		m_cipher = Botan::get_cipher(m_algoName+'/'+m_algoMode+'/'+m_algoPadding,
+					     keyCopy, Botan::DECRYPTION);
 	    }
 	} else {
 	    Botan::InitializationVector ivCopy((Botan::byte*)iv.data(), iv.size());
 	    if (QCA::Encode == dir) {
-		m_crypter = new Botan::Pipe(Botan::get_cipher(m_algoName+'/'+m_algoMode+'/'+m_algoPadding,
-							      keyCopy, ivCopy, Botan::ENCRYPTION));
+		m_cipher = Botan::get_cipher(m_algoName+'/'+m_algoMode+'/'+m_algoPadding,
+					     keyCopy, ivCopy, Botan::ENCRYPTION);
 	    }
 	    else {
-		m_crypter = new Botan::Pipe(Botan::get_cipher(m_algoName+'/'+m_algoMode+'/'+m_algoPadding,
-							      keyCopy, ivCopy, Botan::DECRYPTION));
+		m_cipher = Botan::get_cipher(m_algoName+'/'+m_algoMode+'/'+m_algoPadding,
+					     keyCopy, ivCopy, Botan::DECRYPTION);
 	    }
 	}
+	// the pipe owns the filter
+	delete m_crypter;
+	m_crypter = new Botan::Pipe(m_cipher);
+	m_crypter->start_msg();
+	m_inMessage = true;
+	m_written = false;
+	m_lost = false;
+	} catch (Botan::Exception& e) {
+	    std::cout << "caught: " << e.what() << std::endl;
+	}
+    }
+
+    bool setIV(const QCA::InitializationVector &iv, const QCA::AuthTag &tag)
+    {
+	Q_UNUSED(tag);
+	if (0 == m_crypter)
+	    return false;
+	try {
+	// the filter keeps its key, and the pipe reads from the new message
+	if (m_inMessage)
+	    m_crypter->end_msg();
+	if (iv.size() != 0)
+	    m_cipher->set_iv(Botan::InitializationVector((Botan::byte*)iv.data(), iv.size()));
+	m_iv = iv;
 	m_crypter->start_msg();
+	m_crypter->set_default_msg(m_crypter->message_count() - 1);
+	m_inMessage = true;
+	m_written = false;
+	m_lost = false;
 	} catch (Botan::Exception& e) {
 	    std::cout << "caught: " << e.what() << std::endl;
+	    return false;
 	}
+	return true;
     }
 
     Context *clone() const
@@ -315,6 +609,10 @@ public:
 
     bool update(const QCA::SecureArray &in, QCA::SecureArray *out)
     {
+	if (m_lost)
+	    return false;
+	if (in.size() > 0)
+	    m_written = true;
 	m_crypter->write((Botan::byte*)in.data(), in.size());
 	QCA::SecureArray result( m_crypter->remaining() );
 	// Perhaps bytes_read is redundant and can be dropped
@@ -326,7 +624,10 @@ public:
 
     bool final(QCA::SecureArray *out)
     {
+	if (m_lost)
+	    return false;
 	m_crypter->end_msg();
+	m_inMessage = false;
 	QCA::SecureArray result( m_crypter->remaining() );
 	// Perhaps bytes_read is redundant and can be dropped
 	size_t bytes_read = m_crypter->read((Botan::byte*)result.data(), result.size());
@@ -367,8 +668,13 @@ protected:
     std::string m_algoName;
     std::string m_algoMode;
     std::string m_algoPadding;
+    QCA::SymmetricKey m_key;
+    QCA::InitializationVector m_iv;
     Botan::Keyed_Filter *m_cipher;
     Botan::Pipe *m_crypter;
+    bool m_inMessage;
+    bool m_written; // data was given to the current message
+    bool m_lost;    // copied after that, see the copy constructor
 };
 
 
@@ -421,6 +727,16 @@ public:
 	list += "pbkdf1(sha1)";
 	list += "pbkdf1(md2)";
 	list += "pbkdf2(sha1)";
+	// same problem as HMAC with SHA2
+	// list += "pbkdf2(sha256)";
+	// list += "pbkdf2(sha512)";
+	list += "hkdf(md5)";
+	list += "hkdf(sha1)";
+	// same problem as HMAC with SHA2
+	// list += "hkdf(sha256)";
+	// list += "hkdf(sha384)";
+	// list += "hkdf(sha512)";
+	list += "hkdf(ripemd160)";
 	list += "aes128-ecb";
 	list += "aes128-cbc";
 	list += "aes128-cfb";
@@ -485,7 +801,23 @@ public:
 	else if ( type == "pbkdf1(md2)" )
 	    return new BotanPBKDFContext( QString("PBKDF1(MD2)"), this, type );
 	else if ( type == "pbkdf2(sha1)" )
-	    return new BotanPBKDFContext( QString("PBKDF2(SHA-1)"), this, type );
+	    return new BotanPBKDF2Context( QString("SHA-1"), this, type );
+	else if ( type == "pbkdf2(sha256)" )
+	    return new BotanPBKDF2Context( QString("SHA-256"), this, type );
+	else if ( type == "pbkdf2(sha512)" )
+	    return new BotanPBKDF2Context( QString("SHA-512"), this, type );
+	else if ( type == "hkdf(md5)" )
+	    return new BotanHKDFContext( QString("MD5"), this, type );
+	else if ( type == "hkdf(sha1)" )
+	    return new BotanHKDFContext( QString("SHA-1"), this, type );
+	else if ( type == "hkdf(sha256)" )
+	    return new BotanHKDFContext( QString("SHA-256"), this, type );
+	else if ( type == "hkdf(sha384)" )
+	    return new BotanHKDFContext( QString("SHA-384"), this, type );
+	else if ( type == "hkdf(sha512)" )
+	    return new BotanHKDFContext( QString("SHA-512"), this, type );
+	else if ( type == "hkdf(ripemd160)" )
+	    return new BotanHKDFContext( QString("RIPEMD-160"), this, type );
 	else if ( type == "aes128-ecb" )
 	    return new BotanCipherContext( QString("AES-128"), QString("ECB"), QString("NoPadding"), this, type );
 	else if ( type == "aes128-cbc" )
@@ -29,7 +29,6 @@
 
 namespace gcryptQCAPlugin {
 
-#include "pkcs5.c"
 
 void check_error( const QString &label, gcry_error_t err )
 {
@@ -76,6 +75,11 @@ public:
 	gcry_md_write( context, a.data(), a.size() );
     }
 
+    void updateView(const QCA::MemoryRegion &a)
+    {
+	update(a);
+    }
+
     QCA::MemoryRegion final()
     {
 	unsigned char *md;
@@ -91,12 +95,15 @@ protected:
     int m_hashAlgorithm;
 };
 
+// resetting an HMAC handle keeps its key, and the hash states derived
+// from it, so setup() is only needed when the key changes.
 class gcryHMACContext : public QCA::MACContext
 {
 public:
     gcryHMACContext(int hashAlgorithm, QCA::Provider *p, const QString &type) : QCA::MACContext(p, type)
     {
         m_hashAlgorithm = hashAlgorithm;
+        m_keyed = false;
         err =  gcry_md_open( &context, m_hashAlgorithm, GCRY_MD_FLAG_HMAC );
         if ( GPG_ERR_NO_ERROR != err ) {
             std::cout << "Failure: " ;
@@ -105,6 +112,18 @@ public:
         }
     }
 
+    gcryHMACContext(const gcryHMACContext &from) : QCA::MACContext(from)
+    {
+        m_hashAlgorithm = from.m_hashAlgorithm;
+        m_keyed = from.m_keyed;
+        err = gcry_md_copy( &context, from.context );
+        if ( GPG_ERR_NO_ERROR != err ) {
+            std::cout << "Failure: " ;
+            std::cout << gcry_strsource(err) << "/";
+            std::cout << gcry_strerror(err) << std::endl;
+        }
+    }
+
     ~gcryHMACContext()
     {
         gcry_md_close( context );
@@ -113,6 +132,7 @@ public:
     void setup(const QCA::SymmetricKey &key)
     {
         gcry_md_setkey( context, key.data(), key.size() );
+        m_keyed = true;
     }
 
     Context *clone() const
@@ -120,9 +140,12 @@ public:
         return new gcryHMACContext(*this);
     }
 
-    void clear()
+    bool reset()
     {
+        if ( !m_keyed )
+            return false;
         gcry_md_reset( context );
+        return true;
     }
 
     QCA::KeyLength keyLength() const
@@ -135,6 +158,11 @@ public:
         gcry_md_write( context, a.data(), a.size() );
     }
 
+    void updateView(const QCA::MemoryRegion &a)
+    {
+        update(a);
+    }
+
     void final( QCA::MemoryRegion *out)
     {
         QCA::SecureArray sa( gcry_md_get_algo_dlen( m_hashAlgorithm ), 0 );
@@ -148,9 +176,105 @@ protected:
     gcry_md_hd_t context;
     gcry_error_t err;
     int m_hashAlgorithm;
+    bool m_keyed;
 };
 
 
+// the handle is keyed with the pseudorandom key once.  resetting an HMAC
+// handle keeps its key, so each block of expand() only hashes the data.
+class gcryHKDFContext : public QCA::HKDFContext
+{
+public:
+    gcryHKDFContext(int hashAlgorithm, QCA::Provider *p, const QString &type) : QCA::HKDFContext(p, type)
+    {
+	m_hashAlgorithm = hashAlgorithm;
+	m_context = 0;
+    }
+
+    gcryHKDFContext(const gcryHKDFContext &from) : QCA::HKDFContext(from)
+    {
+	m_hashAlgorithm = from.m_hashAlgorithm;
+	m_context = 0;
+	if ( from.m_context )
+	    setPrk( from.m_prk );
+    }
+
+    ~gcryHKDFContext()
+    {
+	if ( m_context )
+	    gcry_md_close( m_context );
+    }
+
+    Context *clone() const
+    {
+	return new gcryHKDFContext( *this );
+    }
+
+    QCA::SymmetricKey extract(const QCA::SecureArray &secret, const QCA::InitializationVector &salt)
+    {
+	unsigned int hashLength = gcry_md_get_algo_dlen( m_hashAlgorithm );
+	QCA::SecureArray key = salt;
+	if ( key.isEmpty() )
+	    key = QCA::SecureArray( hashLength, 0 );
+
+	gcry_md_hd_t hmac;
+	if ( GPG_ERR_NO_ERROR != gcry_md_open( &hmac, m_hashAlgorithm, GCRY_MD_FLAG_HMAC | GCRY_MD_FLAG_SECURE ) )
+	    return QCA::SymmetricKey();
+	gcry_md_setkey( hmac, key.data(), key.size() );
+	gcry_md_write( hmac, secret.data(), secret.size() );
+	QCA::SymmetricKey prk( hashLength );
+	memcpy( prk.data(), gcry_md_read( hmac, m_hashAlgorithm ), hashLength );
+	gcry_md_close( hmac );
+
+	setPrk( prk );
+	return prk;
+    }
+
+    void setPrk(const QCA::SymmetricKey &prk)
+    {
+	if ( m_context )
+	{
+	    gcry_md_close( m_context );
+	    m_context = 0;
+	}
+	if ( GPG_ERR_NO_ERROR != gcry_md_open( &m_context, m_hashAlgorithm, GCRY_MD_FLAG_HMAC | GCRY_MD_FLAG_SECURE ) )
+	{
+	    m_context = 0;
+	    return;
+	}
+	gcry_md_setkey( m_context, prk.data(), prk.size() );
+	m_prk = prk;
+    }
+
+    QCA::SymmetricKey expand(const QCA::InitializationVector &info, unsigned int keyLength)
+    {
+	unsigned int hashLength = gcry_md_get_algo_dlen( m_hashAlgorithm );
+	if ( !m_context || keyLength > 255 * hashLength )
+	    return QCA::SymmetricKey();
+
+	QCA::SymmetricKey out( keyLength );
+	QCA::SecureArray t( hashLength, 0 );
+	unsigned int tLength = 0;
+	unsigned char counter = 1;
+	for ( unsigned int at = 0; at < keyLength; at += hashLength, ++counter )
+	{
+	    gcry_md_reset( m_context );
+	    gcry_md_write( m_context, t.data(), tLength );
+	    gcry_md_write( m_context, info.data(), info.size() );
+	    gcry_md_write( m_context, &counter, 1 );
+	    memcpy( t.data(), gcry_md_read( m_context, m_hashAlgorithm ), hashLength );
+	    tLength = hashLength;
+	    memcpy( out.data() + at, t.data(), qMin( hashLength, keyLength - at ) );
+	}
+	return out;
+    }
+
+protected:
+    gcry_md_hd_t m_context;
+    int m_hashAlgorithm;
+    QCA::SymmetricKey m_prk;
+};
+
 class gcryCipherContext : public QCA::CipherContext
 {
 public:
@@ -159,6 +283,36 @@ public:
 	m_cryptoAlgorithm = algorithm;
  	m_mode = mode;
 	m_pad = pad;
+	context = 0;
+	m_written = false;
+	m_lost = false;
+    }
+
+    gcryCipherContext(const gcryCipherContext &from) : QCA::CipherContext(from)
+    {
+	m_cryptoAlgorithm = from.m_cryptoAlgorithm;
+	m_mode = from.m_mode;
+	m_pad = from.m_pad;
+	m_direction = from.m_direction;
+	m_key = from.m_key;
+	m_iv = from.m_iv;
+	err = GPG_ERR_NO_ERROR;
+	context = 0;
+	m_written = false;
+	// gcrypt cannot duplicate a handle, so the copy opens its own and
+	// starts over from the current key and IV.  once data was given to
+	// the original, that would repeat the start of the message (and the
+	// keystream of the stream modes), so the copy fails instead until
+	// it is set up again or given a new IV
+	if ( 0 != from.context )
+	    setup( m_direction, m_key, m_iv, QCA::AuthTag() );
+	m_lost = from.m_written;
+    }
+
+    ~gcryCipherContext()
+    {
+	if ( 0 != context )
+	    gcry_cipher_close( context );
     }
 
     void setup(QCA::Direction dir,
@@ -168,6 +322,10 @@ public:
     {
 	Q_UNUSED(tag);
 	m_direction = dir;
+	m_key = key;
+	m_iv = iv;
+	if ( 0 != context )
+	    gcry_cipher_close( context );
 	err =  gcry_cipher_open( &context, m_cryptoAlgorithm, m_mode, 0 );
 	check_error( "gcry_cipher_open", err );
 	if ( ( GCRY_CIPHER_3DES == m_cryptoAlgorithm ) && (key.size() == 16) ) {
@@ -183,6 +341,28 @@ public:
 	check_error( "gcry_cipher_setkey", err );
 	err = gcry_cipher_setiv( context, iv.data(), iv.size() );
 	check_error( "gcry_cipher_setiv", err );
+	m_written = false;
+	m_lost = false;
+    }
+
+    bool setIV(const QCA::InitializationVector &iv, const QCA::AuthTag &tag)
+    {
+	Q_UNUSED(tag);
+	if ( 0 == context )
+	    return false;
+	// the key stays in the handle, only the mode is restarted
+	err = gcry_cipher_reset( context );
+	check_error( "gcry_cipher_reset", err );
+	if ( GPG_ERR_NO_ERROR != err )
+	    return false;
+	err = gcry_cipher_setiv( context, iv.data(), iv.size() );
+	check_error( "gcry_cipher_setiv", err );
+	if ( GPG_ERR_NO_ERROR != err )
+	    return false;
+	m_iv = iv;
+	m_written = false;
+	m_lost = false;
+	return true;
     }
 
     Context *clone() const
@@ -205,6 +385,10 @@ public:
 
     bool update(const QCA::SecureArray &in, QCA::SecureArray *out)
     {
+	if ( m_lost )
+	    return false;
+	if ( in.size() > 0 )
+	    m_written = true;
         QCA::SecureArray result( in.size() );
 	if (QCA::Encode == m_direction) {
 	    err = gcry_cipher_encrypt( context, (unsigned char*)result.data(), result.size(), (unsigned char*)in.data(), in.size() );
@@ -219,6 +403,8 @@ public:
 
     bool final(QCA::SecureArray *out)
     {
+	if ( m_lost )
+	    return false;
         QCA::SecureArray result;
 	if (m_pad) {
 	    result.resize( blockSize() );
@@ -266,6 +452,10 @@ protected:
     QCA::Direction m_direction;
     int m_mode;
     bool m_pad;
+    QCA::SymmetricKey m_key;
+    QCA::InitializationVector m_iv;
+    bool m_written; // data was given to the current message
+    bool m_lost;    // copied after that, see the copy constructor
 };
 
 
@@ -413,6 +603,10 @@ protected:
 };
 
 
+// PBKDF2 of RFC2898.  resetting an HMAC handle keeps its key, so the
+// password is only set up once.  a time bounded derivation runs the real
+// iterations until the time is up, instead of measuring first and
+// deriving afterwards.
 class pbkdf2Context : public QCA::KDFContext
 {
 public:
@@ -429,16 +623,7 @@ public:
     QCA::SymmetricKey makeKey(const QCA::SecureArray &secret, const QCA::InitializationVector &salt,
 			 unsigned int keyLength, unsigned int iterationCount)
     {
-	QCA::SymmetricKey result(keyLength);
-	gcry_error_t retval = gcry_pbkdf2(m_algorithm, secret.data(), secret.size(),
-					  salt.data(), salt.size(),
-				     	  iterationCount, keyLength, result.data());
-	if (retval == GPG_ERR_NO_ERROR) {
-	    return result;
-	} else {
-	    // std::cout << "got: " << retval << std::endl;
-	    return QCA::SymmetricKey();
-	}
+	return derive(secret, salt, keyLength, iterationCount, -1, 0);
     }
 
 	QCA::SymmetricKey makeKey(const QCA::SecureArray &secret,
@@ -448,28 +633,76 @@ public:
 							  unsigned int *iterationCount)
 	{
 		Q_ASSERT(iterationCount != NULL);
-		QCA::SymmetricKey result(keyLength);
-		QTime timer;
+		return derive(secret, salt, keyLength, 0, qMax(msecInterval, 0), iterationCount);
+	}
 
-		*iterationCount = 0;
-		timer.start();
+protected:
+    // if msecInterval is not negative, the iteration count is whatever
+    // fits in that time, and is stored in iterationsDone
+    QCA::SymmetricKey derive(const QCA::SecureArray &secret, const QCA::InitializationVector &salt,
+			     unsigned int keyLength, unsigned int iterationCount,
+			     int msecInterval, unsigned int *iterationsDone)
+    {
+	unsigned int hashLength = gcry_md_get_algo_dlen( m_algorithm );
+	if ( hashLength == 0 || keyLength == 0 )
+	    return QCA::SymmetricKey();
 
-		while (timer.elapsed() < msecInterval) {
-			gcry_pbkdf2(m_algorithm,
-						secret.data(),
-						secret.size(),
-						salt.data(),
-						salt.size(),
-						1,
-						keyLength,
-						result.data());
-			++(*iterationCount);
-		}
+	gcry_md_hd_t prf;
+	if ( GPG_ERR_NO_ERROR != gcry_md_open( &prf, m_algorithm, GCRY_MD_FLAG_HMAC | GCRY_MD_FLAG_SECURE ) )
+	    return QCA::SymmetricKey();
+	if ( GPG_ERR_NO_ERROR != gcry_md_setkey( prf, secret.data(), secret.size() ) ) {
+	    gcry_md_close( prf );
+	    return QCA::SymmetricKey();
+	}
+
+	// every block needs the same number of iterations, so the first
+	// one only gets its share of the time
+	unsigned int blocks = (keyLength + hashLength - 1) / hashLength;
+	int msecFirst = msecInterval / blocks;
+
+	QCA::SymmetricKey out( keyLength );
+	QCA::SecureArray u( hashLength, 0 );
+	QCA::SecureArray t( hashLength, 0 );
+	unsigned char *up = (unsigned char *)u.data();
+	unsigned char *tp = (unsigned char *)t.data();
+	QTime timer;
+	timer.start();
+	quint32 block = 1;
+	for ( unsigned int at = 0; at < keyLength; at += hashLength, ++block )
+	{
+	    unsigned char index[4] = { (unsigned char)(block >> 24), (unsigned char)(block >> 16), (unsigned char)(block >> 8), (unsigned char)block };
+	    gcry_md_reset( prf );
+	    gcry_md_write( prf, salt.data(), salt.size() );
+	    gcry_md_write( prf, index, 4 );
+	    memcpy( up, gcry_md_read( prf, m_algorithm ), hashLength );
+	    memcpy( tp, up, hashLength );
+
+	    // the clock is only looked at every 64 iterations
+	    unsigned int n = 1;
+	    while ( msecInterval >= 0 ? ( n % 64 != 0 || timer.elapsed() < msecFirst ) : n < iterationCount )
+	    {
+		gcry_md_reset( prf );
+		gcry_md_write( prf, up, hashLength );
+		memcpy( up, gcry_md_read( prf, m_algorithm ), hashLength );
+		for ( unsigned int k = 0; k < hashLength; ++k )
+		    tp[k] ^= up[k];
+		++n;
+	    }
+
+	    if ( msecInterval >= 0 )
+	    {
+		*iterationsDone = n;
+		iterationCount = n;
+		msecInterval = -1;
+	    }
 
-		return makeKey(secret, salt, keyLength, *iterationCount);
+	    memcpy( out.data() + at, tp, qMin( hashLength, keyLength - at ) );
 	}
 
-protected:
+	gcry_md_close( prf );
+	return out;
+    }
+
     int m_algorithm;
 };
 
@@ -588,6 +821,23 @@ public:
 	}
 	list += "pbkdf1(sha1)";
 	list += "pbkdf2(sha1)";
+	list += "pbkdf2(sha256)";
+	if ( ! ( NULL == gcry_check_version("1.3.0") ) ) {
+	    // same as for HMAC
+	    list += "pbkdf2(sha512)";
+	}
+	list += "hkdf(md5)";
+	list += "hkdf(sha1)";
+#ifdef GCRY_MD_SHA224
+	list += "hkdf(sha224)";
+#endif
+	list += "hkdf(sha256)";
+	if ( ! ( NULL == gcry_check_version("1.3.0") ) ) {
+	    // same as for HMAC
+	    list += "hkdf(sha384)";
+	    list += "hkdf(sha512)";
+	}
+	list += "hkdf(ripemd160)";
 	return list;
     }
 
@@ -676,6 +926,26 @@ public:
 	    return new gcryptQCAPlugin::pbkdf1Context( GCRY_MD_SHA1, this, type );
 	else if ( type == "pbkdf2(sha1)" )
 	    return new gcryptQCAPlugin::pbkdf2Context( GCRY_MD_SHA1, this, type );
+	else if ( type == "pbkdf2(sha256)" )
+	    return new gcryptQCAPlugin::pbkdf2Context( GCRY_MD_SHA256, this, type );
+	else if ( type == "pbkdf2(sha512)" )
+	    return new gcryptQCAPlugin::pbkdf2Context( GCRY_MD_SHA512, this, type );
+	else if ( type == "hkdf(md5)" )
+	    return new gcryptQCAPlugin::gcryHKDFContext( GCRY_MD_MD5, this, type );
+	else if ( type == "hkdf(sha1)" )
+	    return new gcryptQCAPlugin::gcryHKDFContext( GCRY_MD_SHA1, this, type );
+#ifdef GCRY_MD_SHA224
+	else if ( type == "hkdf(sha224)" )
+	    return new gcryptQCAPlugin::gcryHKDFContext( GCRY_MD_SHA224, this, type );
+#endif
+	else if ( type == "hkdf(sha256)" )
+	    return new gcryptQCAPlugin::gcryHKDFContext( GCRY_MD_SHA256, this, type );
+	else if ( type == "hkdf(sha384)" )
+	    return new gcryptQCAPlugin::gcryHKDFContext( GCRY_MD_SHA384, this, type );
+	else if ( type == "hkdf(sha512)" )
+	    return new gcryptQCAPlugin::gcryHKDFContext( GCRY_MD_SHA512, this, type );
+	else if ( type == "hkdf(ripemd160)" )
+	    return new gcryptQCAPlugin::gcryHKDFContext( GCRY_MD_RMD160, this, type );
 	else
 	    return 0;
     }
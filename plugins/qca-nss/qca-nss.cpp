@@ -95,6 +95,24 @@ public:
 	return new nssHashContext(*this);
     }
 
+    QByteArray saveState() const
+    {
+	int len = 0;
+	unsigned char *state = PK11_SaveContextAlloc(m_context, 0, 0, &len);
+	if (!state)
+	    return QByteArray();
+	QByteArray out((const char *)state, len);
+	PORT_ZFree(state, len);
+	return out;
+    }
+
+    bool restoreState(const QByteArray &state)
+    {
+	if (state.isEmpty())
+	    return false;
+	return PK11_RestoreContext(m_context, (unsigned char *)state.data(), state.size()) == SECSuccess;
+    }
+
     void clear()
     {
 	SECStatus s;
@@ -119,6 +137,11 @@ public:
 	PK11_DigestOp(m_context, (const unsigned char*)a.data(), a.size());
     }
 
+    void updateView(const QCA::MemoryRegion &a)
+    {
+	update(a);
+    }
+
     QCA::MemoryRegion final()
     {
 	unsigned int len = 0;
@@ -137,6 +160,9 @@ private:
 
 
 //-----------------------------------------------------------
+// the state of the context right after PK11_DigestBegin() is saved, if
+// the token allows it, and restored by reset().  otherwise a new context
+// is made from the key that was imported by setup().
 class nssHmacContext : public QCA::MACContext
 {
 public:
@@ -145,6 +171,10 @@ public:
 	NSS_NoDB_Init(".");
 
 	m_status = 0;
+	m_context = 0;
+	m_nssKey = 0;
+	m_saved = 0;
+	m_savedLen = 0;
 
 	/* Get a slot to use for the crypto operations */
 	m_slot = PK11_GetInternalKeySlot();
@@ -179,9 +209,27 @@ public:
 	}
     }
 
+    nssHmacContext(const nssHmacContext &from) : QCA::MACContext(from)
+    {
+	m_status = from.m_status;
+	m_macAlgo = from.m_macAlgo;
+	m_slot = from.m_slot ? PK11_ReferenceSlot(from.m_slot) : 0;
+	m_nssKey = from.m_nssKey ? PK11_ReferenceSymKey(from.m_nssKey) : 0;
+	m_context = from.m_context ? PK11_CloneContext(from.m_context) : 0;
+	m_saved = 0;
+	m_savedLen = 0;
+	if (from.m_saved) {
+	    m_saved = (unsigned char *)PORT_Alloc(from.m_savedLen);
+	    if (m_saved) {
+		memcpy(m_saved, from.m_saved, from.m_savedLen);
+		m_savedLen = from.m_savedLen;
+	    }
+	}
+    }
+
     ~nssHmacContext()
     {
-	PK11_DestroyContext(m_context, PR_TRUE);
+	release();
 	if (m_slot)
 	    PK11_FreeSlot(m_slot);
     }
@@ -191,25 +239,18 @@ public:
 	return new nssHmacContext(*this);
     }
 
-    void clear()
+    bool reset()
     {
-	PK11_DestroyContext(m_context, PR_TRUE);
-
-	SECItem noParams;
-	noParams.data = 0;
-	noParams.len = 0;
-
-	m_context = PK11_CreateContextBySymKey(m_macAlgo, CKA_SIGN, m_nssKey, &noParams);
-	if (! m_context) {
-	    qDebug() << "CreateContextBySymKey failed";
-	    return;
-	}
+	if (!m_nssKey)
+	    return false;
+	if (m_saved && m_context && PK11_RestoreContext(m_context, m_saved, m_savedLen) == SECSuccess)
+	    return true;
 
-	SECStatus s = PK11_DigestBegin(m_context);
-	if (s != SECSuccess) {
-	    qDebug() << "DigestBegin failed";
-	    return;
-	}
+	if (m_context)
+	    PK11_DestroyContext(m_context, PR_TRUE);
+	m_context = 0;
+	begin();
+	return true;
     }
 
     QCA::KeyLength keyLength() const
@@ -219,27 +260,22 @@ public:
 
     void setup(const QCA::SymmetricKey &key)
     {
+	release();
+
         /* turn the raw key into a SECItem */
         SECItem keyItem;
 	keyItem.data = (unsigned char*) key.data();
 	keyItem.len = key.size();
 
 	m_nssKey = PK11_ImportSymKey(m_slot, m_macAlgo, PK11_OriginUnwrap, CKA_SIGN, &keyItem, NULL);
-
-	SECItem noParams;
-	noParams.data = 0;
-	noParams.len = 0;
-
-	m_context = PK11_CreateContextBySymKey(m_macAlgo, CKA_SIGN, m_nssKey, &noParams);
-	if (! m_context) {
-	    qDebug() << "CreateContextBySymKey failed";
+	if (! m_nssKey) {
+	    qDebug() << "ImportSymKey failed";
 	    return;
 	}
 
-	SECStatus s = PK11_DigestBegin(m_context);
-	if (s != SECSuccess) {
-	    qDebug() << "DigestBegin failed";
-	    return;
+	if (begin()) {
+	    /* not all tokens can save the state of an HMAC */
+	    m_saved = PK11_SaveContextAlloc(m_context, 0, 0, &m_savedLen);
 	}
     }
 
@@ -248,6 +284,11 @@ public:
 	PK11_DigestOp(m_context, (const unsigned char*)a.data(), a.size());
     }
 
+    void updateView(const QCA::MemoryRegion &a)
+    {
+	update(a);
+    }
+
     void final( QCA::MemoryRegion *out)
     {
 	// NSS doesn't appear to be able to tell us how big the digest will
@@ -261,11 +302,47 @@ public:
     }
 
 private:
+    bool begin()
+    {
+	SECItem noParams;
+	noParams.data = 0;
+	noParams.len = 0;
+
+	m_context = PK11_CreateContextBySymKey(m_macAlgo, CKA_SIGN, m_nssKey, &noParams);
+	if (! m_context) {
+	    qDebug() << "CreateContextBySymKey failed";
+	    return false;
+	}
+
+	SECStatus s = PK11_DigestBegin(m_context);
+	if (s != SECSuccess) {
+	    qDebug() << "DigestBegin failed";
+	    return false;
+	}
+	return true;
+    }
+
+    void release()
+    {
+	if (m_context)
+	    PK11_DestroyContext(m_context, PR_TRUE);
+	if (m_nssKey)
+	    PK11_FreeSymKey(m_nssKey);
+	if (m_saved)
+	    PORT_ZFree(m_saved, m_savedLen);
+	m_context = 0;
+	m_nssKey = 0;
+	m_saved = 0;
+	m_savedLen = 0;
+    }
+
     PK11SlotInfo *m_slot;
     int m_status;
     PK11Context *m_context;
     CK_MECHANISM_TYPE m_macAlgo;
     PK11SymKey* m_nssKey;
+    unsigned char *m_saved;
+    int m_savedLen;
 };
 
 //-----------------------------------------------------------
@@ -276,6 +353,13 @@ public:
     {
 	NSS_NoDB_Init(".");
 
+	m_nssKey = 0;
+	m_slot = 0;
+	m_context = 0;
+	m_params = 0;
+	m_written = false;
+	m_lost = false;
+
 	if ( QString("aes128-ecb") == type ) {
 	    m_cipherMechanism = CKM_AES_ECB;
 	}
@@ -300,8 +384,37 @@ public:
 	}
     }
 
+    // the copy has its own context and shares the key and slot by
+    // reference.  the softoken can't save the state of a cipher, so if
+    // the context can't be cloned the copy starts a new message with the
+    // same key and IV.  once data was given to the original that would
+    // repeat the start of the message, so the copy fails instead until
+    // it is set up again or given a new IV
+    nssCipherContext( const nssCipherContext &from ) : QCA::CipherContext(from)
+    {
+	m_cipherMechanism = from.m_cipherMechanism;
+	m_direction = from.m_direction;
+	m_slot = from.m_slot ? PK11_ReferenceSlot(from.m_slot) : 0;
+	m_nssKey = from.m_nssKey ? PK11_ReferenceSymKey(from.m_nssKey) : 0;
+	m_params = from.m_params ? SECITEM_DupItem(from.m_params) : 0;
+	m_context = 0;
+	m_written = from.m_written;
+	m_lost = from.m_lost;
+	if (from.m_context) {
+	    m_context = PK11_CloneContext(from.m_context);
+	    if (! m_context) {
+		m_context = PK11_CreateContextBySymKey(m_cipherMechanism,
+						       QCA::Encode == m_direction ? CKA_ENCRYPT : CKA_DECRYPT,
+						       m_nssKey, m_params);
+		m_lost = from.m_written;
+		m_written = false;
+	    }
+	}
+    }
+
     ~nssCipherContext()
 	{
+	    release();
 	}
 
     void setup(QCA::Direction dir,
@@ -310,6 +423,10 @@ public:
                const QCA::AuthTag &tag)
     {
 	Q_UNUSED(tag);
+	release();
+	m_direction = dir;
+	m_written = false;
+	m_lost = false;
 	/* Get a slot to use for the crypto operations */
 	m_slot = PK11_GetBestSlot( m_cipherMechanism, NULL );
 	if (!m_slot)
@@ -357,6 +474,37 @@ public:
 	}
     }
 
+    bool setIV(const QCA::InitializationVector &iv, const QCA::AuthTag &tag)
+    {
+	Q_UNUSED(tag);
+	if (! m_context)
+	    return false;
+
+	/* the imported key is kept, and only the context is made again */
+	PK11_DestroyContext(m_context, PR_TRUE);
+	m_context = 0;
+	if (m_params)
+	    SECITEM_FreeItem(m_params, PR_TRUE);
+
+	SECItem ivItem;
+	ivItem.data = (unsigned char*) iv.data();
+	ivItem.len = iv.size();
+
+	m_params = PK11_ParamFromIV(m_cipherMechanism, &ivItem);
+
+	m_context = PK11_CreateContextBySymKey(m_cipherMechanism,
+					       QCA::Encode == m_direction ? CKA_ENCRYPT : CKA_DECRYPT,
+					       m_nssKey, m_params);
+
+	if (! m_context) {
+	    qDebug() << "CreateContextBySymKey failed";
+	    return false;
+	}
+	m_written = false;
+	m_lost = false;
+	return true;
+    }
+
     QCA::Provider::Context *clone() const
 	{
 	    return new nssCipherContext(*this);
@@ -375,6 +523,10 @@ public:
 
     bool update( const QCA::SecureArray &in, QCA::SecureArray *out )
 	{
+	    if (m_lost)
+		return false;
+	    if (in.size() > 0)
+		m_written = true;
 	    out->resize(in.size()+blockSize());
 	    int resultLength;
 
@@ -388,6 +540,8 @@ public:
 
     bool final( QCA::SecureArray *out )
 	{
+	    if (m_lost)
+		return false;
 	    out->resize(blockSize());
 	    unsigned int resultLength;
 
@@ -429,11 +583,30 @@ public:
 	}
 
 private:
+    void release()
+    {
+	if (m_context)
+	    PK11_DestroyContext(m_context, PR_TRUE);
+	if (m_params)
+	    SECITEM_FreeItem(m_params, PR_TRUE);
+	if (m_nssKey)
+	    PK11_FreeSymKey(m_nssKey);
+	if (m_slot)
+	    PK11_FreeSlot(m_slot);
+	m_context = 0;
+	m_params = 0;
+	m_nssKey = 0;
+	m_slot = 0;
+    }
+
     PK11SymKey* m_nssKey;
     CK_MECHANISM_TYPE m_cipherMechanism;
     PK11SlotInfo *m_slot;
     PK11Context *m_context;
     SECItem* m_params;
+    QCA::Direction m_direction;
+    bool m_written; // data was given to the current message
+    bool m_lost;    // copied after that, see the copy constructor
 };
 
 
@@ -22,11 +22,16 @@
 #include <QtCrypto>
 #include <qcaprovider.h>
 #include <QDebug>
+#include <QMutex>
+#include <QMutexLocker>
 #include <QTime>
 #include <QtPlugin>
 
 #include <openssl/evp.h>
 #include <openssl/hmac.h>
+#include <openssl/md5.h>
+#include <openssl/ripemd.h>
+#include <openssl/sha.h>
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -1024,6 +1029,11 @@ public:
 		EVP_DigestUpdate( &m_context, (unsigned char*)a.data(), a.size() );
 	}
 
+	void updateView(const MemoryRegion &a)
+	{
+		update(a);
+	}
+
 	MemoryRegion final()
 	{
 		SecureArray a( EVP_MD_size( m_algorithm ) );
@@ -1031,6 +1041,28 @@ public:
 		return a;
 	}
 
+	// the state is the digest's own context structure, as is.  it can
+	// only be restored by the same build of OpenSSL on the same kind of
+	// machine, and not with an engine in the way.  only the digests whose
+	// structure is known are supported, so that a restored state can be
+	// checked first.
+	QByteArray saveState() const
+	{
+		if ( m_context.engine || !m_context.md_data || stateSize( EVP_MD_type( m_algorithm ) ) != m_context.digest->ctx_size )
+			return QByteArray();
+		return QByteArray( (const char *)m_context.md_data, m_context.digest->ctx_size );
+	}
+
+	bool restoreState(const QByteArray &state)
+	{
+		if ( m_context.engine || !m_context.md_data || state.size() != m_context.digest->ctx_size )
+			return false;
+		if ( !validState( EVP_MD_type( m_algorithm ), state ) )
+			return false;
+		memcpy( m_context.md_data, state.constData(), state.size() );
+		return true;
+	}
+
 	Provider::Context *clone() const
 	{
 		return new opensslHashContext(*this);
@@ -1039,6 +1071,73 @@ public:
 protected:
 	const EVP_MD *m_algorithm;
 	EVP_MD_CTX m_context;
+
+private:
+	// the size of the context structure of a digest, or 0 if its state
+	// isn't supported
+	static int stateSize(int nid)
+	{
+		switch ( nid ) {
+		case NID_md5:
+			return sizeof(MD5_CTX);
+		case NID_sha1:
+			return sizeof(SHA_CTX);
+		case NID_sha224:
+		case NID_sha256:
+			return sizeof(SHA256_CTX);
+		case NID_sha384:
+		case NID_sha512:
+			return sizeof(SHA512_CTX);
+		case NID_ripemd160:
+			return sizeof(RIPEMD160_CTX);
+		default:
+			return 0;
+		}
+	}
+
+	// a state may come from a file, so the fields that the digest
+	// trusts are checked: the number of bytes waiting for a full block,
+	// and the digest length of the SHA-2 family.  the chaining values
+	// and the message length can be anything.
+	static bool validState(int nid, const QByteArray &state)
+	{
+		if ( stateSize( nid ) == 0 || state.size() != stateSize( nid ) )
+			return false;
+
+		switch ( nid ) {
+		case NID_md5: {
+			MD5_CTX c;
+			memcpy( &c, state.constData(), sizeof(c) );
+			return c.num < MD5_CBLOCK;
+		}
+		case NID_sha1: {
+			SHA_CTX c;
+			memcpy( &c, state.constData(), sizeof(c) );
+			return c.num < SHA_CBLOCK;
+		}
+		case NID_sha224:
+		case NID_sha256: {
+			SHA256_CTX c;
+			memcpy( &c, state.constData(), sizeof(c) );
+			unsigned int len = ( nid == NID_sha224 ) ? SHA224_DIGEST_LENGTH : SHA256_DIGEST_LENGTH;
+			return c.num < SHA256_CBLOCK && c.md_len == len;
+		}
+		case NID_sha384:
+		case NID_sha512: {
+			SHA512_CTX c;
+			memcpy( &c, state.constData(), sizeof(c) );
+			unsigned int len = ( nid == NID_sha384 ) ? SHA384_DIGEST_LENGTH : SHA512_DIGEST_LENGTH;
+			return c.num < SHA512_CBLOCK && c.md_len == len;
+		}
+		case NID_ripemd160: {
+			RIPEMD160_CTX c;
+			memcpy( &c, state.constData(), sizeof(c) );
+			return c.num < RIPEMD160_CBLOCK;
+		}
+		default:
+			return false;
+		}
+	}
 };
 
 
@@ -1167,11 +1266,16 @@ protected:
 	EVP_MD_CTX m_context;
 };
 
+// PBKDF2 of RFC2898, with the HMAC keyed by the password only once.  each
+//   iteration resets the context with a null key, which reuses the key
+//   schedule.  a time bounded derivation runs the real iterations until
+//   the time is up, instead of measuring first and deriving afterwards.
 class opensslPbkdf2Context : public KDFContext
 {
 public:
-	opensslPbkdf2Context(Provider *p, const QString &type) : KDFContext(p, type)
+	opensslPbkdf2Context(const EVP_MD *algorithm, Provider *p, const QString &type) : KDFContext(p, type)
 	{
+		m_algorithm = algorithm;
 	}
 
 	Provider::Context *clone() const
@@ -1182,11 +1286,7 @@ public:
 	SymmetricKey makeKey(const SecureArray &secret, const InitializationVector &salt,
 						 unsigned int keyLength, unsigned int iterationCount)
 	{
-		SecureArray out(keyLength);
-		PKCS5_PBKDF2_HMAC_SHA1( (char*)secret.data(), secret.size(),
-								(unsigned char*)salt.data(), salt.size(),
-								iterationCount, keyLength, (unsigned char*)out.data() );
-		return out;
+		return derive(secret, salt, keyLength, iterationCount, -1, 0);
 	}
 
 	SymmetricKey makeKey(const SecureArray &secret,
@@ -1196,48 +1296,121 @@ public:
 						 unsigned int *iterationCount)
 	{
 		Q_ASSERT(iterationCount != NULL);
-		QTime timer;
-		SecureArray out(keyLength);
+		return derive(secret, salt, keyLength, 0, qMax(msecInterval, 0), iterationCount);
+	}
+
+protected:
+	// if msecInterval is not negative, the iteration count is whatever
+	//   fits in that time, and is stored in iterationsDone
+	SymmetricKey derive(const SecureArray &secret, const InitializationVector &salt,
+						unsigned int keyLength, unsigned int iterationCount,
+						int msecInterval, unsigned int *iterationsDone)
+	{
+		unsigned int hashLength = EVP_MD_size( m_algorithm );
+		if ( keyLength == 0 )
+			return SymmetricKey();
+
+		HMAC_CTX context;
+		HMAC_CTX_init( &context );
+		HMAC_Init_ex( &context, secret.data(), secret.size(), m_algorithm, 0 );
+
+		// every block needs the same number of iterations, so the first
+		//   one only gets its share of the time
+		unsigned int blocks = (keyLength + hashLength - 1) / hashLength;
+		int msecFirst = msecInterval / blocks;
 
-		*iterationCount = 0;
+		SecureArray out( keyLength, 0 );
+		SecureArray u( hashLength, 0 );
+		SecureArray t( hashLength, 0 );
+		unsigned char *up = (unsigned char *)u.data();
+		unsigned char *tp = (unsigned char *)t.data();
+		QTime timer;
 		timer.start();
+		quint32 block = 1;
+		for ( unsigned int at = 0; at < keyLength; at += hashLength, ++block )
+		{
+			unsigned char index[4] = { (unsigned char)(block >> 24), (unsigned char)(block >> 16), (unsigned char)(block >> 8), (unsigned char)block };
+			HMAC_Init_ex( &context, 0, 0, 0, 0 );
+			HMAC_Update( &context, (const unsigned char *)salt.data(), salt.size() );
+			HMAC_Update( &context, index, 4 );
+			HMAC_Final( &context, up, 0 );
+			memcpy( tp, up, hashLength );
+
+			// the clock is only looked at every 64 iterations
+			unsigned int n = 1;
+			while ( msecInterval >= 0 ? ( n % 64 != 0 || timer.elapsed() < msecFirst ) : n < iterationCount )
+			{
+				HMAC_Init_ex( &context, 0, 0, 0, 0 );
+				HMAC_Update( &context, up, hashLength );
+				HMAC_Final( &context, up, 0 );
+				for ( unsigned int k = 0; k < hashLength; ++k )
+					tp[k] ^= up[k];
+				++n;
+			}
 
-		// PBKDF2 needs an iterationCount itself, unless PBKDF1.
-		// So we need to calculate first the number of iterations for
-		// That time interval, then feed the iterationCounts to PBKDF2
-		while (timer.elapsed() < msecInterval) {
-			PKCS5_PBKDF2_HMAC_SHA1((char*)secret.data(),
-								   secret.size(),
-								   (unsigned char*)salt.data(),
-								   salt.size(),
-								   1,
-								   keyLength,
-								   (unsigned char*)out.data());
-			++(*iterationCount);
-		}
+			if ( msecInterval >= 0 )
+			{
+				*iterationsDone = n;
+				iterationCount = n;
+				msecInterval = -1;
+			}
 
-		// Now we can directely call makeKey base function,
-		// as we now have the iterationCount
-		out = makeKey(secret, salt, keyLength, *iterationCount);
+			memcpy( out.data() + at, tp, qMin( hashLength, keyLength - at ) );
+		}
 
+		HMAC_CTX_cleanup( &context );
 		return out;
 	}
 
-protected:
+	const EVP_MD *m_algorithm;
 };
 
+// final() leaves the context keyed, and reset() starts over from the
+//   inner and outer hash states that HMAC_Init_ex() keeps for the key.
 class opensslHMACContext : public MACContext
 {
 public:
 	opensslHMACContext(const EVP_MD *algorithm, Provider *p, const QString &type) : MACContext(p, type)
 	{
 		m_algorithm = algorithm;
+		m_keyed = false;
 		HMAC_CTX_init( &m_context );
 	}
 
+	opensslHMACContext(const opensslHMACContext &from) : MACContext(from)
+	{
+		m_algorithm = from.m_algorithm;
+		m_keyed = false;
+		HMAC_CTX_init( &m_context );
+#if OPENSSL_VERSION_NUMBER >= 0x10000000L
+		if ( from.m_keyed && HMAC_CTX_copy( &m_context, const_cast<HMAC_CTX *>( &from.m_context ) ) )
+			m_keyed = true;
+#else
+		if ( from.m_keyed )
+			setup( from.m_key );
+#endif
+	}
+
+	~opensslHMACContext()
+	{
+		HMAC_CTX_cleanup( &m_context );
+	}
+
 	void setup(const SymmetricKey &key)
 	{
 		HMAC_Init_ex( &m_context, key.data(), key.size(), m_algorithm, 0 );
+		m_keyed = true;
+#if OPENSSL_VERSION_NUMBER < 0x10000000L
+		m_key = key;
+#endif
+	}
+
+	bool reset()
+	{
+		if ( !m_keyed )
+			return false;
+		HMAC_Init_ex( &m_context, 0, 0, 0, 0 );
+		return true;
 	}
 
 	KeyLength keyLength() const
@@ -1250,11 +1423,15 @@ public:
 		HMAC_Update( &m_context, (unsigned char *)a.data(), a.size() );
 	}
 
+	void updateView(const MemoryRegion &a)
+	{
+		update(a);
+	}
+
 	void final(MemoryRegion *out)
 	{
 		SecureArray sa( EVP_MD_size( m_algorithm ), 0 );
 		HMAC_Final(&m_context, (unsigned char *)sa.data(), 0 );
-		HMAC_CTX_cleanup(&m_context);
 		*out = sa;
 	}
 
@@ -1266,6 +1443,95 @@ public:
 protected:
 	HMAC_CTX m_context;
 	const EVP_MD *m_algorithm;
+	bool m_keyed;
+#if OPENSSL_VERSION_NUMBER < 0x10000000L
+	SymmetricKey m_key;
+#endif
+};
+
+//----------------------------------------------------------------------------
+// opensslHKDFContext
+//----------------------------------------------------------------------------
+// the HMAC context is keyed with the pseudorandom key once.  each block of
+//   expand() then resets it with a null key, which reuses the key schedule.
+class opensslHKDFContext : public HKDFContext
+{
+public:
+	opensslHKDFContext(const EVP_MD *algorithm, Provider *p, const QString &type) : HKDFContext(p, type)
+	{
+		m_algorithm = algorithm;
+		m_keyed = false;
+		HMAC_CTX_init( &m_context );
+	}
+
+	opensslHKDFContext(const opensslHKDFContext &from) : HKDFContext(from)
+	{
+		m_algorithm = from.m_algorithm;
+		m_keyed = false;
+		HMAC_CTX_init( &m_context );
+		if ( from.m_keyed )
+			setPrk( from.m_prk );
+	}
+
+	~opensslHKDFContext()
+	{
+		HMAC_CTX_cleanup( &m_context );
+	}
+
+	Provider::Context *clone() const
+	{
+		return new opensslHKDFContext( *this );
+	}
+
+	SymmetricKey extract(const SecureArray &secret, const InitializationVector &salt)
+	{
+		SecureArray key = salt;
+		if ( key.isEmpty() )
+			key = SecureArray( EVP_MD_size( m_algorithm ), 0 );
+
+		SecureArray prk( EVP_MD_size( m_algorithm ), 0 );
+		HMAC( m_algorithm, key.data(), key.size(),
+			  (const unsigned char *)secret.data(), secret.size(),
+			  (unsigned char *)prk.data(), 0 );
+		setPrk( prk );
+		return prk;
+	}
+
+	void setPrk(const SymmetricKey &prk)
+	{
+		m_prk = prk;
+		HMAC_Init_ex( &m_context, prk.data(), prk.size(), m_algorithm, 0 );
+		m_keyed = true;
+	}
+
+	SymmetricKey expand(const InitializationVector &info, unsigned int keyLength)
+	{
+		unsigned int hashLength = EVP_MD_size( m_algorithm );
+		if ( !m_keyed || keyLength > 255 * hashLength )
+			return SymmetricKey();
+
+		SecureArray out( keyLength, 0 );
+		SecureArray t( hashLength, 0 );
+		unsigned int tLength = 0;
+		unsigned char counter = 1;
+		for ( unsigned int at = 0; at < keyLength; at += hashLength, ++counter )
+		{
+			HMAC_Init_ex( &m_context, 0, 0, 0, 0 );
+			HMAC_Update( &m_context, (const unsigned char *)t.data(), tLength );
+			HMAC_Update( &m_context, (const unsigned char *)info.data(), info.size() );
+			HMAC_Update( &m_context, &counter, 1 );
+			HMAC_Final( &m_context, (unsigned char *)t.data(), 0 );
+			tLength = hashLength;
+			memcpy( out.data() + at, t.data(), qMin( hashLength, keyLength - at ) );
+		}
+		return out;
+	}
+
+protected:
+	HMAC_CTX m_context;
+	const EVP_MD *m_algorithm;
+	SymmetricKey m_prk;
+	bool m_keyed;
 };
 
 //----------------------------------------------------------------------------
@@ -1283,11 +1549,17 @@ public:
 	bool raw_type;
 	SecureArray raw;
 
+	// the digest context is set up once and kept for the lifetime of
+	//   the key.  each startSign/startVerify only re-runs the digest
+	//   init, which reuses the existing digest state when the algorithm
+	//   has not changed, so repeated signatures with the same key do not
+	//   allocate (or leak) anything.
 	EVPKey()
 	{
 		pkey = 0;
 		raw_type = false;
 		state = Idle;
+		EVP_MD_CTX_init(&mdctx);
 	}
 
 	EVPKey(const EVPKey &from)
@@ -1296,11 +1568,13 @@ public:
 		CRYPTO_add(&pkey->references, 1, CRYPTO_LOCK_EVP_PKEY);
 		raw_type = false;
 		state = Idle;
+		EVP_MD_CTX_init(&mdctx);
 	}
 
 	~EVPKey()
 	{
 		reset();
+		EVP_MD_CTX_cleanup(&mdctx);
 	}
 
 	void reset()
@@ -1323,7 +1597,6 @@ public:
 		else
 		{
 			raw_type = false;
-			EVP_MD_CTX_init(&mdctx);
 			if(!EVP_SignInit_ex(&mdctx, type, NULL))
 				state = SignError;
 		}
@@ -1340,7 +1613,6 @@ public:
 		else
 		{
 			raw_type = false;
-			EVP_MD_CTX_init(&mdctx);
 			if(!EVP_VerifyInit_ex(&mdctx, type, NULL))
 				state = VerifyError;
 		}
@@ -1578,7 +1850,7 @@ static bool get_dlgroup(const BigInteger &p, const BigInteger &g, DLParams *para
 	return true;
 }
 
-class DLGroupMaker : public QThread
+class DLGroupMaker : public ThreadPoolJob
 {
 	Q_OBJECT
 public:
@@ -1700,8 +1972,8 @@ public:
 		}
 		else
 		{
-			connect(gm, SIGNAL(finished()), SLOT(gm_finished()));
-			gm->start();
+			connect(gm, SIGNAL(finished()), SLOT(gm_finished()), Qt::QueuedConnection);
+			gm->start(ThreadPool::LowPriority);
 		}
 	}
 
@@ -1736,14 +2008,14 @@ private slots:
 //----------------------------------------------------------------------------
 // RSAKey
 //----------------------------------------------------------------------------
-class RSAKeyMaker : public QThread
+class RSAKeyMaker : public ThreadPoolJob
 {
 	Q_OBJECT
 public:
 	RSA *result;
 	int bits, exp;
 
-	RSAKeyMaker(int _bits, int _exp, QObject *parent = 0) : QThread(parent), result(0), bits(_bits), exp(_exp)
+	RSAKeyMaker(int _bits, int _exp, QObject *parent = 0) : ThreadPoolJob(parent), result(0), bits(_bits), exp(_exp)
 	{
 	}
 
@@ -2012,8 +2284,8 @@ public:
 		}
 		else
 		{
-			connect(keymaker, SIGNAL(finished()), SLOT(km_finished()));
-			keymaker->start();
+			connect(keymaker, SIGNAL(finished()), SLOT(km_finished()), Qt::QueuedConnection);
+			keymaker->start(ThreadPool::LowPriority);
 		}
 	}
 
@@ -2114,14 +2386,14 @@ private slots:
 //----------------------------------------------------------------------------
 // DSAKey
 //----------------------------------------------------------------------------
-class DSAKeyMaker : public QThread
+class DSAKeyMaker : public ThreadPoolJob
 {
 	Q_OBJECT
 public:
 	DLGroup domain;
 	DSA *result;
 
-	DSAKeyMaker(const DLGroup &_domain, QObject *parent = 0) : QThread(parent), domain(_domain), result(0)
+	DSAKeyMaker(const DLGroup &_domain, QObject *parent = 0) : ThreadPoolJob(parent), domain(_domain), result(0)
 	{
 	}
 
@@ -2296,8 +2568,8 @@ public:
 		}
 		else
 		{
-			connect(keymaker, SIGNAL(finished()), SLOT(km_finished()));
-			keymaker->start();
+			connect(keymaker, SIGNAL(finished()), SLOT(km_finished()), Qt::QueuedConnection);
+			keymaker->start(ThreadPool::LowPriority);
 		}
 	}
 
@@ -2384,14 +2656,14 @@ private slots:
 //----------------------------------------------------------------------------
 // DHKey
 //----------------------------------------------------------------------------
-class DHKeyMaker : public QThread
+class DHKeyMaker : public ThreadPoolJob
 {
 	Q_OBJECT
 public:
 	DLGroup domain;
 	DH *result;
 
-	DHKeyMaker(const DLGroup &_domain, QObject *parent = 0) : QThread(parent), domain(_domain), result(0)
+	DHKeyMaker(const DLGroup &_domain, QObject *parent = 0) : ThreadPoolJob(parent), domain(_domain), result(0)
 	{
 	}
 
@@ -2522,8 +2794,8 @@ public:
 		}
 		else
 		{
-			connect(keymaker, SIGNAL(finished()), SLOT(km_finished()));
-			keymaker->start();
+			connect(keymaker, SIGNAL(finished()), SLOT(km_finished()), Qt::QueuedConnection);
+			keymaker->start(ThreadPool::LowPriority);
 		}
 	}
 
@@ -6113,6 +6385,14 @@ public:
 	CertificateCollection untrustedCerts;
 	QList<SecureMessageKey> privateKeys;
 
+	// last foreign private key converted for signing, and the result.
+	//   holding the original keeps its context pointer valid for the
+	//   comparison.  messages sign from their own threads, so the pair
+	//   is only touched with convertMutex held.
+	PrivateKey convertedFrom;
+	PrivateKey converted;
+	QMutex convertMutex;
+
 	CMSContext(Provider *p) : SMSContext(p, "cms")
 	{
 	}
@@ -6142,6 +6422,37 @@ public:
 	}
 
 	virtual MessageContext *createMessage();
+
+	// return a key usable by this provider.  keys from other providers
+	//   are wrapped once and the wrapper is reused for as long as the
+	//   same key is used for signing.
+	PrivateKey nativeKey(const PrivateKey &key)
+	{
+		const PKeyContext *kc = static_cast<const PKeyContext *>(key.context());
+		if(kc->sameProvider(this))
+			return key;
+
+		QMutexLocker locker(&convertMutex);
+		if(!converted.isNull() && convertedFrom.context() == key.context())
+			return converted;
+
+		//fprintf(stderr, "experimental: private key supplied by a different provider\n");
+
+		// make a pkey pointing to the existing private key
+		EVP_PKEY *pkey;
+		pkey = EVP_PKEY_new();
+		EVP_PKEY_assign_RSA(pkey, createFromExisting(key.toRSA()));
+
+		// make a new private key object to hold it
+		MyPKeyContext *pk = new MyPKeyContext(provider());
+		PKeyBase *k = pk->pkeyToBase(pkey, true); // does an EVP_PKEY_free()
+		pk->k = k;
+
+		convertedFrom = key;
+		converted = PrivateKey();
+		converted.change(pk);
+		return converted;
+	}
 };
 
 STACK_OF(X509) *get_pk7_certs(PKCS7 *p7)
@@ -6155,68 +6466,94 @@ STACK_OF(X509) *get_pk7_certs(PKCS7 *p7)
 		return 0;
 }
 
-class MyMessageContextThread : public QThread
+// the signature is computed while the data streams through; only the
+//   final private key operation and the output encoding are left for
+//   this thread.
+class MyMessageContextThread : public ThreadPoolJob
 {
 	Q_OBJECT
 public:
 	SecureMessage::Format format;
 	SecureMessage::SignMode signMode;
-	Certificate cert;
-	PrivateKey key;
-	STACK_OF(X509) *other_certs;
-	BIO *bi;
-	int flags;
+	PrivateKey key; // keeps the signing key alive
 	PKCS7 *p7;
+	BIO *sbio; // input chain
+	BIO *obio; // collected output
+	BIO *b64;  // base64 filter in front of obio, for Ascii
 	bool ok;
 	QByteArray out, sig;
 
-	MyMessageContextThread(QObject *parent = 0) : QThread(parent), ok(false)
+	MyMessageContextThread(QObject *parent = 0) : ThreadPoolJob(parent), p7(0), sbio(0), obio(0), b64(0), ok(false)
+	{
+	}
+
+	~MyMessageContextThread()
 	{
+		wait();
+		if(p7)
+			PKCS7_free(p7);
 	}
 
 protected:
 	virtual void run()
 	{
-		MyCertContext *cc = static_cast<MyCertContext *>(cert.context());
-		MyPKeyContext *kc = static_cast<MyPKeyContext *>(key.context());
-		X509 *cx = cc->item.cert;
-		EVP_PKEY *kx = kc->get_pkey();
-
-		p7 = PKCS7_sign(cx, kx, other_certs, bi, flags);
-
-		BIO_free(bi);
-		sk_X509_pop_free(other_certs, X509_free);
-
-		if(p7)
+		if(SecureMessage::Detached == signMode)
 		{
-			//printf("good\n");
-			BIO *bo;
-
-			//BIO *bo = BIO_new(BIO_s_mem());
-			//i2d_PKCS7_bio(bo, p7);
-			//PEM_write_bio_PKCS7(bo, p7);
-			//SecureArray buf = bio2buf(bo);
-			//printf("[%s]\n", buf.data());
-
-			bo = BIO_new(BIO_s_mem());
-			if(format == SecureMessage::Binary)
-				i2d_PKCS7_bio(bo, p7);
-			else // Ascii
-				PEM_write_bio_PKCS7(bo, p7);
+			// the content went into a null sink, only the digests
+			//   were kept
+			ok = PKCS7_dataFinal(p7, sbio);
+			BIO_free_all(sbio);
+			sbio = 0;
 
-			if (SecureMessage::Detached == signMode)
+			if(ok)
+			{
+				BIO *bo = BIO_new(BIO_s_mem());
+				if(format == SecureMessage::Binary)
+					i2d_PKCS7_bio(bo, p7);
+				else // Ascii
+					PEM_write_bio_PKCS7(bo, p7);
 				sig = bio2ba(bo);
-			else
-				out = bio2ba(bo);
-
-			ok = true;
+			}
 		}
 		else
+		{
+			// flushing the streaming bio signs and writes the
+			//   trailing part of the structure
+			ok = (BIO_flush(sbio) > 0);
+			out = finishStream(sbio, obio, b64);
+			sbio = 0;
+			b64 = 0;
+		}
+		obio = 0;
+
+		if(!ok)
 		{
 			printf("bad here\n");
 			ERR_print_errors_fp(stdout);
 		}
 	}
+
+public:
+	// frees the chain set up by BIO_new_PKCS7, and returns whatever
+	//   output is left.  obio is freed too.
+	static QByteArray finishStream(BIO *sbio, BIO *obio, BIO *b64)
+	{
+		BIO *target = b64 ? b64 : obio;
+		while(sbio != target)
+		{
+			BIO *next = BIO_pop(sbio);
+			BIO_free(sbio);
+			sbio = next;
+		}
+		if(b64)
+		{
+			BIO_flush(b64);
+			BIO_pop(b64);
+			BIO_free(b64);
+			BIO_puts(obio, "-----END PKCS7-----\n");
+		}
+		return bio2ba(obio);
+	}
 };
 
 class MyMessageContext : public MessageContext
@@ -6233,6 +6570,7 @@ public:
 
 	Operation op;
 	bool _finished;
+	bool failed; // the operation could not be carried out
 
 	QByteArray in, out;
 	QByteArray sig;
@@ -6243,6 +6581,14 @@ public:
 
 	MyMessageContextThread *thread;
 
+	// streaming state.  when sbio is set, update() feeds the data
+	//   straight into it instead of collecting it in 'in'.
+	PrivateKey signKey;
+	PKCS7 *sp7;
+	BIO *sbio;
+	BIO *obio;
+	BIO *b64;
+
 	MyMessageContext(CMSContext *_cms, Provider *p) : MessageContext(p, "cmsmsg")
 	{
 		cms = _cms;
@@ -6252,10 +6598,18 @@ public:
 		ver_ret = 0;
 
 		thread = 0;
+
+		failed = false;
+
+		sp7 = 0;
+		sbio = 0;
+		obio = 0;
+		b64 = 0;
 	}
 
 	~MyMessageContext()
 	{
+		resetStream();
 	}
 
 	virtual Provider::Context *clone() const
@@ -6300,6 +6654,7 @@ public:
 	{
 		format = f;
 		_finished = false;
+		failed = false;
 
 		// TODO: other operations
 		//if(op == Sign)
@@ -6310,18 +6665,41 @@ public:
 		//{
 		//	this->op = op;
 		//}
+
+		resetStream();
+		if(op == Sign)
+			startSign();
+		else if(op == Encrypt)
+			startEncrypt();
+		else if(op == Verify && !sig.isEmpty())
+			startDetachedVerify();
 	}
 
 	virtual void update(const QByteArray &in)
 	{
-		this->in.append(in);
+		if(sbio)
+		{
+			if(BIO_write(sbio, in.data(), in.size()) != in.size())
+			{
+				// the stream can't be continued, end() reports it
+				failed = true;
+				resetStream();
+			}
+			// pass on whatever output is ready so far
+			else if(obio)
+				out += takeOutput(obio);
+		}
+		else if(!failed)
+			this->in.append(in);
 		total += in.size();
 		QMetaObject::invokeMethod(this, "updated", Qt::QueuedConnection);
 	}
 
 	virtual QByteArray read()
 	{
-		return out;
+		QByteArray a = out;
+		out.clear();
+		return a;
 	}
 
 	virtual int written()
@@ -6338,156 +6716,83 @@ public:
 		// sign
 		if(op == Sign)
 		{
-			CertificateChain chain = signer.x509CertificateChain();
-			Certificate cert = chain.primary();
-			QList<Certificate> nonroots;
-			if(chain.count() > 1)
-			{
-				for(int n = 1; n < chain.count(); ++n)
-					nonroots.append(chain[n]);
-			}
-			PrivateKey key = signer.x509PrivateKey();
-
-			const PKeyContext *tmp_kc = static_cast<const PKeyContext *>(key.context());
-
-			if(!tmp_kc->sameProvider(this))
-			{
-				//fprintf(stderr, "experimental: private key supplied by a different provider\n");
-
-				// make a pkey pointing to the existing private key
-				EVP_PKEY *pkey;
-				pkey = EVP_PKEY_new();
-				EVP_PKEY_assign_RSA(pkey, createFromExisting(key.toRSA()));
-
-				// make a new private key object to hold it
-				MyPKeyContext *pk = new MyPKeyContext(provider());
-				PKeyBase *k = pk->pkeyToBase(pkey, true); // does an EVP_PKEY_free()
-				pk->k = k;
-				key.change(pk);
-			}
-
-			// allow different cert provider.  this is just a
-			//   quick hack, enough to please qca-test
-			if(!cert.context()->sameProvider(this))
-			{
-				//fprintf(stderr, "experimental: cert supplied by a different provider\n");
-				cert = Certificate::fromDER(cert.toDER());
-				if(cert.isNull() || !cert.context()->sameProvider(this))
-				{
-					//fprintf(stderr, "error converting cert\n");
-				}
-			}
-
-			//MyCertContext *cc = static_cast<MyCertContext *>(cert.context());
-			//MyPKeyContext *kc = static_cast<MyPKeyContext *>(key.context());
-
-			//X509 *cx = cc->item.cert;
-			//EVP_PKEY *kx = kc->get_pkey();
-
-			STACK_OF(X509) *other_certs;
-			BIO *bi;
-			int flags;
-			//PKCS7 *p7;
-
-			// nonroots
-			other_certs = sk_X509_new_null();
-			for(int n = 0; n < nonroots.count(); ++n)
+			// setting up the stream in start() failed, or a write
+			if(!sbio)
 			{
-				X509 *x = static_cast<MyCertContext *>(nonroots[n].context())->item.cert;
-				CRYPTO_add(&x->references, 1, CRYPTO_LOCK_X509);
-				sk_X509_push(other_certs, x);
-			}
-
-			//printf("bundling %d other_certs\n", sk_X509_num(other_certs));
-
-			bi = BIO_new(BIO_s_mem());
-			BIO_write(bi, in.data(), in.size());
-
-			flags = 0;
-			flags |= PKCS7_BINARY;
-			if (SecureMessage::Detached == signMode) {
-				flags |= PKCS7_DETACHED;
+				failed = true;
+				QMetaObject::invokeMethod(this, "updated", Qt::QueuedConnection);
+				return;
 			}
-			if (false == bundleSigner)
-				flags |= PKCS7_NOCERTS;
 
 			if(thread)
 				delete thread;
 			thread = new MyMessageContextThread(this);
 			thread->format = format;
 			thread->signMode = signMode;
-			thread->cert = cert;
-			thread->key = key;
-			thread->other_certs = other_certs;
-			thread->bi = bi;
-			thread->flags = flags;
-			connect(thread, SIGNAL(finished()), SLOT(thread_finished()));
+			thread->key = signKey;
+			thread->p7 = sp7;
+			thread->sbio = sbio;
+			thread->obio = obio;
+			thread->b64 = b64;
+			sp7 = 0;
+			sbio = 0;
+			obio = 0;
+			b64 = 0;
+			// queued, since waitForFinished() may end up running the
+			//   job in this thread
+			connect(thread, SIGNAL(finished()), SLOT(thread_finished()), Qt::QueuedConnection);
 			thread->start();
 		}
 		else if(op == Encrypt)
 		{
-			// TODO: support multiple recipients
-			Certificate target = to.first().x509CertificateChain().primary();
-
-			STACK_OF(X509) *other_certs;
-			BIO *bi;
-			int flags;
-			PKCS7 *p7;
-
-			other_certs = sk_X509_new_null();
-			X509 *x = static_cast<MyCertContext *>(target.context())->item.cert;
-			CRYPTO_add(&x->references, 1, CRYPTO_LOCK_X509);
-			sk_X509_push(other_certs, x);
-
-			bi = BIO_new(BIO_s_mem());
-			BIO_write(bi, in.data(), in.size());
-
-			flags = 0;
-			flags |= PKCS7_BINARY;
-			p7 = PKCS7_encrypt(other_certs, bi, EVP_des_ede3_cbc(), flags); // TODO: cipher?
-
-			BIO_free(bi);
-			sk_X509_pop_free(other_certs, X509_free);
-
-			QString env;
-			if(p7)
-			{
-				// FIXME: format
-				BIO *bo = BIO_new(BIO_s_mem());
-				i2d_PKCS7_bio(bo, p7);
-				//PEM_write_bio_PKCS7(bo, p7);
-				out = bio2ba(bo);
-				PKCS7_free(p7);
-			}
-			else
+			if(!sbio)
 			{
-				printf("bad\n");
+				failed = true;
+				QMetaObject::invokeMethod(this, "updated", Qt::QueuedConnection);
 				return;
 			}
+
+			bool ok = (BIO_flush(sbio) > 0);
+			out += MyMessageContextThread::finishStream(sbio, obio, b64);
+			sbio = 0;
+			obio = 0;
+			b64 = 0;
+			PKCS7_free(sp7);
+			sp7 = 0;
+
+			if(!ok)
+				failed = true;
+
+			QMetaObject::invokeMethod(this, "updated", Qt::QueuedConnection);
 		}
 		else if(op == Verify)
 		{
 			// TODO: support non-detached sigs
 
 			BIO *out = BIO_new(BIO_s_mem());
-			BIO *bi = BIO_new(BIO_s_mem());
-			if (false == sig.isEmpty()) {
-				// We have detached signature
-				BIO_write(bi, sig.data(), sig.size());
-			} else {
+			PKCS7 *p7;
+			if(sp7)
+			{
+				// detached signature, parsed in start()
+				p7 = sp7;
+				sp7 = 0;
+			}
+			else
+			{
+				BIO *bi = BIO_new(BIO_s_mem());
 				BIO_write(bi, in.data(), in.size());
+				if(format == SecureMessage::Binary)
+					p7 = d2i_PKCS7_bio(bi, NULL);
+				else // Ascii
+					p7 = PEM_read_bio_PKCS7(bi, NULL, passphrase_cb, NULL);
+				BIO_free(bi);
 			}
-			PKCS7 *p7;
-			if(format == SecureMessage::Binary)
-				p7 = d2i_PKCS7_bio(bi, NULL);
-			else // Ascii
-				p7 = PEM_read_bio_PKCS7(bi, NULL, passphrase_cb, NULL);
-			BIO_free(bi);
 
 			if(!p7)
 			{
 				// TODO
 				printf("bad1\n");
+				BIO_free(out);
 				QMetaObject::invokeMethod(this, "updated", Qt::QueuedConnection);
 				return;
 			}
@@ -6540,6 +6845,10 @@ public:
 			//   or via cms->untrustedCerts
 			if(signers.isEmpty())
 			{
+				sk_X509_pop_free(other_certs, X509_free);
+				PKCS7_free(p7);
+				BIO_free(out);
+				resetStream();
 				QMetaObject::invokeMethod(this, "updated", Qt::QueuedConnection);
 				return;
 			}
@@ -6582,12 +6891,12 @@ public:
 			}
 
 			int ret;
-			if(!sig.isEmpty()) {
-				// Detached signMode
-				bi = BIO_new(BIO_s_mem());
-				BIO_write(bi, in.data(), in.size());
-				ret = PKCS7_verify(p7, other_certs, store, bi, NULL, 0);
-				BIO_free(bi);
+			if(sbio) {
+				// Detached signMode, the content has already been
+				//   digested by update()
+				ret = verifyStreamed(p7, other_certs, store, sbio);
+				BIO_free_all(sbio);
+				sbio = 0;
 			} else {
 				ret = PKCS7_verify(p7, other_certs, store, NULL, out, 0);
 				// qDebug() << "Verify: " << ret;
@@ -6597,6 +6906,7 @@ public:
 			sk_X509_pop_free(other_certs, X509_free);
 			X509_STORE_free(store);
 			PKCS7_free(p7);
+			BIO_free(out);
 
 			ver_ret = ret;
 			// TODO
@@ -6634,7 +6944,10 @@ public:
 				int ret = PKCS7_decrypt(p7, kx, cx, bo, 0);
 				PKCS7_free(p7);
 				if(!ret)
+				{
+					BIO_free(bo);
 					continue;
+				}
 
 				ok = true;
 				out = bio2ba(bo);
@@ -6670,8 +6983,7 @@ public:
 
 	virtual bool success() const
 	{
-		// TODO
-		return true;
+		return !failed;
 	}
 
 	virtual SecureMessage::Error errorCode() const
@@ -6726,8 +7038,212 @@ public:
 
 	void getresults()
 	{
+		// the job hands over its results only once
 		sig = thread->sig;
-		out = thread->out;
+		out += thread->out;
+		thread->out.clear();
+		if(!thread->ok)
+			failed = true;
+	}
+
+private:
+	// drain a memory bio without freeing it
+	static QByteArray takeOutput(BIO *b)
+	{
+		char *p;
+		long len = BIO_get_mem_data(b, &p);
+		if(len <= 0)
+			return QByteArray();
+		QByteArray a(p, len);
+		BIO_reset(b);
+		return a;
+	}
+
+	void resetStream()
+	{
+		if(sbio)
+		{
+			if(op == Verify || (op == Sign && SecureMessage::Detached == signMode))
+				BIO_free_all(sbio);
+			else
+				MyMessageContextThread::finishStream(sbio, obio, b64);
+		}
+		else if(obio)
+			BIO_free(obio);
+		if(sp7)
+			PKCS7_free(sp7);
+		sp7 = 0;
+		sbio = 0;
+		obio = 0;
+		b64 = 0;
+		signKey = PrivateKey();
+	}
+
+	// output bio for the streaming encoder, with PEM armour for Ascii
+	BIO *makeOutput(bool ascii)
+	{
+		obio = BIO_new(BIO_s_mem());
+		if(!ascii)
+			return obio;
+		BIO_puts(obio, "-----BEGIN PKCS7-----\n");
+		b64 = BIO_new(BIO_f_base64());
+		return BIO_push(b64, obio);
+	}
+
+	void startSign()
+	{
+		CertificateChain chain = signer.x509CertificateChain();
+		Certificate cert = chain.primary();
+		QList<Certificate> nonroots;
+		if(chain.count() > 1)
+		{
+			for(int n = 1; n < chain.count(); ++n)
+				nonroots.append(chain[n]);
+		}
+		signKey = cms->nativeKey(signer.x509PrivateKey());
+
+		// allow different cert provider.  this is just a
+		//   quick hack, enough to please qca-test
+		if(!cert.context()->sameProvider(this))
+		{
+			//fprintf(stderr, "experimental: cert supplied by a different provider\n");
+			cert = Certificate::fromDER(cert.toDER());
+			if(cert.isNull() || !cert.context()->sameProvider(this))
+			{
+				//fprintf(stderr, "error converting cert\n");
+				failed = true;
+				QMetaObject::invokeMethod(this, "updated", Qt::QueuedConnection);
+				return;
+			}
+		}
+
+		MyCertContext *cc = static_cast<MyCertContext *>(cert.context());
+		MyPKeyContext *kc = static_cast<MyPKeyContext *>(signKey.context());
+		X509 *cx = cc->item.cert;
+		EVP_PKEY *kx = kc->get_pkey();
+
+		// nonroots
+		STACK_OF(X509) *other_certs = sk_X509_new_null();
+		for(int n = 0; n < nonroots.count(); ++n)
+		{
+			X509 *x = static_cast<MyCertContext *>(nonroots[n].context())->item.cert;
+			CRYPTO_add(&x->references, 1, CRYPTO_LOCK_X509);
+			sk_X509_push(other_certs, x);
+		}
+
+		//printf("bundling %d other_certs\n", sk_X509_num(other_certs));
+
+		// with PKCS7_STREAM, the structure is only prepared here and
+		//   the signature is made once all data has been written
+		int flags = 0;
+		flags |= PKCS7_BINARY;
+		flags |= PKCS7_STREAM;
+		if (SecureMessage::Detached == signMode) {
+			flags |= PKCS7_DETACHED;
+		}
+		if (false == bundleSigner)
+			flags |= PKCS7_NOCERTS;
+
+		sp7 = PKCS7_sign(cx, kx, other_certs, NULL, flags);
+		sk_X509_pop_free(other_certs, X509_free);
+		if(!sp7)
+		{
+			failed = true;
+			QMetaObject::invokeMethod(this, "updated", Qt::QueuedConnection);
+			return;
+		}
+
+		if (SecureMessage::Detached == signMode)
+		{
+			// only digest the content, it is not part of the output
+			sbio = PKCS7_dataInit(sp7, NULL);
+		}
+		else
+		{
+			BIO *target = makeOutput(format == SecureMessage::Ascii);
+			sbio = BIO_new_PKCS7(target, sp7);
+		}
+		if(!sbio)
+			resetStream();
+	}
+
+	void startEncrypt()
+	{
+		// TODO: support multiple recipients
+		Certificate target = to.first().x509CertificateChain().primary();
+
+		STACK_OF(X509) *other_certs = sk_X509_new_null();
+		X509 *x = static_cast<MyCertContext *>(target.context())->item.cert;
+		CRYPTO_add(&x->references, 1, CRYPTO_LOCK_X509);
+		sk_X509_push(other_certs, x);
+
+		int flags = 0;
+		flags |= PKCS7_BINARY;
+		flags |= PKCS7_STREAM;
+		sp7 = PKCS7_encrypt(other_certs, NULL, EVP_des_ede3_cbc(), flags); // TODO: cipher?
+		sk_X509_pop_free(other_certs, X509_free);
+		if(!sp7)
+			return;
+
+		// FIXME: format
+		sbio = BIO_new_PKCS7(makeOutput(false), sp7);
+		if(!sbio)
+			resetStream();
+	}
+
+	void startDetachedVerify()
+	{
+		BIO *bi = BIO_new(BIO_s_mem());
+		BIO_write(bi, sig.data(), sig.size());
+		if(format == SecureMessage::Binary)
+			sp7 = d2i_PKCS7_bio(bi, NULL);
+		else // Ascii
+			sp7 = PEM_read_bio_PKCS7(bi, NULL, passphrase_cb, NULL);
+		BIO_free(bi);
+
+		// anything unexpected is left for end() to report
+		if(!sp7 || !PKCS7_type_is_signed(sp7) || !PKCS7_is_detached(sp7))
+			return;
+
+		// digest bios for every algorithm used by the signers, in
+		//   front of a null sink
+		sbio = PKCS7_dataInit(sp7, NULL);
+	}
+
+	// the checks PKCS7_verify() makes, with the content digests already
+	//   computed in sbio
+	static int verifyStreamed(PKCS7 *p7, STACK_OF(X509) *other_certs, X509_STORE *store, BIO *sbio)
+	{
+		STACK_OF(X509) *xs = PKCS7_get0_signers(p7, other_certs, 0);
+		if(!xs)
+			return 0;
+
+		int ret = 1;
+		for(int n = 0; n < sk_X509_num(xs) && ret; ++n)
+		{
+			X509_STORE_CTX ctx;
+			if(!X509_STORE_CTX_init(&ctx, store, sk_X509_value(xs, n), p7->d.sign->cert))
+			{
+				ret = 0;
+				break;
+			}
+			X509_STORE_CTX_set_default(&ctx, "smime_sign");
+			X509_STORE_CTX_set0_crls(&ctx, p7->d.sign->crl);
+			if(X509_verify_cert(&ctx) <= 0)
+				ret = 0;
+			X509_STORE_CTX_cleanup(&ctx);
+		}
+
+		STACK_OF(PKCS7_SIGNER_INFO) *sinfos = PKCS7_get_signer_info(p7);
+		for(int n = 0; ret && n < sk_PKCS7_SIGNER_INFO_num(sinfos); ++n)
+		{
+			PKCS7_SIGNER_INFO *si = sk_PKCS7_SIGNER_INFO_value(sinfos, n);
+			if(PKCS7_signatureVerify(sbio, p7, si, sk_X509_value(xs, n)) <= 0)
+				ret = 0;
+		}
+
+		sk_X509_free(xs);
+		return ret;
 	}
 
 private slots:
@@ -6755,6 +7271,22 @@ public:
 		m_type = type;
 	}
 
+	// the EVP context owns the expanded key and the mode's own data, so
+	// a copy needs its own
+	opensslCipherContext(const opensslCipherContext &from) : CipherContext(from)
+	{
+		m_cryptoAlgorithm = from.m_cryptoAlgorithm;
+		EVP_CIPHER_CTX_init(&m_context);
+#if OPENSSL_VERSION_NUMBER >= 0x10000000L
+		if ( EVP_CIPHER_CTX_cipher( &from.m_context ) )
+			EVP_CIPHER_CTX_copy( &m_context, &from.m_context );
+#endif
+		m_direction = from.m_direction;
+		m_pad = from.m_pad;
+		m_type = from.m_type;
+		m_tag = from.m_tag;
+	}
+
 	~opensslCipherContext()
 	{
 		EVP_CIPHER_CTX_cleanup(&m_context);
@@ -6774,8 +7306,8 @@ public:
 		if (Encode == m_direction) {
 			EVP_EncryptInit_ex(&m_context, m_cryptoAlgorithm, 0, 0, 0);
 			EVP_CIPHER_CTX_set_key_length(&m_context, key.size());
-			if (m_type.endsWith("gcm") || m_type.endsWith("ccm")) {
-				int parameter = m_type.endsWith("gcm") ? EVP_CTRL_GCM_SET_IVLEN : EVP_CTRL_CCM_SET_IVLEN;
+			if (isAead()) {
+				int parameter = m_type.endsWith("ccm") ? EVP_CTRL_CCM_SET_IVLEN : EVP_CTRL_GCM_SET_IVLEN;
 				EVP_CIPHER_CTX_ctrl(&m_context, parameter, iv.size(), NULL);
 			}
 			EVP_EncryptInit_ex(&m_context, 0, 0,
@@ -6784,8 +7316,8 @@ public:
 		} else {
 			EVP_DecryptInit_ex(&m_context, m_cryptoAlgorithm, 0, 0, 0);
 			EVP_CIPHER_CTX_set_key_length(&m_context, key.size());
-			if (m_type.endsWith("gcm") || m_type.endsWith("ccm")) {
-				int parameter = m_type.endsWith("gcm") ? EVP_CTRL_GCM_SET_IVLEN : EVP_CTRL_CCM_SET_IVLEN;
+			if (isAead()) {
+				int parameter = m_type.endsWith("ccm") ? EVP_CTRL_CCM_SET_IVLEN : EVP_CTRL_GCM_SET_IVLEN;
 				EVP_CIPHER_CTX_ctrl(&m_context, parameter, iv.size(), NULL);
 			}
 			EVP_DecryptInit_ex(&m_context, 0, 0,
@@ -6796,6 +7328,25 @@ public:
 		EVP_CIPHER_CTX_set_padding(&m_context, m_pad);
 	}
 
+	bool setIV(const InitializationVector &iv, const AuthTag &tag)
+	{
+		// without a cipher or key, EVP keeps the expanded key of the
+		// last setup and only restarts the mode with the new IV
+		if (!EVP_CIPHER_CTX_cipher(&m_context))
+			return false;
+		m_tag = tag;
+		if (isAead()) {
+			int parameter = m_type.endsWith("ccm") ? EVP_CTRL_CCM_SET_IVLEN : EVP_CTRL_GCM_SET_IVLEN;
+			EVP_CIPHER_CTX_ctrl(&m_context, parameter, iv.size(), NULL);
+		}
+		if (0 == EVP_CipherInit_ex(&m_context, 0, 0, 0,
+								   (const unsigned char*)(iv.data()), -1)) {
+			return false;
+		}
+		EVP_CIPHER_CTX_set_padding(&m_context, m_pad);
+		return true;
+	}
+
 	Provider::Context *clone() const
 	{
 		return new opensslCipherContext( *this );
@@ -6851,15 +7402,15 @@ public:
 										 &resultLength)) {
 				return false;
 			}
-			if (m_tag.size() && (m_type.endsWith("gcm") || m_type.endsWith("ccm"))) {
-				int parameter = m_type.endsWith("gcm") ? EVP_CTRL_GCM_GET_TAG : EVP_CTRL_CCM_GET_TAG;
+			if (m_tag.size() && isAead()) {
+				int parameter = m_type.endsWith("ccm") ? EVP_CTRL_CCM_GET_TAG : EVP_CTRL_GCM_GET_TAG;
 				if (0 == EVP_CIPHER_CTX_ctrl(&m_context, parameter, m_tag.size(), (unsigned char*)m_tag.data())) {
 					return false;
 				}
 			}
 		} else {
-			if (m_tag.size() && (m_type.endsWith("gcm") || m_type.endsWith("ccm"))) {
-				int parameter = m_type.endsWith("gcm") ? EVP_CTRL_GCM_SET_TAG : EVP_CTRL_CCM_SET_TAG;
+			if (m_tag.size() && isAead()) {
+				int parameter = m_type.endsWith("ccm") ? EVP_CTRL_CCM_SET_TAG : EVP_CTRL_GCM_SET_TAG;
 				if (0 == EVP_CIPHER_CTX_ctrl(&m_context, parameter, m_tag.size(), m_tag.data())) {
 					return false;
 				}
@@ -6899,6 +7450,11 @@ public:
 
 
 protected:
+	bool isAead() const
+	{
+		return m_type.endsWith("gcm") || m_type.endsWith("ccm");
+	}
+
 	EVP_CIPHER_CTX m_context;
 	const EVP_CIPHER *m_cryptoAlgorithm;
 	Direction m_direction;
@@ -7027,6 +7583,27 @@ static QStringList all_mac_types()
 	return list;
 }
 
+static QStringList all_hkdf_types()
+{
+	QStringList list;
+	list += "hkdf(md5)";
+	list += "hkdf(sha1)";
+#ifdef SHA224_DIGEST_LENGTH
+	list += "hkdf(sha224)";
+#endif
+#ifdef SHA256_DIGEST_LENGTH
+	list += "hkdf(sha256)";
+#endif
+#ifdef SHA384_DIGEST_LENGTH
+	list += "hkdf(sha384)";
+#endif
+#ifdef SHA512_DIGEST_LENGTH
+	list += "hkdf(sha512)";
+#endif
+	list += "hkdf(ripemd160)";
+	return list;
+}
+
 class opensslInfoContext : public InfoContext
 {
 	Q_OBJECT
@@ -7158,6 +7735,13 @@ public:
 #endif
 		list += "pbkdf1(sha1)";
 		list += "pbkdf2(sha1)";
+#ifdef SHA256_DIGEST_LENGTH
+		list += "pbkdf2(sha256)";
+#endif
+#ifdef SHA512_DIGEST_LENGTH
+		list += "pbkdf2(sha512)";
+#endif
+		list += all_hkdf_types();
 		list += "pkey";
 		list += "dlgroup";
 		list += "rsa";
@@ -7227,7 +7811,15 @@ public:
 			return new opensslPbkdf1Context( EVP_md2(), this, type );
 #endif
 		else if ( type == "pbkdf2(sha1)" )
-			return new opensslPbkdf2Context( this, type );
+			return new opensslPbkdf2Context( EVP_sha1(), this, type );
+#ifdef SHA256_DIGEST_LENGTH
+		else if ( type == "pbkdf2(sha256)" )
+			return new opensslPbkdf2Context( EVP_sha256(), this, type );
+#endif
+#ifdef SHA512_DIGEST_LENGTH
+		else if ( type == "pbkdf2(sha512)" )
+			return new opensslPbkdf2Context( EVP_sha512(), this, type );
+#endif
 		else if ( type == "hmac(md5)" )
 			return new opensslHMACContext( EVP_md5(), this, type );
 		else if ( type == "hmac(sha1)" )
@@ -7250,6 +7842,28 @@ public:
 #endif
 		else if ( type == "hmac(ripemd160)" )
 			return new opensslHMACContext( EVP_ripemd160(), this, type );
+		else if ( type == "hkdf(md5)" )
+			return new opensslHKDFContext( EVP_md5(), this, type );
+		else if ( type == "hkdf(sha1)" )
+			return new opensslHKDFContext( EVP_sha1(), this, type );
+#ifdef SHA224_DIGEST_LENGTH
+		else if ( type == "hkdf(sha224)" )
+			return new opensslHKDFContext( EVP_sha224(), this, type );
+#endif
+#ifdef SHA256_DIGEST_LENGTH
+		else if ( type == "hkdf(sha256)" )
+			return new opensslHKDFContext( EVP_sha256(), this, type );
+#endif
+#ifdef SHA384_DIGEST_LENGTH
+		else if ( type == "hkdf(sha384)" )
+			return new opensslHKDFContext( EVP_sha384(), this, type );
+#endif
+#ifdef SHA512_DIGEST_LENGTH
+		else if ( type == "hkdf(sha512)" )
+			return new opensslHKDFContext( EVP_sha512(), this, type );
+#endif
+		else if ( type == "hkdf(ripemd160)" )
+			return new opensslHKDFContext( EVP_ripemd160(), this, type );
 		else if ( type == "aes128-ecb" )
 			return new opensslCipherContext( EVP_aes_128_ecb(), 0, this, type);
 		else if ( type == "aes128-cfb" )
@@ -62,8 +62,25 @@ class Pooling_Allocator : public Allocator
 
       void destroy();
 
+      struct Stats
+         {
+         u32bit pool_bytes;
+         u32bit used_bytes;
+         u32bit peak_used_bytes;
+         u32bit large_bytes;
+         u64bit allocations;
+         u32bit lock_failures;
+         u32bit free_runs;
+         u32bit largest_free_run;
+         };
+
+      Stats stats() const;
+      void reserve(u32bit);
+
       Pooling_Allocator(u32bit, bool);
       ~Pooling_Allocator();
+   protected:
+      u32bit lock_failures;
    private:
       void get_more_core(u32bit);
       byte* allocate_blocks(u32bit);
@@ -82,6 +99,9 @@ class Pooling_Allocator : public Allocator
             bool contains(void*, u32bit) const throw();
             byte* alloc(u32bit) throw();
             void free(void*, u32bit) throw();
+            void free_runs(u32bit&, u32bit&, u32bit&) const throw();
+            const byte* start() const { return buffer; }
+            const byte* end() const { return buffer_end; }
 
             bool operator<(const Memory_Block& other) const
                {
@@ -105,6 +125,9 @@ class Pooling_Allocator : public Allocator
       std::vector<Memory_Block>::iterator last_used;
       std::vector<std::pair<void*, u32bit> > allocated;
       Mutex* mutex;
+
+      u32bit used_bytes, peak_used_bytes, large_bytes;
+      u64bit allocation_count;
    };
 
 }
@@ -50,7 +50,7 @@ u64bit system_clock();
 /*************************************************
 * Memory Locking Functions                       *
 *************************************************/
-void lock_mem(void*, u32bit);
+bool lock_mem(void*, u32bit);
 void unlock_mem(void*, u32bit);
 
 /*************************************************
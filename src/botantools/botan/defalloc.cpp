@@ -59,7 +59,7 @@ namespace {
 /*************************************************
 * Perform Memory Allocation                      *
 *************************************************/
-void* do_malloc(u32bit n, bool do_lock)
+void* do_malloc(u32bit n, bool do_lock, bool* locked = 0)
    {
    void* ptr = malloc(n);
 
@@ -67,7 +67,11 @@ void* do_malloc(u32bit n, bool do_lock)
       return 0;
 
    if(do_lock)
-      lock_mem(ptr, n);
+      {
+      bool ok = lock_mem(ptr, n);
+      if(locked)
+         *locked = ok;
+      }
 
    memset(ptr, 0, n);
    return ptr;
@@ -111,7 +115,12 @@ void Malloc_Allocator::dealloc_block(void* ptr, u32bit n)
 *************************************************/
 void* Locking_Allocator::alloc_block(u32bit n)
    {
-   return do_malloc(n, true);
+   // the memory is still usable, just not locked
+   bool locked = true;
+   void* ptr = do_malloc(n, true, &locked);
+   if(ptr && !locked)
+      ++lock_failures;
+   return ptr;
    }
 
 /*************************************************
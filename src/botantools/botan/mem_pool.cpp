@@ -158,6 +158,28 @@ void Pooling_Allocator::Memory_Block::free(void* ptr, u32bit blocks) throw()
       }
    }
 
+/*************************************************
+* Count runs of free blocks, and the longest     *
+*************************************************/
+void Pooling_Allocator::Memory_Block::free_runs(u32bit& runs, u32bit& longest,
+                                                u32bit& current) const throw()
+   {
+   // current carries a run over from the previous block, if adjacent
+   for(u32bit j = 0; j != BITMAP_SIZE; ++j)
+      {
+      if(bitmap & ((bitmap_type)1 << j))
+         current = 0;
+      else
+         {
+         if(current == 0)
+            ++runs;
+         ++current;
+         if(current > longest)
+            longest = current;
+         }
+      }
+   }
+
 /*************************************************
 * Pooling_Allocator Constructor                  *
 *************************************************/
@@ -166,6 +188,11 @@ Pooling_Allocator::Pooling_Allocator(u32bit p_size, bool) :
    {
    mutex = global_state().get_mutex();
    last_used = blocks.begin();
+   lock_failures = 0;
+   used_bytes = 0;
+   peak_used_bytes = 0;
+   large_bytes = 0;
+   allocation_count = 0;
    }
 
 /*************************************************
@@ -207,21 +234,34 @@ void* Pooling_Allocator::allocate(u32bit n)
       const u32bit block_no = round_up(n, BLOCK_SIZE) / BLOCK_SIZE;
 
       byte* mem = allocate_blocks(block_no);
-      if(mem)
-         return mem;
-
-      get_more_core(PREF_SIZE);
+      if(!mem)
+         {
+         get_more_core(PREF_SIZE);
+         mem = allocate_blocks(block_no);
+         }
 
-      mem = allocate_blocks(block_no);
       if(mem)
+         {
+         ++allocation_count;
+         used_bytes += block_no * BLOCK_SIZE;
+         if(used_bytes > peak_used_bytes)
+            peak_used_bytes = used_bytes;
          return mem;
+         }
 
       throw Memory_Exhaustion();
       }
 
    void* new_buf = alloc_block(n);
    if(new_buf)
+      {
+      ++allocation_count;
+      large_bytes += n;
+      used_bytes += n;
+      if(used_bytes > peak_used_bytes)
+         peak_used_bytes = used_bytes;
       return new_buf;
+      }
 
    throw Memory_Exhaustion();
    }
@@ -240,7 +280,11 @@ void Pooling_Allocator::deallocate(void* ptr, u32bit n)
    Mutex_Holder lock(mutex);
 
    if(n > BITMAP_SIZE * BLOCK_SIZE)
+      {
       dealloc_block(ptr, n);
+      large_bytes -= n;
+      used_bytes -= n;
+      }
    else
       {
       const u32bit block_no = round_up(n, BLOCK_SIZE) / BLOCK_SIZE;
@@ -252,9 +296,58 @@ void Pooling_Allocator::deallocate(void* ptr, u32bit n)
          throw Invalid_State("Pointer released to the wrong allocator");
 
       i->free(ptr, block_no);
+      used_bytes -= block_no * BLOCK_SIZE;
       }
    }
 
+/*************************************************
+* Report on the state of the pool                *
+*************************************************/
+Pooling_Allocator::Stats Pooling_Allocator::stats() const
+   {
+   const u32bit BITMAP_SIZE = Memory_Block::bitmap_size();
+   const u32bit BLOCK_SIZE = Memory_Block::block_size();
+
+   Mutex_Holder lock(mutex);
+
+   Stats s;
+   s.pool_bytes = blocks.size() * BITMAP_SIZE * BLOCK_SIZE;
+   s.used_bytes = used_bytes;
+   s.peak_used_bytes = peak_used_bytes;
+   s.large_bytes = large_bytes;
+   s.allocations = allocation_count;
+   s.lock_failures = lock_failures;
+
+   // blocks are sorted by address, so a free run may continue into
+   //   the next block when they are adjacent in memory
+   u32bit runs = 0, longest = 0, current = 0;
+   const byte* prev_end = 0;
+   for(std::vector<Memory_Block>::const_iterator i = blocks.begin();
+       i != blocks.end(); ++i)
+      {
+      if(i->start() != prev_end)
+         current = 0;
+      i->free_runs(runs, longest, current);
+      prev_end = i->end();
+      }
+   s.free_runs = runs;
+   s.largest_free_run = longest * BLOCK_SIZE;
+
+   return s;
+   }
+
+/*************************************************
+* Grow the pool ahead of time                    *
+*************************************************/
+void Pooling_Allocator::reserve(u32bit n)
+   {
+   const u32bit TOTAL_BLOCK_SIZE =
+      Memory_Block::bitmap_size() * Memory_Block::block_size();
+
+   Mutex_Holder lock(mutex);
+   get_more_core(round_up(n, TOTAL_BLOCK_SIZE));
+   }
+
 /*************************************************
 * Try to get some memory from an existing block  *
 *************************************************/
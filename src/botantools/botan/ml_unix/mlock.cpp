@@ -50,9 +50,9 @@ namespace Botan {
 /*************************************************
 * Lock an area of memory into RAM                *
 *************************************************/
-void lock_mem(void* ptr, u32bit bytes)
+bool lock_mem(void* ptr, u32bit bytes)
    {
-   mlock(ptr, bytes);
+   return (mlock(ptr, bytes) == 0);
    }
 
 /*************************************************
@@ -42,9 +42,9 @@ namespace Botan {
 /*************************************************
 * Lock an area of memory into RAM                *
 *************************************************/
-void lock_mem(void* ptr, u32bit bytes)
+bool lock_mem(void* ptr, u32bit bytes)
    {
-   VirtualLock(ptr, bytes);
+   return (VirtualLock(ptr, bytes) != 0);
    }
 
 /*************************************************
@@ -22,6 +22,7 @@
 
 #include <QtGlobal>
 #include <botan/allocate.h>
+#include <botan/mem_pool.h>
 #include <botan/secmem.h>
 #include <botan/modules.h>
 #include <botan/libstate.h>
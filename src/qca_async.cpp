@@ -0,0 +1,288 @@
+/*
+ * Copyright (C) 2026  Forkworks
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301  USA
+ *
+ */
+
+#include "qca_async.h"
+
+#include <QFutureInterface>
+
+namespace QCA {
+
+//----------------------------------------------------------------------------
+// AsyncTask
+//----------------------------------------------------------------------------
+template <typename T>
+class AsyncTask : public QRunnable
+{
+public:
+	QFutureInterface<T> fi;
+
+	AsyncTask()
+	{
+		fi.reportStarted();
+	}
+
+	// queues the task, which the pool deletes once it has run
+	QFuture<T> start(ThreadPool::Priority priority = ThreadPool::NormalPriority)
+	{
+		QFuture<T> f = fi.future();
+		ThreadPool::instance()->start(this, priority);
+		return f;
+	}
+
+	virtual void run()
+	{
+		if(!fi.isCanceled())
+		{
+			T result = compute();
+			fi.reportResult(result);
+		}
+		fi.reportFinished();
+	}
+
+protected:
+	virtual T compute() = 0;
+};
+
+// the arguments are copied, and their contexts detached, by the calling
+//   thread, so that the task never shares a provider context with it
+
+class SignTask : public AsyncTask<QByteArray>
+{
+public:
+	PrivateKey key;
+	MemoryRegion a;
+	SignatureAlgorithm alg;
+	SignatureFormat format;
+
+	SignTask(const PrivateKey &_key, const MemoryRegion &_a, SignatureAlgorithm _alg, SignatureFormat _format)
+	:key(_key), a(_a), alg(_alg), format(_format)
+	{
+		key.context();
+	}
+
+protected:
+	virtual QByteArray compute()
+	{
+		return key.signMessage(a, alg, format);
+	}
+};
+
+class VerifyTask : public AsyncTask<bool>
+{
+public:
+	PublicKey key;
+	MemoryRegion a;
+	QByteArray sig;
+	SignatureAlgorithm alg;
+	SignatureFormat format;
+
+	VerifyTask(const PublicKey &_key, const MemoryRegion &_a, const QByteArray &_sig, SignatureAlgorithm _alg, SignatureFormat _format)
+	:key(_key), a(_a), sig(_sig), alg(_alg), format(_format)
+	{
+		key.context();
+	}
+
+protected:
+	virtual bool compute()
+	{
+		return key.verifyMessage(a, sig, alg, format);
+	}
+};
+
+class KeyGenTask : public AsyncTask<PrivateKey>
+{
+public:
+	enum Type { RSA, DSA, DH };
+
+	Type type;
+	int bits, exp;
+	DLGroup domain;
+	QString provider;
+
+	KeyGenTask(Type _type, const QString &_provider)
+	:type(_type), bits(0), exp(0), provider(_provider)
+	{
+	}
+
+protected:
+	virtual PrivateKey compute()
+	{
+		KeyGenerator gen;
+		if(type == RSA)
+			return gen.createRSA(bits, exp, provider);
+		else if(type == DSA)
+			return gen.createDSA(domain, provider);
+		else
+			return gen.createDH(domain, provider);
+	}
+};
+
+class DLGroupTask : public AsyncTask<DLGroup>
+{
+public:
+	DLGroupSet set;
+	QString provider;
+
+	DLGroupTask(DLGroupSet _set, const QString &_provider)
+	:set(_set), provider(_provider)
+	{
+	}
+
+protected:
+	virtual DLGroup compute()
+	{
+		KeyGenerator gen;
+		return gen.createDLGroup(set, provider);
+	}
+};
+
+class ValidateTask : public AsyncTask<Validity>
+{
+public:
+	Certificate cert;
+	CertificateCollection trusted, untrusted;
+	UsageMode u;
+	ValidateFlags vf;
+
+	ValidateTask(const Certificate &_cert, const CertificateCollection &_trusted, const CertificateCollection &_untrusted, UsageMode _u, ValidateFlags _vf)
+	:cert(_cert), trusted(detached(_trusted)), untrusted(detached(_untrusted)), u(_u), vf(_vf)
+	{
+		cert.context();
+	}
+
+private:
+	// the collections hold certificates and CRLs that share their
+	//   contexts with the caller, so they are detached one by one
+	static CertificateCollection detached(const CertificateCollection &from)
+	{
+		CertificateCollection c;
+		foreach(Certificate cert, from.certificates())
+		{
+			cert.context();
+			c.addCertificate(cert);
+		}
+		foreach(CRL crl, from.crls())
+		{
+			crl.context();
+			c.addCRL(crl);
+		}
+		return c;
+	}
+
+protected:
+	virtual Validity compute()
+	{
+		return cert.validate(trusted, untrusted, u, vf);
+	}
+};
+
+class KDFTask : public AsyncTask<SymmetricKey>
+{
+public:
+	KeyDerivationFunction kdf;
+	SecureArray secret;
+	InitializationVector salt;
+	unsigned int keyLength, iterationCount;
+
+	KDFTask(const KeyDerivationFunction &_kdf, const SecureArray &_secret, const InitializationVector &_salt, unsigned int _keyLength, unsigned int _iterationCount)
+	:kdf(_kdf), secret(_secret), salt(_salt), keyLength(_keyLength), iterationCount(_iterationCount)
+	{
+		kdf.context();
+	}
+
+protected:
+	virtual SymmetricKey compute()
+	{
+		return kdf.makeKey(secret, salt, keyLength, iterationCount);
+	}
+};
+
+class KeyBundleTask : public AsyncTask<KeyBundle>
+{
+public:
+	QByteArray a;
+	SecureArray passphrase;
+	QString provider;
+
+	KeyBundleTask(const QByteArray &_a, const SecureArray &_passphrase, const QString &_provider)
+	:a(_a), passphrase(_passphrase), provider(_provider)
+	{
+	}
+
+protected:
+	virtual KeyBundle compute()
+	{
+		return KeyBundle::fromArray(a, passphrase, 0, provider);
+	}
+};
+
+QFuture<QByteArray> signMessageAsync(const PrivateKey &key, const MemoryRegion &a, SignatureAlgorithm alg, SignatureFormat format)
+{
+	return (new SignTask(key, a, alg, format))->start();
+}
+
+QFuture<bool> verifyMessageAsync(const PublicKey &key, const MemoryRegion &a, const QByteArray &sig, SignatureAlgorithm alg, SignatureFormat format)
+{
+	return (new VerifyTask(key, a, sig, alg, format))->start();
+}
+
+QFuture<PrivateKey> createRSAAsync(int bits, int exp, const QString &provider)
+{
+	KeyGenTask *t = new KeyGenTask(KeyGenTask::RSA, provider);
+	t->bits = bits;
+	t->exp = exp;
+	return t->start(ThreadPool::LowPriority);
+}
+
+QFuture<PrivateKey> createDSAAsync(const DLGroup &domain, const QString &provider)
+{
+	KeyGenTask *t = new KeyGenTask(KeyGenTask::DSA, provider);
+	t->domain = domain;
+	return t->start(ThreadPool::LowPriority);
+}
+
+QFuture<PrivateKey> createDHAsync(const DLGroup &domain, const QString &provider)
+{
+	KeyGenTask *t = new KeyGenTask(KeyGenTask::DH, provider);
+	t->domain = domain;
+	return t->start(ThreadPool::LowPriority);
+}
+
+QFuture<DLGroup> createDLGroupAsync(DLGroupSet set, const QString &provider)
+{
+	return (new DLGroupTask(set, provider))->start(ThreadPool::LowPriority);
+}
+
+QFuture<Validity> validateAsync(const Certificate &cert, const CertificateCollection &trusted, const CertificateCollection &untrusted, UsageMode u, ValidateFlags vf)
+{
+	return (new ValidateTask(cert, trusted, untrusted, u, vf))->start();
+}
+
+QFuture<SymmetricKey> makeKeyAsync(const KeyDerivationFunction &kdf, const SecureArray &secret, const InitializationVector &salt, unsigned int keyLength, unsigned int iterationCount)
+{
+	return (new KDFTask(kdf, secret, salt, keyLength, iterationCount))->start();
+}
+
+QFuture<KeyBundle> keyBundleFromArrayAsync(const QByteArray &a, const SecureArray &passphrase, const QString &provider)
+{
+	return (new KeyBundleTask(a, passphrase, provider))->start();
+}
+
+}
@@ -22,10 +22,18 @@
 #include "qca_basic.h"
 
 #include "qcaprovider.h"
+#include "qca_simd.h"
 
+#include <QDataStream>
+#include <QFile>
 #include <QMutexLocker>
 #include <QtGlobal>
 
+#ifdef Q_OS_UNIX
+# include <sys/mman.h>
+# include <unistd.h>
+#endif
+
 namespace QCA {
 
 // from qca_core.cpp
@@ -207,12 +215,12 @@ void Hash::clear()
 
 void Hash::update(const MemoryRegion &a)
 {
-	static_cast<HashContext *>(context())->update(a);
+	static_cast<HashContext *>(context())->updateView(a);
 }
 
 void Hash::update(const QByteArray &a)
 {
-	update(MemoryRegion(a));
+	update(MemoryView(a.constData(), a.size()));
 }
 
 void Hash::update(const char *data, int len)
@@ -222,17 +230,82 @@ void Hash::update(const char *data, int len)
 	if(len == 0)
 		return;
 
-	update(MemoryRegion(QByteArray::fromRawData(data, len)));
+	update(MemoryView(data, len));
 }
 
-// Reworked from KMD5, from KDE's kdelibs
-void Hash::update(QIODevice *file)
+// files are mapped a window at a time, so that huge files do not exhaust
+//   the address space of 32-bit processes.  within a window, all of the
+//   hashes are fed one slice at a time while it is still in the cache.
+#define HASH_MAP_WINDOW (64 * 1024 * 1024)
+#define HASH_SLICE      (1024 * 1024)
+#define HASH_READ_SIZE  (64 * 1024)
+
+// hashes the rest of a file from memory mappings.  returns false, with the
+//   file positioned after the data that was hashed, if the file cannot be
+//   (fully) mapped.
+static bool update_mapped(QFile *file, const QList<Hash*> &hashes)
+{
+	if(file->isSequential())
+		return false;
+
+	qint64 pos = file->pos();
+	qint64 size = file->size();
+
+	// files in /proc and the like claim to be empty
+	if(pos >= size)
+		return false;
+
+	while(pos < size)
+	{
+		qint64 len = qMin(size - pos, qint64(HASH_MAP_WINDOW));
+		uchar *p = file->map(pos, len);
+		if(!p)
+		{
+			file->seek(pos);
+			return false;
+		}
+
+#ifdef Q_OS_UNIX
+		quintptr page = sysconf(_SC_PAGESIZE);
+		quintptr start = quintptr(p) & ~(page - 1);
+		madvise(reinterpret_cast<void *>(start), size_t(quintptr(p) + len - start), MADV_SEQUENTIAL);
+#endif
+
+		for(qint64 at = 0; at < len; at += HASH_SLICE)
+		{
+			MemoryView slice(reinterpret_cast<const char *>(p) + at, int(qMin(len - at, qint64(HASH_SLICE))));
+			foreach(Hash *h, hashes)
+				h->update(slice);
+		}
+
+		file->unmap(p);
+		pos += len;
+	}
+
+	file->seek(size);
+	return true;
+}
+
+static void update_all(QIODevice *file, const QList<Hash*> &hashes)
 {
-	char buffer[1024];
+	QFile *f = qobject_cast<QFile*>(file);
+	if(f && update_mapped(f, hashes))
+		return;
+
+	// pipes, sockets and anything else that cannot be mapped
+	QByteArray buffer(HASH_READ_SIZE, 0);
 	int len;
+	while((len = file->read(buffer.data(), buffer.size())) > 0)
+	{
+		MemoryView chunk(buffer.constData(), len);
+		foreach(Hash *h, hashes)
+			h->update(chunk);
+	}
+}
 
-	while ((len=file->read(reinterpret_cast<char*>(buffer), sizeof(buffer))) > 0)
-		update(buffer, len);
+void Hash::update(QIODevice *file)
+{
+	update_all(file, QList<Hash*>() << this);
 }
 
 MemoryRegion Hash::final()
@@ -240,6 +313,13 @@ MemoryRegion Hash::final()
 	return static_cast<HashContext *>(context())->final();
 }
 
+MemoryRegion Hash::final(int outLen)
+{
+	if(outLen < 0)
+		return MemoryRegion();
+	return static_cast<HashContext *>(context())->xofFinal(outLen);
+}
+
 MemoryRegion Hash::hash(const MemoryRegion &a)
 {
 	return process(a);
@@ -250,9 +330,602 @@ QString Hash::hashToString(const MemoryRegion &a)
 	return arrayToHex(hash(a).toByteArray());
 }
 
+MemoryRegion Hash::hashFile(const QString &fileName)
+{
+	QFile file(fileName);
+	if(!file.open(QIODevice::ReadOnly))
+		return MemoryRegion();
+	clear();
+	update(&file);
+	return final();
+}
+
+bool Hash::hashFile(const QString &fileName, const QList<Hash*> &hashes)
+{
+	QFile file(fileName);
+	if(!file.open(QIODevice::ReadOnly))
+		return false;
+	foreach(Hash *h, hashes)
+		h->clear();
+	update_all(&file, hashes);
+	return true;
+}
+
+// the provider's state is wrapped with the hash type and provider name,
+//   so that it is not restored into a context that would misread it
+static const quint32 hash_state_magic = 0x51434148; // "QCAH"
+
+QByteArray Hash::saveState() const
+{
+	const HashContext *c = static_cast<const HashContext *>(context());
+	if(!c)
+		return QByteArray();
+	QByteArray state = c->saveState();
+	if(state.isEmpty())
+		return QByteArray();
+
+	QByteArray out;
+	QDataStream s(&out, QIODevice::WriteOnly);
+	s << hash_state_magic << (quint8)1 << type() << provider()->name() << state;
+	return out;
+}
+
+bool Hash::restoreState(const QByteArray &state)
+{
+	if(!context())
+		return false;
+
+	quint32 magic;
+	quint8 version;
+	QString stateType, stateProvider;
+	QByteArray inner;
+	QDataStream s(state);
+	s >> magic >> version >> stateType >> stateProvider >> inner;
+	if(s.status() != QDataStream::Ok || !s.atEnd() || magic != hash_state_magic || version != 1)
+		return false;
+	if(stateType != type() || stateProvider != provider()->name())
+		return false;
+
+	return static_cast<HashContext *>(context())->restoreState(inner);
+}
+
 //----------------------------------------------------------------------------
 // Cipher
 //----------------------------------------------------------------------------
+// GHASH of GCM.  the field elements are two big endian words.  nothing
+//   is looked up in a table indexed by H or by the data, so the time
+//   taken says nothing about them: the multiply is the carry-less
+//   multiply instruction if the CPU has one, or else a loop over the bits
+//   that uses masks instead of branches.
+#ifdef QCA_HAVE_PCLMUL
+
+// a * b.  in a register the two words go the other way around, which is
+//   the bit reflected order that the instruction works in.  the product
+//   is then shifted left by a bit and reduced modulo
+//   x^128 + x^7 + x^2 + x + 1
+QCA_TARGET_PCLMUL static inline __m128i ghash_mult_pclmul(__m128i a, __m128i b)
+{
+	__m128i lo = _mm_clmulepi64_si128(a, b, 0x00);
+	__m128i mid = _mm_xor_si128(_mm_clmulepi64_si128(a, b, 0x10), _mm_clmulepi64_si128(a, b, 0x01));
+	__m128i hi = _mm_clmulepi64_si128(a, b, 0x11);
+	lo = _mm_xor_si128(lo, _mm_slli_si128(mid, 8));
+	hi = _mm_xor_si128(hi, _mm_srli_si128(mid, 8));
+
+	__m128i lc = _mm_srli_epi32(lo, 31);
+	__m128i hc = _mm_srli_epi32(hi, 31);
+	lo = _mm_or_si128(_mm_slli_epi32(lo, 1), _mm_slli_si128(lc, 4));
+	hi = _mm_or_si128(_mm_or_si128(_mm_slli_epi32(hi, 1), _mm_slli_si128(hc, 4)), _mm_srli_si128(lc, 12));
+
+	__m128i t = _mm_xor_si128(_mm_xor_si128(_mm_slli_epi32(lo, 31), _mm_slli_epi32(lo, 30)), _mm_slli_epi32(lo, 25));
+	__m128i carry = _mm_srli_si128(t, 4);
+	lo = _mm_xor_si128(lo, _mm_slli_si128(t, 12));
+	__m128i u = _mm_xor_si128(_mm_xor_si128(_mm_srli_epi32(lo, 1), _mm_srli_epi32(lo, 2)), _mm_srli_epi32(lo, 7));
+	return _mm_xor_si128(hi, _mm_xor_si128(lo, _mm_xor_si128(u, carry)));
+}
+
+QCA_TARGET_PCLMUL static inline __m128i ghash_load_pclmul(const quint64 *x)
+{
+	return _mm_set_epi64x((qint64)x[0], (qint64)x[1]);
+}
+
+QCA_TARGET_PCLMUL static inline void ghash_store_pclmul(quint64 *x, __m128i a)
+{
+	quint64 r[2];
+	_mm_storeu_si128((__m128i *)r, a);
+	x[0] = r[1];
+	x[1] = r[0];
+}
+
+#endif
+
+class GHash
+{
+public:
+	quint64 h[2];
+
+	void setKey(const unsigned char *key)
+	{
+		h[0] = load64(key);
+		h[1] = load64(key + 8);
+	}
+
+	// y = (y ^ x) * H, for each block of x
+	void blocks(quint64 *y, const unsigned char *x, quint64 count) const
+	{
+#ifdef QCA_HAVE_PCLMUL
+		if(have_pclmul())
+		{
+			blocksPclmul(y, x, count);
+			return;
+		}
+#endif
+		for(; count > 0; --count, x += 16)
+		{
+			y[0] ^= load64(x);
+			y[1] ^= load64(x + 8);
+			mult(y, h);
+		}
+	}
+
+	// x = x * y
+	static void mult(quint64 *x, const quint64 *y)
+	{
+#ifdef QCA_HAVE_PCLMUL
+		if(have_pclmul())
+		{
+			ghash_store_pclmul(x, ghash_mult_pclmul(ghash_load_pclmul(x), ghash_load_pclmul(y)));
+			return;
+		}
+#endif
+		quint64 zh = 0, zl = 0, vh = y[0], vl = y[1];
+		for(int i = 0; i < 128; ++i)
+		{
+			quint64 bit = (x[i / 64] >> (63 - i % 64)) & 1;
+			zh ^= vh & (0 - bit);
+			zl ^= vl & (0 - bit);
+			quint64 t = Q_UINT64_C(0xe100000000000000) & (0 - (vl & 1));
+			vl = (vh << 63) | (vl >> 1);
+			vh = (vh >> 1) ^ t;
+		}
+		x[0] = zh;
+		x[1] = zl;
+	}
+
+	// x = x * H^n
+	void multPower(quint64 *x, quint64 n) const
+	{
+		quint64 p[2] = { h[0], h[1] };
+		for(; n > 0; n >>= 1)
+		{
+			if(n & 1)
+				mult(x, p);
+			mult(p, p);
+		}
+	}
+
+	static quint64 load64(const unsigned char *p)
+	{
+		quint64 x = 0;
+		for(int n = 0; n < 8; ++n)
+			x = (x << 8) | p[n];
+		return x;
+	}
+
+	static void store64(unsigned char *p, quint64 x)
+	{
+		for(int n = 7; n >= 0; --n)
+		{
+			p[n] = (unsigned char)x;
+			x >>= 8;
+		}
+	}
+
+private:
+#ifdef QCA_HAVE_PCLMUL
+	QCA_TARGET_PCLMUL void blocksPclmul(quint64 *y, const unsigned char *x, quint64 count) const
+	{
+		__m128i hv = ghash_load_pclmul(h);
+		__m128i yv = ghash_load_pclmul(y);
+		for(; count > 0; --count, x += 16)
+		{
+			quint64 w[2] = { load64(x), load64(x + 8) };
+			yv = ghash_mult_pclmul(_mm_xor_si128(yv, ghash_load_pclmul(w)), hv);
+		}
+		ghash_store_pclmul(y, yv);
+	}
+#endif
+};
+
+// CTR, or GCM, done with a provider's CTR mode, so that large updates
+//   can be split into segments that are encrypted on the ThreadPool at
+//   the same time.  each segment gets a clone of the CTR context, set up
+//   at the counter of its first block, and for GCM the GHASH of each
+//   segment is folded into the running one with the right power of H.
+//   the result is the same as that of doing it all in one piece.
+class ParallelCounterMode
+{
+public:
+	// smaller updates, and pieces, aren't worth a job
+	enum { SegmentSize = 256 * 1024 };
+
+	// every piece gets a context of its own from the provider, since a
+	//   clone() may share the state of a provider's library
+	ParallelCounterMode(Provider *_provider, const QString &_ctrType, bool _gcm) : provider(_provider), ctrType(_ctrType), gcm(_gcm)
+	{
+		ctr = newContext();
+		dir = Encode;
+		pos = 0;
+		ctrPos = -1;
+		y[0] = y[1] = 0;
+		bufLen = 0;
+		memset(ej0, 0, 16);
+	}
+
+	ParallelCounterMode(const ParallelCounterMode &from) : ctr(0)
+	{
+		*this = from;
+	}
+
+	~ParallelCounterMode()
+	{
+		delete ctr;
+	}
+
+	ParallelCounterMode & operator=(const ParallelCounterMode &from)
+	{
+		if(this == &from)
+			return *this;
+		delete ctr;
+		provider = from.provider;
+		ctrType = from.ctrType;
+		ctr = newContext();
+		gcm = from.gcm;
+		dir = from.dir;
+		key = from.key;
+		counter0 = from.counter0;
+		expectedTag = from.expectedTag;
+		tag = from.tag;
+		pos = from.pos;
+		ctrPos = -1;
+		gh = from.gh;
+		y[0] = from.y[0];
+		y[1] = from.y[1];
+		memcpy(buf, from.buf, 16);
+		bufLen = from.bufLen;
+		memcpy(ej0, from.ej0, 16);
+		return *this;
+	}
+
+	// for CTR.  the IV is the first counter block
+	bool setup(const SymmetricKey &_key, const InitializationVector &iv)
+	{
+		key = _key;
+		counter0 = iv;
+		return ctr && !iv.isEmpty();
+	}
+
+	// for GCM, with the cipher in ECB mode to make H and the tag mask
+	bool setup(Direction _dir, const SymmetricKey &_key, const InitializationVector &iv, const AuthTag &_tag, CipherContext *ecb)
+	{
+		dir = _dir;
+		key = _key;
+		expectedTag = _tag;
+		if(!ctr || iv.isEmpty() || _tag.size() > 16)
+			return false;
+
+		SecureArray h;
+		if(!encryptBlock(ecb, SecureArray(16, 0), &h))
+			return false;
+		gh.setKey((const unsigned char *)h.data());
+
+		// J0 is the IV and a counter of 1, or the GHASH of any other
+		//   size of IV
+		SecureArray j0(16, 0);
+		if(iv.size() == 12)
+		{
+			memcpy(j0.data(), iv.data(), 12);
+			j0[15] = 1;
+		}
+		else
+		{
+			ghashBytes((const unsigned char *)iv.data(), iv.size());
+			ghashFlush();
+			unsigned char lengths[16];
+			GHash::store64(lengths, 0);
+			GHash::store64(lengths + 8, (quint64)iv.size() * 8);
+			gh.blocks(y, lengths, 1);
+			GHash::store64((unsigned char *)j0.data(), y[0]);
+			GHash::store64((unsigned char *)j0.data() + 8, y[1]);
+			y[0] = y[1] = 0;
+		}
+
+		SecureArray mask;
+		if(!encryptBlock(ecb, j0, &mask))
+			return false;
+		memcpy(ej0, mask.data(), 16);
+
+		counter0 = j0;
+		increment((unsigned char *)counter0.data(), 1);
+		return true;
+	}
+
+	bool update(const MemoryRegion &in, SecureArray *out)
+	{
+		int n = in.size();
+		out->resize(n);
+		const char *src = in.data();
+		char *dest = out->data();
+
+		// up to a block boundary, then whole blocks in parallel, then
+		//   the rest
+		int bs = counter0.size();
+		int head = qMin(n, (int)((bs - pos % bs) % bs));
+		if(!sequential(src, dest, head))
+			return false;
+		src += head;
+		dest += head;
+		n -= head;
+
+		int body = n - n % bs;
+		int threads = ThreadPool::instance()->maxThreadCount();
+		if(threads > 1 && body >= 2 * SegmentSize)
+		{
+			if(!parallel(src, dest, body, qMin(threads, body / SegmentSize)))
+				return false;
+			src += body;
+			dest += body;
+			n -= body;
+		}
+
+		return sequential(src, dest, n);
+	}
+
+	bool final()
+	{
+		if(!gcm)
+			return true;
+
+		// the length of the associated data (none), and of the text
+		ghashFlush();
+		unsigned char lengths[16];
+		GHash::store64(lengths, 0);
+		GHash::store64(lengths + 8, pos * 8);
+		gh.blocks(y, lengths, 1);
+
+		unsigned char full[16];
+		GHash::store64(full, y[0]);
+		GHash::store64(full + 8, y[1]);
+		for(int n = 0; n < 16; ++n)
+			full[n] ^= ej0[n];
+
+		if(dir == Encode)
+		{
+			tag = AuthTag(expectedTag.size());
+			memcpy(tag.data(), full, tag.size());
+			return true;
+		}
+
+		// a tag is needed to decrypt, and it is compared in constant
+		//   time
+		tag = expectedTag;
+		if(expectedTag.isEmpty())
+			return false;
+		unsigned char diff = 0;
+		for(int n = 0; n < expectedTag.size(); ++n)
+			diff |= (unsigned char)(full[n] ^ expectedTag[n]);
+		return diff == 0;
+	}
+
+	AuthTag tag;
+
+private:
+	class Segment : public ThreadPoolJob
+	{
+	public:
+		const ParallelCounterMode *m;
+		CipherContext *c;
+		quint64 at;
+		const char *in;
+		char *out;
+		int size;
+		quint64 y[2];
+		bool ok;
+
+		Segment(const ParallelCounterMode *_m) : m(_m), c(_m->newContext())
+		{
+		}
+
+		~Segment()
+		{
+			wait();
+			delete c;
+		}
+
+	protected:
+		virtual void run()
+		{
+			ok = true;
+			y[0] = y[1] = 0;
+			for(int done = 0; ok && done < size; )
+			{
+				int k = (int)qMin((quint64)(size - done), m->bytesToWrap(at + done));
+				ok = m->seek(c, at + done) && m->crypt(c, in + done, out + done, k);
+				done += k;
+			}
+			if(ok && m->gcm)
+				m->gh.blocks(y, (const unsigned char *)(m->dir == Encode ? out : in), size / 16);
+		}
+	};
+
+	Provider *provider;
+	QString ctrType;
+	CipherContext *ctr;
+	bool gcm;
+	Direction dir;
+	SymmetricKey key;
+	InitializationVector counter0;
+	AuthTag expectedTag;
+	quint64 pos;
+	qint64 ctrPos; // where ctr is in the key stream, or -1
+	GHash gh;
+	quint64 y[2];
+	unsigned char buf[16];
+	int bufLen;
+	unsigned char ej0[16];
+
+	CipherContext *newContext() const
+	{
+		return static_cast<CipherContext *>(provider->createContext(ctrType));
+	}
+
+	static bool encryptBlock(CipherContext *ecb, const SecureArray &in, SecureArray *out)
+	{
+		SecureArray rest;
+		return ecb->update(in, out) && ecb->final(&rest) && out->size() == 16;
+	}
+
+	// adds n to a counter block.  GCM only counts in the last 32 bits
+	void increment(unsigned char *block, quint64 n) const
+	{
+		int last = counter0.size() - 1;
+		int first = gcm ? last - 3 : 0;
+		for(int i = last; i >= first && n > 0; --i)
+		{
+			n += block[i];
+			block[i] = (unsigned char)n;
+			n >>= 8;
+		}
+	}
+
+	// the number of bytes from a position until the 32 bit counter of
+	//   GCM wraps, which a CTR context doesn't know about
+	quint64 bytesToWrap(quint64 at) const
+	{
+		if(!gcm)
+			return Q_UINT64_C(0xffffffffffffffff);
+		const unsigned char *c = (const unsigned char *)counter0.data();
+		quint64 low = ((quint64)c[12] << 24) | (c[13] << 16) | (c[14] << 8) | c[15];
+		quint64 blocks = Q_UINT64_C(0x100000000) - ((low + at / 16) & 0xffffffff);
+		return blocks * 16 - at % 16;
+	}
+
+	// sets up a CTR context at a position of the key stream
+	bool seek(CipherContext *c, quint64 at) const
+	{
+		if(!c)
+			return false;
+		int bs = counter0.size();
+		InitializationVector iv = counter0;
+		increment((unsigned char *)iv.data(), at / bs);
+		c->setup(Encode, key, iv, AuthTag());
+		return crypt(c, SecureArray(at % bs, 0).data(), 0, at % bs);
+	}
+
+	static bool crypt(CipherContext *c, const char *in, char *out, int n)
+	{
+		if(n == 0)
+			return true;
+		SecureArray a(n);
+		memcpy(a.data(), in, n);
+		SecureArray b;
+		if(!c->update(a, &b) || b.size() != n)
+			return false;
+		if(out)
+			memcpy(out, b.data(), n);
+		return true;
+	}
+
+	bool sequential(const char *in, char *out, int n)
+	{
+		while(n > 0)
+		{
+			if(ctrPos != (qint64)pos)
+			{
+				if(!seek(ctr, pos))
+					return false;
+				ctrPos = pos;
+			}
+			quint64 toWrap = bytesToWrap(pos);
+			int k = (int)qMin((quint64)n, toWrap);
+			if(!crypt(ctr, in, out, k))
+				return false;
+			if(gcm)
+				ghashBytes((const unsigned char *)(dir == Encode ? out : in), k);
+			pos += k;
+			ctrPos = (k == (qint64)toWrap) ? -1 : (qint64)pos;
+			in += k;
+			out += k;
+			n -= k;
+		}
+		return true;
+	}
+
+	bool parallel(const char *in, char *out, int size, int count)
+	{
+		QList<Segment*> segments;
+		int each = size / count;
+		each -= each % counter0.size();
+		for(int n = 0; n < count; ++n)
+		{
+			Segment *s = new Segment(this);
+			s->at = pos + n * each;
+			s->in = in + n * each;
+			s->out = out + n * each;
+			s->size = (n == count - 1) ? size - n * each : each;
+			s->start();
+			segments += s;
+		}
+
+		// waiting runs any segment the pool has not got to yet right
+		//   here
+		bool ok = true;
+		foreach(Segment *s, segments)
+		{
+			s->wait();
+			ok = ok && s->ok;
+			if(ok && gcm)
+			{
+				gh.multPower(y, s->size / 16);
+				y[0] ^= s->y[0];
+				y[1] ^= s->y[1];
+			}
+			delete s;
+		}
+		pos += size;
+		return ok;
+	}
+
+	void ghashBytes(const unsigned char *data, int n)
+	{
+		if(bufLen > 0)
+		{
+			int k = qMin(16 - bufLen, n);
+			memcpy(buf + bufLen, data, k);
+			bufLen += k;
+			data += k;
+			n -= k;
+			if(bufLen < 16)
+				return;
+			gh.blocks(y, buf, 1);
+			bufLen = 0;
+		}
+		gh.blocks(y, data, n / 16);
+		memcpy(buf, data + (n & ~15), n % 16);
+		bufLen = n % 16;
+	}
+
+	// zeros up to a whole block
+	void ghashFlush()
+	{
+		if(bufLen > 0)
+		{
+			memset(buf + bufLen, 0, 16 - bufLen);
+			gh.blocks(y, buf, 1);
+			bufLen = 0;
+		}
+	}
+};
+
 class Cipher::Private
 {
 public:
@@ -265,6 +938,41 @@ public:
 	AuthTag tag;
 
 	bool ok, done;
+	bool parallel;
+	ParallelCounterMode *counterMode; // replaces the context when set
+
+	Private() : parallel(false), counterMode(0)
+	{
+	}
+
+	Private(const Private &from) : counterMode(0)
+	{
+		*this = from;
+	}
+
+	~Private()
+	{
+		delete counterMode;
+	}
+
+	Private & operator=(const Private &from)
+	{
+		if(this == &from)
+			return *this;
+		type = from.type;
+		mode = from.mode;
+		pad = from.pad;
+		dir = from.dir;
+		key = from.key;
+		iv = from.iv;
+		tag = from.tag;
+		ok = from.ok;
+		done = from.done;
+		parallel = from.parallel;
+		delete counterMode;
+		counterMode = from.counterMode ? new ParallelCounterMode(*from.counterMode) : 0;
+		return *this;
+	}
 };
 
 Cipher::Cipher(const QString &type, Mode mode, Padding pad,
@@ -355,13 +1063,48 @@ int Cipher::blockSize() const
 
 AuthTag Cipher::tag() const
 {
+	if(d->counterMode && d->mode == GCM)
+		return d->counterMode->tag;
 	return static_cast<const CipherContext *>(context())->tag();
 }
 
 void Cipher::clear()
 {
 	d->done = false;
+	d->ok = true;
 	static_cast<CipherContext *>(context())->setup(d->dir, d->key, d->iv, d->tag);
+
+	delete d->counterMode;
+	d->counterMode = 0;
+	if(!d->parallel)
+		return;
+
+	// CTR mode uses contexts of the same type, and GCM is built from
+	//   the cipher in CTR and ECB modes of the same provider
+	if(d->mode == CTR)
+	{
+		d->counterMode = new ParallelCounterMode(provider(), type(), false);
+		if(!d->counterMode->setup(d->key, d->iv))
+		{
+			delete d->counterMode;
+			d->counterMode = 0;
+		}
+	}
+	else if(d->mode == GCM)
+	{
+		CipherContext *ecb = static_cast<CipherContext *>(provider()->createContext(withAlgorithms(d->type, ECB, NoPadding)));
+		if(ecb && ecb->blockSize() == 16)
+		{
+			ecb->setup(Encode, d->key, InitializationVector(), AuthTag());
+			d->counterMode = new ParallelCounterMode(provider(), withAlgorithms(d->type, CTR, NoPadding), true);
+			if(!d->counterMode->setup(d->dir, d->key, d->iv, d->tag, ecb))
+			{
+				delete d->counterMode;
+				d->counterMode = 0;
+			}
+		}
+		delete ecb;
+	}
 }
 
 MemoryRegion Cipher::update(const MemoryRegion &a)
@@ -369,7 +1112,10 @@ MemoryRegion Cipher::update(const MemoryRegion &a)
 	SecureArray out;
 	if(d->done)
 		return out;
-	d->ok = static_cast<CipherContext *>(context())->update(a, &out);
+	if(d->counterMode)
+		d->ok = d->counterMode->update(a, &out);
+	else
+		d->ok = static_cast<CipherContext *>(context())->update(a, &out);
 	return out;
 }
 
@@ -379,7 +1125,10 @@ MemoryRegion Cipher::final()
 	if(d->done)
 		return out;
 	d->done = true;
-	d->ok = static_cast<CipherContext *>(context())->final(&out);
+	if(d->counterMode)
+		d->ok = d->counterMode->final();
+	else
+		d->ok = static_cast<CipherContext *>(context())->final(&out);
 	return out;
 }
 
@@ -388,6 +1137,40 @@ bool Cipher::ok() const
 	return d->ok;
 }
 
+void Cipher::setIV(const InitializationVector &iv)
+{
+	// an encrypting GCM or CCM cipher still makes a tag of the same size
+	setIV(iv, AuthTag(d->tag.size()));
+}
+
+void Cipher::setIV(const InitializationVector &iv, const AuthTag &tag)
+{
+	d->iv = iv;
+	d->tag = tag;
+	if(d->key.isEmpty())
+		return;
+
+	// the parallel modes are made again from the IV, as are contexts
+	//   that can't keep their key
+	if(d->counterMode || !static_cast<CipherContext *>(context())->setIV(iv, tag))
+	{
+		clear();
+		return;
+	}
+	d->done = false;
+	d->ok = true;
+}
+
+void Cipher::setParallel(bool enable)
+{
+	d->parallel = enable;
+}
+
+bool Cipher::isParallel() const
+{
+	return d->parallel;
+}
+
 void Cipher::setup(Direction dir, const SymmetricKey &key, const InitializationVector &iv)
 {
 	setup(dir, key, iv, AuthTag());
@@ -427,6 +1210,11 @@ QString Cipher::withAlgorithms(const QString &cipherType, Mode modeType, Padding
 	case CCM:
 		mode = "ccm";
 		break;
+	case Poly1305:
+		mode = "poly1305";
+		break;
+	case Stream:
+		break;
 	default:
 		Q_ASSERT(0);
 	}
@@ -447,7 +1235,9 @@ QString Cipher::withAlgorithms(const QString &cipherType, Mode modeType, Padding
 	else
 		pad = "pkcs7";
 
-	QString result = cipherType + '-' + mode;
+	QString result = cipherType;
+	if(!mode.isEmpty())
+		result += QString("-") + mode;
 	if(!pad.isEmpty())
 		result += QString("-") + pad;
 
@@ -462,6 +1252,8 @@ class MessageAuthenticationCode::Private
 public:
 	SymmetricKey key;
 
+	// whether the context has been set up with the key
+	bool keyed;
 	bool done;
 	MemoryRegion buf;
 };
@@ -473,6 +1265,7 @@ MessageAuthenticationCode::MessageAuthenticationCode(const QString &type,
 :Algorithm(type, provider)
 {
 	d = new Private;
+	d->keyed = false;
 	setup(key);
 }
 
@@ -519,14 +1312,19 @@ bool MessageAuthenticationCode::validKeyLength(int n) const
 void MessageAuthenticationCode::clear()
 {
 	d->done = false;
-	static_cast<MACContext *>(context())->setup(d->key);
+	MACContext *c = static_cast<MACContext *>(context());
+	if(!d->keyed || !c->reset())
+	{
+		c->setup(d->key);
+		d->keyed = true;
+	}
 }
 
 void MessageAuthenticationCode::update(const MemoryRegion &a)
 {
 	if(d->done)
 		return;
-	static_cast<MACContext *>(context())->update(a);
+	static_cast<MACContext *>(context())->updateView(a);
 }
 
 MemoryRegion MessageAuthenticationCode::final()
@@ -542,7 +1340,15 @@ MemoryRegion MessageAuthenticationCode::final()
 void MessageAuthenticationCode::setup(const SymmetricKey &key)
 {
 	d->key = key;
+	d->keyed = false;
+	clear();
+}
+
+MemoryRegion MessageAuthenticationCode::mac(const MemoryRegion &message)
+{
 	clear();
+	update(message);
+	return final();
 }
 
 //----------------------------------------------------------------------------
@@ -586,9 +1392,178 @@ SymmetricKey KeyDerivationFunction::makeKey(const SecureArray &secret,
 														 iterationCount);
 }
 
+// derives one key on the pool, with a context of its own
+class KDFJob : public ThreadPoolJob
+{
+public:
+	KDFContext *c;
+	SecureArray secret;
+	InitializationVector salt;
+	unsigned int keyLength;
+	unsigned int iterationCount;
+	SymmetricKey key;
+
+	KDFJob(KDFContext *_c) : c(_c)
+	{
+	}
+
+	~KDFJob()
+	{
+		wait();
+		delete c;
+	}
+
+protected:
+	virtual void run()
+	{
+		key = c->makeKey(secret, salt, keyLength, iterationCount);
+	}
+};
+
+static QList<SymmetricKey> make_keys(KDFContext *c, const QList<SecureArray> &secrets, const QList<InitializationVector> &salts, const QList<unsigned int> &keyLengths, unsigned int iterationCount)
+{
+	QList<KDFJob*> jobs;
+	for(int n = 0; n < secrets.count(); ++n)
+	{
+		KDFJob *job = new KDFJob(static_cast<KDFContext *>(c->clone()));
+		job->secret = secrets[n];
+		job->salt = salts[n];
+		job->keyLength = keyLengths[n];
+		job->iterationCount = iterationCount;
+		job->start();
+		jobs += job;
+	}
+
+	// waiting runs any job the pool has not got to yet right here
+	QList<SymmetricKey> keys;
+	foreach(KDFJob *job, jobs)
+	{
+		job->wait();
+		keys += job->key;
+		delete job;
+	}
+	return keys;
+}
+
+QList<SymmetricKey> KeyDerivationFunction::makeKeys(const QList<SecureArray> &secrets, const QList<InitializationVector> &salts, unsigned int keyLength, unsigned int iterationCount)
+{
+	if(secrets.count() != salts.count())
+		return QList<SymmetricKey>();
+
+	QList<unsigned int> keyLengths;
+	for(int n = 0; n < secrets.count(); ++n)
+		keyLengths += keyLength;
+	return make_keys(static_cast<KDFContext *>(context()), secrets, salts, keyLengths, iterationCount);
+}
+
+QList<bool> KeyDerivationFunction::verifyKeys(const QList<SecureArray> &secrets, const QList<InitializationVector> &salts, const QList<SymmetricKey> &keys, unsigned int iterationCount)
+{
+	if(secrets.count() != salts.count() || secrets.count() != keys.count())
+		return QList<bool>();
+
+	QList<unsigned int> keyLengths;
+	foreach(const SymmetricKey &key, keys)
+		keyLengths += key.size();
+	QList<SymmetricKey> derived = make_keys(static_cast<KDFContext *>(context()), secrets, salts, keyLengths, iterationCount);
+
+	// compare without bailing out early, so as not to leak how much
+	//   of a key matched
+	QList<bool> out;
+	for(int n = 0; n < keys.count(); ++n)
+	{
+		const SymmetricKey &a = derived[n];
+		const SymmetricKey &b = keys[n];
+		unsigned char diff = (a.size() == b.size()) ? 0 : 1;
+		for(int k = 0; k < a.size() && k < b.size(); ++k)
+			diff |= (unsigned char)(a[k] ^ b[k]);
+		out += (diff == 0);
+	}
+	return out;
+}
+
 QString KeyDerivationFunction::withAlgorithm(const QString &kdfType, const QString &algType)
 {
 	return (kdfType + '(' + algType + ')');
 }
 
+//----------------------------------------------------------------------------
+// SCRYPT
+//----------------------------------------------------------------------------
+SCRYPT::SCRYPT(const QString &provider)
+:KeyDerivationFunction("scrypt", provider)
+{
+}
+
+void SCRYPT::setParameters(unsigned int cost, unsigned int blockSize, unsigned int parallelism)
+{
+	static_cast<MemoryHardKDFContext *>(context())->setParameters(cost, blockSize, parallelism);
+}
+
+SymmetricKey SCRYPT::makeKey(const SecureArray &secret, const InitializationVector &salt, unsigned int keyLength)
+{
+	return KeyDerivationFunction::makeKey(secret, salt, keyLength, 1);
+}
+
+//----------------------------------------------------------------------------
+// Argon2id
+//----------------------------------------------------------------------------
+Argon2id::Argon2id(const QString &provider)
+:KeyDerivationFunction("argon2id", provider)
+{
+}
+
+void Argon2id::setParameters(unsigned int memoryCost, unsigned int timeCost, unsigned int lanes)
+{
+	static_cast<MemoryHardKDFContext *>(context())->setParameters(memoryCost, timeCost, lanes);
+}
+
+SymmetricKey Argon2id::makeKey(const SecureArray &secret, const InitializationVector &salt, unsigned int keyLength)
+{
+	return KeyDerivationFunction::makeKey(secret, salt, keyLength, 1);
+}
+
+//----------------------------------------------------------------------------
+// HKDF
+//----------------------------------------------------------------------------
+HKDF::HKDF(const QString &algorithm, const QString &provider)
+:Algorithm(KeyDerivationFunction::withAlgorithm("hkdf", algorithm), provider)
+{
+}
+
+HKDF::HKDF(const HKDF &from)
+:Algorithm(from)
+{
+}
+
+HKDF::~HKDF()
+{
+}
+
+HKDF & HKDF::operator=(const HKDF &from)
+{
+	Algorithm::operator=(from);
+	return *this;
+}
+
+SymmetricKey HKDF::extract(const SecureArray &secret, const InitializationVector &salt)
+{
+	return static_cast<HKDFContext *>(context())->extract(secret, salt);
+}
+
+void HKDF::setPrk(const SymmetricKey &prk)
+{
+	static_cast<HKDFContext *>(context())->setPrk(prk);
+}
+
+SymmetricKey HKDF::expand(const InitializationVector &info, unsigned int keyLength)
+{
+	return static_cast<HKDFContext *>(context())->expand(info, keyLength);
+}
+
+SymmetricKey HKDF::makeKey(const SecureArray &secret, const InitializationVector &salt, const InitializationVector &info, unsigned int keyLength)
+{
+	extract(secret, salt);
+	return expand(info, keyLength);
+}
+
 }
@@ -2806,7 +2806,7 @@ PGPKey PGPKey::fromFile(const QString &fileName, ConvertResult *result, const QS
 //----------------------------------------------------------------------------
 // KeyLoader
 //----------------------------------------------------------------------------
-class KeyLoaderThread : public QThread
+class KeyLoaderThread : public ThreadPoolJob
 {
 	Q_OBJECT
 public:
@@ -2832,10 +2832,15 @@ public:
 	In in;
 	Out out;
 
-	KeyLoaderThread(QObject *parent = 0) : QThread(parent)
+	KeyLoaderThread(QObject *parent = 0) : ThreadPoolJob(parent)
 	{
 	}
 
+	~KeyLoaderThread()
+	{
+		wait();
+	}
+
 protected:
 	virtual void run()
 	{
@@ -2881,7 +2886,7 @@ public:
 		// used queued for signal-safety
 		connect(thread, SIGNAL(finished()), SLOT(thread_finished()), Qt::QueuedConnection);
 		thread->in = in;
-		thread->start();
+		thread->start(ThreadPool::HighPriority);
 	}
 
 private slots:
@@ -36,6 +36,9 @@
 #include <QVariantMap>
 #include <QWaitCondition>
 #include <QDir>
+#include <QIODevice>
+
+#include <string.h>
 
 #ifdef Q_OS_UNIX
 # include <unistd.h>
@@ -72,6 +75,9 @@ namespace QCA {
 bool botan_init(int prealloc, bool mmap);
 void botan_deinit();
 
+// from threadpool
+void threadpool_stop();
+
 // from qca_default
 Provider *create_default_provider();
 
@@ -185,6 +191,7 @@ public:
 		}
 		rng_mutex.unlock();
 
+		ThreadPool::instance()->waitForDone();
 		manager->unloadAll();
 	}
 };
@@ -272,6 +279,9 @@ void deinit()
 		// it has been present since ancient times with the same semantics.
 		qRemovePostRoutine(deinit);
 
+		// pool work may still be running plugin code
+		threadpool_stop();
+
 		delete global;
 		global = 0;
 		botan_deinit();
@@ -1018,6 +1028,32 @@ QStringList InfoContext::supportedMACTypes() const
 	return QStringList();
 }
 
+//----------------------------------------------------------------------------
+// HashContext / MACContext
+//----------------------------------------------------------------------------
+// a copy of a view that owns its data, and is secure if the view is
+static MemoryRegion owned_copy(const MemoryRegion &a)
+{
+	if(!a.isView())
+		return a;
+	if(!a.isSecure())
+		return a.toByteArray();
+
+	SecureArray buf(a.size());
+	memcpy(buf.data(), a.constData(), a.size());
+	return buf;
+}
+
+void HashContext::updateView(const MemoryRegion &a)
+{
+	update(owned_copy(a));
+}
+
+void MACContext::updateView(const MemoryRegion &in)
+{
+	update(owned_copy(in));
+}
+
 //----------------------------------------------------------------------------
 // PKeyBase
 //----------------------------------------------------------------------------
@@ -1279,6 +1315,207 @@ MemoryRegion Filter::process(const MemoryRegion &a)
 		return (buf.toByteArray() + fin.toByteArray());
 }
 
+//----------------------------------------------------------------------------
+// FilterChain
+//----------------------------------------------------------------------------
+class FilterChain::Private
+{
+public:
+	class Stage
+	{
+	public:
+		Filter *filter;
+		QList<BufferedComputation*> taps; // on the output
+	};
+
+	QList<BufferedComputation*> inputTaps;
+	QList<Stage> stages;
+	bool ok;
+
+	Private() : ok(true)
+	{
+	}
+
+	static void feed(const QList<BufferedComputation*> &taps, const MemoryRegion &a)
+	{
+		for(int n = 0; n < taps.count(); ++n)
+			taps[n]->update(a);
+	}
+
+	// passes a through the stages starting at 'from'
+	MemoryRegion push(const MemoryRegion &a, int from)
+	{
+		MemoryRegion buf = a;
+		for(int n = from; n < stages.count(); ++n)
+		{
+			if(buf.isEmpty())
+				return MemoryRegion();
+
+			buf = stages[n].filter->update(buf);
+			if(!stages[n].filter->ok())
+			{
+				ok = false;
+				return MemoryRegion();
+			}
+			if(!buf.isEmpty())
+				feed(stages[n].taps, buf);
+		}
+		return buf;
+	}
+};
+
+FilterChain::FilterChain()
+{
+	d = new Private;
+}
+
+FilterChain::~FilterChain()
+{
+	delete d;
+}
+
+void FilterChain::append(Filter *filter)
+{
+	Private::Stage s;
+	s.filter = filter;
+	d->stages += s;
+}
+
+void FilterChain::tap(BufferedComputation *computation)
+{
+	if(d->stages.isEmpty())
+		d->inputTaps += computation;
+	else
+		d->stages.last().taps += computation;
+}
+
+int FilterChain::count() const
+{
+	return d->stages.count();
+}
+
+void FilterChain::clear()
+{
+	for(int n = 0; n < d->inputTaps.count(); ++n)
+		d->inputTaps[n]->clear();
+	for(int n = 0; n < d->stages.count(); ++n)
+	{
+		Private::Stage &s = d->stages[n];
+		s.filter->clear();
+		for(int k = 0; k < s.taps.count(); ++k)
+			s.taps[k]->clear();
+	}
+	d->ok = true;
+}
+
+MemoryRegion FilterChain::update(const MemoryRegion &a)
+{
+	if(!d->ok)
+		return MemoryRegion();
+	if(!a.isEmpty())
+		Private::feed(d->inputTaps, a);
+	return d->push(a, 0);
+}
+
+MemoryRegion FilterChain::final()
+{
+	if(!d->ok)
+		return MemoryRegion();
+
+	// the output of each final() still has to go through the stages
+	//   after it
+	QList<MemoryRegion> parts;
+	bool secure = false;
+	int size = 0;
+	for(int n = 0; n < d->stages.count(); ++n)
+	{
+		Private::Stage &s = d->stages[n];
+		MemoryRegion buf = s.filter->final();
+		if(!s.filter->ok())
+		{
+			d->ok = false;
+			return MemoryRegion();
+		}
+		if(!buf.isEmpty())
+			Private::feed(s.taps, buf);
+
+		buf = d->push(buf, n + 1);
+		if(!d->ok)
+			return MemoryRegion();
+		if(!buf.isEmpty())
+		{
+			parts += buf;
+			secure = secure || buf.isSecure();
+			size += buf.size();
+		}
+	}
+
+	if(parts.count() == 1)
+		return parts.first();
+
+	if(secure)
+	{
+		SecureArray out;
+		out.reserve(size);
+		for(int n = 0; n < parts.count(); ++n)
+			out += SecureArray(parts[n]);
+		return out;
+	}
+	else
+	{
+		QByteArray out;
+		out.reserve(size);
+		for(int n = 0; n < parts.count(); ++n)
+			out.append(parts[n].constData(), parts[n].size());
+		return out;
+	}
+}
+
+bool FilterChain::ok() const
+{
+	return d->ok;
+}
+
+bool FilterChain::process(QIODevice *in, QIODevice *out, int bufferSize)
+{
+	clear();
+	if(bufferSize < 1)
+		bufferSize = 65536;
+
+	// the buffer is reused for every chunk, and handed to the first stage
+	//   without a copy
+	QByteArray buf;
+	buf.resize(bufferSize);
+	while(true)
+	{
+		qint64 len = in->read(buf.data(), bufferSize);
+		if(len < 0)
+			return false;
+		if(len == 0)
+		{
+			// a socket or pipe may just have nothing to read yet.  for
+			//   those, waitForReadyRead() fails once no more data can
+			//   come.  other devices are at the end.
+			if(in->isSequential() && in->waitForReadyRead(-1))
+				continue;
+			break;
+		}
+
+		MemoryRegion result = update(MemoryView(buf.constData(), (int)len));
+		if(!d->ok)
+			return false;
+		if(out && !result.isEmpty() && out->write(result.constData(), result.size()) != result.size())
+			return false;
+	}
+
+	MemoryRegion result = final();
+	if(!d->ok)
+		return false;
+	if(out && !result.isEmpty() && out->write(result.constData(), result.size()) != result.size())
+		return false;
+	return true;
+}
+
 //----------------------------------------------------------------------------
 // Algorithm
 //----------------------------------------------------------------------------
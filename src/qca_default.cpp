@@ -22,6 +22,10 @@
 #include "qca_core.h"
 
 #include <QMutex>
+#include <QDataStream>
+#include <QElapsedTimer>
+#include <QVector>
+#include <stdlib.h>
 #include "qca_textfilter.h"
 #include "qca_cert.h"
 #include "qcaprovider.h"
@@ -30,6 +34,8 @@
 # include "qca_systemstore.h"
 #endif
 
+#include "qca_simd.h"
+
 #define FRIENDLY_NAMES
 
 namespace QCA {
@@ -196,7 +202,9 @@ struct md5_state_t {
 
     md5_state_t & operator=(const md5_state_t &from)
     {
-        *this = from;
+        memcpy(count, from.count, 2 * sizeof(md5_word_t));
+        memcpy(abcd, from.abcd, 4 * sizeof(md5_word_t));
+        memcpy(buf, from.buf, 64 * sizeof(md5_byte_t));
         return *this;
     }
 };
@@ -536,6 +544,38 @@ public:
 		md5_append(&md5, (const md5_byte_t *)in.data(), in.size());
 	}
 
+	// the data is hashed right away, so a view needs no copy
+	virtual void updateView(const MemoryRegion &in)
+	{
+		update(in);
+	}
+
+	// the words are stored portably, so a state can be restored on
+	//   another machine
+	virtual QByteArray saveState() const
+	{
+		QByteArray out;
+		QDataStream s(&out, QIODevice::WriteOnly);
+		s << md5.count[0] << md5.count[1];
+		for(int n = 0; n < 4; ++n)
+			s << md5.abcd[n];
+		s.writeRawData((const char *)md5.buf, 64);
+		return out;
+	}
+
+	virtual bool restoreState(const QByteArray &state)
+	{
+		md5_state_t in;
+		QDataStream s(state);
+		s >> in.count[0] >> in.count[1];
+		for(int n = 0; n < 4; ++n)
+			s >> in.abcd[n];
+		if(s.readRawData((char *)in.buf, 64) != 64 || s.status() != QDataStream::Ok || !s.atEnd())
+			return false;
+		md5 = in;
+		return true;
+	}
+
 	virtual MemoryRegion final()
 	{
 		if(secure)
@@ -597,7 +637,9 @@ struct SHA1_CONTEXT
 
 	SHA1_CONTEXT & operator=(const SHA1_CONTEXT &from)
 	{
-		*this = from;
+		memcpy(state, from.state, 5 * sizeof(quint32));
+		memcpy(count, from.count, 2 * sizeof(quint32));
+		memcpy(buffer, from.buffer, 64 * sizeof(unsigned char));
 		return *this;
 	}
 };
@@ -641,6 +683,35 @@ public:
 		sha1_update(&_context, (unsigned char *)in.data(), (unsigned int)in.size());
 	}
 
+	virtual void updateView(const MemoryRegion &in)
+	{
+		update(in);
+	}
+
+	virtual QByteArray saveState() const
+	{
+		QByteArray out;
+		QDataStream s(&out, QIODevice::WriteOnly);
+		for(int n = 0; n < 5; ++n)
+			s << _context.state[n];
+		s << _context.count[0] << _context.count[1];
+		s.writeRawData((const char *)_context.buffer, 64);
+		return out;
+	}
+
+	virtual bool restoreState(const QByteArray &state)
+	{
+		SHA1_CONTEXT in;
+		QDataStream s(state);
+		for(int n = 0; n < 5; ++n)
+			s >> in.state[n];
+		s >> in.count[0] >> in.count[1];
+		if(s.readRawData((char *)in.buffer, 64) != 64 || s.status() != QDataStream::Ok || !s.atEnd())
+			return false;
+		_context = in;
+		return true;
+	}
+
 	virtual MemoryRegion final()
 	{
 		if(secure)
@@ -786,6 +857,3071 @@ public:
 	}
 };
 
+//----------------------------------------------------------------------------
+// DefaultPBKDF2Context
+//----------------------------------------------------------------------------
+// PBKDF2 of RFC2898 with HMAC-SHA1.  the inner and outer HMAC states are
+//   computed from the password once, after which every iteration hashes
+//   exactly one padded block for each.  the output blocks of a long key
+//   are independent of each other, so all but the first are computed on
+//   the thread pool while the calling thread computes the first.
+class DefaultPBKDF2Context : public KDFContext
+{
+public:
+	class Block : public ThreadPoolJob
+	{
+	public:
+		DefaultSHA1Context sha;
+		SHA1_CONTEXT inner, outer;
+		SecureArray salt;
+		quint32 index;
+		unsigned int iterations;
+		int msecInterval; // if not negative, iterate for this long instead
+		unsigned char t[20];
+
+		Block(Provider *p) : sha(p)
+		{
+		}
+
+		~Block()
+		{
+			wait();
+			memset(t, 0, 20);
+		}
+
+		// one HMAC over a 20 byte message, in place
+		void hmac(unsigned char u[20])
+		{
+			unsigned char buf[64];
+			quint32 state[5];
+
+			hashBlock(inner, u, buf, state);
+			for(int n = 0; n < 20; ++n)
+				u[n] = (unsigned char)(state[n >> 2] >> ((3 - (n & 3)) * 8));
+			hashBlock(outer, u, buf, state);
+			for(int n = 0; n < 20; ++n)
+				u[n] = (unsigned char)(state[n >> 2] >> ((3 - (n & 3)) * 8));
+
+			memset(buf, 0, 64);
+		}
+
+		// the message follows the 64 byte key block, so it is 84 bytes
+		//   long in total, and its padding fits into the same block
+		void hashBlock(const SHA1_CONTEXT &key, const unsigned char u[20], unsigned char buf[64], quint32 state[5])
+		{
+			memcpy(buf, u, 20);
+			buf[20] = 0x80;
+			memset(buf + 21, 0, 41);
+			buf[62] = (84 * 8) >> 8;
+			buf[63] = (84 * 8) & 0xff;
+			memcpy(state, key.state, 5 * sizeof(quint32));
+			sha.transform(state, buf);
+		}
+
+		void compute()
+		{
+			unsigned char idx[4] = { (unsigned char)(index >> 24), (unsigned char)(index >> 16), (unsigned char)(index >> 8), (unsigned char)index };
+			unsigned char u[20];
+
+			// U_1 = PRF(P, S || INT(i)), which is the only one of arbitrary length
+			SHA1_CONTEXT c = inner;
+			sha.sha1_update(&c, (unsigned char *)salt.data(), salt.size());
+			sha.sha1_update(&c, idx, 4);
+			sha.sha1_final(u, &c);
+			c = outer;
+			sha.sha1_update(&c, u, 20);
+			sha.sha1_final(u, &c);
+			memcpy(t, u, 20);
+
+			// the clock is only looked at every 64 iterations
+			QElapsedTimer timer;
+			timer.start();
+			unsigned int n = 1;
+			while(msecInterval >= 0 ? (n % 64 != 0 || timer.elapsed() < msecInterval) : n < iterations)
+			{
+				hmac(u);
+				for(int k = 0; k < 20; ++k)
+					t[k] ^= u[k];
+				++n;
+			}
+			iterations = n;
+
+			memset(u, 0, 20);
+		}
+
+	protected:
+		virtual void run()
+		{
+			compute();
+		}
+	};
+
+	DefaultPBKDF2Context(Provider *p) : KDFContext(p, "pbkdf2(sha1)")
+	{
+	}
+
+	virtual Provider::Context *clone() const
+	{
+		return new DefaultPBKDF2Context(*this);
+	}
+
+	virtual SymmetricKey makeKey(const SecureArray &secret, const InitializationVector &salt, unsigned int keyLength, unsigned int iterationCount)
+	{
+		return derive(secret, salt, keyLength, iterationCount, -1, 0);
+	}
+
+	virtual SymmetricKey makeKey(const SecureArray &secret, const InitializationVector &salt, unsigned int keyLength, int msecInterval, unsigned int *iterationCount)
+	{
+		Q_ASSERT(iterationCount != NULL);
+		return derive(secret, salt, keyLength, 0, qMax(msecInterval, 0), iterationCount);
+	}
+
+private:
+	Block *makeBlock(const SHA1_CONTEXT &inner, const SHA1_CONTEXT &outer, const SecureArray &salt, quint32 index, unsigned int iterations, int msecInterval)
+	{
+		Block *b = new Block(provider());
+		b->inner = inner;
+		b->outer = outer;
+		b->salt = salt;
+		b->index = index;
+		b->iterations = iterations;
+		b->msecInterval = msecInterval;
+		return b;
+	}
+
+	SymmetricKey derive(const SecureArray &secret, const InitializationVector &salt, unsigned int keyLength, unsigned int iterationCount, int msecInterval, unsigned int *iterationsDone)
+	{
+		if(keyLength == 0)
+			return SymmetricKey();
+
+		// the HMAC key schedule, as hash states after the padded key
+		DefaultSHA1Context sha(provider());
+		SecureArray key = secret;
+		if(key.size() > 64)
+		{
+			sha.clear();
+			sha.update(key);
+			key = sha.final();
+		}
+		SecureArray ipad(64, 0x36);
+		SecureArray opad(64, 0x5c);
+		for(int n = 0; n < key.size(); ++n)
+		{
+			ipad[n] ^= key[n];
+			opad[n] ^= key[n];
+		}
+		SHA1_CONTEXT inner, outer;
+		sha.sha1_init(&inner);
+		sha.sha1_update(&inner, (unsigned char *)ipad.data(), 64);
+		sha.sha1_init(&outer);
+		sha.sha1_update(&outer, (unsigned char *)opad.data(), 64);
+
+		unsigned int blocks = (keyLength + 19) / 20;
+		SecureArray out(blocks * 20);
+
+		// with a time limit, the first block determines the iteration
+		//   count, and the others then run in parallel.  the first gets
+		//   its share of the time accordingly.
+		if(msecInterval >= 0)
+		{
+			int threads = qMax(ThreadPool::instance()->maxThreadCount(), 1);
+			int rounds = 1 + (blocks - 1 + threads - 1) / threads;
+			Block *first = makeBlock(inner, outer, salt, 1, 0, msecInterval / rounds);
+			first->compute();
+			iterationCount = first->iterations;
+			*iterationsDone = iterationCount;
+			memcpy(out.data(), first->t, 20);
+			delete first;
+
+			if(blocks > 1)
+				computeBlocks(inner, outer, salt, 2, blocks, iterationCount, &out);
+		}
+		else
+			computeBlocks(inner, outer, salt, 1, blocks, iterationCount, &out);
+
+		out.resize(keyLength);
+		return out;
+	}
+
+	void computeBlocks(const SHA1_CONTEXT &inner, const SHA1_CONTEXT &outer, const SecureArray &salt, unsigned int from, unsigned int to, unsigned int iterations, SecureArray *out)
+	{
+		QList<Block*> jobs;
+		for(unsigned int n = from; n <= to; ++n)
+			jobs += makeBlock(inner, outer, salt, n, iterations, -1);
+
+		// the calling thread takes the first block, and any that the
+		//   pool has not got to by the time it is done
+		for(int n = 1; n < jobs.count(); ++n)
+			jobs[n]->start();
+		jobs[0]->compute();
+		for(int n = 0; n < jobs.count(); ++n)
+		{
+			jobs[n]->wait();
+			memcpy(out->data() + (from - 1 + n) * 20, jobs[n]->t, 20);
+			delete jobs[n];
+		}
+	}
+};
+
+//----------------------------------------------------------------------------
+// Memory-hard KDF primitives
+//----------------------------------------------------------------------------
+static inline quint32 rotl32(quint32 x, int n)
+{
+	return (x << n) | (x >> (32 - n));
+}
+
+static inline quint32 rotr32(quint32 x, int n)
+{
+	return (x >> n) | (x << (32 - n));
+}
+
+static inline quint64 rotl64(quint64 x, int n)
+{
+	return (x << n) | (x >> (64 - n));
+}
+
+static inline quint64 rotr64(quint64 x, int n)
+{
+	return (x >> n) | (x << (64 - n));
+}
+
+static inline quint32 load32_le(const unsigned char *p)
+{
+	return (quint32)p[0] | ((quint32)p[1] << 8) | ((quint32)p[2] << 16) | ((quint32)p[3] << 24);
+}
+
+static inline void store32_le(unsigned char *p, quint32 x)
+{
+	p[0] = (unsigned char)x;
+	p[1] = (unsigned char)(x >> 8);
+	p[2] = (unsigned char)(x >> 16);
+	p[3] = (unsigned char)(x >> 24);
+}
+
+static inline quint64 load64_le(const unsigned char *p)
+{
+	return (quint64)load32_le(p) | ((quint64)load32_le(p + 4) << 32);
+}
+
+static inline void store64_le(unsigned char *p, quint64 x)
+{
+	store32_le(p, (quint32)x);
+	store32_le(p + 4, (quint32)(x >> 32));
+}
+
+//----------------------------------------------------------------------------
+// SSSE3 support
+//----------------------------------------------------------------------------
+// The BLAKE2, BLAKE3 and ChaCha20 rounds have SSSE3 versions, used if
+// the CPU supports it (see qca_simd.h).  Rotations by whole bytes are
+// done with a byte shuffle.
+
+#ifdef QCA_HAVE_SSSE3
+
+// n is a constant wherever these are used, so only one branch remains
+QCA_TARGET_SSSE3 static inline __m128i rotr32_ssse3(__m128i x, int n)
+{
+	if(n == 8)
+		return _mm_shuffle_epi8(x, _mm_setr_epi8(1, 2, 3, 0, 5, 6, 7, 4, 9, 10, 11, 8, 13, 14, 15, 12));
+	if(n == 16)
+		return _mm_shuffle_epi8(x, _mm_setr_epi8(2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13));
+	if(n == 24)
+		return _mm_shuffle_epi8(x, _mm_setr_epi8(3, 0, 1, 2, 7, 4, 5, 6, 11, 8, 9, 10, 15, 12, 13, 14));
+	return _mm_or_si128(_mm_srli_epi32(x, n), _mm_slli_epi32(x, 32 - n));
+}
+
+QCA_TARGET_SSSE3 static inline __m128i rotr64_ssse3(__m128i x, int n)
+{
+	if(n == 16)
+		return _mm_shuffle_epi8(x, _mm_setr_epi8(2, 3, 4, 5, 6, 7, 0, 1, 10, 11, 12, 13, 14, 15, 8, 9));
+	if(n == 24)
+		return _mm_shuffle_epi8(x, _mm_setr_epi8(3, 4, 5, 6, 7, 0, 1, 2, 11, 12, 13, 14, 15, 8, 9, 10));
+	if(n == 32)
+		return _mm_shuffle_epi32(x, _MM_SHUFFLE(2, 3, 0, 1));
+	if(n == 63)
+		return _mm_xor_si128(_mm_srli_epi64(x, 63), _mm_add_epi64(x, x));
+	return _mm_or_si128(_mm_srli_epi64(x, n), _mm_slli_epi64(x, 64 - n));
+}
+
+// x[i] holds word j of four blocks, and afterwards x[j] holds word i
+QCA_TARGET_SSSE3 static inline void transpose4_ssse3(__m128i *x)
+{
+	__m128i t0 = _mm_unpacklo_epi32(x[0], x[1]);
+	__m128i t1 = _mm_unpackhi_epi32(x[0], x[1]);
+	__m128i t2 = _mm_unpacklo_epi32(x[2], x[3]);
+	__m128i t3 = _mm_unpackhi_epi32(x[2], x[3]);
+	x[0] = _mm_unpacklo_epi64(t0, t2);
+	x[1] = _mm_unpackhi_epi64(t0, t2);
+	x[2] = _mm_unpacklo_epi64(t1, t3);
+	x[3] = _mm_unpackhi_epi64(t1, t3);
+}
+
+// the rounds of BLAKE2b on the working vector v, a row of four words in
+//   each pair of registers.  the diagonal steps turn the rows so that
+//   they become columns.
+QCA_TARGET_SSSE3 static void blake2b_rounds_ssse3(quint64 *v, const quint64 *m, const unsigned char (*sigma)[16])
+{
+	__m128i al = _mm_loadu_si128((const __m128i *)(v + 0));
+	__m128i ah = _mm_loadu_si128((const __m128i *)(v + 2));
+	__m128i bl = _mm_loadu_si128((const __m128i *)(v + 4));
+	__m128i bh = _mm_loadu_si128((const __m128i *)(v + 6));
+	__m128i cl = _mm_loadu_si128((const __m128i *)(v + 8));
+	__m128i ch = _mm_loadu_si128((const __m128i *)(v + 10));
+	__m128i dl = _mm_loadu_si128((const __m128i *)(v + 12));
+	__m128i dh = _mm_loadu_si128((const __m128i *)(v + 14));
+
+#define B2B_G2(a, b, c, d, x, y) \
+		a = _mm_add_epi64(_mm_add_epi64(a, b), x); d = rotr64_ssse3(_mm_xor_si128(d, a), 32); \
+		c = _mm_add_epi64(c, d);                   b = rotr64_ssse3(_mm_xor_si128(b, c), 24); \
+		a = _mm_add_epi64(_mm_add_epi64(a, b), y); d = rotr64_ssse3(_mm_xor_si128(d, a), 16); \
+		c = _mm_add_epi64(c, d);                   b = rotr64_ssse3(_mm_xor_si128(b, c), 63);
+#define B2B_M(i, j) _mm_set_epi64x((qint64)m[s[j]], (qint64)m[s[i]])
+
+	for(int i = 0; i < 12; ++i)
+	{
+		const unsigned char *s = sigma[i];
+		B2B_G2(al, bl, cl, dl, B2B_M(0, 2), B2B_M(1, 3));
+		B2B_G2(ah, bh, ch, dh, B2B_M(4, 6), B2B_M(5, 7));
+
+		__m128i t0 = _mm_alignr_epi8(bh, bl, 8);
+		__m128i t1 = _mm_alignr_epi8(bl, bh, 8);
+		bl = t0;
+		bh = t1;
+		t0 = cl;
+		cl = ch;
+		ch = t0;
+		t0 = _mm_alignr_epi8(dh, dl, 8);
+		t1 = _mm_alignr_epi8(dl, dh, 8);
+		dl = t1;
+		dh = t0;
+
+		B2B_G2(al, bl, cl, dl, B2B_M(8, 10), B2B_M(9, 11));
+		B2B_G2(ah, bh, ch, dh, B2B_M(12, 14), B2B_M(13, 15));
+
+		t0 = _mm_alignr_epi8(bl, bh, 8);
+		t1 = _mm_alignr_epi8(bh, bl, 8);
+		bl = t0;
+		bh = t1;
+		t0 = cl;
+		cl = ch;
+		ch = t0;
+		t0 = _mm_alignr_epi8(dl, dh, 8);
+		t1 = _mm_alignr_epi8(dh, dl, 8);
+		dl = t1;
+		dh = t0;
+	}
+#undef B2B_M
+#undef B2B_G2
+
+	_mm_storeu_si128((__m128i *)(v + 0), al);
+	_mm_storeu_si128((__m128i *)(v + 2), ah);
+	_mm_storeu_si128((__m128i *)(v + 4), bl);
+	_mm_storeu_si128((__m128i *)(v + 6), bh);
+	_mm_storeu_si128((__m128i *)(v + 8), cl);
+	_mm_storeu_si128((__m128i *)(v + 10), ch);
+	_mm_storeu_si128((__m128i *)(v + 12), dl);
+	_mm_storeu_si128((__m128i *)(v + 14), dh);
+}
+
+// the rounds of BLAKE2s, and of BLAKE3, which differs only in its
+//   message schedule and number of rounds.  a row is one register.
+QCA_TARGET_SSSE3 static void blake2s_rounds_ssse3(quint32 *v, const quint32 *m, const unsigned char (*sigma)[16], int rounds)
+{
+	__m128i a = _mm_loadu_si128((const __m128i *)(v + 0));
+	__m128i b = _mm_loadu_si128((const __m128i *)(v + 4));
+	__m128i c = _mm_loadu_si128((const __m128i *)(v + 8));
+	__m128i d = _mm_loadu_si128((const __m128i *)(v + 12));
+
+#define B2S_G4(x, y) \
+		a = _mm_add_epi32(_mm_add_epi32(a, b), x); d = rotr32_ssse3(_mm_xor_si128(d, a), 16); \
+		c = _mm_add_epi32(c, d);                   b = rotr32_ssse3(_mm_xor_si128(b, c), 12); \
+		a = _mm_add_epi32(_mm_add_epi32(a, b), y); d = rotr32_ssse3(_mm_xor_si128(d, a), 8); \
+		c = _mm_add_epi32(c, d);                   b = rotr32_ssse3(_mm_xor_si128(b, c), 7);
+#define B2S_M(i, j, k, l) _mm_setr_epi32((int)m[s[i]], (int)m[s[j]], (int)m[s[k]], (int)m[s[l]])
+
+	for(int i = 0; i < rounds; ++i)
+	{
+		const unsigned char *s = sigma[i];
+		B2S_G4(B2S_M(0, 2, 4, 6), B2S_M(1, 3, 5, 7));
+		b = _mm_shuffle_epi32(b, _MM_SHUFFLE(0, 3, 2, 1));
+		c = _mm_shuffle_epi32(c, _MM_SHUFFLE(1, 0, 3, 2));
+		d = _mm_shuffle_epi32(d, _MM_SHUFFLE(2, 1, 0, 3));
+		B2S_G4(B2S_M(8, 10, 12, 14), B2S_M(9, 11, 13, 15));
+		b = _mm_shuffle_epi32(b, _MM_SHUFFLE(2, 1, 0, 3));
+		c = _mm_shuffle_epi32(c, _MM_SHUFFLE(1, 0, 3, 2));
+		d = _mm_shuffle_epi32(d, _MM_SHUFFLE(0, 3, 2, 1));
+	}
+#undef B2S_M
+#undef B2S_G4
+
+	_mm_storeu_si128((__m128i *)(v + 0), a);
+	_mm_storeu_si128((__m128i *)(v + 4), b);
+	_mm_storeu_si128((__m128i *)(v + 8), c);
+	_mm_storeu_si128((__m128i *)(v + 12), d);
+}
+
+#endif
+
+// SHA-256, for the PBKDF2 steps of scrypt
+class SHA256State
+{
+public:
+	quint32 h[8];
+	quint64 len;
+	unsigned char buf[64];
+
+	SHA256State()
+	{
+		static const quint32 iv[8] =
+		{
+			0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+			0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+		};
+		memcpy(h, iv, sizeof(h));
+		len = 0;
+	}
+
+	void update(const unsigned char *data, size_t n)
+	{
+		size_t used = (size_t)(len & 63);
+		len += n;
+		if(used)
+		{
+			size_t k = qMin((size_t)64 - used, n);
+			memcpy(buf + used, data, k);
+			data += k;
+			n -= k;
+			if(used + k < 64)
+				return;
+			transform(buf);
+		}
+		for(; n >= 64; data += 64, n -= 64)
+			transform(data);
+		memcpy(buf, data, n);
+	}
+
+	void final(unsigned char out[32])
+	{
+		unsigned char pad[72];
+		size_t used = (size_t)(len & 63);
+		size_t padLen = (used < 56 ? 56 : 120) - used;
+		quint64 bits = len * 8;
+		memset(pad, 0, sizeof(pad));
+		pad[0] = 0x80;
+		for(int n = 0; n < 8; ++n)
+			pad[padLen + n] = (unsigned char)(bits >> (56 - n * 8));
+		update(pad, padLen + 8);
+		for(int n = 0; n < 32; ++n)
+			out[n] = (unsigned char)(h[n >> 2] >> ((3 - (n & 3)) * 8));
+	}
+
+private:
+	void transform(const unsigned char *p)
+	{
+		static const quint32 k[64] =
+		{
+			0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+			0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+			0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+			0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+			0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+			0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+			0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+			0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+		};
+		quint32 w[64];
+		for(int n = 0; n < 16; ++n)
+			w[n] = ((quint32)p[n * 4] << 24) | ((quint32)p[n * 4 + 1] << 16) | ((quint32)p[n * 4 + 2] << 8) | p[n * 4 + 3];
+		for(int n = 16; n < 64; ++n)
+		{
+			quint32 s0 = rotl32(w[n - 15], 25) ^ rotl32(w[n - 15], 14) ^ (w[n - 15] >> 3);
+			quint32 s1 = rotl32(w[n - 2], 15) ^ rotl32(w[n - 2], 13) ^ (w[n - 2] >> 10);
+			w[n] = w[n - 16] + s0 + w[n - 7] + s1;
+		}
+		quint32 a = h[0], b = h[1], c = h[2], d = h[3], e = h[4], f = h[5], g = h[6], hh = h[7];
+		for(int n = 0; n < 64; ++n)
+		{
+			quint32 t1 = hh + (rotl32(e, 26) ^ rotl32(e, 21) ^ rotl32(e, 7)) + ((e & f) ^ (~e & g)) + k[n] + w[n];
+			quint32 t2 = (rotl32(a, 30) ^ rotl32(a, 19) ^ rotl32(a, 10)) + ((a & b) ^ (a & c) ^ (b & c));
+			hh = g;
+			g = f;
+			f = e;
+			e = d + t1;
+			d = c;
+			c = b;
+			b = a;
+			a = t1 + t2;
+		}
+		h[0] += a; h[1] += b; h[2] += c; h[3] += d;
+		h[4] += e; h[5] += f; h[6] += g; h[7] += hh;
+	}
+};
+
+// PBKDF2 with HMAC-SHA256 and a single iteration, as scrypt uses it
+static void pbkdf2_sha256_once(const unsigned char *secret, size_t secretLen, const unsigned char *salt, size_t saltLen, unsigned char *out, size_t outLen)
+{
+	unsigned char key[64];
+	memset(key, 0, 64);
+	if(secretLen > 64)
+	{
+		SHA256State s;
+		s.update(secret, secretLen);
+		s.final(key);
+	}
+	else if(secretLen > 0)
+		memcpy(key, secret, secretLen);
+
+	unsigned char pad[64];
+	SHA256State inner, outer;
+	for(int n = 0; n < 64; ++n)
+		pad[n] = key[n] ^ 0x36;
+	inner.update(pad, 64);
+	for(int n = 0; n < 64; ++n)
+		pad[n] = key[n] ^ 0x5c;
+	outer.update(pad, 64);
+
+	unsigned char u[32];
+	for(quint32 i = 1; outLen > 0; ++i)
+	{
+		unsigned char idx[4] = { (unsigned char)(i >> 24), (unsigned char)(i >> 16), (unsigned char)(i >> 8), (unsigned char)i };
+		SHA256State c = inner;
+		c.update(salt, saltLen);
+		c.update(idx, 4);
+		c.final(u);
+		c = outer;
+		c.update(u, 32);
+		c.final(u);
+
+		size_t n = qMin(outLen, (size_t)32);
+		memcpy(out, u, n);
+		out += n;
+		outLen -= n;
+	}
+
+	memset(key, 0, 64);
+	memset(pad, 0, 64);
+	memset(u, 0, 32);
+}
+
+// the scrypt mixing function of RFC 7914, over one lane
+static void salsa20_8(quint32 b[16])
+{
+	quint32 x[16];
+	memcpy(x, b, 64);
+	for(int n = 0; n < 8; n += 2)
+	{
+		x[ 4] ^= rotl32(x[ 0] + x[12],  7); x[ 8] ^= rotl32(x[ 4] + x[ 0],  9);
+		x[12] ^= rotl32(x[ 8] + x[ 4], 13); x[ 0] ^= rotl32(x[12] + x[ 8], 18);
+		x[ 9] ^= rotl32(x[ 5] + x[ 1],  7); x[13] ^= rotl32(x[ 9] + x[ 5],  9);
+		x[ 1] ^= rotl32(x[13] + x[ 9], 13); x[ 5] ^= rotl32(x[ 1] + x[13], 18);
+		x[14] ^= rotl32(x[10] + x[ 6],  7); x[ 2] ^= rotl32(x[14] + x[10],  9);
+		x[ 6] ^= rotl32(x[ 2] + x[14], 13); x[10] ^= rotl32(x[ 6] + x[ 2], 18);
+		x[ 3] ^= rotl32(x[15] + x[11],  7); x[ 7] ^= rotl32(x[ 3] + x[15],  9);
+		x[11] ^= rotl32(x[ 7] + x[ 3], 13); x[15] ^= rotl32(x[11] + x[ 7], 18);
+		x[ 1] ^= rotl32(x[ 0] + x[ 3],  7); x[ 2] ^= rotl32(x[ 1] + x[ 0],  9);
+		x[ 3] ^= rotl32(x[ 2] + x[ 1], 13); x[ 0] ^= rotl32(x[ 3] + x[ 2], 18);
+		x[ 6] ^= rotl32(x[ 5] + x[ 4],  7); x[ 7] ^= rotl32(x[ 6] + x[ 5],  9);
+		x[ 4] ^= rotl32(x[ 7] + x[ 6], 13); x[ 5] ^= rotl32(x[ 4] + x[ 7], 18);
+		x[11] ^= rotl32(x[10] + x[ 9],  7); x[ 8] ^= rotl32(x[11] + x[10],  9);
+		x[ 9] ^= rotl32(x[ 8] + x[11], 13); x[10] ^= rotl32(x[ 9] + x[ 8], 18);
+		x[12] ^= rotl32(x[15] + x[14],  7); x[13] ^= rotl32(x[12] + x[15],  9);
+		x[14] ^= rotl32(x[13] + x[12], 13); x[15] ^= rotl32(x[14] + x[13], 18);
+	}
+	for(int n = 0; n < 16; ++n)
+		b[n] += x[n];
+}
+
+static void scrypt_blockmix(quint32 *b, quint32 *y, unsigned int r)
+{
+	quint32 x[16];
+	memcpy(x, b + (2 * r - 1) * 16, 64);
+	for(unsigned int i = 0; i < 2 * r; ++i)
+	{
+		for(int k = 0; k < 16; ++k)
+			x[k] ^= b[i * 16 + k];
+		salsa20_8(x);
+		memcpy(y + i * 16, x, 64);
+	}
+	for(unsigned int i = 0; i < r; ++i)
+	{
+		memcpy(b + i * 16, y + (2 * i) * 16, 64);
+		memcpy(b + (i + r) * 16, y + (2 * i + 1) * 16, 64);
+	}
+}
+
+// b is the 128 * r bytes of the lane, v has room for n times that, and
+//   xy for twice that
+static void scrypt_romix(unsigned char *b, quint32 *v, quint32 *xy, unsigned int n, unsigned int r)
+{
+	size_t words = 32 * (size_t)r;
+	quint32 *x = xy;
+	quint32 *y = xy + words;
+
+	for(size_t k = 0; k < words; ++k)
+		x[k] = load32_le(b + k * 4);
+	for(unsigned int i = 0; i < n; ++i)
+	{
+		memcpy(v + i * words, x, words * 4);
+		scrypt_blockmix(x, y, r);
+	}
+	for(unsigned int i = 0; i < n; ++i)
+	{
+		const quint32 *vj = v + (x[(2 * r - 1) * 16] & (n - 1)) * words;
+		for(size_t k = 0; k < words; ++k)
+			x[k] ^= vj[k];
+		scrypt_blockmix(x, y, r);
+	}
+	for(size_t k = 0; k < words; ++k)
+		store32_le(b + k * 4, x[k]);
+}
+
+// BLAKE2b of RFC 7693, unkeyed, for Argon2 and the BLAKE2 hashes.  the
+//   tree parameters are only needed for the nodes of BLAKE2bp.
+class Blake2bState
+{
+public:
+	quint64 h[8];
+	quint64 t[2];
+	unsigned char buf[128];
+	size_t bufLen;
+	size_t outLen;
+	bool lastNode;
+
+	Blake2bState(size_t _outLen = 64, quint32 fanout = 1, quint32 depth = 1, quint64 nodeOffset = 0, quint32 nodeDepth = 0, quint32 innerLength = 0)
+	{
+		outLen = _outLen;
+		for(int n = 0; n < 8; ++n)
+			h[n] = iv(n);
+		h[0] ^= (quint64)outLen | (fanout << 16) | (depth << 24);
+		h[1] ^= nodeOffset;
+		h[2] ^= nodeDepth | (innerLength << 8);
+		t[0] = t[1] = 0;
+		bufLen = 0;
+		lastNode = false;
+	}
+
+	void update(const unsigned char *data, size_t n)
+	{
+		// the last block is held back, since it is compressed differently
+		while(n > 0)
+		{
+			if(bufLen == 128)
+			{
+				count(128);
+				compress(buf, false);
+				bufLen = 0;
+			}
+			size_t k = qMin((size_t)128 - bufLen, n);
+			memcpy(buf + bufLen, data, k);
+			bufLen += k;
+			data += k;
+			n -= k;
+		}
+	}
+
+	void final(unsigned char *out)
+	{
+		count(bufLen);
+		memset(buf + bufLen, 0, 128 - bufLen);
+		compress(buf, true);
+
+		unsigned char full[64];
+		for(int n = 0; n < 8; ++n)
+			store64_le(full + n * 8, h[n]);
+		memcpy(out, full, outLen);
+		memset(full, 0, 64);
+	}
+
+private:
+	static quint64 iv(int n)
+	{
+		static const quint64 v[8] =
+		{
+			Q_UINT64_C(0x6a09e667f3bcc908), Q_UINT64_C(0xbb67ae8584caa73b),
+			Q_UINT64_C(0x3c6ef372fe94f82b), Q_UINT64_C(0xa54ff53a5f1d36f1),
+			Q_UINT64_C(0x510e527fade682d1), Q_UINT64_C(0x9b05688c2b3e6c1f),
+			Q_UINT64_C(0x1f83d9abfb41bd6b), Q_UINT64_C(0x5be0cd19137e2179)
+		};
+		return v[n];
+	}
+
+	void count(size_t n)
+	{
+		t[0] += n;
+		if(t[0] < n)
+			++t[1];
+	}
+
+	void compress(const unsigned char *block, bool last)
+	{
+		static const unsigned char sigma[12][16] =
+		{
+			{  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15 },
+			{ 14, 10,  4,  8,  9, 15, 13,  6,  1, 12,  0,  2, 11,  7,  5,  3 },
+			{ 11,  8, 12,  0,  5,  2, 15, 13, 10, 14,  3,  6,  7,  1,  9,  4 },
+			{  7,  9,  3,  1, 13, 12, 11, 14,  2,  6,  5, 10,  4,  0, 15,  8 },
+			{  9,  0,  5,  7,  2,  4, 10, 15, 14,  1, 11, 12,  6,  8,  3, 13 },
+			{  2, 12,  6, 10,  0, 11,  8,  3,  4, 13,  7,  5, 15, 14,  1,  9 },
+			{ 12,  5,  1, 15, 14, 13,  4, 10,  0,  7,  6,  3,  9,  2,  8, 11 },
+			{ 13, 11,  7, 14, 12,  1,  3,  9,  5,  0, 15,  4,  8,  6,  2, 10 },
+			{  6, 15, 14,  9, 11,  3,  0,  8, 12,  2, 13,  7,  1,  4, 10,  5 },
+			{ 10,  2,  8,  4,  7,  6,  1,  5, 15, 11,  9, 14,  3, 12, 13,  0 },
+			{  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15 },
+			{ 14, 10,  4,  8,  9, 15, 13,  6,  1, 12,  0,  2, 11,  7,  5,  3 }
+		};
+
+		quint64 m[16], v[16];
+		for(int n = 0; n < 16; ++n)
+			m[n] = load64_le(block + n * 8);
+		for(int n = 0; n < 8; ++n)
+		{
+			v[n] = h[n];
+			v[n + 8] = iv(n);
+		}
+		v[12] ^= t[0];
+		v[13] ^= t[1];
+		if(last)
+			v[14] = ~v[14];
+		if(last && lastNode)
+			v[15] = ~v[15];
+
+#ifdef QCA_HAVE_SSSE3
+		if(have_ssse3())
+		{
+			blake2b_rounds_ssse3(v, m, sigma);
+			for(int n = 0; n < 8; ++n)
+				h[n] ^= v[n] ^ v[n + 8];
+			return;
+		}
+#endif
+
+#define B2B_G(a, b, c, d, x, y) \
+		v[a] = v[a] + v[b] + (x); v[d] = rotr64(v[d] ^ v[a], 32); \
+		v[c] = v[c] + v[d];       v[b] = rotr64(v[b] ^ v[c], 24); \
+		v[a] = v[a] + v[b] + (y); v[d] = rotr64(v[d] ^ v[a], 16); \
+		v[c] = v[c] + v[d];       v[b] = rotr64(v[b] ^ v[c], 63);
+
+		for(int i = 0; i < 12; ++i)
+		{
+			const unsigned char *s = sigma[i];
+			B2B_G(0, 4,  8, 12, m[s[ 0]], m[s[ 1]]);
+			B2B_G(1, 5,  9, 13, m[s[ 2]], m[s[ 3]]);
+			B2B_G(2, 6, 10, 14, m[s[ 4]], m[s[ 5]]);
+			B2B_G(3, 7, 11, 15, m[s[ 6]], m[s[ 7]]);
+			B2B_G(0, 5, 10, 15, m[s[ 8]], m[s[ 9]]);
+			B2B_G(1, 6, 11, 12, m[s[10]], m[s[11]]);
+			B2B_G(2, 7,  8, 13, m[s[12]], m[s[13]]);
+			B2B_G(3, 4,  9, 14, m[s[14]], m[s[15]]);
+		}
+#undef B2B_G
+
+		for(int n = 0; n < 8; ++n)
+			h[n] ^= v[n] ^ v[n + 8];
+	}
+};
+
+// the variable length hash H' of RFC 9106
+static void argon2_hash(unsigned char *out, size_t outLen, const unsigned char *in, size_t inLen)
+{
+	unsigned char len[4];
+	store32_le(len, (quint32)outLen);
+
+	if(outLen <= 64)
+	{
+		Blake2bState b(outLen);
+		b.update(len, 4);
+		b.update(in, inLen);
+		b.final(out);
+		return;
+	}
+
+	unsigned char v[64];
+	Blake2bState b(64);
+	b.update(len, 4);
+	b.update(in, inLen);
+	b.final(v);
+	memcpy(out, v, 32);
+	out += 32;
+	size_t left = outLen - 32;
+	while(left > 64)
+	{
+		Blake2bState c(64);
+		c.update(v, 64);
+		c.final(v);
+		memcpy(out, v, 32);
+		out += 32;
+		left -= 32;
+	}
+	Blake2bState c(left);
+	c.update(v, 64);
+	c.final(out);
+	memset(v, 0, 64);
+}
+
+// one of the 1 KiB blocks Argon2 works on
+struct Argon2Block
+{
+	quint64 v[128];
+};
+
+#define ARGON2_G(a, b, c, d) \
+	a = a + b + 2 * (quint64)(quint32)a * (quint32)b; d = rotr64(d ^ a, 32); \
+	c = c + d + 2 * (quint64)(quint32)c * (quint32)d; b = rotr64(b ^ c, 24); \
+	a = a + b + 2 * (quint64)(quint32)a * (quint32)b; d = rotr64(d ^ a, 16); \
+	c = c + d + 2 * (quint64)(quint32)c * (quint32)d; b = rotr64(b ^ c, 63);
+
+#define ARGON2_ROUND(v0, v1, v2, v3, v4, v5, v6, v7, v8, v9, v10, v11, v12, v13, v14, v15) \
+	ARGON2_G(v0, v4, v8, v12); ARGON2_G(v1, v5, v9, v13); \
+	ARGON2_G(v2, v6, v10, v14); ARGON2_G(v3, v7, v11, v15); \
+	ARGON2_G(v0, v5, v10, v15); ARGON2_G(v1, v6, v11, v12); \
+	ARGON2_G(v2, v7, v8, v13); ARGON2_G(v3, v4, v9, v14);
+
+// the compression function G.  the result is xored into next rather than
+//   stored if xorInto is set, as in the later passes of version 1.3.
+static void argon2_fill_block(const Argon2Block *prev, const Argon2Block *ref, Argon2Block *next, bool xorInto)
+{
+	Argon2Block r, tmp;
+	for(int n = 0; n < 128; ++n)
+		r.v[n] = prev->v[n] ^ ref->v[n];
+	tmp = r;
+	if(xorInto)
+	{
+		for(int n = 0; n < 128; ++n)
+			tmp.v[n] ^= next->v[n];
+	}
+
+	quint64 *v = r.v;
+	for(int i = 0; i < 8; ++i)
+	{
+		ARGON2_ROUND(v[16 * i], v[16 * i + 1], v[16 * i + 2], v[16 * i + 3],
+			v[16 * i + 4], v[16 * i + 5], v[16 * i + 6], v[16 * i + 7],
+			v[16 * i + 8], v[16 * i + 9], v[16 * i + 10], v[16 * i + 11],
+			v[16 * i + 12], v[16 * i + 13], v[16 * i + 14], v[16 * i + 15]);
+	}
+	for(int i = 0; i < 8; ++i)
+	{
+		ARGON2_ROUND(v[2 * i], v[2 * i + 1], v[2 * i + 16], v[2 * i + 17],
+			v[2 * i + 32], v[2 * i + 33], v[2 * i + 48], v[2 * i + 49],
+			v[2 * i + 64], v[2 * i + 65], v[2 * i + 80], v[2 * i + 81],
+			v[2 * i + 96], v[2 * i + 97], v[2 * i + 112], v[2 * i + 113]);
+	}
+
+	for(int n = 0; n < 128; ++n)
+		next->v[n] = tmp.v[n] ^ r.v[n];
+}
+
+#undef ARGON2_ROUND
+#undef ARGON2_G
+
+// the memory of one Argon2id derivation.  the lanes of a segment are
+//   independent of each other, so they can be filled at the same time.
+class Argon2Memory
+{
+public:
+	Argon2Block *blocks;
+	quint32 lanes, passes;
+	quint32 laneLength, segmentLength;
+
+	enum { SyncPoints = 4, Type = 2, Version = 0x13 };
+
+	quint32 blockCount() const
+	{
+		return laneLength * lanes;
+	}
+
+	// fills the first two blocks of each lane from the initial hash
+	void init(const unsigned char h0[64])
+	{
+		unsigned char in[72];
+		unsigned char out[1024];
+		memcpy(in, h0, 64);
+		for(quint32 l = 0; l < lanes; ++l)
+		{
+			for(quint32 k = 0; k < 2; ++k)
+			{
+				store32_le(in + 64, k);
+				store32_le(in + 68, l);
+				argon2_hash(out, 1024, in, 72);
+				for(int n = 0; n < 128; ++n)
+					blocks[l * laneLength + k].v[n] = load64_le(out + n * 8);
+			}
+		}
+		memset(in, 0, 72);
+		memset(out, 0, 1024);
+	}
+
+	void fillSegment(quint32 pass, quint32 lane, quint32 slice)
+	{
+		// argon2id uses data independent addressing for the first half
+		//   of the first pass only
+		bool independent = (pass == 0 && slice < SyncPoints / 2);
+		Argon2Block zero, input, address;
+		if(independent)
+		{
+			memset(&zero, 0, sizeof(zero));
+			memset(&input, 0, sizeof(input));
+			input.v[0] = pass;
+			input.v[1] = lane;
+			input.v[2] = slice;
+			input.v[3] = blockCount();
+			input.v[4] = passes;
+			input.v[5] = Type;
+		}
+
+		quint32 start = 0;
+		if(pass == 0 && slice == 0)
+		{
+			start = 2;
+			if(independent)
+				nextAddresses(&zero, &input, &address);
+		}
+
+		quint32 cur = lane * laneLength + slice * segmentLength + start;
+		quint32 prev = (cur % laneLength == 0) ? cur + laneLength - 1 : cur - 1;
+		for(quint32 i = start; i < segmentLength; ++i, ++cur, ++prev)
+		{
+			if(cur % laneLength == 1)
+				prev = cur - 1;
+
+			quint64 rand;
+			if(independent)
+			{
+				if(i % 128 == 0)
+					nextAddresses(&zero, &input, &address);
+				rand = address.v[i % 128];
+			}
+			else
+				rand = blocks[prev].v[0];
+
+			quint32 refLane = (quint32)((rand >> 32) % lanes);
+			if(pass == 0 && slice == 0)
+				refLane = lane;
+			quint32 refIndex = indexAlpha(pass, slice, i, (quint32)rand, refLane == lane);
+
+			argon2_fill_block(&blocks[prev], &blocks[refLane * laneLength + refIndex], &blocks[cur], pass != 0);
+		}
+	}
+
+	// the xor of the last blocks of the lanes, hashed to the tag
+	void final(unsigned char *out, size_t outLen)
+	{
+		Argon2Block c = blocks[laneLength - 1];
+		for(quint32 l = 1; l < lanes; ++l)
+		{
+			const Argon2Block &b = blocks[l * laneLength + laneLength - 1];
+			for(int n = 0; n < 128; ++n)
+				c.v[n] ^= b.v[n];
+		}
+		unsigned char bytes[1024];
+		for(int n = 0; n < 128; ++n)
+			store64_le(bytes + n * 8, c.v[n]);
+		argon2_hash(out, outLen, bytes, 1024);
+		memset(bytes, 0, 1024);
+		memset(&c, 0, sizeof(c));
+	}
+
+private:
+	void nextAddresses(const Argon2Block *zero, Argon2Block *input, Argon2Block *address)
+	{
+		++input->v[6];
+		argon2_fill_block(zero, input, address, false);
+		argon2_fill_block(zero, address, address, false);
+	}
+
+	// maps a pseudo-random number onto the blocks that may be referenced
+	quint32 indexAlpha(quint32 pass, quint32 slice, quint32 index, quint32 rand, bool sameLane) const
+	{
+		quint32 area;
+		if(pass == 0)
+		{
+			if(slice == 0)
+				area = index - 1;
+			else if(sameLane)
+				area = slice * segmentLength + index - 1;
+			else
+				area = slice * segmentLength - (index == 0 ? 1 : 0);
+		}
+		else
+		{
+			if(sameLane)
+				area = laneLength - segmentLength + index - 1;
+			else
+				area = laneLength - segmentLength - (index == 0 ? 1 : 0);
+		}
+
+		quint64 pos = rand;
+		pos = (pos * pos) >> 32;
+		pos = area - 1 - (((quint64)area * pos) >> 32);
+
+		quint32 startPos = 0;
+		if(pass != 0)
+			startPos = (slice == SyncPoints - 1) ? 0 : (slice + 1) * segmentLength;
+		return (quint32)((startPos + pos) % laneLength);
+	}
+};
+
+// work memory for the memory-hard KDFs.  it is kept from one key to the
+//   next, so that only the first key of a given size allocates, and it is
+//   wiped after each key.  copies get an arena of their own.
+class KDFArena
+{
+public:
+	KDFArena() : mem(0), size(0)
+	{
+	}
+
+	KDFArena(const KDFArena &) : mem(0), size(0)
+	{
+	}
+
+	~KDFArena()
+	{
+		free(mem);
+	}
+
+	KDFArena & operator=(const KDFArena &)
+	{
+		return *this;
+	}
+
+	// returns 0 if the memory cannot be had
+	void *get(quint64 bytes)
+	{
+		if(bytes > (quint64)(size_t)-1)
+			return 0;
+		if(size < bytes)
+		{
+			free(mem);
+			size = 0;
+			mem = malloc((size_t)bytes);
+			if(!mem)
+				return 0;
+			size = (size_t)bytes;
+		}
+		return mem;
+	}
+
+	void wipe(quint64 bytes)
+	{
+		if(mem)
+			memset(mem, 0, (size_t)bytes);
+	}
+
+private:
+	void *mem;
+	size_t size;
+};
+
+// runs something for each of a number of lanes at the same time.  the
+//   lanes are spread over at most as many jobs as the pool has threads,
+//   and the calling thread takes the first of them.
+class LaneRunner
+{
+public:
+	virtual ~LaneRunner()
+	{
+		qDeleteAll(jobs);
+	}
+
+	virtual void runLane(quint32 lane) = 0;
+
+	void runLanes(quint32 count)
+	{
+		quint32 jobCount = qMin(count, (quint32)qMax(ThreadPool::instance()->maxThreadCount(), 1));
+		while((quint32)jobs.count() < jobCount - 1)
+			jobs += new Job(this);
+		for(quint32 n = 1; n < jobCount; ++n)
+		{
+			Job *job = jobs[n - 1];
+			job->first = n;
+			job->step = jobCount;
+			job->count = count;
+			job->start();
+		}
+		for(quint32 lane = 0; lane < count; lane += jobCount)
+			runLane(lane);
+		for(quint32 n = 1; n < jobCount; ++n)
+			jobs[n - 1]->wait();
+	}
+
+private:
+	class Job : public ThreadPoolJob
+	{
+	public:
+		LaneRunner *r;
+		quint32 first, step, count;
+
+		Job(LaneRunner *_r) : r(_r)
+		{
+		}
+
+		~Job()
+		{
+			wait();
+		}
+
+	protected:
+		virtual void run()
+		{
+			for(quint32 lane = first; lane < count; lane += step)
+				r->runLane(lane);
+		}
+	};
+
+	QList<Job*> jobs;
+};
+
+//----------------------------------------------------------------------------
+// DefaultScryptContext
+//----------------------------------------------------------------------------
+class DefaultScryptContext : public MemoryHardKDFContext
+{
+public:
+	unsigned int n, r, p;
+	KDFArena arena;
+
+	DefaultScryptContext(Provider *prov) : MemoryHardKDFContext(prov, "scrypt")
+	{
+		n = 16384;
+		r = 8;
+		p = 1;
+	}
+
+	virtual Provider::Context *clone() const
+	{
+		return new DefaultScryptContext(*this);
+	}
+
+	virtual void setParameters(unsigned int memoryCost, unsigned int timeCost, unsigned int lanes)
+	{
+		n = memoryCost;
+		r = timeCost;
+		p = lanes;
+	}
+
+	virtual SymmetricKey makeKey(const SecureArray &secret, const InitializationVector &salt, unsigned int keyLength, unsigned int iterationCount)
+	{
+		Q_UNUSED(iterationCount);
+		return derive(secret, salt, keyLength);
+	}
+
+	virtual SymmetricKey makeKey(const SecureArray &secret, const InitializationVector &salt, unsigned int keyLength, int msecInterval, unsigned int *iterationCount)
+	{
+		Q_UNUSED(msecInterval);
+		Q_ASSERT(iterationCount != NULL);
+		*iterationCount = 1;
+		return derive(secret, salt, keyLength);
+	}
+
+private:
+	class Lanes : public LaneRunner
+	{
+	public:
+		unsigned char *b;
+		quint32 *mem;
+		unsigned int n, r;
+
+		virtual void runLane(quint32 lane)
+		{
+			size_t words = 32 * (size_t)r;
+			quint32 *v = mem + lane * (words * n + 2 * words);
+			scrypt_romix(b + lane * 128 * (size_t)r, v, v + words * n, n, r);
+		}
+	};
+
+	SymmetricKey derive(const SecureArray &secret, const InitializationVector &salt, unsigned int keyLength)
+	{
+		// RFC7914 allows r * p up to 2^30, but B has to fit in a SecureArray
+		if(keyLength == 0 || n < 2 || (n & (n - 1)) != 0 || r == 0 || p == 0 || 128 * (quint64)r * p > 0x7fffffff)
+			return SymmetricKey();
+
+		// each lane has its own V, and room for X and Y
+		quint64 laneBytes = 128 * (quint64)r * n + 256 * (quint64)r;
+		if(laneBytes > Q_UINT64_C(0xffffffffffffffff) / p)
+			return SymmetricKey();
+		quint64 bytes = laneBytes * p;
+		quint32 *mem = (quint32 *)arena.get(bytes);
+		if(!mem)
+			return SymmetricKey();
+
+		SecureArray b(128 * r * p);
+		pbkdf2_sha256_once((const unsigned char *)secret.data(), secret.size(), (const unsigned char *)salt.data(), salt.size(), (unsigned char *)b.data(), b.size());
+
+		Lanes lanes;
+		lanes.b = (unsigned char *)b.data();
+		lanes.mem = mem;
+		lanes.n = n;
+		lanes.r = r;
+		lanes.runLanes(p);
+		arena.wipe(bytes);
+
+		SecureArray out(keyLength);
+		pbkdf2_sha256_once((const unsigned char *)secret.data(), secret.size(), (const unsigned char *)b.data(), b.size(), (unsigned char *)out.data(), out.size());
+		return out;
+	}
+};
+
+//----------------------------------------------------------------------------
+// DefaultArgon2Context
+//----------------------------------------------------------------------------
+class DefaultArgon2Context : public MemoryHardKDFContext
+{
+public:
+	unsigned int m, t, p;
+	KDFArena arena;
+
+	DefaultArgon2Context(Provider *prov) : MemoryHardKDFContext(prov, "argon2id")
+	{
+		m = 65536;
+		t = 3;
+		p = 4;
+	}
+
+	virtual Provider::Context *clone() const
+	{
+		return new DefaultArgon2Context(*this);
+	}
+
+	virtual void setParameters(unsigned int memoryCost, unsigned int timeCost, unsigned int lanes)
+	{
+		m = memoryCost;
+		t = timeCost;
+		p = lanes;
+	}
+
+	virtual SymmetricKey makeKey(const SecureArray &secret, const InitializationVector &salt, unsigned int keyLength, unsigned int iterationCount)
+	{
+		Q_UNUSED(iterationCount);
+		return derive(secret, salt, keyLength);
+	}
+
+	virtual SymmetricKey makeKey(const SecureArray &secret, const InitializationVector &salt, unsigned int keyLength, int msecInterval, unsigned int *iterationCount)
+	{
+		Q_UNUSED(msecInterval);
+		Q_ASSERT(iterationCount != NULL);
+		*iterationCount = 1;
+		return derive(secret, salt, keyLength);
+	}
+
+private:
+	class Lanes : public LaneRunner
+	{
+	public:
+		Argon2Memory *mem;
+		quint32 pass, slice;
+
+		virtual void runLane(quint32 lane)
+		{
+			mem->fillSegment(pass, lane, slice);
+		}
+	};
+
+	static void hashValue(Blake2bState *h, quint32 x)
+	{
+		unsigned char buf[4];
+		store32_le(buf, x);
+		h->update(buf, 4);
+	}
+
+	static void hashBytes(Blake2bState *h, const MemoryRegion &a)
+	{
+		hashValue(h, a.size());
+		h->update((const unsigned char *)a.data(), a.size());
+	}
+
+	SymmetricKey derive(const SecureArray &secret, const InitializationVector &salt, unsigned int keyLength)
+	{
+		if(keyLength < 4 || salt.size() < 8 || t == 0 || p == 0 || p > 0xffffff || m < 8 * p)
+			return SymmetricKey();
+
+		Argon2Memory mem;
+		mem.lanes = p;
+		mem.passes = t;
+		mem.segmentLength = m / (p * Argon2Memory::SyncPoints);
+		mem.laneLength = mem.segmentLength * Argon2Memory::SyncPoints;
+		quint64 bytes = (quint64)mem.blockCount() * sizeof(Argon2Block);
+		mem.blocks = (Argon2Block *)arena.get(bytes);
+		if(!mem.blocks)
+			return SymmetricKey();
+
+		// the initial hash H0 over all of the parameters
+		Blake2bState h(64);
+		hashValue(&h, p);
+		hashValue(&h, keyLength);
+		hashValue(&h, m);
+		hashValue(&h, t);
+		hashValue(&h, Argon2Memory::Version);
+		hashValue(&h, Argon2Memory::Type);
+		hashBytes(&h, secret);
+		hashBytes(&h, salt);
+		hashBytes(&h, QByteArray()); // secret key
+		hashBytes(&h, QByteArray()); // associated data
+		SecureArray h0(64);
+		h.final((unsigned char *)h0.data());
+
+		mem.init((const unsigned char *)h0.data());
+		Lanes lanes;
+		lanes.mem = &mem;
+		for(quint32 pass = 0; pass < t; ++pass)
+		{
+			for(quint32 slice = 0; slice < Argon2Memory::SyncPoints; ++slice)
+			{
+				lanes.pass = pass;
+				lanes.slice = slice;
+				lanes.runLanes(p);
+			}
+		}
+
+		SecureArray out(keyLength);
+		mem.final((unsigned char *)out.data(), keyLength);
+		arena.wipe(bytes);
+		return out;
+	}
+};
+
+//----------------------------------------------------------------------------
+// Tree hash primitives
+//----------------------------------------------------------------------------
+
+// BLAKE2s of RFC 7693, unkeyed
+class Blake2sState
+{
+public:
+	quint32 h[8];
+	quint32 t[2];
+	unsigned char buf[64];
+	size_t bufLen;
+
+	Blake2sState()
+	{
+		for(int n = 0; n < 8; ++n)
+			h[n] = iv(n);
+		h[0] ^= 0x01010000 ^ 32;
+		t[0] = t[1] = 0;
+		bufLen = 0;
+	}
+
+	void update(const unsigned char *data, size_t n)
+	{
+		// the last block is held back, as with BLAKE2b
+		while(n > 0)
+		{
+			if(bufLen == 64)
+			{
+				count(64);
+				compress(buf, false);
+				bufLen = 0;
+			}
+			size_t k = qMin((size_t)64 - bufLen, n);
+			memcpy(buf + bufLen, data, k);
+			bufLen += k;
+			data += k;
+			n -= k;
+		}
+	}
+
+	void final(unsigned char *out)
+	{
+		count(bufLen);
+		memset(buf + bufLen, 0, 64 - bufLen);
+		compress(buf, true);
+		for(int n = 0; n < 8; ++n)
+			store32_le(out + n * 4, h[n]);
+	}
+
+	// also the IV of BLAKE3
+	static quint32 iv(int n)
+	{
+		static const quint32 v[8] =
+		{
+			0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+			0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+		};
+		return v[n];
+	}
+
+private:
+	void count(size_t n)
+	{
+		t[0] += (quint32)n;
+		if(t[0] < n)
+			++t[1];
+	}
+
+	void compress(const unsigned char *block, bool last)
+	{
+		static const unsigned char sigma[10][16] =
+		{
+			{  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15 },
+			{ 14, 10,  4,  8,  9, 15, 13,  6,  1, 12,  0,  2, 11,  7,  5,  3 },
+			{ 11,  8, 12,  0,  5,  2, 15, 13, 10, 14,  3,  6,  7,  1,  9,  4 },
+			{  7,  9,  3,  1, 13, 12, 11, 14,  2,  6,  5, 10,  4,  0, 15,  8 },
+			{  9,  0,  5,  7,  2,  4, 10, 15, 14,  1, 11, 12,  6,  8,  3, 13 },
+			{  2, 12,  6, 10,  0, 11,  8,  3,  4, 13,  7,  5, 15, 14,  1,  9 },
+			{ 12,  5,  1, 15, 14, 13,  4, 10,  0,  7,  6,  3,  9,  2,  8, 11 },
+			{ 13, 11,  7, 14, 12,  1,  3,  9,  5,  0, 15,  4,  8,  6,  2, 10 },
+			{  6, 15, 14,  9, 11,  3,  0,  8, 12,  2, 13,  7,  1,  4, 10,  5 },
+			{ 10,  2,  8,  4,  7,  6,  1,  5, 15, 11,  9, 14,  3, 12, 13,  0 }
+		};
+
+		quint32 m[16], v[16];
+		for(int n = 0; n < 16; ++n)
+			m[n] = load32_le(block + n * 4);
+		for(int n = 0; n < 8; ++n)
+		{
+			v[n] = h[n];
+			v[n + 8] = iv(n);
+		}
+		v[12] ^= t[0];
+		v[13] ^= t[1];
+		if(last)
+			v[14] = ~v[14];
+
+#ifdef QCA_HAVE_SSSE3
+		if(have_ssse3())
+		{
+			blake2s_rounds_ssse3(v, m, sigma, 10);
+			for(int n = 0; n < 8; ++n)
+				h[n] ^= v[n] ^ v[n + 8];
+			return;
+		}
+#endif
+
+#define B2S_G(a, b, c, d, x, y) \
+		v[a] = v[a] + v[b] + (x); v[d] = rotr32(v[d] ^ v[a], 16); \
+		v[c] = v[c] + v[d];       v[b] = rotr32(v[b] ^ v[c], 12); \
+		v[a] = v[a] + v[b] + (y); v[d] = rotr32(v[d] ^ v[a], 8); \
+		v[c] = v[c] + v[d];       v[b] = rotr32(v[b] ^ v[c], 7);
+
+		for(int i = 0; i < 10; ++i)
+		{
+			const unsigned char *s = sigma[i];
+			B2S_G(0, 4,  8, 12, m[s[ 0]], m[s[ 1]]);
+			B2S_G(1, 5,  9, 13, m[s[ 2]], m[s[ 3]]);
+			B2S_G(2, 6, 10, 14, m[s[ 4]], m[s[ 5]]);
+			B2S_G(3, 7, 11, 15, m[s[ 6]], m[s[ 7]]);
+			B2S_G(0, 5, 10, 15, m[s[ 8]], m[s[ 9]]);
+			B2S_G(1, 6, 11, 12, m[s[10]], m[s[11]]);
+			B2S_G(2, 7,  8, 13, m[s[12]], m[s[13]]);
+			B2S_G(3, 4,  9, 14, m[s[14]], m[s[15]]);
+		}
+#undef B2S_G
+
+		for(int n = 0; n < 8; ++n)
+			h[n] ^= v[n] ^ v[n + 8];
+	}
+};
+
+// BLAKE2bp: four BLAKE2b leaves, each taking every fourth block of the
+//   input, under a BLAKE2b root.  the leaves are independent, so large
+//   updates feed them on the thread pool.
+class Blake2bpState
+{
+public:
+	enum { Leaves = 4, StripeSize = Leaves * 128 };
+
+	Blake2bState leaf[Leaves];
+	Blake2bState root;
+	unsigned char buf[StripeSize];
+	size_t bufLen;
+
+	Blake2bpState() : root(64, Leaves, 2, 0, 1, 64)
+	{
+		for(int n = 0; n < Leaves; ++n)
+			leaf[n] = Blake2bState(64, Leaves, 2, n, 0, 64);
+		leaf[Leaves - 1].lastNode = true;
+		root.lastNode = true;
+		bufLen = 0;
+	}
+
+	void update(const unsigned char *data, size_t n)
+	{
+		if(bufLen > 0 && n >= StripeSize - bufLen)
+		{
+			size_t k = StripeSize - bufLen;
+			memcpy(buf + bufLen, data, k);
+			updateStripes(buf, 1);
+			bufLen = 0;
+			data += k;
+			n -= k;
+		}
+
+		size_t stripes = n / StripeSize;
+		if(stripes > 0)
+		{
+			updateStripes(data, stripes);
+			data += stripes * StripeSize;
+			n -= stripes * StripeSize;
+		}
+
+		memcpy(buf + bufLen, data, n);
+		bufLen += n;
+	}
+
+	void final(unsigned char *out)
+	{
+		unsigned char digest[64];
+		for(int n = 0; n < Leaves; ++n)
+		{
+			if(bufLen > (size_t)n * 128)
+				leaf[n].update(buf + n * 128, qMin(bufLen - n * 128, (size_t)128));
+			leaf[n].final(digest);
+			root.update(digest, 64);
+		}
+		root.final(out);
+		memset(digest, 0, 64);
+	}
+
+private:
+	class Lanes : public LaneRunner
+	{
+	public:
+		Blake2bState *leaf;
+		const unsigned char *data;
+		size_t stripes;
+
+		virtual void runLane(quint32 lane)
+		{
+			for(size_t n = 0; n < stripes; ++n)
+				leaf[lane].update(data + n * StripeSize + lane * 128, 128);
+		}
+	};
+
+	void updateStripes(const unsigned char *data, size_t stripes)
+	{
+		Lanes lanes;
+		lanes.leaf = leaf;
+		lanes.data = data;
+		lanes.stripes = stripes;
+
+		// starting the jobs costs more than a few blocks
+		if(stripes < 64)
+		{
+			for(quint32 n = 0; n < Leaves; ++n)
+				lanes.runLane(n);
+		}
+		else
+			lanes.runLanes(Leaves);
+	}
+};
+
+static const unsigned char blake3_schedule[7][16] =
+{
+	{  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15 },
+	{  2,  6,  3, 10,  7,  0,  4, 13,  1, 11, 12,  5,  9, 14, 15,  8 },
+	{  3,  4, 10, 12, 13,  2,  7, 14,  6,  5,  9,  0, 11, 15,  8,  1 },
+	{ 10,  7, 12,  9, 14,  3, 13, 15,  4,  0, 11,  2,  5,  8,  1,  6 },
+	{ 12, 13,  9, 11, 15, 10, 14,  8,  7,  2,  5,  3,  0,  1,  6,  4 },
+	{  9, 14, 11,  5,  8, 12, 15,  1, 13,  3,  0, 10,  2,  6,  4,  7 },
+	{ 11, 15,  5,  0,  1,  9,  8,  6, 14, 10,  2, 12,  3,  4,  7, 13 }
+};
+
+// BLAKE3, unkeyed.  the input is split into 1024 byte chunks whose
+//   chaining values are merged up a binary tree, so the chunks of a large
+//   update are hashed on the thread pool and merged in order afterwards.
+//   with SSSE3, four chunks are hashed at once, one in each lane.
+class Blake3State
+{
+public:
+	enum { BlockLen = 64, ChunkLen = 1024 };
+	enum { ChunkStart = 1, ChunkEnd = 2, Parent = 4, Root = 8 };
+
+	// the current chunk
+	quint32 cv[8];
+	quint64 chunkCounter;
+	unsigned char block[BlockLen];
+	size_t blockLen;
+	int blocksCompressed;
+
+	// chaining values of the finished subtrees, one per bit of the
+	//   chunk count
+	quint32 stack[54][8];
+	int stackLen;
+
+	Blake3State()
+	{
+		stackLen = 0;
+		startChunk(0);
+	}
+
+	void update(const unsigned char *data, size_t n)
+	{
+		while(n > 0)
+		{
+			// a full chunk is only finished once more input shows that
+			//   it isn't the root
+			if(chunkLen() == ChunkLen)
+			{
+				quint32 out[8];
+				chunkOutput().chainingValue(out);
+				addChunk(out, chunkCounter + 1);
+				startChunk(chunkCounter + 1);
+			}
+
+			// whole chunks, except the last one of the input, don't
+			//   need the chunk state at all
+			if(chunkLen() == 0 && n > ChunkLen)
+			{
+				size_t chunks = (n - 1) / ChunkLen;
+				updateChunks(data, chunks);
+				data += chunks * ChunkLen;
+				n -= chunks * ChunkLen;
+				continue;
+			}
+
+			size_t k = qMin((size_t)ChunkLen - chunkLen(), n);
+			updateChunk(data, k);
+			data += k;
+			n -= k;
+		}
+	}
+
+	void final(unsigned char *out, size_t outLen)
+	{
+		Output o = chunkOutput();
+		for(int n = stackLen - 1; n >= 0; --n)
+		{
+			quint32 right[8];
+			o.chainingValue(right);
+			o = parentOutput(stack[n], right);
+		}
+		o.rootBytes(out, outLen);
+	}
+
+private:
+	// the input of a compression that is yet to be done, since its flags
+	//   depend on whether it is the root
+	struct Output
+	{
+		quint32 cv[8];
+		unsigned char block[BlockLen];
+		quint64 counter;
+		quint32 blockLen;
+		quint32 flags;
+
+		void chainingValue(quint32 *out) const
+		{
+			quint32 s[16];
+			compress(cv, block, counter, blockLen, flags, s);
+			memcpy(out, s, 32);
+		}
+
+		void rootBytes(unsigned char *out, size_t outLen) const
+		{
+			for(quint64 n = 0; outLen > 0; ++n)
+			{
+				quint32 s[16];
+				unsigned char b[BlockLen];
+				compress(cv, block, n, blockLen, flags | Root, s);
+				for(int i = 0; i < 16; ++i)
+					store32_le(b + i * 4, s[i]);
+				size_t k = qMin((size_t)BlockLen, outLen);
+				memcpy(out, b, k);
+				out += k;
+				outLen -= k;
+			}
+		}
+	};
+
+	// each lane is a group of up to four chunks
+	class Lanes : public LaneRunner
+	{
+	public:
+		const unsigned char *data;
+		quint64 counter;
+		quint32 (*cvs)[8];
+		size_t chunks;
+
+		virtual void runLane(quint32 lane)
+		{
+			size_t first = (size_t)lane * 4;
+			size_t count = qMin(chunks - first, (size_t)4);
+#ifdef QCA_HAVE_SSSE3
+			if(count == 4 && have_ssse3())
+			{
+				hashChunks4(data + first * ChunkLen, counter + first, cvs + first);
+				return;
+			}
+#endif
+			for(size_t n = first; n < first + count; ++n)
+				hashChunk(data + n * ChunkLen, counter + n, cvs[n]);
+		}
+	};
+
+	static void compress(const quint32 *cv, const unsigned char *block, quint64 counter, quint32 blockLen, quint32 flags, quint32 *out)
+	{
+		quint32 m[16], v[16];
+		for(int n = 0; n < 16; ++n)
+			m[n] = load32_le(block + n * 4);
+		for(int n = 0; n < 8; ++n)
+			v[n] = cv[n];
+		for(int n = 0; n < 4; ++n)
+			v[n + 8] = Blake2sState::iv(n);
+		v[12] = (quint32)counter;
+		v[13] = (quint32)(counter >> 32);
+		v[14] = blockLen;
+		v[15] = flags;
+
+#ifdef QCA_HAVE_SSSE3
+		if(have_ssse3())
+			blake2s_rounds_ssse3(v, m, blake3_schedule, 7);
+		else
+#endif
+		rounds(v, m);
+
+		for(int n = 0; n < 8; ++n)
+		{
+			out[n] = v[n] ^ v[n + 8];
+			out[n + 8] = v[n + 8] ^ cv[n];
+		}
+	}
+
+	static void rounds(quint32 *v, const quint32 *m)
+	{
+#define B3_G(a, b, c, d, x, y) \
+		v[a] = v[a] + v[b] + (x); v[d] = rotr32(v[d] ^ v[a], 16); \
+		v[c] = v[c] + v[d];       v[b] = rotr32(v[b] ^ v[c], 12); \
+		v[a] = v[a] + v[b] + (y); v[d] = rotr32(v[d] ^ v[a], 8); \
+		v[c] = v[c] + v[d];       v[b] = rotr32(v[b] ^ v[c], 7);
+
+		for(int i = 0; i < 7; ++i)
+		{
+			const unsigned char *s = blake3_schedule[i];
+			B3_G(0, 4,  8, 12, m[s[ 0]], m[s[ 1]]);
+			B3_G(1, 5,  9, 13, m[s[ 2]], m[s[ 3]]);
+			B3_G(2, 6, 10, 14, m[s[ 4]], m[s[ 5]]);
+			B3_G(3, 7, 11, 15, m[s[ 6]], m[s[ 7]]);
+			B3_G(0, 5, 10, 15, m[s[ 8]], m[s[ 9]]);
+			B3_G(1, 6, 11, 12, m[s[10]], m[s[11]]);
+			B3_G(2, 7,  8, 13, m[s[12]], m[s[13]]);
+			B3_G(3, 4,  9, 14, m[s[14]], m[s[15]]);
+		}
+#undef B3_G
+	}
+
+#ifdef QCA_HAVE_SSSE3
+	// hashChunk() for four chunks at once.  v[i] holds word i of the
+	//   four states, so the rounds are the scalar ones on registers.
+	QCA_TARGET_SSSE3 static void hashChunks4(const unsigned char *data, quint64 counter, quint32 (*out)[8])
+	{
+		__m128i h[8], m[16], v[16];
+		for(int n = 0; n < 8; ++n)
+			h[n] = _mm_set1_epi32((int)Blake2sState::iv(n));
+		__m128i counterLow = _mm_setr_epi32((int)counter, (int)(counter + 1), (int)(counter + 2), (int)(counter + 3));
+		__m128i counterHigh = _mm_setr_epi32((int)(counter >> 32), (int)((counter + 1) >> 32), (int)((counter + 2) >> 32), (int)((counter + 3) >> 32));
+
+#define B3_G4(a, b, c, d, x, y) \
+		v[a] = _mm_add_epi32(_mm_add_epi32(v[a], v[b]), x); v[d] = rotr32_ssse3(_mm_xor_si128(v[d], v[a]), 16); \
+		v[c] = _mm_add_epi32(v[c], v[d]);                   v[b] = rotr32_ssse3(_mm_xor_si128(v[b], v[c]), 12); \
+		v[a] = _mm_add_epi32(_mm_add_epi32(v[a], v[b]), y); v[d] = rotr32_ssse3(_mm_xor_si128(v[d], v[a]), 8); \
+		v[c] = _mm_add_epi32(v[c], v[d]);                   v[b] = rotr32_ssse3(_mm_xor_si128(v[b], v[c]), 7);
+
+		for(int block = 0; block < ChunkLen / BlockLen; ++block)
+		{
+			// sixteen bytes of each chunk, turned into four words of
+			//   the four chunks
+			for(int j = 0; j < 16; j += 4)
+			{
+				for(int k = 0; k < 4; ++k)
+					m[j + k] = _mm_loadu_si128((const __m128i *)(data + k * ChunkLen + block * BlockLen + j * 4));
+				transpose4_ssse3(m + j);
+			}
+
+			quint32 flags = 0;
+			if(block == 0)
+				flags |= ChunkStart;
+			if(block == ChunkLen / BlockLen - 1)
+				flags |= ChunkEnd;
+			for(int n = 0; n < 8; ++n)
+				v[n] = h[n];
+			for(int n = 0; n < 4; ++n)
+				v[n + 8] = _mm_set1_epi32((int)Blake2sState::iv(n));
+			v[12] = counterLow;
+			v[13] = counterHigh;
+			v[14] = _mm_set1_epi32(BlockLen);
+			v[15] = _mm_set1_epi32((int)flags);
+
+			for(int i = 0; i < 7; ++i)
+			{
+				const unsigned char *s = blake3_schedule[i];
+				B3_G4(0, 4,  8, 12, m[s[ 0]], m[s[ 1]]);
+				B3_G4(1, 5,  9, 13, m[s[ 2]], m[s[ 3]]);
+				B3_G4(2, 6, 10, 14, m[s[ 4]], m[s[ 5]]);
+				B3_G4(3, 7, 11, 15, m[s[ 6]], m[s[ 7]]);
+				B3_G4(0, 5, 10, 15, m[s[ 8]], m[s[ 9]]);
+				B3_G4(1, 6, 11, 12, m[s[10]], m[s[11]]);
+				B3_G4(2, 7,  8, 13, m[s[12]], m[s[13]]);
+				B3_G4(3, 4,  9, 14, m[s[14]], m[s[15]]);
+			}
+
+			for(int n = 0; n < 8; ++n)
+				h[n] = _mm_xor_si128(v[n], v[n + 8]);
+		}
+#undef B3_G4
+
+		transpose4_ssse3(h);
+		transpose4_ssse3(h + 4);
+		for(int k = 0; k < 4; ++k)
+		{
+			_mm_storeu_si128((__m128i *)out[k], h[k]);
+			_mm_storeu_si128((__m128i *)(out[k] + 4), h[k + 4]);
+		}
+	}
+#endif
+
+	// the chaining value of a whole chunk that isn't the root
+	static void hashChunk(const unsigned char *data, quint64 counter, quint32 *out)
+	{
+		quint32 s[16];
+		quint32 h[8];
+		for(int n = 0; n < 8; ++n)
+			h[n] = Blake2sState::iv(n);
+		for(int n = 0; n < ChunkLen / BlockLen; ++n)
+		{
+			quint32 flags = 0;
+			if(n == 0)
+				flags |= ChunkStart;
+			if(n == ChunkLen / BlockLen - 1)
+				flags |= ChunkEnd;
+			compress(h, data + n * BlockLen, counter, BlockLen, flags, s);
+			memcpy(h, s, 32);
+		}
+		memcpy(out, h, 32);
+	}
+
+	static Output parentOutput(const quint32 *left, const quint32 *right)
+	{
+		Output o;
+		for(int n = 0; n < 8; ++n)
+		{
+			o.cv[n] = Blake2sState::iv(n);
+			store32_le(o.block + n * 4, left[n]);
+			store32_le(o.block + 32 + n * 4, right[n]);
+		}
+		o.counter = 0;
+		o.blockLen = BlockLen;
+		o.flags = Parent;
+		return o;
+	}
+
+	size_t chunkLen() const
+	{
+		return blocksCompressed * BlockLen + blockLen;
+	}
+
+	quint32 startFlag() const
+	{
+		return blocksCompressed == 0 ? ChunkStart : 0;
+	}
+
+	void startChunk(quint64 counter)
+	{
+		for(int n = 0; n < 8; ++n)
+			cv[n] = Blake2sState::iv(n);
+		chunkCounter = counter;
+		memset(block, 0, BlockLen);
+		blockLen = 0;
+		blocksCompressed = 0;
+	}
+
+	void updateChunk(const unsigned char *data, size_t n)
+	{
+		while(n > 0)
+		{
+			if(blockLen == BlockLen)
+			{
+				quint32 s[16];
+				compress(cv, block, chunkCounter, BlockLen, startFlag(), s);
+				memcpy(cv, s, 32);
+				++blocksCompressed;
+				memset(block, 0, BlockLen);
+				blockLen = 0;
+			}
+			size_t k = qMin((size_t)BlockLen - blockLen, n);
+			memcpy(block + blockLen, data, k);
+			blockLen += k;
+			data += k;
+			n -= k;
+		}
+	}
+
+	Output chunkOutput() const
+	{
+		Output o;
+		memcpy(o.cv, cv, 32);
+		memcpy(o.block, block, BlockLen);
+		o.counter = chunkCounter;
+		o.blockLen = blockLen;
+		o.flags = startFlag() | ChunkEnd;
+		return o;
+	}
+
+	// merges the new chunk with every finished subtree of the same size
+	void addChunk(const quint32 *chunkCV, quint64 totalChunks)
+	{
+		quint32 h[8];
+		memcpy(h, chunkCV, 32);
+		while((totalChunks & 1) == 0)
+		{
+			--stackLen;
+			parentOutput(stack[stackLen], h).chainingValue(h);
+			totalChunks >>= 1;
+		}
+		memcpy(stack[stackLen], h, 32);
+		++stackLen;
+	}
+
+	void updateChunks(const unsigned char *data, size_t chunks)
+	{
+		QVector<quint32> cvs(chunks * 8);
+		Lanes lanes;
+		lanes.data = data;
+		lanes.counter = chunkCounter;
+		lanes.cvs = (quint32 (*)[8])cvs.data();
+		lanes.chunks = chunks;
+
+		// starting the jobs costs more than a few chunks
+		quint32 groups = (chunks + 3) / 4;
+		if(chunks < 16)
+		{
+			for(quint32 n = 0; n < groups; ++n)
+				lanes.runLane(n);
+		}
+		else
+			lanes.runLanes(groups);
+
+		for(size_t n = 0; n < chunks; ++n)
+			addChunk(lanes.cvs[n], chunkCounter + n + 1);
+		startChunk(chunkCounter + chunks);
+	}
+};
+
+//----------------------------------------------------------------------------
+// DefaultBlake2bContext
+//----------------------------------------------------------------------------
+class DefaultBlake2bContext : public HashContext
+{
+public:
+	DefaultBlake2bContext(Provider *p) : HashContext(p, "blake2b")
+	{
+		clear();
+	}
+
+	virtual Provider::Context *clone() const
+	{
+		return new DefaultBlake2bContext(*this);
+	}
+
+	virtual void clear()
+	{
+		secure = true;
+		state = Blake2bState(64);
+	}
+
+	virtual void update(const MemoryRegion &in)
+	{
+		if(!in.isSecure())
+			secure = false;
+		state.update((const unsigned char *)in.data(), in.size());
+	}
+
+	virtual void updateView(const MemoryRegion &in)
+	{
+		update(in);
+	}
+
+	virtual MemoryRegion final()
+	{
+		SecureArray b(64);
+		state.final((unsigned char *)b.data());
+		if(secure)
+			return b;
+		else
+			return b.toByteArray();
+	}
+
+	bool secure;
+	Blake2bState state;
+};
+
+//----------------------------------------------------------------------------
+// DefaultBlake2sContext
+//----------------------------------------------------------------------------
+class DefaultBlake2sContext : public HashContext
+{
+public:
+	DefaultBlake2sContext(Provider *p) : HashContext(p, "blake2s")
+	{
+		clear();
+	}
+
+	virtual Provider::Context *clone() const
+	{
+		return new DefaultBlake2sContext(*this);
+	}
+
+	virtual void clear()
+	{
+		secure = true;
+		state = Blake2sState();
+	}
+
+	virtual void update(const MemoryRegion &in)
+	{
+		if(!in.isSecure())
+			secure = false;
+		state.update((const unsigned char *)in.data(), in.size());
+	}
+
+	virtual void updateView(const MemoryRegion &in)
+	{
+		update(in);
+	}
+
+	virtual MemoryRegion final()
+	{
+		SecureArray b(32);
+		state.final((unsigned char *)b.data());
+		if(secure)
+			return b;
+		else
+			return b.toByteArray();
+	}
+
+	bool secure;
+	Blake2sState state;
+};
+
+//----------------------------------------------------------------------------
+// DefaultBlake2bpContext
+//----------------------------------------------------------------------------
+class DefaultBlake2bpContext : public HashContext
+{
+public:
+	DefaultBlake2bpContext(Provider *p) : HashContext(p, "blake2bp")
+	{
+		clear();
+	}
+
+	virtual Provider::Context *clone() const
+	{
+		return new DefaultBlake2bpContext(*this);
+	}
+
+	virtual void clear()
+	{
+		secure = true;
+		state = Blake2bpState();
+	}
+
+	virtual void update(const MemoryRegion &in)
+	{
+		if(!in.isSecure())
+			secure = false;
+		state.update((const unsigned char *)in.data(), in.size());
+	}
+
+	virtual void updateView(const MemoryRegion &in)
+	{
+		update(in);
+	}
+
+	virtual MemoryRegion final()
+	{
+		SecureArray b(64);
+		state.final((unsigned char *)b.data());
+		if(secure)
+			return b;
+		else
+			return b.toByteArray();
+	}
+
+	bool secure;
+	Blake2bpState state;
+};
+
+//----------------------------------------------------------------------------
+// DefaultBlake3Context
+//----------------------------------------------------------------------------
+class DefaultBlake3Context : public HashContext
+{
+public:
+	DefaultBlake3Context(Provider *p) : HashContext(p, "blake3")
+	{
+		clear();
+	}
+
+	virtual Provider::Context *clone() const
+	{
+		return new DefaultBlake3Context(*this);
+	}
+
+	virtual void clear()
+	{
+		secure = true;
+		state = Blake3State();
+	}
+
+	virtual void update(const MemoryRegion &in)
+	{
+		if(!in.isSecure())
+			secure = false;
+		state.update((const unsigned char *)in.data(), in.size());
+	}
+
+	virtual void updateView(const MemoryRegion &in)
+	{
+		update(in);
+	}
+
+	virtual MemoryRegion final()
+	{
+		return xofFinal(32);
+	}
+
+	virtual MemoryRegion xofFinal(int length)
+	{
+		SecureArray b(length);
+		state.final((unsigned char *)b.data(), length);
+		if(secure)
+			return b;
+		else
+			return b.toByteArray();
+	}
+
+	bool secure;
+	Blake3State state;
+};
+
+//----------------------------------------------------------------------------
+// DefaultSHA3Context
+//----------------------------------------------------------------------------
+// Keccak-f[1600], with the lanes of the state at 1, 2, 8, 12, 17 and 20
+//   kept complemented.  that way chi needs one NOT per row instead of
+//   five.  the round is from the Keccak team's implementation overview.
+//   unlike the BLAKE rounds there is no SSSE3 version: the 64 bit lanes
+//   rotate by 25 different amounts and move between rows in rho and pi,
+//   so two lanes to a register spend more on shuffles than they save.
+//   vectors only pay off when several messages are hashed side by side,
+//   which a Hash never does.
+#define KECCAK_ROUND(A, E, rc) \
+	{ \
+		quint64 c0 = A[0] ^ A[5] ^ A[10] ^ A[15] ^ A[20]; \
+		quint64 c1 = A[1] ^ A[6] ^ A[11] ^ A[16] ^ A[21]; \
+		quint64 c2 = A[2] ^ A[7] ^ A[12] ^ A[17] ^ A[22]; \
+		quint64 c3 = A[3] ^ A[8] ^ A[13] ^ A[18] ^ A[23]; \
+		quint64 c4 = A[4] ^ A[9] ^ A[14] ^ A[19] ^ A[24]; \
+		quint64 d0 = c4 ^ rotl64(c1, 1); \
+		quint64 d1 = c0 ^ rotl64(c2, 1); \
+		quint64 d2 = c1 ^ rotl64(c3, 1); \
+		quint64 d3 = c2 ^ rotl64(c4, 1); \
+		quint64 d4 = c3 ^ rotl64(c0, 1); \
+		quint64 b0, b1, b2, b3, b4; \
+		b0 = A[0] ^ d0; \
+		b1 = rotl64(A[6] ^ d1, 44); \
+		b2 = rotl64(A[12] ^ d2, 43); \
+		b3 = rotl64(A[18] ^ d3, 21); \
+		b4 = rotl64(A[24] ^ d4, 14); \
+		E[0] = b0 ^ (b1 | b2) ^ (rc); \
+		E[1] = b1 ^ (~b2 | b3); \
+		E[2] = b2 ^ (b3 & b4); \
+		E[3] = b3 ^ (b4 | b0); \
+		E[4] = b4 ^ (b0 & b1); \
+		b0 = rotl64(A[3] ^ d3, 28); \
+		b1 = rotl64(A[9] ^ d4, 20); \
+		b2 = rotl64(A[10] ^ d0, 3); \
+		b3 = rotl64(A[16] ^ d1, 45); \
+		b4 = rotl64(A[22] ^ d2, 61); \
+		E[5] = b0 ^ (b1 | b2); \
+		E[6] = b1 ^ (b2 & b3); \
+		E[7] = b2 ^ (b3 | ~b4); \
+		E[8] = b3 ^ (b4 | b0); \
+		E[9] = b4 ^ (b0 & b1); \
+		b0 = rotl64(A[1] ^ d1, 1); \
+		b1 = rotl64(A[7] ^ d2, 6); \
+		b2 = rotl64(A[13] ^ d3, 25); \
+		b3 = rotl64(A[19] ^ d4, 8); \
+		b4 = rotl64(A[20] ^ d0, 18); \
+		E[10] = b0 ^ (b1 | b2); \
+		E[11] = b1 ^ (b2 & b3); \
+		E[12] = b2 ^ (~b3 & b4); \
+		E[13] = ~b3 ^ (b4 | b0); \
+		E[14] = b4 ^ (b0 & b1); \
+		b0 = rotl64(A[4] ^ d4, 27); \
+		b1 = rotl64(A[5] ^ d0, 36); \
+		b2 = rotl64(A[11] ^ d1, 10); \
+		b3 = rotl64(A[17] ^ d2, 15); \
+		b4 = rotl64(A[23] ^ d3, 56); \
+		E[15] = b0 ^ (b1 & b2); \
+		E[16] = b1 ^ (b2 | b3); \
+		E[17] = b2 ^ (~b3 | b4); \
+		E[18] = ~b3 ^ (b4 & b0); \
+		E[19] = b4 ^ (b0 | b1); \
+		b0 = rotl64(A[2] ^ d2, 62); \
+		b1 = rotl64(A[8] ^ d3, 55); \
+		b2 = rotl64(A[14] ^ d4, 39); \
+		b3 = rotl64(A[15] ^ d0, 41); \
+		b4 = rotl64(A[21] ^ d1, 2); \
+		E[20] = b0 ^ (~b1 & b2); \
+		E[21] = ~b1 ^ (b2 | b3); \
+		E[22] = b2 ^ (b3 & b4); \
+		E[23] = b3 ^ (b4 | b0); \
+		E[24] = b4 ^ (b0 & b1); \
+	}
+
+static void keccak_f1600(quint64 *a)
+{
+	static const quint64 rc[24] =
+	{
+		Q_UINT64_C(0x0000000000000001), Q_UINT64_C(0x0000000000008082),
+		Q_UINT64_C(0x800000000000808a), Q_UINT64_C(0x8000000080008000),
+		Q_UINT64_C(0x000000000000808b), Q_UINT64_C(0x0000000080000001),
+		Q_UINT64_C(0x8000000080008081), Q_UINT64_C(0x8000000000008009),
+		Q_UINT64_C(0x000000000000008a), Q_UINT64_C(0x0000000000000088),
+		Q_UINT64_C(0x0000000080008009), Q_UINT64_C(0x000000008000000a),
+		Q_UINT64_C(0x000000008000808b), Q_UINT64_C(0x800000000000008b),
+		Q_UINT64_C(0x8000000000008089), Q_UINT64_C(0x8000000000008003),
+		Q_UINT64_C(0x8000000000008002), Q_UINT64_C(0x8000000000000080),
+		Q_UINT64_C(0x000000000000800a), Q_UINT64_C(0x800000008000000a),
+		Q_UINT64_C(0x8000000080008081), Q_UINT64_C(0x8000000000008080),
+		Q_UINT64_C(0x0000000080000001), Q_UINT64_C(0x8000000080008008)
+	};
+
+	// two rounds at a time, so that the state goes back and forth
+	//   between a and e without copying
+	quint64 e[25];
+	for(int i = 0; i < 24; i += 2)
+	{
+		KECCAK_ROUND(a, e, rc[i]);
+		KECCAK_ROUND(e, a, rc[i + 1]);
+	}
+}
+
+#undef KECCAK_ROUND
+
+// the sponge of FIPS 202, for SHA-3 and SHAKE
+class KeccakState
+{
+public:
+	quint64 a[25];
+	size_t rate;
+	size_t pos;
+	unsigned char suffix;
+	bool squeezing;
+
+	// rate in bytes, and the domain bits of the padding
+	KeccakState(size_t _rate = 136, unsigned char _suffix = 0x06)
+	{
+		rate = _rate;
+		suffix = _suffix;
+		memset(a, 0, sizeof(a));
+		a[1] = a[2] = a[8] = a[12] = a[17] = a[20] = ~Q_UINT64_C(0);
+		pos = 0;
+		squeezing = false;
+	}
+
+	void update(const unsigned char *data, size_t n)
+	{
+		// whole lanes, when the input is lined up with them
+		while(pos == 0 && n >= rate)
+		{
+			for(size_t i = 0; i < rate / 8; ++i)
+				a[i] ^= load64_le(data + i * 8);
+			keccak_f1600(a);
+			data += rate;
+			n -= rate;
+		}
+
+		while(n > 0)
+		{
+			a[pos / 8] ^= (quint64)*data << (8 * (pos % 8));
+			++data;
+			--n;
+			if(++pos == rate)
+			{
+				keccak_f1600(a);
+				pos = 0;
+			}
+		}
+	}
+
+	// can be called again for more output, but update() can't be
+	//   called afterwards
+	void squeeze(unsigned char *out, size_t n)
+	{
+		if(!squeezing)
+		{
+			a[pos / 8] ^= (quint64)suffix << (8 * (pos % 8));
+			a[(rate - 1) / 8] ^= (quint64)0x80 << (8 * ((rate - 1) % 8));
+			keccak_f1600(a);
+			pos = 0;
+			squeezing = true;
+		}
+
+		while(n > 0)
+		{
+			if(pos == rate)
+			{
+				keccak_f1600(a);
+				pos = 0;
+			}
+			quint64 lane = a[pos / 8];
+			if(complemented(pos / 8))
+				lane = ~lane;
+			*out = (unsigned char)(lane >> (8 * (pos % 8)));
+			++out;
+			--n;
+			++pos;
+		}
+	}
+
+private:
+	static bool complemented(size_t lane)
+	{
+		return lane == 1 || lane == 2 || lane == 8 || lane == 12 || lane == 17 || lane == 20;
+	}
+};
+
+class DefaultSHA3Context : public HashContext
+{
+public:
+	// outLen is the size of final() for SHAKE, which is the same as
+	//   OpenSSL's.  other sizes come from xofFinal().
+	DefaultSHA3Context(Provider *p, const QString &type, size_t _rate, unsigned char _suffix, int _outLen) : HashContext(p, type)
+	{
+		rate = _rate;
+		suffix = _suffix;
+		outLen = _outLen;
+		clear();
+	}
+
+	virtual Provider::Context *clone() const
+	{
+		return new DefaultSHA3Context(*this);
+	}
+
+	virtual void clear()
+	{
+		secure = true;
+		state = KeccakState(rate, suffix);
+	}
+
+	virtual void update(const MemoryRegion &in)
+	{
+		if(!in.isSecure())
+			secure = false;
+		state.update((const unsigned char *)in.data(), in.size());
+	}
+
+	virtual void updateView(const MemoryRegion &in)
+	{
+		update(in);
+	}
+
+	virtual MemoryRegion final()
+	{
+		return squeeze(outLen);
+	}
+
+	virtual MemoryRegion xofFinal(int length)
+	{
+		// only SHAKE is extendable
+		if(suffix != 0x1f)
+			return MemoryRegion();
+		return squeeze(length);
+	}
+
+	bool secure;
+	size_t rate;
+	unsigned char suffix;
+	int outLen;
+	KeccakState state;
+
+private:
+	MemoryRegion squeeze(int length)
+	{
+		SecureArray b(length);
+		state.squeeze((unsigned char *)b.data(), length);
+		if(secure)
+			return b;
+		else
+			return b.toByteArray();
+	}
+};
+
+//----------------------------------------------------------------------------
+// DefaultChaChaContext
+//----------------------------------------------------------------------------
+
+#ifdef QCA_HAVE_SSSE3
+
+// four blocks of ChaCha20 keystream, one in each lane of the registers,
+//   the same as ChaCha20State::blocks()
+QCA_TARGET_SSSE3 static void chacha20_blocks_ssse3(const quint32 *in, unsigned char *out)
+{
+	__m128i x[16];
+	for(int i = 0; i < 16; ++i)
+		x[i] = _mm_set1_epi32((int)in[i]);
+	x[12] = _mm_add_epi32(x[12], _mm_setr_epi32(0, 1, 2, 3));
+
+#define CHACHA_QR4(a, b, c, d) \
+	x[a] = _mm_add_epi32(x[a], x[b]); x[d] = rotr32_ssse3(_mm_xor_si128(x[d], x[a]), 16); \
+	x[c] = _mm_add_epi32(x[c], x[d]); x[b] = rotr32_ssse3(_mm_xor_si128(x[b], x[c]), 20); \
+	x[a] = _mm_add_epi32(x[a], x[b]); x[d] = rotr32_ssse3(_mm_xor_si128(x[d], x[a]), 24); \
+	x[c] = _mm_add_epi32(x[c], x[d]); x[b] = rotr32_ssse3(_mm_xor_si128(x[b], x[c]), 25);
+
+	for(int i = 0; i < 10; ++i)
+	{
+		CHACHA_QR4(0, 4,  8, 12);
+		CHACHA_QR4(1, 5,  9, 13);
+		CHACHA_QR4(2, 6, 10, 14);
+		CHACHA_QR4(3, 7, 11, 15);
+		CHACHA_QR4(0, 5, 10, 15);
+		CHACHA_QR4(1, 6, 11, 12);
+		CHACHA_QR4(2, 7,  8, 13);
+		CHACHA_QR4(3, 4,  9, 14);
+	}
+#undef CHACHA_QR4
+
+	for(int i = 0; i < 16; ++i)
+		x[i] = _mm_add_epi32(x[i], _mm_set1_epi32((int)in[i]));
+	x[12] = _mm_add_epi32(x[12], _mm_setr_epi32(0, 1, 2, 3));
+
+	// back from words of the four blocks to the blocks
+	for(int i = 0; i < 16; i += 4)
+	{
+		transpose4_ssse3(x + i);
+		for(int j = 0; j < 4; ++j)
+			_mm_storeu_si128((__m128i *)(out + j * 64 + i * 4), x[i + j]);
+	}
+}
+
+#endif
+
+// ChaCha20 of RFC 8439.  four blocks of keystream are made at a time,
+//   with the four states interleaved word by word, so that each step of
+//   the rounds is a loop over the blocks.  with SSSE3 the loop is one
+//   instruction on a register.
+class ChaCha20State
+{
+public:
+	enum { Blocks = 4, StreamSize = Blocks * 64 };
+
+	quint32 input[16];
+	unsigned char stream[StreamSize];
+	size_t streamPos;
+	quint64 left; // bytes of keystream before the block counter wraps
+
+	ChaCha20State()
+	{
+		memset(input, 0, sizeof(input));
+		streamPos = StreamSize;
+		left = 0;
+	}
+
+	// a 32 byte key, and a 12 byte nonce
+	void setup(const unsigned char *key, const unsigned char *nonce, quint32 counter)
+	{
+		setConstants(input);
+		for(int n = 0; n < 8; ++n)
+			input[n + 4] = load32_le(key + n * 4);
+		input[12] = counter;
+		for(int n = 0; n < 3; ++n)
+			input[n + 13] = load32_le(nonce + n * 4);
+		streamPos = StreamSize;
+		left = ((Q_UINT64_C(1) << 32) - counter) * 64;
+	}
+
+	// fails, without processing anything, if the block counter would
+	//   wrap and so repeat the keystream.  the blocks made in advance
+	//   past that point are never used.
+	bool process(const unsigned char *in, unsigned char *out, size_t n)
+	{
+		if(n > left)
+			return false;
+		left -= n;
+
+		while(n > 0)
+		{
+			if(streamPos == StreamSize)
+			{
+				blocks(input, stream);
+				input[12] += Blocks;
+				streamPos = 0;
+			}
+			size_t k = qMin((size_t)StreamSize - streamPos, n);
+			for(size_t i = 0; i < k; ++i)
+				out[i] = in[i] ^ stream[streamPos + i];
+			streamPos += k;
+			in += k;
+			out += k;
+			n -= k;
+		}
+		return true;
+	}
+
+	void wipe()
+	{
+		memset(input, 0, sizeof(input));
+		memset(stream, 0, sizeof(stream));
+		streamPos = StreamSize;
+		left = 0;
+	}
+
+	// HChaCha20, which makes the XChaCha20 subkey from a key and the
+	//   first 16 bytes of its nonce
+	static void hchacha20(const unsigned char *key, const unsigned char *nonce, unsigned char *out)
+	{
+		quint32 x[16];
+		setConstants(x);
+		for(int n = 0; n < 8; ++n)
+			x[n + 4] = load32_le(key + n * 4);
+		for(int n = 0; n < 4; ++n)
+			x[n + 12] = load32_le(nonce + n * 4);
+
+#define CHACHA_QR(a, b, c, d) \
+		x[a] += x[b]; x[d] = rotl32(x[d] ^ x[a], 16); \
+		x[c] += x[d]; x[b] = rotl32(x[b] ^ x[c], 12); \
+		x[a] += x[b]; x[d] = rotl32(x[d] ^ x[a], 8); \
+		x[c] += x[d]; x[b] = rotl32(x[b] ^ x[c], 7);
+
+		for(int i = 0; i < 10; ++i)
+		{
+			CHACHA_QR(0, 4,  8, 12);
+			CHACHA_QR(1, 5,  9, 13);
+			CHACHA_QR(2, 6, 10, 14);
+			CHACHA_QR(3, 7, 11, 15);
+			CHACHA_QR(0, 5, 10, 15);
+			CHACHA_QR(1, 6, 11, 12);
+			CHACHA_QR(2, 7,  8, 13);
+			CHACHA_QR(3, 4,  9, 14);
+		}
+#undef CHACHA_QR
+
+		for(int n = 0; n < 4; ++n)
+		{
+			store32_le(out + n * 4, x[n]);
+			store32_le(out + 16 + n * 4, x[n + 12]);
+		}
+		memset(x, 0, sizeof(x));
+	}
+
+private:
+	static void setConstants(quint32 *x)
+	{
+		// "expand 32-byte k"
+		x[0] = 0x61707865;
+		x[1] = 0x3320646e;
+		x[2] = 0x79622d32;
+		x[3] = 0x6b206574;
+	}
+
+	static void blocks(const quint32 *in, unsigned char *out)
+	{
+#ifdef QCA_HAVE_SSSE3
+		if(have_ssse3())
+		{
+			chacha20_blocks_ssse3(in, out);
+			return;
+		}
+#endif
+
+		quint32 x[16][Blocks];
+		for(int i = 0; i < 16; ++i)
+		{
+			for(int j = 0; j < Blocks; ++j)
+				x[i][j] = in[i];
+		}
+		for(int j = 0; j < Blocks; ++j)
+			x[12][j] += j;
+
+#define CHACHA_QR4(a, b, c, d) \
+		for(int j = 0; j < Blocks; ++j) \
+		{ \
+			x[a][j] += x[b][j]; x[d][j] = rotl32(x[d][j] ^ x[a][j], 16); \
+			x[c][j] += x[d][j]; x[b][j] = rotl32(x[b][j] ^ x[c][j], 12); \
+			x[a][j] += x[b][j]; x[d][j] = rotl32(x[d][j] ^ x[a][j], 8); \
+			x[c][j] += x[d][j]; x[b][j] = rotl32(x[b][j] ^ x[c][j], 7); \
+		}
+
+		for(int i = 0; i < 10; ++i)
+		{
+			CHACHA_QR4(0, 4,  8, 12);
+			CHACHA_QR4(1, 5,  9, 13);
+			CHACHA_QR4(2, 6, 10, 14);
+			CHACHA_QR4(3, 7, 11, 15);
+			CHACHA_QR4(0, 5, 10, 15);
+			CHACHA_QR4(1, 6, 11, 12);
+			CHACHA_QR4(2, 7,  8, 13);
+			CHACHA_QR4(3, 4,  9, 14);
+		}
+#undef CHACHA_QR4
+
+		for(int j = 0; j < Blocks; ++j)
+		{
+			for(int i = 0; i < 16; ++i)
+			{
+				quint32 v = x[i][j] + in[i];
+				if(i == 12)
+					v += j;
+				store32_le(out + j * 64 + i * 4, v);
+			}
+		}
+		memset(x, 0, sizeof(x));
+	}
+};
+
+// Poly1305 of RFC 8439, in 26 bit limbs
+class Poly1305State
+{
+public:
+	Poly1305State()
+	{
+		memset(r, 0, sizeof(r));
+		memset(h, 0, sizeof(h));
+		memset(pad, 0, sizeof(pad));
+		bufLen = 0;
+	}
+
+	void setup(const unsigned char *key)
+	{
+		r[0] = (load32_le(key + 0)) & 0x3ffffff;
+		r[1] = (load32_le(key + 3) >> 2) & 0x3ffff03;
+		r[2] = (load32_le(key + 6) >> 4) & 0x3ffc0ff;
+		r[3] = (load32_le(key + 9) >> 6) & 0x3f03fff;
+		r[4] = (load32_le(key + 12) >> 8) & 0x00fffff;
+		for(int n = 0; n < 5; ++n)
+			h[n] = 0;
+		for(int n = 0; n < 4; ++n)
+			pad[n] = load32_le(key + 16 + n * 4);
+		bufLen = 0;
+	}
+
+	void update(const unsigned char *m, size_t n)
+	{
+		if(bufLen > 0)
+		{
+			size_t k = qMin((size_t)16 - bufLen, n);
+			memcpy(buf + bufLen, m, k);
+			bufLen += k;
+			m += k;
+			n -= k;
+			if(bufLen < 16)
+				return;
+			blocks(buf, 16, 1 << 24);
+			bufLen = 0;
+		}
+
+		size_t whole = n & ~(size_t)15;
+		if(whole > 0)
+		{
+			blocks(m, whole, 1 << 24);
+			m += whole;
+			n -= whole;
+		}
+
+		memcpy(buf, m, n);
+		bufLen = n;
+	}
+
+	// zeros up to a multiple of 16 bytes, for the AEAD construction
+	void pad16()
+	{
+		if(bufLen > 0)
+		{
+			memset(buf + bufLen, 0, 16 - bufLen);
+			blocks(buf, 16, 1 << 24);
+			bufLen = 0;
+		}
+	}
+
+	void final(unsigned char *mac)
+	{
+		if(bufLen > 0)
+		{
+			buf[bufLen] = 1;
+			memset(buf + bufLen + 1, 0, 15 - bufLen);
+			blocks(buf, 16, 0);
+			bufLen = 0;
+		}
+
+		// fully carry h
+		quint32 h0 = h[0], h1 = h[1], h2 = h[2], h3 = h[3], h4 = h[4];
+		quint32 c;
+		c = h1 >> 26; h1 &= 0x3ffffff; h2 += c;
+		c = h2 >> 26; h2 &= 0x3ffffff; h3 += c;
+		c = h3 >> 26; h3 &= 0x3ffffff; h4 += c;
+		c = h4 >> 26; h4 &= 0x3ffffff; h0 += c * 5;
+		c = h0 >> 26; h0 &= 0x3ffffff; h1 += c;
+
+		// h - p, and take it if it didn't go negative
+		quint32 g0, g1, g2, g3, g4;
+		g0 = h0 + 5; c = g0 >> 26; g0 &= 0x3ffffff;
+		g1 = h1 + c; c = g1 >> 26; g1 &= 0x3ffffff;
+		g2 = h2 + c; c = g2 >> 26; g2 &= 0x3ffffff;
+		g3 = h3 + c; c = g3 >> 26; g3 &= 0x3ffffff;
+		g4 = h4 + c - (1 << 26);
+
+		quint32 mask = (g4 >> 31) - 1;
+		h0 = (h0 & ~mask) | (g0 & mask);
+		h1 = (h1 & ~mask) | (g1 & mask);
+		h2 = (h2 & ~mask) | (g2 & mask);
+		h3 = (h3 & ~mask) | (g3 & mask);
+		h4 = (h4 & ~mask) | (g4 & mask);
+
+		// h + pad, mod 2^128
+		h0 = h0 | (h1 << 26);
+		h1 = (h1 >> 6) | (h2 << 20);
+		h2 = (h2 >> 12) | (h3 << 14);
+		h3 = (h3 >> 18) | (h4 << 8);
+
+		quint64 f;
+		f = (quint64)h0 + pad[0];             store32_le(mac + 0, (quint32)f);
+		f = (quint64)h1 + pad[1] + (f >> 32); store32_le(mac + 4, (quint32)f);
+		f = (quint64)h2 + pad[2] + (f >> 32); store32_le(mac + 8, (quint32)f);
+		f = (quint64)h3 + pad[3] + (f >> 32); store32_le(mac + 12, (quint32)f);
+
+		wipe();
+	}
+
+	void wipe()
+	{
+		memset(r, 0, sizeof(r));
+		memset(h, 0, sizeof(h));
+		memset(pad, 0, sizeof(pad));
+		memset(buf, 0, sizeof(buf));
+		bufLen = 0;
+	}
+
+private:
+	quint32 r[5];
+	quint32 h[5];
+	quint32 pad[4];
+	unsigned char buf[16];
+	size_t bufLen;
+
+	void blocks(const unsigned char *m, size_t n, quint32 hibit)
+	{
+		const quint32 r0 = r[0], r1 = r[1], r2 = r[2], r3 = r[3], r4 = r[4];
+		const quint32 s1 = r1 * 5, s2 = r2 * 5, s3 = r3 * 5, s4 = r4 * 5;
+		quint32 h0 = h[0], h1 = h[1], h2 = h[2], h3 = h[3], h4 = h[4];
+
+		for(; n >= 16; m += 16, n -= 16)
+		{
+			h0 += (load32_le(m + 0)) & 0x3ffffff;
+			h1 += (load32_le(m + 3) >> 2) & 0x3ffffff;
+			h2 += (load32_le(m + 6) >> 4) & 0x3ffffff;
+			h3 += (load32_le(m + 9) >> 6) & 0x3ffffff;
+			h4 += (load32_le(m + 12) >> 8) | hibit;
+
+			quint64 d0 = (quint64)h0 * r0 + (quint64)h1 * s4 + (quint64)h2 * s3 + (quint64)h3 * s2 + (quint64)h4 * s1;
+			quint64 d1 = (quint64)h0 * r1 + (quint64)h1 * r0 + (quint64)h2 * s4 + (quint64)h3 * s3 + (quint64)h4 * s2;
+			quint64 d2 = (quint64)h0 * r2 + (quint64)h1 * r1 + (quint64)h2 * r0 + (quint64)h3 * s4 + (quint64)h4 * s3;
+			quint64 d3 = (quint64)h0 * r3 + (quint64)h1 * r2 + (quint64)h2 * r1 + (quint64)h3 * r0 + (quint64)h4 * s4;
+			quint64 d4 = (quint64)h0 * r4 + (quint64)h1 * r3 + (quint64)h2 * r2 + (quint64)h3 * r1 + (quint64)h4 * r0;
+
+			quint32 c;
+			c = (quint32)(d0 >> 26); h0 = (quint32)d0 & 0x3ffffff;
+			d1 += c; c = (quint32)(d1 >> 26); h1 = (quint32)d1 & 0x3ffffff;
+			d2 += c; c = (quint32)(d2 >> 26); h2 = (quint32)d2 & 0x3ffffff;
+			d3 += c; c = (quint32)(d3 >> 26); h3 = (quint32)d3 & 0x3ffffff;
+			d4 += c; c = (quint32)(d4 >> 26); h4 = (quint32)d4 & 0x3ffffff;
+			h0 += c * 5; c = h0 >> 26; h0 &= 0x3ffffff;
+			h1 += c;
+		}
+
+		h[0] = h0; h[1] = h1; h[2] = h2; h[3] = h3; h[4] = h4;
+	}
+};
+
+// "chacha20" takes a 16 byte IV, which is the initial block counter
+//   followed by the nonce, as in OpenSSL.  the AEAD types take the 12
+//   byte nonce of RFC 8439, or the 24 byte one of XChaCha20.  their 16
+//   byte tag works like that of GCM: it comes from tag() after
+//   encrypting, and is given to setup() for decrypting, in which case
+//   final() fails if it doesn't match.  there is no associated data.
+class DefaultChaChaContext : public CipherContext
+{
+public:
+	DefaultChaChaContext(Provider *p, const QString &type) : CipherContext(p, type)
+	{
+		aead = type.endsWith("-poly1305");
+		extended = type.startsWith("xchacha20");
+		dir = Encode;
+		valid = false;
+		length = 0;
+	}
+
+	~DefaultChaChaContext()
+	{
+		stream.wipe();
+		mac.wipe();
+	}
+
+	virtual Provider::Context *clone() const
+	{
+		return new DefaultChaChaContext(*this);
+	}
+
+	virtual void setup(Direction _dir, const SymmetricKey &key, const InitializationVector &iv, const AuthTag &tag)
+	{
+		dir = _dir;
+		m_tag = tag;
+		length = 0;
+		stream.wipe();
+		mac.wipe();
+
+		int ivSize = aead ? (extended ? 24 : 12) : 16;
+		valid = (key.size() == 32 && iv.size() == ivSize);
+		if(!valid)
+			return;
+
+		const unsigned char *k = (const unsigned char *)key.data();
+		const unsigned char *n = (const unsigned char *)iv.data();
+		if(!aead)
+		{
+			stream.setup(k, n + 4, load32_le(n));
+			return;
+		}
+
+		unsigned char subkey[32];
+		unsigned char nonce[12];
+		if(extended)
+		{
+			ChaCha20State::hchacha20(k, n, subkey);
+			memset(nonce, 0, 4);
+			memcpy(nonce + 4, n + 16, 8);
+			k = subkey;
+		}
+		else
+			memcpy(nonce, n, 12);
+
+		// the Poly1305 key is the start of block 0, and the message
+		//   is encrypted from block 1 on
+		unsigned char block[64];
+		memset(block, 0, 64);
+		stream.setup(k, nonce, 0);
+		stream.process(block, block, 64);
+		mac.setup(block);
+		memset(block, 0, 64);
+		memset(subkey, 0, 32);
+	}
+
+	virtual KeyLength keyLength() const
+	{
+		return KeyLength(32, 32, 1);
+	}
+
+	virtual int blockSize() const
+	{
+		return 1;
+	}
+
+	virtual AuthTag tag() const
+	{
+		return m_tag;
+	}
+
+	virtual bool update(const SecureArray &in, SecureArray *out)
+	{
+		if(!valid)
+			return false;
+
+		// the 32-bit block counter limits a message to 256 GiB, less the
+		//   block of the Poly1305 key for the AEAD types.  past that the
+		//   message fails as a whole
+		if((quint64)in.size() > stream.left)
+		{
+			valid = false;
+			return false;
+		}
+
+		out->resize(in.size());
+		if(aead && dir == Decode)
+			mac.update((const unsigned char *)in.data(), in.size());
+		stream.process((const unsigned char *)in.data(), (unsigned char *)out->data(), in.size());
+		if(aead && dir == Encode)
+			mac.update((const unsigned char *)out->data(), out->size());
+		length += in.size();
+		return true;
+	}
+
+	virtual bool final(SecureArray *out)
+	{
+		out->clear();
+		if(!valid)
+			return false;
+		valid = false;
+		if(!aead)
+			return true;
+
+		// the lengths of the associated data (none) and of the
+		//   ciphertext
+		unsigned char lengths[16];
+		store64_le(lengths, 0);
+		store64_le(lengths + 8, length);
+		mac.pad16();
+		mac.update(lengths, 16);
+		AuthTag t(16);
+		mac.final((unsigned char *)t.data());
+
+		if(dir == Encode)
+		{
+			m_tag = t;
+			return true;
+		}
+
+		if(m_tag.size() != 16)
+			return false;
+		unsigned char diff = 0;
+		for(int n = 0; n < 16; ++n)
+			diff |= t[n] ^ m_tag[n];
+		return diff == 0;
+	}
+
+	Direction dir;
+	bool aead, extended, valid;
+	quint64 length;
+	AuthTag m_tag;
+	ChaCha20State stream;
+	Poly1305State mac;
+};
+
+//----------------------------------------------------------------------------
+// DefaultHKDFContext
+//----------------------------------------------------------------------------
+// RFC 5869 over the HMAC of one of the hashes above.  the inner and outer
+//   hash states of the HMAC are computed once for the pseudorandom key and
+//   cloned for each block, so expanding many keys from it is cheap.
+class DefaultHKDFContext : public HKDFContext
+{
+public:
+	HashContext *hash;
+	HashContext *inner, *outer;
+
+	// takes ownership of the hash
+	DefaultHKDFContext(HashContext *_hash, Provider *p, const QString &type) : HKDFContext(p, type)
+	{
+		hash = _hash;
+		inner = 0;
+		outer = 0;
+	}
+
+	DefaultHKDFContext(const DefaultHKDFContext &from) : HKDFContext(from)
+	{
+		hash = static_cast<HashContext *>(from.hash->clone());
+		inner = from.inner ? static_cast<HashContext *>(from.inner->clone()) : 0;
+		outer = from.outer ? static_cast<HashContext *>(from.outer->clone()) : 0;
+	}
+
+	~DefaultHKDFContext()
+	{
+		delete inner;
+		delete outer;
+		delete hash;
+	}
+
+	virtual Provider::Context *clone() const
+	{
+		return new DefaultHKDFContext(*this);
+	}
+
+	// md5 and sha1 both work on 64 byte blocks
+	static int blockSize()
+	{
+		return 64;
+	}
+
+	int hashLength()
+	{
+		hash->clear();
+		return hash->final().size();
+	}
+
+	void setKey(const MemoryRegion &key, HashContext **in, HashContext **out)
+	{
+		SecureArray k = key;
+		if(k.size() > blockSize())
+		{
+			hash->clear();
+			hash->update(k);
+			k = hash->final();
+		}
+
+		SecureArray ipad(blockSize(), 0x36);
+		SecureArray opad(blockSize(), 0x5c);
+		for(int n = 0; n < k.size(); ++n)
+		{
+			ipad[n] ^= k[n];
+			opad[n] ^= k[n];
+		}
+
+		*in = static_cast<HashContext *>(hash->clone());
+		(*in)->clear();
+		(*in)->update(ipad);
+		*out = static_cast<HashContext *>(hash->clone());
+		(*out)->clear();
+		(*out)->update(opad);
+	}
+
+	static SecureArray hmac(HashContext *in, HashContext *out, const QList<MemoryRegion> &parts)
+	{
+		HashContext *c = static_cast<HashContext *>(in->clone());
+		foreach(const MemoryRegion &a, parts)
+			c->update(a);
+		MemoryRegion d = c->final();
+		delete c;
+
+		c = static_cast<HashContext *>(out->clone());
+		c->update(d);
+		SecureArray r = c->final();
+		delete c;
+		return r;
+	}
+
+	virtual SymmetricKey extract(const SecureArray &secret, const InitializationVector &salt)
+	{
+		HashContext *in, *out;
+		if(salt.isEmpty())
+			setKey(SecureArray(hashLength(), 0), &in, &out);
+		else
+			setKey(salt, &in, &out);
+		SymmetricKey prk = hmac(in, out, QList<MemoryRegion>() << secret);
+		delete in;
+		delete out;
+
+		setPrk(prk);
+		return prk;
+	}
+
+	virtual void setPrk(const SymmetricKey &prk)
+	{
+		delete inner;
+		delete outer;
+		setKey(prk, &inner, &outer);
+	}
+
+	virtual SymmetricKey expand(const InitializationVector &info, unsigned int keyLength)
+	{
+		int hashLen = hashLength();
+		if(!inner || keyLength > 255 * (unsigned int)hashLen)
+			return SymmetricKey();
+
+		SecureArray out;
+		out.reserve(keyLength);
+		SecureArray t;
+		for(int i = 1; (unsigned int)out.size() < keyLength; ++i)
+		{
+			QByteArray counter(1, (char)i);
+			t = hmac(inner, outer, QList<MemoryRegion>() << t << info << counter);
+			out.append(t);
+		}
+		out.resize(keyLength);
+		return out;
+	}
+};
+
 //----------------------------------------------------------------------------
 // DefaultKeyStoreEntry
 //----------------------------------------------------------------------------
@@ -1237,6 +4373,24 @@ public:
 		list += "random";
 		list += "md5";
 		list += "sha1";
+		list += "blake2b";
+		list += "blake2s";
+		list += "blake2bp";
+		list += "blake3";
+		list += "sha3-224";
+		list += "sha3-256";
+		list += "sha3-384";
+		list += "sha3-512";
+		list += "shake128";
+		list += "shake256";
+		list += "chacha20";
+		list += "chacha20-poly1305";
+		list += "xchacha20-poly1305";
+		list += "pbkdf2(sha1)";
+		list += "scrypt";
+		list += "argon2id";
+		list += "hkdf(md5)";
+		list += "hkdf(sha1)";
 		list += "keystorelist";
 		return list;
 	}
@@ -1249,6 +4403,38 @@ public:
 			return new DefaultMD5Context(this);
 		else if(type == "sha1")
 			return new DefaultSHA1Context(this);
+		else if(type == "blake2b")
+			return new DefaultBlake2bContext(this);
+		else if(type == "blake2s")
+			return new DefaultBlake2sContext(this);
+		else if(type == "blake2bp")
+			return new DefaultBlake2bpContext(this);
+		else if(type == "blake3")
+			return new DefaultBlake3Context(this);
+		else if(type == "sha3-224")
+			return new DefaultSHA3Context(this, type, 144, 0x06, 28);
+		else if(type == "sha3-256")
+			return new DefaultSHA3Context(this, type, 136, 0x06, 32);
+		else if(type == "sha3-384")
+			return new DefaultSHA3Context(this, type, 104, 0x06, 48);
+		else if(type == "sha3-512")
+			return new DefaultSHA3Context(this, type, 72, 0x06, 64);
+		else if(type == "shake128")
+			return new DefaultSHA3Context(this, type, 168, 0x1f, 16);
+		else if(type == "shake256")
+			return new DefaultSHA3Context(this, type, 136, 0x1f, 32);
+		else if(type == "chacha20" || type == "chacha20-poly1305" || type == "xchacha20-poly1305")
+			return new DefaultChaChaContext(this, type);
+		else if(type == "pbkdf2(sha1)")
+			return new DefaultPBKDF2Context(this);
+		else if(type == "scrypt")
+			return new DefaultScryptContext(this);
+		else if(type == "argon2id")
+			return new DefaultArgon2Context(this);
+		else if(type == "hkdf(md5)")
+			return new DefaultHKDFContext(new DefaultMD5Context(this), this, type);
+		else if(type == "hkdf(sha1)")
+			return new DefaultHKDFContext(new DefaultSHA1Context(this), this, type);
 		else if(type == "keystorelist")
 			return new DefaultKeyStoreList(this, &shared);
 		else
@@ -0,0 +1,560 @@
+/*
+ * Copyright (C) 2026  Forkworks
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301  USA
+ *
+ */
+
+#include "qca_device.h"
+
+#include "qca_support.h"
+
+#include <QFile>
+
+namespace QCA {
+
+//----------------------------------------------------------------------------
+// FilterDevice
+//----------------------------------------------------------------------------
+class FilterDevice::Private : public QObject
+{
+	Q_OBJECT
+public:
+	enum Status { Ok, End, Failed };
+
+	class ReadJob : public ThreadPoolJob
+	{
+	public:
+		Private *d;
+		QByteArray result;
+		int status;
+
+		ReadJob(Private *_d) : d(_d), status(Ok)
+		{
+		}
+
+		~ReadJob()
+		{
+			wait();
+		}
+
+	protected:
+		virtual void run()
+		{
+			status = d->step(&result);
+		}
+	};
+
+	FilterDevice *q;
+	Filter *filter;
+	QIODevice *dev;
+	int blockSize;
+	bool readAhead;
+	bool ok;
+
+	// reading
+	bool ahead; // read the next block on the pool
+	bool sequential;
+	bool devFinished;
+	bool done;
+	QByteArray out;
+	int outPos;
+	ReadJob *job;
+
+	// writing
+	QByteArray pending;
+
+	Private(FilterDevice *_q, Filter *_filter, QIODevice *_dev) : QObject(_q), q(_q), filter(_filter), dev(_dev)
+	{
+		blockSize = 65536;
+		readAhead = false;
+		ok = true;
+		ahead = false;
+		sequential = false;
+		devFinished = false;
+		done = false;
+		outPos = 0;
+		job = 0;
+	}
+
+	~Private()
+	{
+		delete job;
+	}
+
+	void reset()
+	{
+		ok = true;
+		sequential = dev->isSequential();
+		// a QFile can be read from another thread.  other devices may
+		//   emit signals or rely on objects of their own thread
+		ahead = readAhead && !sequential && qobject_cast<QFile*>(dev);
+		devFinished = false;
+		done = false;
+		out.clear();
+		outPos = 0;
+		pending.clear();
+	}
+
+	void fail()
+	{
+		ok = false;
+		q->setErrorString("Filter failed");
+	}
+
+	// reads and filters the next block.  this may run on the pool, so it
+	//   only touches the device and the filter.
+	int step(QByteArray *result)
+	{
+		QByteArray buf(blockSize, 0);
+		qint64 len = dev->read(buf.data(), blockSize);
+		if(len < 0)
+			len = 0;
+		buf.resize(int(len));
+
+		if(len > 0)
+		{
+			*result = filter->update(buf).toByteArray();
+			if(!filter->ok())
+				return Failed;
+		}
+
+		if(len == 0 && (sequential ? (devFinished || !dev->isOpen()) : dev->atEnd()))
+		{
+			*result += filter->final().toByteArray();
+			if(!filter->ok())
+				return Failed;
+			return End;
+		}
+		return Ok;
+	}
+
+	// refills the output buffer once it has been consumed.  returns false
+	//   if nothing could be read without blocking.
+	bool fill()
+	{
+		QByteArray result;
+		int status;
+		if(job)
+		{
+			job->wait();
+			result = job->result;
+			status = job->status;
+			job->result.clear();
+		}
+		else
+			status = step(&result);
+
+		if(status == Failed)
+		{
+			fail();
+			return false;
+		}
+
+		out = result;
+		outPos = 0;
+		if(status == End)
+			done = true;
+
+		if(ahead && !done)
+		{
+			if(!job)
+				job = new ReadJob(this);
+			job->start();
+		}
+
+		return !result.isEmpty() || done;
+	}
+
+	void stopReading()
+	{
+		if(job)
+		{
+			delete job;
+			job = 0;
+		}
+	}
+
+	bool flushPending()
+	{
+		if(pending.isEmpty())
+			return true;
+		bool r = write(pending);
+		pending.clear();
+		return r;
+	}
+
+	bool write(const QByteArray &in)
+	{
+		QByteArray result = filter->update(in).toByteArray();
+		if(!filter->ok())
+		{
+			fail();
+			return false;
+		}
+		return writeOut(result);
+	}
+
+	bool writeOut(const QByteArray &result)
+	{
+		if(!result.isEmpty() && dev->write(result) != result.size())
+		{
+			ok = false;
+			q->setErrorString(dev->errorString());
+			return false;
+		}
+		return true;
+	}
+
+public slots:
+	void dev_readChannelFinished()
+	{
+		devFinished = true;
+		if(q->isOpen())
+			emit q->readyRead();
+	}
+};
+
+FilterDevice::FilterDevice(Filter *filter, QIODevice *device, QObject *parent)
+:QIODevice(parent)
+{
+	d = new Private(this, filter, device);
+}
+
+FilterDevice::~FilterDevice()
+{
+	close();
+	delete d;
+}
+
+QIODevice *FilterDevice::device() const
+{
+	return d->dev;
+}
+
+int FilterDevice::blockSize() const
+{
+	return d->blockSize;
+}
+
+void FilterDevice::setBlockSize(int size)
+{
+	d->blockSize = qMax(size, 1);
+}
+
+bool FilterDevice::readAhead() const
+{
+	return d->readAhead;
+}
+
+void FilterDevice::setReadAhead(bool enabled)
+{
+	d->readAhead = enabled;
+}
+
+bool FilterDevice::ok() const
+{
+	return d->ok;
+}
+
+void FilterDevice::setFilter(Filter *filter)
+{
+	d->filter = filter;
+}
+
+bool FilterDevice::open(OpenMode mode)
+{
+	mode &= ~(QIODevice::Text | QIODevice::Unbuffered);
+	if(isOpen() || !d->filter || !d->dev)
+		return false;
+	if(mode == QIODevice::ReadOnly)
+	{
+		if(!d->dev->isReadable())
+			return false;
+	}
+	else if(mode == QIODevice::WriteOnly)
+	{
+		if(!d->dev->isWritable())
+			return false;
+	}
+	else
+		return false;
+
+	d->reset();
+	d->filter->clear();
+	QIODevice::open(mode | QIODevice::Unbuffered);
+
+	if(mode == QIODevice::ReadOnly)
+	{
+		connect(d->dev, SIGNAL(readyRead()), this, SIGNAL(readyRead()));
+		connect(d->dev, SIGNAL(readChannelFinished()), d, SLOT(dev_readChannelFinished()));
+
+		// get the first block going while the caller gets ready to read
+		if(d->ahead)
+		{
+			d->job = new Private::ReadJob(d);
+			d->job->start();
+		}
+	}
+	return true;
+}
+
+void FilterDevice::close()
+{
+	if(!isOpen())
+		return;
+
+	if(openMode() & QIODevice::WriteOnly)
+	{
+		if(d->ok && d->flushPending())
+		{
+			QByteArray result = d->filter->final().toByteArray();
+			if(d->filter->ok())
+				d->writeOut(result);
+			else
+				d->fail();
+		}
+	}
+	else
+	{
+		d->stopReading();
+		disconnect(d->dev, 0, this, 0);
+		disconnect(d->dev, 0, d, 0);
+	}
+
+	d->out.clear();
+	d->outPos = 0;
+	QIODevice::close();
+}
+
+bool FilterDevice::flushFilter()
+{
+	if(!isOpen())
+		return d->ok;
+
+	if(openMode() & QIODevice::WriteOnly)
+		return d->ok && d->flushPending();
+
+	if(d->job)
+	{
+		d->job->wait();
+		if(d->job->status == Private::Failed)
+			return false;
+	}
+	return d->ok;
+}
+
+bool FilterDevice::isSequential() const
+{
+	return true;
+}
+
+bool FilterDevice::atEnd() const
+{
+	return d->done && d->outPos >= d->out.size() && QIODevice::bytesAvailable() == 0;
+}
+
+qint64 FilterDevice::bytesAvailable() const
+{
+	return (d->out.size() - d->outPos) + QIODevice::bytesAvailable();
+}
+
+qint64 FilterDevice::readData(char *data, qint64 maxSize)
+{
+	if(!d->ok)
+		return -1;
+
+	qint64 copied = 0;
+	while(copied < maxSize)
+	{
+		int avail = d->out.size() - d->outPos;
+		if(avail == 0)
+		{
+			if(d->done || !d->fill())
+				break;
+			continue;
+		}
+
+		int n = int(qMin(qint64(avail), maxSize - copied));
+		memcpy(data + copied, d->out.constData() + d->outPos, n);
+		d->outPos += n;
+		copied += n;
+	}
+
+	if(copied == 0 && (d->done || !d->ok))
+		return -1;
+	return copied;
+}
+
+qint64 FilterDevice::writeData(const char *data, qint64 maxSize)
+{
+	if(!d->ok)
+		return -1;
+
+	// large writes go straight through, small ones are batched up to a
+	//   full block
+	if(d->pending.isEmpty() && maxSize >= d->blockSize)
+	{
+		if(!d->write(QByteArray::fromRawData(data, int(maxSize))))
+			return -1;
+		return maxSize;
+	}
+
+	d->pending.append(data, int(maxSize));
+	if(d->pending.size() >= d->blockSize && !d->flushPending())
+		return -1;
+	return maxSize;
+}
+
+//----------------------------------------------------------------------------
+// TapFilter
+//----------------------------------------------------------------------------
+// passes data through unchanged, feeding it to a computation on the way
+class TapFilter : public Filter
+{
+public:
+	BufferedComputation *c;
+
+	TapFilter(BufferedComputation *_c) : c(_c)
+	{
+	}
+
+	virtual void clear()
+	{
+		c->clear();
+	}
+
+	virtual MemoryRegion update(const MemoryRegion &a)
+	{
+		c->update(a);
+		return a;
+	}
+
+	virtual MemoryRegion final()
+	{
+		return MemoryRegion();
+	}
+
+	virtual bool ok() const
+	{
+		return true;
+	}
+};
+
+//----------------------------------------------------------------------------
+// CipherDevice
+//----------------------------------------------------------------------------
+class CipherDevice::Private
+{
+public:
+	Cipher cipher;
+
+	Private(const Cipher &_cipher) : cipher(_cipher)
+	{
+	}
+};
+
+CipherDevice::CipherDevice(const Cipher &cipher, QIODevice *device, QObject *parent)
+:FilterDevice(0, device, parent)
+{
+	d = new Private(cipher);
+	setFilter(&d->cipher);
+}
+
+CipherDevice::~CipherDevice()
+{
+	close();
+	delete d;
+}
+
+Cipher *CipherDevice::cipher()
+{
+	return &d->cipher;
+}
+
+//----------------------------------------------------------------------------
+// HashDevice
+//----------------------------------------------------------------------------
+class HashDevice::Private
+{
+public:
+	Hash hash;
+	TapFilter tap;
+
+	Private(const Hash &_hash) : hash(_hash), tap(&hash)
+	{
+	}
+};
+
+HashDevice::HashDevice(const Hash &hash, QIODevice *device, QObject *parent)
+:FilterDevice(0, device, parent)
+{
+	d = new Private(hash);
+	setFilter(&d->tap);
+}
+
+HashDevice::~HashDevice()
+{
+	close();
+	delete d;
+}
+
+MemoryRegion HashDevice::final()
+{
+	flushFilter();
+	MemoryRegion r = d->hash.final();
+	d->hash.clear();
+	return r;
+}
+
+//----------------------------------------------------------------------------
+// MACDevice
+//----------------------------------------------------------------------------
+class MACDevice::Private
+{
+public:
+	MessageAuthenticationCode mac;
+	TapFilter tap;
+
+	Private(const MessageAuthenticationCode &_mac) : mac(_mac), tap(&mac)
+	{
+	}
+};
+
+MACDevice::MACDevice(const MessageAuthenticationCode &mac, QIODevice *device, QObject *parent)
+:FilterDevice(0, device, parent)
+{
+	d = new Private(mac);
+	setFilter(&d->tap);
+}
+
+MACDevice::~MACDevice()
+{
+	close();
+	delete d;
+}
+
+MemoryRegion MACDevice::final()
+{
+	flushFilter();
+	MemoryRegion r = d->mac.final();
+	d->mac.clear();
+	return r;
+}
+
+}
+
+#include "qca_device.moc"
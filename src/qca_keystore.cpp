@@ -972,7 +972,7 @@ public:
 	}
 };
 
-class KeyStoreOperation : public QThread
+class KeyStoreOperation : public ThreadPoolJob
 {
 	Q_OBJECT
 public:
@@ -987,7 +987,7 @@ public:
 	bool success; // out: RemoveEntry
 
 	KeyStoreOperation(QObject *parent = 0)
-	:QThread(parent)
+	:ThreadPoolJob(parent)
 	{
 	}
 
@@ -1110,7 +1110,7 @@ public:
 		op->type = KeyStoreOperation::EntryList;
 		op->trackerId = trackerId;
 		ops += op;
-		op->start();
+		op->start(ThreadPool::HighPriority);
 	}
 
 	void async_writeEntry(const KeyStoreWriteEntry &wentry)
@@ -1122,7 +1122,7 @@ public:
 		op->trackerId = trackerId;
 		op->wentry = wentry;
 		ops += op;
-		op->start();
+		op->start(ThreadPool::HighPriority);
 	}
 
 	void async_removeEntry(const QString &entryId)
@@ -1134,7 +1134,7 @@ public:
 		op->trackerId = trackerId;
 		op->entryId = entryId;
 		ops += op;
-		op->start();
+		op->start(ThreadPool::HighPriority);
 	}
 
 private slots:
@@ -24,7 +24,10 @@
 #include "qcaprovider.h"
 
 #include <QFile>
+#include <QHash>
+#include <QSemaphore>
 #include <QTextStream>
+#include <QVector>
 
 namespace QCA {
 
@@ -1552,6 +1555,405 @@ BigInteger DHPrivateKey::x() const
 	return static_cast<const DHContext *>(static_cast<const PKeyContext *>(context())->key())->x();
 }
 
+//----------------------------------------------------------------------------
+// Signer
+//----------------------------------------------------------------------------
+class Signer::Private
+{
+public:
+	PrivateKey key;
+	SignatureAlgorithm alg;
+	SignatureFormat format;
+	PKeyBase *k;
+	bool started;
+
+	Private(const PrivateKey &_key, SignatureAlgorithm _alg, SignatureFormat _format)
+	{
+		alg = _alg;
+		format = _format;
+		bind(_key);
+	}
+
+	Private(const Private &from)
+	{
+		alg = from.alg;
+		format = from.format;
+		bind(from.key);
+	}
+
+	// take a private copy of the key context, so that whatever the
+	//   provider caches for the key stays with this object
+	void bind(const PrivateKey &_key)
+	{
+		key = _key;
+		k = 0;
+		started = false;
+		if(key.isNull() || !key.canSign())
+			return;
+		if(key.isDSA() && format == DefaultFormat)
+			format = IEEE_1363;
+		k = static_cast<PKeyContext *>(key.context())->key();
+	}
+
+	void start()
+	{
+		if(!started)
+		{
+			k->startSign(alg, format);
+			started = true;
+		}
+	}
+};
+
+Signer::Signer(const PrivateKey &key, SignatureAlgorithm alg, SignatureFormat format)
+{
+	d = new Private(key, alg, format);
+}
+
+Signer::Signer(const Signer &from)
+{
+	d = new Private(*from.d);
+}
+
+Signer::~Signer()
+{
+	delete d;
+}
+
+Signer & Signer::operator=(const Signer &from)
+{
+	if(this != &from)
+	{
+		delete d;
+		d = new Private(*from.d);
+	}
+	return *this;
+}
+
+bool Signer::isNull() const
+{
+	return !d->k;
+}
+
+SignatureAlgorithm Signer::signatureAlgorithm() const
+{
+	return d->alg;
+}
+
+SignatureFormat Signer::signatureFormat() const
+{
+	return d->format;
+}
+
+void Signer::update(const MemoryRegion &a)
+{
+	if(!d->k)
+		return;
+	d->start();
+	d->k->update(a);
+}
+
+QByteArray Signer::signature()
+{
+	if(!d->k)
+		return QByteArray();
+	d->start();
+	d->started = false;
+	return d->k->endSign();
+}
+
+QByteArray Signer::signMessage(const MemoryRegion &a)
+{
+	update(a);
+	return signature();
+}
+
+//----------------------------------------------------------------------------
+// Verifier
+//----------------------------------------------------------------------------
+class Verifier::Private
+{
+public:
+	PublicKey key;
+	SignatureAlgorithm alg;
+	SignatureFormat format;
+	PKeyBase *k;
+	bool started;
+
+	Private(const PublicKey &_key, SignatureAlgorithm _alg, SignatureFormat _format)
+	{
+		alg = _alg;
+		format = _format;
+		bind(_key);
+	}
+
+	Private(const Private &from)
+	{
+		alg = from.alg;
+		format = from.format;
+		bind(from.key);
+	}
+
+	void bind(const PublicKey &_key)
+	{
+		key = _key;
+		k = 0;
+		started = false;
+		if(key.isNull() || !key.canVerify())
+			return;
+		if(key.isDSA() && format == DefaultFormat)
+			format = IEEE_1363;
+		PKeyContext *c = qobject_cast<PKeyContext *>(key.context());
+		if(c)
+			k = c->key();
+	}
+
+	void start()
+	{
+		if(!started)
+		{
+			k->startVerify(alg, format);
+			started = true;
+		}
+	}
+};
+
+Verifier::Verifier(const PublicKey &key, SignatureAlgorithm alg, SignatureFormat format)
+{
+	d = new Private(key, alg, format);
+}
+
+Verifier::Verifier(const Verifier &from)
+{
+	d = new Private(*from.d);
+}
+
+Verifier::~Verifier()
+{
+	delete d;
+}
+
+Verifier & Verifier::operator=(const Verifier &from)
+{
+	if(this != &from)
+	{
+		delete d;
+		d = new Private(*from.d);
+	}
+	return *this;
+}
+
+bool Verifier::isNull() const
+{
+	return !d->k;
+}
+
+SignatureAlgorithm Verifier::signatureAlgorithm() const
+{
+	return d->alg;
+}
+
+SignatureFormat Verifier::signatureFormat() const
+{
+	return d->format;
+}
+
+void Verifier::update(const MemoryRegion &a)
+{
+	if(!d->k)
+		return;
+	d->start();
+	d->k->update(a);
+}
+
+bool Verifier::validSignature(const QByteArray &sig)
+{
+	if(!d->k)
+		return false;
+	d->start();
+	d->started = false;
+	return d->k->endVerify(sig);
+}
+
+bool Verifier::verifyMessage(const MemoryRegion &a, const QByteArray &sig)
+{
+	update(a);
+	return validSignature(sig);
+}
+
+//----------------------------------------------------------------------------
+// VerifyBatchItem
+//----------------------------------------------------------------------------
+class VerifyBatchItem::Private : public QSharedData
+{
+public:
+	PublicKey key;
+	MemoryRegion message;
+	QByteArray signature;
+	SignatureAlgorithm alg;
+	SignatureFormat format;
+
+	Private() : alg(SignatureUnknown), format(DefaultFormat)
+	{
+	}
+};
+
+VerifyBatchItem::VerifyBatchItem()
+:d(new Private)
+{
+}
+
+VerifyBatchItem::VerifyBatchItem(const PublicKey &key, const MemoryRegion &message, const QByteArray &signature, SignatureAlgorithm alg, SignatureFormat format)
+:d(new Private)
+{
+	d->key = key;
+	d->message = message;
+	d->signature = signature;
+	d->alg = alg;
+	d->format = format;
+}
+
+VerifyBatchItem::VerifyBatchItem(const VerifyBatchItem &from)
+:d(from.d)
+{
+}
+
+VerifyBatchItem::~VerifyBatchItem()
+{
+}
+
+VerifyBatchItem & VerifyBatchItem::operator=(const VerifyBatchItem &from)
+{
+	d = from.d;
+	return *this;
+}
+
+PublicKey VerifyBatchItem::key() const
+{
+	return d->key;
+}
+
+MemoryRegion VerifyBatchItem::message() const
+{
+	return d->message;
+}
+
+QByteArray VerifyBatchItem::signature() const
+{
+	return d->signature;
+}
+
+SignatureAlgorithm VerifyBatchItem::signatureAlgorithm() const
+{
+	return d->alg;
+}
+
+SignatureFormat VerifyBatchItem::signatureFormat() const
+{
+	return d->format;
+}
+
+//----------------------------------------------------------------------------
+// verifyBatch
+//----------------------------------------------------------------------------
+class VerifyBatchTask : public QRunnable
+{
+public:
+	QList<VerifyBatchItem> items;
+	QList<const Provider::Context*> contexts;
+	QList<int> indexes;
+	bool *results;
+	QSemaphore *done;
+
+	// one private copy of each distinct key.  these are detached by
+	// the caller before the task is started, so every thread works on
+	// its own provider context and no context is ever shared.
+	QHash<const Provider::Context*, PublicKey> keys;
+
+	VerifyBatchTask(bool *_results, QSemaphore *_done) : results(_results), done(_done)
+	{
+	}
+
+	void add(const VerifyBatchItem &item, int index)
+	{
+		const PublicKey key = item.key();
+		const Provider::Context *c = key.context();
+		if(c && !keys.contains(c))
+		{
+			PublicKey own = key;
+			own.context(); // detach
+			keys.insert(c, own);
+		}
+		items += item;
+		contexts += c;
+		indexes += index;
+	}
+
+	virtual void run()
+	{
+		for(int n = 0; n < items.count(); ++n)
+		{
+			const VerifyBatchItem &i = items[n];
+			const Provider::Context *c = contexts[n];
+			if(!c)
+			{
+				results[indexes[n]] = false;
+				continue;
+			}
+			PublicKey &key = keys[c];
+			results[indexes[n]] = key.verifyMessage(i.message(), i.signature(), i.signatureAlgorithm(), i.signatureFormat());
+		}
+		done->release();
+	}
+};
+
+QList<bool> verifyBatch(const QList<VerifyBatchItem> &items, int maxThreads)
+{
+	QList<bool> out;
+	if(items.isEmpty())
+		return out;
+
+	if(maxThreads < 1)
+		maxThreads = ThreadPool::instance()->maxThreadCount();
+	const int count = qMin(maxThreads, items.count());
+
+	QVector<bool> results(items.count(), false);
+	QSemaphore done;
+	QList<VerifyBatchTask*> tasks;
+	for(int n = 0; n < count; ++n)
+	{
+		VerifyBatchTask *t = new VerifyBatchTask(results.data(), &done);
+		t->setAutoDelete(false);
+		tasks += t;
+	}
+
+	// hand out contiguous runs of items, so that batches signed with
+	// the same key tend to land on the same thread
+	const int per = (items.count() + count - 1) / count;
+	for(int n = 0; n < items.count(); ++n)
+		tasks[n / per]->add(items[n], n);
+
+	// queue all but the first run and do that one here.  afterwards,
+	//   take back whatever the pool has not started yet, so that a busy
+	//   pool (or a call from within a pool thread) never leaves us
+	//   blocked on queued work.
+	ThreadPool *pool = ThreadPool::instance();
+	for(int n = 1; n < count; ++n)
+		pool->start(tasks[n]);
+	tasks[0]->run();
+	for(int n = 1; n < count; ++n)
+	{
+		if(pool->tryTake(tasks[n]))
+			tasks[n]->run();
+	}
+	done.acquire(count);
+
+	qDeleteAll(tasks);
+	for(int n = 0; n < results.count(); ++n)
+		out += results[n];
+	return out;
+}
+
 }
 
 #include "qca_publickey.moc"
@@ -0,0 +1,110 @@
+/*
+ * qca_simd.h - Qt Cryptographic Architecture
+ * Copyright (C) 2026  Forkworks
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301  USA
+ *
+ */
+
+#ifndef QCA_SIMD_H
+#define QCA_SIMD_H
+
+// NOTE: this API is private to QCA
+
+// Code with SSSE3 versions of its inner loops is compiled in whenever the
+// compiler can target SSSE3 for a single function (QCA_TARGET_SSSE3), and
+// is used if have_ssse3() says the CPU supports it.  The same goes for the
+// carry-less multiply (QCA_TARGET_PCLMUL, have_pclmul()).  Defining
+// QCA_NO_SIMD leaves it all out.
+
+#if !defined(QCA_NO_SIMD) && (defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86))
+# if defined(_MSC_VER)
+#  define QCA_HAVE_SSSE3
+#  define QCA_TARGET_SSSE3
+#  define QCA_HAVE_PCLMUL
+#  define QCA_TARGET_PCLMUL
+#  include <intrin.h>
+# elif defined(__clang__) || (defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9)))
+#  define QCA_HAVE_SSSE3
+#  define QCA_TARGET_SSSE3 __attribute__((target("ssse3")))
+#  define QCA_HAVE_PCLMUL
+#  define QCA_TARGET_PCLMUL __attribute__((target("pclmul")))
+#  include <cpuid.h>
+# endif
+#endif
+
+#ifdef QCA_HAVE_SSSE3
+# include <tmmintrin.h>
+#endif
+
+#ifdef QCA_HAVE_PCLMUL
+# include <wmmintrin.h>
+#endif
+
+namespace QCA {
+
+#ifdef QCA_HAVE_SSSE3
+
+inline bool detect_ssse3()
+{
+#ifdef _MSC_VER
+	int info[4];
+	__cpuid(info, 1);
+	return (info[2] & (1 << 9)) != 0;
+#else
+	unsigned int a, b, c, d;
+	if(!__get_cpuid(1, &a, &b, &c, &d))
+		return false;
+	return (c & bit_SSSE3) != 0;
+#endif
+}
+
+// the CPU is asked once, whichever file asks first
+inline bool have_ssse3()
+{
+	static const bool ssse3 = detect_ssse3();
+	return ssse3;
+}
+
+#endif
+
+#ifdef QCA_HAVE_PCLMUL
+
+inline bool detect_pclmul()
+{
+#ifdef _MSC_VER
+	int info[4];
+	__cpuid(info, 1);
+	return (info[2] & (1 << 1)) != 0;
+#else
+	unsigned int a, b, c, d;
+	if(!__get_cpuid(1, &a, &b, &c, &d))
+		return false;
+	return (c & bit_PCLMUL) != 0;
+#endif
+}
+
+inline bool have_pclmul()
+{
+	static const bool pclmul = detect_pclmul();
+	return pclmul;
+}
+
+#endif
+
+}
+
+#endif
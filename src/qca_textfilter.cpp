@@ -21,6 +21,8 @@
 
 #include "qca_textfilter.h"
 
+#include "qca_simd.h"
+
 namespace QCA {
 
 //----------------------------------------------------------------------------
@@ -78,26 +80,124 @@ QString TextFilter::decodeString(const QString &s)
 //----------------------------------------------------------------------------
 // Hex
 //----------------------------------------------------------------------------
-static int enhex(uchar c)
+static const char hex_digits[] = "0123456789abcdef";
+
+// -1 specifies invalid
+static const signed char hex_values[256] =
 {
-	if(c < 10)
-		return c + '0';
-	else if(c < 16)
-		return c - 10 + 'a';
-	else
-		return -1;
+	-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+	-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+	-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+	 0, 1, 2, 3, 4, 5, 6, 7, 8, 9,-1,-1,-1,-1,-1,-1,
+	-1,10,11,12,13,14,15,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+	-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+	-1,10,11,12,13,14,15,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+	-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+	-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+	-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+	-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+	-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+	-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+	-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+	-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+	-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+};
+
+#ifdef QCA_HAVE_SSSE3
+
+// returns the number of bytes encoded, a multiple of 16
+QCA_TARGET_SSSE3 static int hex_encode_ssse3(const uchar *in, int len, char *out)
+{
+	const __m128i digits = _mm_loadu_si128((const __m128i *)hex_digits);
+	const __m128i mask = _mm_set1_epi8(0x0f);
+
+	int n = 0;
+	for(; n + 16 <= len; n += 16)
+	{
+		__m128i v = _mm_loadu_si128((const __m128i *)(in + n));
+		__m128i hi = _mm_shuffle_epi8(digits, _mm_and_si128(_mm_srli_epi16(v, 4), mask));
+		__m128i lo = _mm_shuffle_epi8(digits, _mm_and_si128(v, mask));
+		_mm_storeu_si128((__m128i *)(out + n * 2), _mm_unpacklo_epi8(hi, lo));
+		_mm_storeu_si128((__m128i *)(out + n * 2 + 16), _mm_unpackhi_epi8(hi, lo));
+	}
+	return n;
 }
 
-static int dehex(char c)
+// converts 16 hex digits to their values.  returns false if any is invalid.
+QCA_TARGET_SSSE3 static inline bool hex_values_ssse3(__m128i v, __m128i *values)
 {
-	if(c >= 'a' && c <= 'f')
-		return c - 'a' + 10;
-	else if(c >= 'A' && c <= 'F')
-		return c - 'A' + 10;
-	else if(c >= '0' && c <= '9')
-		return c - '0';
-	else
-		return -1;
+	// digits are 0-9 after subtracting '0', letters are 0-5 after
+	//   folding case and subtracting 'a'
+	__m128i d = _mm_sub_epi8(v, _mm_set1_epi8('0'));
+	__m128i l = _mm_sub_epi8(_mm_or_si128(v, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+	__m128i isDigit = _mm_cmpeq_epi8(_mm_min_epu8(d, _mm_set1_epi8(9)), d);
+	__m128i isLetter = _mm_cmpeq_epi8(_mm_min_epu8(l, _mm_set1_epi8(5)), l);
+	if(_mm_movemask_epi8(_mm_or_si128(isDigit, isLetter)) != 0xffff)
+		return false;
+
+	*values = _mm_or_si128(_mm_and_si128(isDigit, d), _mm_and_si128(isLetter, _mm_add_epi8(l, _mm_set1_epi8(10))));
+	return true;
+}
+
+// returns the number of pairs decoded, a multiple of 16.  stops at the
+//   first block with an invalid digit.
+QCA_TARGET_SSSE3 static int hex_decode_ssse3(const char *in, int pairs, uchar *out)
+{
+	// the high digit of each pair times 16, plus the low digit
+	const __m128i weights = _mm_set1_epi16(0x0110);
+
+	int n = 0;
+	for(; n + 16 <= pairs; n += 16)
+	{
+		__m128i a, b;
+		if(!hex_values_ssse3(_mm_loadu_si128((const __m128i *)(in + n * 2)), &a) ||
+			!hex_values_ssse3(_mm_loadu_si128((const __m128i *)(in + n * 2 + 16)), &b))
+			break;
+		a = _mm_maddubs_epi16(a, weights);
+		b = _mm_maddubs_epi16(b, weights);
+		_mm_storeu_si128((__m128i *)(out + n), _mm_packus_epi16(a, b));
+	}
+	return n;
+}
+
+#endif
+
+static char *hex_encode(const uchar *in, int len, char *out)
+{
+	int n = 0;
+#ifdef QCA_HAVE_SSSE3
+	if(have_ssse3())
+	{
+		n = hex_encode_ssse3(in, len, out);
+		out += n * 2;
+	}
+#endif
+	for(; n < len; ++n)
+	{
+		*(out++) = hex_digits[in[n] >> 4];
+		*(out++) = hex_digits[in[n] & 0x0f];
+	}
+	return out;
+}
+
+// returns the number of pairs decoded, which is less than the number
+//   given if an invalid digit was found
+static int hex_decode(const char *in, int pairs, uchar *out)
+{
+	int n = 0;
+#ifdef QCA_HAVE_SSSE3
+	if(have_ssse3())
+		n = hex_decode_ssse3(in, pairs, out);
+#endif
+	for(; n < pairs; ++n)
+	{
+		int hi = hex_values[(uchar)in[n * 2]];
+		int lo = hex_values[(uchar)in[n * 2 + 1]];
+		if(hi < 0 || lo < 0)
+			break;
+		out[n] = (uchar)((hi << 4) | lo);
+	}
+	return n;
 }
 
 Hex::Hex(Direction dir)
@@ -114,77 +214,56 @@ void Hex::clear()
 
 MemoryRegion Hex::update(const MemoryRegion &m)
 {
-	QByteArray a = m.toByteArray();
+	// nothing more is returned after a failure
+	if(!_ok)
+		return MemoryRegion();
+
+	const char *in = m.constData();
+	int len = m.size();
 	if(_dir == Encode)
 	{
-		QByteArray out(a.size() * 2, 0);
+		QByteArray out;
+		out.resize(len * 2);
+		hex_encode((const uchar *)in, len, out.data());
+		return out;
+	}
+	else
+	{
+		QByteArray out;
+		out.resize((len + (partial ? 1 : 0)) / 2);
+		uchar *p = (uchar *)out.data();
+
 		int at = 0;
-		int c;
-		for(int n = 0; n < (int)a.size(); ++n)
+		if(partial && len > 0)
 		{
-			uchar lo = (uchar)a[n] & 0x0f;
-			uchar hi = (uchar)a[n] >> 4;
-			c = enhex(hi);
+			int c = hex_values[(uchar)in[0]];
 			if(c == -1)
 			{
 				_ok = false;
-				break;
+				return MemoryRegion();
 			}
-			out[at++] = (char)c;
-			c = enhex(lo);
-			if(c == -1)
-			{
-				_ok = false;
-				break;
-			}
-			out[at++] = (char)c;
+			*(p++) = (uchar)((val << 4) | c);
+			partial = false;
+			at = 1;
 		}
-		if(!_ok)
-			return MemoryRegion();
 
-		return out;
-	}
-	else
-	{
-		uchar lo = 0;
-		uchar hi = 0;
-		bool flag = false;
-		if(partial)
+		int pairs = (len - at) / 2;
+		if(hex_decode(in + at, pairs, p) != pairs)
 		{
-			hi = val;
-			flag = true;
+			_ok = false;
+			return MemoryRegion();
 		}
+		at += pairs * 2;
 
-		QByteArray out(a.size() / 2, 0);
-		int at = 0;
-		int c;
-		for(int n = 0; n < (int)a.size(); ++n)
+		if(at < len)
 		{
-			c = dehex((char)a[n]);
+			int c = hex_values[(uchar)in[at]];
 			if(c == -1)
 			{
 				_ok = false;
-				break;
-			}
-			if(flag)
-			{
-				lo = (uchar)c;
-				uchar full = ((hi & 0x0f) << 4) + (lo & 0x0f);
-				out[at++] = full;
-				flag = false;
-			}
-			else
-			{
-				hi = (uchar)c;
-				flag = true;
+				return MemoryRegion();
 			}
-		}
-		if(!_ok)
-			return MemoryRegion();
-
-		if(flag)
-		{
-			val = hi;
+			val = (uchar)c;
 			partial = true;
 		}
 		return out;
@@ -211,6 +290,7 @@ Base64::Base64(Direction dir)
 {
 	_lb_enabled = false;
 	_lb_column = 76;
+	clear();
 }
 
 void Base64::clear()
@@ -243,249 +323,330 @@ void Base64::setLineBreaksColumn(int column)
 		_lb_column = 76;
 }
 
-static QByteArray b64encode(const QByteArray &s)
-{
-	int i;
-	int len = s.size();
-	static char tbl[] =
-		"ABCDEFGH"
-		"IJKLMNOP"
-		"QRSTUVWX"
-		"YZabcdef"
-		"ghijklmn"
-		"opqrstuv"
-		"wxyz0123"
-		"456789+/"
-		"=";
-	int a, b, c;
-
-	QByteArray p((len + 2) / 3 * 4, 0);
-	int at = 0;
-	for(i = 0; i < len; i += 3)
-	{
-		a = ((unsigned char)s[i] & 3) << 4;
-		if(i + 1 < len)
-		{
-			a += (unsigned char)s[i + 1] >> 4;
-			b = ((unsigned char)s[i + 1] & 0xf) << 2;
-			if(i + 2 < len)
-			{
-				b += (unsigned char)s[i + 2] >> 6;
-				c = (unsigned char)s[i + 2] & 0x3f;
-			}
-			else
-				c = 64;
-		}
-		else
-			b = c = 64;
-
-		p[at++] = tbl[(unsigned char)s[i] >> 2];
-		p[at++] = tbl[a];
-		p[at++] = tbl[b];
-		p[at++] = tbl[c];
-	}
-	return p;
+static const char b64_digits[] =
+	"ABCDEFGH"
+	"IJKLMNOP"
+	"QRSTUVWX"
+	"YZabcdef"
+	"ghijklmn"
+	"opqrstuv"
+	"wxyz0123"
+	"456789+/";
+
+// -1 specifies invalid
+// 64 specifies eof
+// everything else specifies data
+static const signed char b64_values[256] =
+{
+	-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+	-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+	-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,62,-1,-1,-1,63,
+	52,53,54,55,56,57,58,59,60,61,-1,-1,-1,64,-1,-1,
+	-1, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9,10,11,12,13,14,
+	15,16,17,18,19,20,21,22,23,24,25,-1,-1,-1,-1,-1,
+	-1,26,27,28,29,30,31,32,33,34,35,36,37,38,39,40,
+	41,42,43,44,45,46,47,48,49,50,51,-1,-1,-1,-1,-1,
+	-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+	-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+	-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+	-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+	-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+	-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+	-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+	-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+};
+
+// the number of characters, including line breaks, that encoding the
+//   given number of groups of three bytes produces
+static int b64_encoded_size(int groups, int col, int lfAt)
+{
+	int len = groups * 4;
+	if(lfAt > 0)
+		len += (len + col) / lfAt + 1;
+	return len;
 }
 
-static QByteArray b64decode(const QByteArray &s, bool *ok)
+// breaks the line every lfAt characters (never, if lfAt is 0).  p points
+//   to the len characters just written, and the return value past them.
+static inline char *wrap_line(char *p, int len, int *col, int lfAt)
 {
-	// -1 specifies invalid
-	// 64 specifies eof
-	// everything else specifies data
+	if(lfAt == 0)
+		return p + len;
 
-	static signed char tbl[] =
+	int c = *col;
+	while(c + len >= lfAt)
 	{
-		-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
-		-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
-		-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,62,-1,-1,-1,63,
-		52,53,54,55,56,57,58,59,60,61,-1,-1,-1,64,-1,-1,
-		-1, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9,10,11,12,13,14,
-		15,16,17,18,19,20,21,22,23,24,25,-1,-1,-1,-1,-1,
-		-1,26,27,28,29,30,31,32,33,34,35,36,37,38,39,40,
-		41,42,43,44,45,46,47,48,49,50,51,-1,-1,-1,-1,-1,
-		-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
-		-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
-		-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
-		-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
-		-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
-		-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
-		-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
-		-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
-	};
-
-	// return value
-	QByteArray p;
-	*ok = true;
-
-	// this should be a multiple of 4
-	int len = s.size();
-	if(len % 4)
-	{
-		*ok = false;
-		return p;
+		int first = qMax(lfAt - c, 0);
+		memmove(p + first + 1, p + first, len - first);
+		p[first] = '\n';
+		p += first + 1;
+		len -= first;
+		c = 0;
 	}
+	*col = c + len;
+	return p + len;
+}
 
-	p.resize(len / 4 * 3);
-
-	int i;
-	int at = 0;
+#ifdef QCA_HAVE_SSSE3
 
-	int a, b, c, d;
-	c = d = 0;
+// see http://0x80.pl/notesen/2016-01-12-sse-base64-encoding.html
 
-	for(i = 0; i < len; i += 4)
+// returns the number of groups encoded, a multiple of 4
+QCA_TARGET_SSSE3 static int b64_encode_ssse3(const uchar *in, int groups, char **out, int *col, int lfAt)
+{
+	const __m128i spread = _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1);
+	const __m128i shiftLUT = _mm_setr_epi8(
+		'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+		'0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+	char *p = *out;
+
+	// 16 bytes are loaded for every 12 used
+	int n = 0;
+	for(; (n + 4) * 3 + 4 <= groups * 3; n += 4)
 	{
-		a = tbl[(int)s[i]];
-		b = tbl[(int)s[i + 1]];
-		c = tbl[(int)s[i + 2]];
-		d = tbl[(int)s[i + 3]];
-		if((a == 64 || b == 64) || (a < 0 || b < 0 || c < 0 || d < 0))
-		{
-			p.resize(0);
-			*ok = false;
-			return p;
-		}
-		p[at++] = ((a & 0x3F) << 2) | ((b >> 4) & 0x03);
-		p[at++] = ((b & 0x0F) << 4) | ((c >> 2) & 0x0F);
-		p[at++] = ((c & 0x03) << 6) | ((d >> 0) & 0x3F);
-	}
+		__m128i v = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(in + n * 3)), spread);
 
-	if(c & 64)
-		p.resize(at - 2);
-	else if(d & 64)
-		p.resize(at - 1);
+		// split each 3 bytes into 4 sextets, one per byte
+		__m128i t0 = _mm_mulhi_epu16(_mm_and_si128(v, _mm_set1_epi32(0x0fc0fc00)), _mm_set1_epi32(0x04000040));
+		__m128i t1 = _mm_mullo_epi16(_mm_and_si128(v, _mm_set1_epi32(0x003f03f0)), _mm_set1_epi32(0x01000010));
+		__m128i sextets = _mm_or_si128(t0, t1);
 
-	return p;
-}
+		// map each range of the alphabet to its offset in the LUT
+		__m128i index = _mm_subs_epu8(sextets, _mm_set1_epi8(51));
+		__m128i less = _mm_cmpgt_epi8(_mm_set1_epi8(26), sextets);
+		index = _mm_or_si128(index, _mm_and_si128(less, _mm_set1_epi8(13)));
+		__m128i chars = _mm_add_epi8(sextets, _mm_shuffle_epi8(shiftLUT, index));
 
-static int findLF(const QByteArray &in, int offset)
-{
-	for(int n = offset; n < in.size(); ++n)
-	{
-		if(in[n] == '\n')
-			return n;
+		_mm_storeu_si128((__m128i *)p, chars);
+		p = wrap_line(p, 16, col, lfAt);
 	}
-	return -1;
+
+	*out = p;
+	return n;
 }
 
-static QByteArray insert_linebreaks(const QByteArray &s, int *col, int lfAt)
-{
-	QByteArray out = s;
+// see http://0x80.pl/notesen/2016-01-17-sse-base64-decoding.html
 
-	int needed = (out.size() + *col) / lfAt;   // how many newlines needed?
-	if(needed > 0)
+// returns the number of characters decoded, a multiple of 16.  stops at
+//   the first block with anything but the 64 data characters in it, and
+//   sets *stop to the position of the first such character.
+QCA_TARGET_SSSE3 static int b64_decode_ssse3(const char *in, int len, uchar *out, int *stop)
+{
+	const __m128i shiftLUT = _mm_setr_epi8(0, 0, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+	const __m128i maskLUT = _mm_setr_epi8(
+		(char)0xa8, (char)0xf8, (char)0xf8, (char)0xf8, (char)0xf8, (char)0xf8, (char)0xf8, (char)0xf8,
+		(char)0xf8, (char)0xf8, (char)0xf0, 0x54, 0x50, 0x50, 0x50, 0x54);
+	const __m128i bitLUT = _mm_setr_epi8(0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, (char)0x80, 0, 0, 0, 0, 0, 0, 0, 0);
+	const __m128i pack = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+	const __m128i mask = _mm_set1_epi8(0x0f);
+
+	int n = 0;
+	for(; n + 16 <= len; n += 16)
 	{
-		int firstlen = lfAt - *col;                // length of first chunk
-		int at = firstlen + (lfAt * (needed - 1)); // position of last newline
-		int lastlen = out.size() - at;             // length of last chunk
-
-		//printf("size=%d,needed=%d,firstlen=%d,at=%d,lastlen=%d\n", out.size(), needed, firstlen, at, lastlen);
-
-		// make room
-		out.resize(out.size() + needed);
-
-		// move backwards
-		for(int n = 0; n < needed; ++n)
+		__m128i v = _mm_loadu_si128((const __m128i *)(in + n));
+		__m128i hi = _mm_and_si128(_mm_srli_epi32(v, 4), mask);
+		__m128i lo = _mm_and_si128(v, mask);
+
+		// the valid high nibbles for each low nibble
+		__m128i valid = _mm_and_si128(_mm_shuffle_epi8(maskLUT, lo), _mm_shuffle_epi8(bitLUT, hi));
+		int bad = _mm_movemask_epi8(_mm_cmpeq_epi8(valid, _mm_setzero_si128()));
+		if(bad)
 		{
-			char *p = out.data() + at;
-			int len;
-			if(n == 0)
-				len = lastlen;
-			else
-				len = lfAt;
-			memmove(p + needed - n, p, len);
-			p[needed - n - 1] = '\n';
-			at -= lfAt;
+			int at = 0;
+			while(!(bad & (1 << at)))
+				++at;
+			*stop = n + at;
+			break;
 		}
 
-		*col = lastlen;
-	}
-	else
-		*col += out.size();
+		// '/' shares its high nibble with '+'
+		__m128i shift = _mm_shuffle_epi8(shiftLUT, hi);
+		shift = _mm_add_epi8(shift, _mm_and_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('/')), _mm_set1_epi8(-3)));
+		__m128i sextets = _mm_add_epi8(v, shift);
 
-	return out;
+		// join the sextets into 12 bytes.  the store is 16 bytes wide.
+		__m128i pairs = _mm_maddubs_epi16(sextets, _mm_set1_epi32(0x01400140));
+		__m128i bytes = _mm_madd_epi16(pairs, _mm_set1_epi32(0x00011000));
+		_mm_storeu_si128((__m128i *)(out + n / 4 * 3), _mm_shuffle_epi8(bytes, pack));
+	}
+	return n;
 }
 
-static QByteArray remove_linebreaks(const QByteArray &s)
-{
-	QByteArray out = s;
+#endif
 
-	int removed = 0;
-	int at = findLF(out, 0);
-	while(at != -1)
+// encodes whole groups of three bytes
+static char *b64_encode(const uchar *in, int groups, char *out, int *col, int lfAt)
+{
+	int n = 0;
+#ifdef QCA_HAVE_SSSE3
+	if(have_ssse3())
+		n = b64_encode_ssse3(in, groups, &out, col, lfAt);
+#endif
+	for(; n < groups; ++n)
 	{
-		int next = findLF(out, at + 1);
-		int len;
-		if(next != -1)
-			len = next - at;
-		else
-			len = out.size() - at;
-
-		if(len > 1)
-		{
-			char *p = out.data() + at;
-			memmove(p - removed, p + 1, len - 1);
-		}
-		++removed;
-		at = next;
+		const uchar *s = in + n * 3;
+		out[0] = b64_digits[s[0] >> 2];
+		out[1] = b64_digits[((s[0] & 0x03) << 4) | (s[1] >> 4)];
+		out[2] = b64_digits[((s[1] & 0x0f) << 2) | (s[2] >> 6)];
+		out[3] = b64_digits[s[2] & 0x3f];
+		out = wrap_line(out, 4, col, lfAt);
 	}
-	out.resize(out.size() - removed);
-
 	return out;
 }
 
-static void appendArray(QByteArray *a, const QByteArray &b)
+// encodes the last one or two bytes, with padding
+static char *b64_encode_tail(const uchar *in, int len, char *out, int *col, int lfAt)
 {
-	a->append(b);
+	out[0] = b64_digits[in[0] >> 2];
+	if(len == 2)
+	{
+		out[1] = b64_digits[((in[0] & 0x03) << 4) | (in[1] >> 4)];
+		out[2] = b64_digits[(in[1] & 0x0f) << 2];
+	}
+	else
+	{
+		out[1] = b64_digits[(in[0] & 0x03) << 4];
+		out[2] = '=';
+	}
+	out[3] = '=';
+	return wrap_line(out, 4, col, lfAt);
 }
 
-MemoryRegion Base64::update(const MemoryRegion &m)
+// decodes a group of four characters.  returns the number of padding
+//   characters, or -1 if the group is invalid.
+static inline int b64_decode_group(const char *in, uchar *out)
 {
-	QByteArray in;
-	if(_dir == Decode && _lb_enabled)
-		in = remove_linebreaks(m.toByteArray());
+	int a = b64_values[(uchar)in[0]];
+	int b = b64_values[(uchar)in[1]];
+	int c = b64_values[(uchar)in[2]];
+	int d = b64_values[(uchar)in[3]];
+	if((a == 64 || b == 64) || (a < 0 || b < 0 || c < 0 || d < 0))
+		return -1;
+
+	// padding is only trimmed off of the last group, so here it is
+	//   decoded as zero bits
+	out[0] = (uchar)(((a & 0x3F) << 2) | ((b >> 4) & 0x03));
+	out[1] = (uchar)(((b & 0x0F) << 4) | ((c >> 2) & 0x0F));
+	out[2] = (uchar)(((c & 0x03) << 6) | ((d >> 0) & 0x3F));
+
+	if(c & 64)
+		return 2;
+	else if(d & 64)
+		return 1;
 	else
-		in = m.toByteArray();
+		return 0;
+}
 
-	if(in.isEmpty())
+MemoryRegion Base64::update(const MemoryRegion &m)
+{
+	const char *in = m.constData();
+	int len = m.size();
+	if(len == 0)
 		return MemoryRegion();
 
-	int chunk;
 	if(_dir == Encode)
-		chunk = 3;
-	else
-		chunk = 4;
-
-	int size = partial.size() + in.size();
-	if(size < chunk)
 	{
-		appendArray(&partial, in);
-		return MemoryRegion();
-	}
+		const uchar *data = (const uchar *)in;
+		int size = partial.size() + len;
+		if(size < 3)
+		{
+			partial.append(in, len);
+			return MemoryRegion();
+		}
 
-	int eat = size % chunk;
+		int lfAt = _lb_enabled ? _lb_column : 0;
+		QByteArray out;
+		out.resize(b64_encoded_size(size / 3, col, lfAt));
+		char *p = out.data();
 
-	// s = partial + a - eat
-	QByteArray s(partial.size() + in.size() - eat, 0);
-	memcpy(s.data(), partial.data(), partial.size());
-	memcpy(s.data() + partial.size(), in.data(), in.size() - eat);
+		// complete the group started by the last call
+		int at = 0;
+		if(!partial.isEmpty())
+		{
+			uchar group[3];
+			at = 3 - partial.size();
+			memcpy(group, partial.constData(), partial.size());
+			memcpy(group + partial.size(), data, at);
+			p = b64_encode(group, 1, p, &col, lfAt);
+		}
 
-	partial.resize(eat);
-	memcpy(partial.data(), in.data() + in.size() - eat, eat);
+		int groups = (len - at) / 3;
+		p = b64_encode(data + at, groups, p, &col, lfAt);
+		at += groups * 3;
 
-	if(_dir == Encode)
-	{
-		if(_lb_enabled)
-			return insert_linebreaks(b64encode(s), &col, _lb_column);
-		else
-			return b64encode(s);
+		partial = QByteArray(in + at, len - at);
+		out.resize(p - out.data());
+		return out;
 	}
 	else
 	{
-		bool ok;
-		QByteArray out = b64decode(s, &ok);
-		if(!ok)
+		// line breaks are skipped as the groups are collected.  the
+		//   vector loop is only used between them.
+		bool skipLF = _lb_enabled;
+		char group[4];
+		int count = partial.size();
+		memcpy(group, partial.constData(), count);
+
+		// room for the 16 byte stores of the vector loop
+		QByteArray out;
+		out.resize((count + len) / 4 * 3 + 16);
+		uchar *start = (uchar *)out.data();
+		uchar *p = start;
+
+		bool bad = false;
+		int pad = 0;
+		int at = 0;
+#ifdef QCA_HAVE_SSSE3
+		bool vector = have_ssse3();
+		int vectorFrom = 0;
+#endif
+		while(at < len)
+		{
+#ifdef QCA_HAVE_SSSE3
+			if(vector && count == 0 && at >= vectorFrom && len - at >= 16)
+			{
+				int stop = len;
+				int n = b64_decode_ssse3(in + at, len - at, p, &stop);
+				if(n > 0)
+				{
+					p += n / 4 * 3;
+					pad = 0;
+				}
+				vectorFrom = at + stop + 1;
+				at += n;
+				if(at == len)
+					break;
+			}
+#endif
+			char c = in[at++];
+			if(skipLF && c == '\n')
+				continue;
+
+			group[count++] = c;
+			if(count == 4)
+			{
+				pad = b64_decode_group(group, p);
+				if(pad == -1)
+				{
+					// keep going, so that the partial group is right
+					bad = true;
+					pad = 0;
+				}
+				p += 3;
+				count = 0;
+			}
+		}
+
+		partial = QByteArray(group, count);
+		if(bad)
+		{
 			_ok = false;
+			return QByteArray();
+		}
+		if(p == start)
+			return MemoryRegion();
+
+		out.resize(p - start - pad);
 		return out;
 	}
 }
@@ -494,18 +655,22 @@ MemoryRegion Base64::final()
 {
 	if(_dir == Encode)
 	{
-		if(_lb_enabled)
-			return insert_linebreaks(b64encode(partial), &col, _lb_column);
-		else
-			return b64encode(partial);
+		if(partial.isEmpty())
+			return MemoryRegion();
+
+		int lfAt = _lb_enabled ? _lb_column : 0;
+		QByteArray out;
+		out.resize(b64_encoded_size(1, col, lfAt));
+		char *p = b64_encode_tail((const uchar *)partial.constData(), partial.size(), out.data(), &col, lfAt);
+		out.resize(p - out.data());
+		return out;
 	}
 	else
 	{
-		bool ok;
-		QByteArray out = b64decode(partial, &ok);
-		if(!ok)
+		// a group was left incomplete
+		if(!partial.isEmpty())
 			_ok = false;
-		return out;
+		return MemoryRegion();
 	}
 }
 
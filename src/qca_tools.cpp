@@ -23,8 +23,14 @@
 
 #include "qdebug.h"
 
+#include <QAtomicInt>
+#include <QMutex>
+#include <QThreadStorage>
+
+#include <new>
+#include <stdlib.h>
+
 #ifdef Q_OS_UNIX
-# include <stdlib.h>
 # include <sys/mman.h>
 #endif
 #include "botantools/botantools.h"
@@ -60,6 +66,8 @@ static bool can_lock()
 
 static Botan::Allocator *alloc = 0;
 
+static void arena_deinit();
+
 void botan_throw_abort()
 {
 	fprintf(stderr, "QCA: Exception from internal Botan\n");
@@ -107,6 +115,7 @@ void botan_deinit()
 {
 	try
 	{
+		arena_deinit();
 		alloc = 0;
 		Botan::set_global_state(0);
 	}
@@ -116,6 +125,15 @@ void botan_deinit()
 	}
 }
 
+// zero memory in a way the compiler can't leave out, even when the
+//   memory is freed right after
+static void secure_wipe(void *p, int bytes)
+{
+	volatile char *v = (volatile char *)p;
+	for(int n = 0; n < bytes; ++n)
+		v[n] = 0;
+}
+
 void *botan_secure_alloc(int bytes)
 {
 	try
@@ -141,12 +159,554 @@ void botan_secure_free(void *p, int bytes)
 	}
 }
 
+//----------------------------------------------------------------------------
+// SecureArena
+//----------------------------------------------------------------------------
+// Small secure allocations are served from per-thread arenas, so that
+// threads don't all serialize on the single mutex of the Botan pool.  An
+// arena takes whole slabs from the pool and carves each one into chunks
+// of a single size class.  The owning thread allocates and frees without
+// any locking.  A chunk freed by another thread is wiped and kept in that
+// thread's outbox, and the outbox is handed back to the owners in batches.
+//
+// Chunks are wiped when freed and slabs when carved, so memory handed out
+// is always zero'd.
+
+#define ARENA_CLASSES 6
+#define ARENA_SLAB_SIZE 4096
+#define ARENA_BATCH 32
+
+static const int arena_class_size[ARENA_CLASSES] = { 16, 32, 64, 128, 256, 512 };
+
+class SecureArena;
+
+// called by the owner after carving a new slab
+static void arena_grew();
+
+// precedes the data of each chunk.  while a chunk is free, its data holds
+//   the free list link.
+struct ArenaChunk
+{
+	SecureArena *owner;
+	int sizeClass;
+};
+
+// keeps the data 16-byte aligned
+static const int arena_header_size = (sizeof(ArenaChunk) + 15) & ~15;
+
+static inline ArenaChunk *&chunk_next(ArenaChunk *c)
+{
+	return *(ArenaChunk **)((char *)c + arena_header_size);
+}
+
+static int arena_class(int bytes)
+{
+	for(int n = 0; n < ARENA_CLASSES; ++n)
+	{
+		if(bytes <= arena_class_size[n])
+			return n;
+	}
+	return -1;
+}
+
+class SecureArena
+{
+public:
+	// owner only
+	ArenaChunk *freeList[ARENA_CLASSES];
+	int outstanding; // chunks not on any list of ours
+	QList<void*> slabs;
+	ArenaChunk *outbox[ARENA_BATCH]; // other arenas' chunks
+	int outboxCount;
+
+	// chunks given back by other threads
+	QMutex m;
+	ArenaChunk *remote;
+	int remoteCount;
+	bool orphaned;
+
+	// statistics, in bytes handed out and allocation count
+	QAtomicInt used;
+	QAtomicInt allocations;
+
+	SecureArena()
+	{
+		for(int n = 0; n < ARENA_CLASSES; ++n)
+			freeList[n] = 0;
+		outstanding = 0;
+		outboxCount = 0;
+		remote = 0;
+		remoteCount = 0;
+		orphaned = false;
+	}
+
+	void *alloc(int c)
+	{
+		if(!freeList[c])
+			collect();
+		if(!freeList[c])
+			carve(c);
+
+		ArenaChunk *h = freeList[c];
+		freeList[c] = chunk_next(h);
+		chunk_next(h) = 0;
+		++outstanding;
+		used.fetchAndAddRelaxed(arena_class_size[c]);
+		allocations.fetchAndAddRelaxed(1);
+		return (char *)h + arena_header_size;
+	}
+
+	// h: wiped chunk of this arena
+	void release(ArenaChunk *h)
+	{
+		chunk_next(h) = freeList[h->sizeClass];
+		freeList[h->sizeClass] = h;
+		--outstanding;
+		used.fetchAndAddRelaxed(-arena_class_size[h->sizeClass]);
+	}
+
+	// h: wiped chunk of another arena
+	void post(ArenaChunk *h)
+	{
+		h->owner->used.fetchAndAddRelaxed(-arena_class_size[h->sizeClass]);
+		outbox[outboxCount++] = h;
+		if(outboxCount == ARENA_BATCH)
+			flush();
+	}
+
+	void flush()
+	{
+		// one hand-over per owner
+		while(outboxCount > 0)
+		{
+			SecureArena *owner = outbox[0]->owner;
+			ArenaChunk *list = 0;
+			int count = 0;
+			int kept = 0;
+			for(int n = 0; n < outboxCount; ++n)
+			{
+				ArenaChunk *h = outbox[n];
+				if(h->owner == owner)
+				{
+					chunk_next(h) = list;
+					list = h;
+					++count;
+				}
+				else
+					outbox[kept++] = h;
+			}
+			outboxCount = kept;
+			owner->giveBack(list, count);
+		}
+	}
+
+	// called by other threads
+	void giveBack(ArenaChunk *list, int count)
+	{
+		m.lock();
+		if(orphaned)
+		{
+			// our thread is gone, so nobody will allocate these again
+			outstanding -= count;
+			bool done = (outstanding == 0);
+			m.unlock();
+			if(done)
+				destroy();
+			return;
+		}
+
+		ArenaChunk *last = list;
+		while(chunk_next(last))
+			last = chunk_next(last);
+		chunk_next(last) = remote;
+		remote = list;
+		remoteCount += count;
+		m.unlock();
+	}
+
+	// called by the owner when its thread exits
+	void detach()
+	{
+		flush();
+
+		m.lock();
+		outstanding -= remoteCount;
+		remote = 0;
+		remoteCount = 0;
+		bool done = (outstanding == 0);
+		if(!done)
+			orphaned = true;
+		m.unlock();
+
+		// otherwise the last giveBack() finishes up
+		if(done)
+			destroy();
+	}
+
+	void destroy();
+
+	// frees the slabs, without touching the registry
+	void freeSlabs()
+	{
+		for(int n = 0; n < slabs.count(); ++n)
+			botan_secure_free(slabs[n], ARENA_SLAB_SIZE);
+		slabs.clear();
+	}
+
+private:
+	void collect()
+	{
+		m.lock();
+		ArenaChunk *list = remote;
+		int count = remoteCount;
+		remote = 0;
+		remoteCount = 0;
+		m.unlock();
+
+		while(list)
+		{
+			ArenaChunk *h = list;
+			list = chunk_next(h);
+			chunk_next(h) = freeList[h->sizeClass];
+			freeList[h->sizeClass] = h;
+		}
+		outstanding -= count;
+	}
+
+	void carve(int c)
+	{
+		char *slab = (char *)botan_secure_alloc(ARENA_SLAB_SIZE);
+		memset(slab, 0, ARENA_SLAB_SIZE);
+		slabs += slab;
+
+		int stride = arena_header_size + arena_class_size[c];
+		for(int at = 0; at + stride <= ARENA_SLAB_SIZE; at += stride)
+		{
+			ArenaChunk *h = (ArenaChunk *)(slab + at);
+			h->owner = this;
+			h->sizeClass = c;
+			chunk_next(h) = freeList[c];
+			freeList[c] = h;
+		}
+
+		arena_grew();
+	}
+};
+
+// arenas are registered so that deinit can reclaim the slabs of threads
+//   that are still running.  the generation changes with every deinit.
+static QMutex *arena_mutex()
+{
+	static QMutex m;
+	return &m;
+}
+
+static QList<SecureArena*> *g_arenas = 0;
+static int arena_gen = 0;
+
+// bytes taken from the pool, and the peak of the bytes handed out.  the
+//   peak is only sampled when an arena grows, which is when it matters.
+static qint64 arena_slab_bytes = 0;
+static qint64 arena_peak_used = 0;
+static qint64 arena_retired_allocations = 0;
+
+// call with arena_mutex locked
+static qint64 arena_used()
+{
+	qint64 total = 0;
+	for(int n = 0; g_arenas && n < g_arenas->count(); ++n)
+		total += (*g_arenas)[n]->used.fetchAndAddRelaxed(0);
+	return total;
+}
+
+void arena_grew()
+{
+	QMutexLocker locker(arena_mutex());
+	arena_slab_bytes += ARENA_SLAB_SIZE;
+	arena_peak_used = qMax(arena_peak_used, arena_used());
+}
+
+void SecureArena::destroy()
+{
+	arena_mutex()->lock();
+	bool live = g_arenas && g_arenas->removeOne(this);
+	if(live)
+	{
+		arena_slab_bytes -= (qint64)slabs.count() * ARENA_SLAB_SIZE;
+		arena_retired_allocations += allocations.fetchAndAddRelaxed(0);
+	}
+	arena_mutex()->unlock();
+
+	if(live)
+	{
+		freeSlabs();
+		delete this;
+	}
+}
+
+class ArenaHandle
+{
+public:
+	SecureArena *arena;
+	int gen;
+
+	ArenaHandle(SecureArena *_arena, int _gen) : arena(_arena), gen(_gen)
+	{
+	}
+
+	~ArenaHandle()
+	{
+		arena_mutex()->lock();
+		bool live = (gen == arena_gen);
+		arena_mutex()->unlock();
+
+		if(live)
+			arena->detach();
+	}
+};
+
+static QThreadStorage<ArenaHandle*> *arena_storage()
+{
+	static QThreadStorage<ArenaHandle*> storage;
+	return &storage;
+}
+
+static SecureArena *current_arena(bool create)
+{
+	QThreadStorage<ArenaHandle*> *storage = arena_storage();
+	ArenaHandle *h = storage->hasLocalData() ? storage->localData() : 0;
+
+	// the generation only changes in deinit, when no other thread may be
+	//   using secure memory
+	if(h && h->gen == arena_gen)
+		return h->arena;
+	if(!create)
+		return 0;
+
+	SecureArena *a = new SecureArena;
+	arena_mutex()->lock();
+	if(!g_arenas)
+		g_arenas = new QList<SecureArena*>;
+	*g_arenas += a;
+	h = new ArenaHandle(a, arena_gen);
+	arena_mutex()->unlock();
+
+	// deletes any stale handle
+	storage->setLocalData(h);
+	return a;
+}
+
+// memory is zero'd
+static void *secure_alloc(int bytes)
+{
+	int c = arena_class(bytes);
+	if(c == -1)
+	{
+		void *p = botan_secure_alloc(bytes);
+		memset(p, 0, bytes);
+		return p;
+	}
+
+	return current_arena(true)->alloc(c);
+}
+
+// bytes: the size given to secure_alloc()
+static void secure_free(void *p, int bytes)
+{
+	int c = arena_class(bytes);
+	if(c == -1)
+	{
+		secure_wipe(p, bytes);
+		botan_secure_free(p, bytes);
+		return;
+	}
+
+	secure_wipe(p, arena_class_size[c]);
+	ArenaChunk *h = (ArenaChunk *)((char *)p - arena_header_size);
+	SecureArena *self = current_arena(false);
+	if(h->owner == self)
+		self->release(h);
+	else if(self)
+		self->post(h);
+	else
+	{
+		chunk_next(h) = 0;
+		h->owner->used.fetchAndAddRelaxed(-arena_class_size[c]);
+		h->owner->giveBack(h, 1);
+	}
+}
+
+static void arena_deinit()
+{
+	QMutexLocker locker(arena_mutex());
+	if(g_arenas)
+	{
+		for(int n = 0; n < g_arenas->count(); ++n)
+		{
+			(*g_arenas)[n]->freeSlabs();
+			delete (*g_arenas)[n];
+		}
+		delete g_arenas;
+		g_arenas = 0;
+	}
+	arena_slab_bytes = 0;
+	arena_peak_used = 0;
+	arena_retired_allocations = 0;
+	++arena_gen;
+}
+
+//----------------------------------------------------------------------------
+// SecureMemoryStatistics
+//----------------------------------------------------------------------------
+class SecureMemoryStatistics::Private : public QSharedData
+{
+public:
+	QString name;
+	int poolSize, inUse, peakInUse;
+	qint64 allocations;
+	int fallbacks, freeRuns, largestFreeRun;
+
+	Private()
+	{
+		poolSize = 0;
+		inUse = 0;
+		peakInUse = 0;
+		allocations = 0;
+		fallbacks = 0;
+		freeRuns = 0;
+		largestFreeRun = 0;
+	}
+};
+
+SecureMemoryStatistics::SecureMemoryStatistics()
+:d(new Private)
+{
+}
+
+SecureMemoryStatistics::SecureMemoryStatistics(const SecureMemoryStatistics &from)
+:d(from.d)
+{
+}
+
+SecureMemoryStatistics::~SecureMemoryStatistics()
+{
+}
+
+SecureMemoryStatistics & SecureMemoryStatistics::operator=(const SecureMemoryStatistics &from)
+{
+	d = from.d;
+	return *this;
+}
+
+QString SecureMemoryStatistics::name() const
+{
+	return d->name;
+}
+
+int SecureMemoryStatistics::poolSize() const
+{
+	return d->poolSize;
+}
+
+int SecureMemoryStatistics::inUse() const
+{
+	return d->inUse;
+}
+
+int SecureMemoryStatistics::peakInUse() const
+{
+	return d->peakInUse;
+}
+
+qint64 SecureMemoryStatistics::allocations() const
+{
+	return d->allocations;
+}
+
+int SecureMemoryStatistics::fallbacks() const
+{
+	return d->fallbacks;
+}
+
+int SecureMemoryStatistics::freeRuns() const
+{
+	return d->freeRuns;
+}
+
+int SecureMemoryStatistics::largestFreeRun() const
+{
+	return d->largestFreeRun;
+}
+
+QList<SecureMemoryStatistics> secureMemoryStatistics()
+{
+	QList<SecureMemoryStatistics> list;
+	if(!alloc)
+		return list;
+
+	SecureMemoryStatistics pool;
+	pool.d->name = QString::fromLatin1(alloc->type().c_str());
+	Botan::Pooling_Allocator *p = dynamic_cast<Botan::Pooling_Allocator*>(alloc);
+	if(p)
+	{
+		try
+		{
+			Botan::Pooling_Allocator::Stats s = p->stats();
+			pool.d->poolSize = s.pool_bytes + s.large_bytes;
+			pool.d->inUse = s.used_bytes;
+			pool.d->peakInUse = s.peak_used_bytes;
+			pool.d->allocations = s.allocations;
+			pool.d->fallbacks = s.lock_failures;
+			pool.d->freeRuns = s.free_runs;
+			pool.d->largestFreeRun = s.largest_free_run;
+		}
+		catch(std::exception &)
+		{
+			botan_throw_abort();
+		}
+	}
+	list += pool;
+
+	SecureMemoryStatistics arenas;
+	arenas.d->name = QString::fromLatin1("arena");
+	QMutexLocker locker(arena_mutex());
+	qint64 used = arena_used();
+	arena_peak_used = qMax(arena_peak_used, used);
+	qint64 count = arena_retired_allocations;
+	for(int n = 0; g_arenas && n < g_arenas->count(); ++n)
+		count += (*g_arenas)[n]->allocations.fetchAndAddRelaxed(0);
+	arenas.d->poolSize = (int)arena_slab_bytes;
+	arenas.d->inUse = (int)used;
+	arenas.d->peakInUse = (int)arena_peak_used;
+	arenas.d->allocations = count;
+	list += arenas;
+
+	return list;
+}
+
+bool growSecureMemory(int size)
+{
+	Botan::Pooling_Allocator *p = dynamic_cast<Botan::Pooling_Allocator*>(alloc);
+	if(!p || size <= 0)
+		return false;
+
+	try
+	{
+		p->reserve((Botan::u32bit)size * 1024);
+	}
+	catch(std::exception &)
+	{
+		return false;
+	}
+	return true;
+}
+
 } // end namespace QCA
 
 void *qca_secure_alloc(int bytes)
 {
 	// allocate enough room to store a size value in front, return a pointer after it
-	char *c = (char *)QCA::botan_secure_alloc(bytes + sizeof(int));
+	char *c = (char *)QCA::secure_alloc(bytes + sizeof(int));
 	((int *)c)[0] = bytes + sizeof(int);
 	return c + sizeof(int);
 }
@@ -157,7 +717,7 @@ void qca_secure_free(void *p)
 	char *c = (char *)p;
 	c -= sizeof(int);
 	int bytes = ((int *)c)[0];
-	QCA::botan_secure_free(c, bytes);
+	QCA::secure_free(c, bytes);
 }
 
 void *qca_secure_realloc(void *p, int bytes)
@@ -188,8 +748,13 @@ void *qca_secure_realloc(void *p, int bytes)
 
 namespace QCA {
 
+// secure data of up to this size is kept in the same arena chunk as the
+//   MemoryRegion::Private that owns it, see below
+#define AI_INLINE_SIZE 64
+
 // secure or non-secure buffer, with trailing 0-byte.
 // buffer size of 0 is okay (sbuf/qbuf will be 0).
+// secure storage grows geometrically, and is zero'd beyond size.
 struct alloc_info
 {
 	bool sec;
@@ -197,19 +762,21 @@ struct alloc_info
 	int size;
 
 	// internal
-	Botan::SecureVector<Botan::byte> *sbuf;
+	int capacity; // secure storage, 0 if there is none
+	char *sbuf; // from secure_alloc(), capacity + 1, or 0 if inline
 	QByteArray *qbuf;
+	char *ibuf; // inline room for AI_INLINE_SIZE + 1 bytes, or 0
 };
 
 // note: these functions don't return error if memory allocation/resizing
 //   fails..  maybe fix this someday?
 
-// ai: uninitialized
+// ai: uninitialized, except for ibuf
 // size: >= 0
 // note: memory will be initially zero'd out
 static bool ai_new(alloc_info *ai, int size, bool sec);
 
-// ai: uninitialized
+// ai: uninitialized, except for ibuf
 // from: initialized
 static bool ai_copy(alloc_info *ai, const alloc_info *from);
 
@@ -217,9 +784,68 @@ static bool ai_copy(alloc_info *ai, const alloc_info *from);
 // new_size: >= 0
 static bool ai_resize(alloc_info *ai, int new_size);
 
+// ai: initialized
+// size: >= 0
+static bool ai_reserve(alloc_info *ai, int size);
+
+// ai: initialized
+static void ai_squeeze(alloc_info *ai);
+
 // ai: initialized
 static void ai_delete(alloc_info *ai);
 
+// zero'd secure storage for at least size bytes plus the trailing 0-byte,
+//   inline if there is room
+// ai: sbuf/data/capacity not yet set
+static void ai_secure_new(alloc_info *ai, int size)
+{
+	if(ai->ibuf && size <= AI_INLINE_SIZE)
+	{
+		memset(ai->ibuf, 0, AI_INLINE_SIZE + 1);
+		ai->capacity = AI_INLINE_SIZE;
+		ai->sbuf = 0;
+		ai->data = ai->ibuf;
+		return;
+	}
+
+	ai->capacity = size;
+	ai->sbuf = (char *)secure_alloc(size + 1);
+	ai->data = ai->sbuf;
+}
+
+// frees the secure storage, which secure_free() wipes, or wipes the
+//   inline storage
+static void ai_secure_delete(alloc_info *ai)
+{
+	if(ai->sbuf)
+		secure_free(ai->sbuf, ai->capacity + 1);
+	else if(ai->capacity > 0)
+		secure_wipe(ai->ibuf, AI_INLINE_SIZE + 1);
+	ai->sbuf = 0;
+	ai->capacity = 0;
+}
+
+// moves the secure data to storage for at least size bytes.  the old
+//   storage is wiped.
+// size: >= ai->size
+static void ai_secure_realloc(alloc_info *ai, int size)
+{
+	// inline already, and it fits
+	if(ai->capacity > 0 && !ai->sbuf && size <= AI_INLINE_SIZE)
+		return;
+
+	alloc_info other;
+	other.ibuf = ai->ibuf;
+	ai_secure_new(&other, size);
+	if(ai->size > 0)
+		memcpy(other.data, ai->data, ai->size);
+	ai_secure_delete(ai);
+
+	ai->sbuf = other.sbuf;
+	ai->data = other.data;
+	ai->capacity = other.capacity;
+}
+
 bool ai_new(alloc_info *ai, int size, bool sec)
 {
 	if(size < 0)
@@ -227,6 +853,7 @@ bool ai_new(alloc_info *ai, int size, bool sec)
 
 	ai->size = size;
 	ai->sec = sec;
+	ai->capacity = 0;
 
 	if(size == 0)
 	{
@@ -238,20 +865,8 @@ bool ai_new(alloc_info *ai, int size, bool sec)
 
 	if(sec)
 	{
-		try
-		{
-			ai->sbuf = new Botan::SecureVector<Botan::byte>((Botan::u32bit)size + 1);
-		}
-		catch(std::exception &)
-		{
-			botan_throw_abort();
-			return false; // never get here
-		}
-
-		(*(ai->sbuf))[size] = 0;
+		ai_secure_new(ai, size);
 		ai->qbuf = 0;
-		Botan::byte *bp = (Botan::byte *)(*(ai->sbuf));
-		ai->data = (char *)bp;
 	}
 	else
 	{
@@ -267,6 +882,7 @@ bool ai_copy(alloc_info *ai, const alloc_info *from)
 {
 	ai->size = from->size;
 	ai->sec = from->sec;
+	ai->capacity = 0;
 
 	if(ai->size == 0)
 	{
@@ -278,24 +894,18 @@ bool ai_copy(alloc_info *ai, const alloc_info *from)
 
 	if(ai->sec)
 	{
-		try
-		{
-			ai->sbuf = new Botan::SecureVector<Botan::byte>(*(from->sbuf));
-		}
-		catch(std::exception &)
-		{
-			botan_throw_abort();
-			return false; // never get here
-		}
-
+		// the copy doesn't inherit any spare capacity
+		ai_secure_new(ai, ai->size);
+		memcpy(ai->data, from->data, ai->size);
 		ai->qbuf = 0;
-		Botan::byte *bp = (Botan::byte *)(*(ai->sbuf));
-		ai->data = (char *)bp;
 	}
 	else
 	{
 		ai->sbuf = 0;
-		ai->qbuf = new QByteArray(*(from->qbuf));
+		if(from->qbuf)
+			ai->qbuf = new QByteArray(*(from->qbuf));
+		else // a view
+			ai->qbuf = new QByteArray(from->data, from->size);
 		ai->data = ai->qbuf->data();
 	}
 
@@ -310,51 +920,38 @@ bool ai_resize(alloc_info *ai, int new_size)
 	// new size is empty
 	if(new_size == 0)
 	{
-		// we currently aren't empty
-		if(ai->size > 0)
+		if(ai->sec)
 		{
-			if(ai->sec)
-			{
-				delete ai->sbuf;
-				ai->sbuf = 0;
-			}
-			else
-			{
-				delete ai->qbuf;
-				ai->qbuf = 0;
-			}
-
-			ai->size = 0;
-			ai->data = 0;
+			ai_secure_delete(ai);
+		}
+		else if(ai->size > 0)
+		{
+			delete ai->qbuf;
+			ai->qbuf = 0;
 		}
 
+		ai->size = 0;
+		ai->data = 0;
 		return true;
 	}
 
 	if(ai->sec)
 	{
-		Botan::SecureVector<Botan::byte> *new_buf;
-		try
+		if(new_size > ai->capacity)
 		{
-			new_buf = new Botan::SecureVector<Botan::byte>((Botan::u32bit)new_size + 1);
+			// grow by half again, so that appending in a loop
+			//   isn't quadratic
+			int grown = ai->capacity + ai->capacity / 2;
+			ai_secure_realloc(ai, qMax(new_size, grown));
 		}
-		catch(std::exception &)
+		else if(new_size < ai->size)
 		{
-			botan_throw_abort();
-			return false; // never get here
+			// keep the storage, but wipe what was cut off
+			secure_wipe(ai->data + new_size, ai->size - new_size);
 		}
 
-		Botan::byte *new_p = (Botan::byte *)(*new_buf);
-		if(ai->size > 0)
-		{
-			const Botan::byte *old_p = (const Botan::byte *)(*(ai->sbuf));
-			memcpy(new_p, old_p, qMin(new_size, ai->size));
-			delete ai->sbuf;
-		}
-		ai->sbuf = new_buf;
+		// anything past the old size is already zero
 		ai->size = new_size;
-		(*(ai->sbuf))[new_size] = 0;
-		ai->data = (char *)new_p;
 	}
 	else
 	{
@@ -370,15 +967,50 @@ bool ai_resize(alloc_info *ai, int new_size)
 	return true;
 }
 
-void ai_delete(alloc_info *ai)
+bool ai_reserve(alloc_info *ai, int size)
 {
-	if(ai->size > 0)
+	if(size < 0)
+		return false;
+
+	if(ai->sec)
 	{
-		if(ai->sec)
-			delete ai->sbuf;
-		else
-			delete ai->qbuf;
+		if(size > ai->capacity)
+			ai_secure_realloc(ai, size);
 	}
+	else if(ai->qbuf)
+	{
+		ai->qbuf->reserve(size);
+		ai->data = ai->qbuf->data();
+	}
+
+	return true;
+}
+
+void ai_squeeze(alloc_info *ai)
+{
+	if(ai->sec)
+	{
+		if(ai->size == 0)
+		{
+			ai_secure_delete(ai);
+			ai->data = 0;
+		}
+		else if(ai->capacity > ai->size)
+			ai_secure_realloc(ai, ai->size);
+	}
+	else if(ai->qbuf)
+	{
+		ai->qbuf->squeeze();
+		ai->data = ai->qbuf->data();
+	}
+}
+
+void ai_delete(alloc_info *ai)
+{
+	if(ai->sec)
+		ai_secure_delete(ai);
+	else if(ai->size > 0)
+		delete ai->qbuf;
 }
 
 //----------------------------------------------------------------------------
@@ -386,37 +1018,131 @@ void ai_delete(alloc_info *ai)
 //----------------------------------------------------------------------------
 static char blank[] = "";
 
+// each Private is preceded by a header with the size of the arena chunk
+//   it is in, or 0 if it is on the heap
+static const int private_header_size = 16;
+
 class MemoryRegion::Private : public QSharedData
 {
 public:
 	alloc_info ai;
 
-	Private(int size, bool sec)
+	// a view refers to memory it doesn't own: part of another region,
+	//   which is kept alive by 'owner', or raw data given to MemoryView.
+	//   it gets storage of its own before it is changed.
+	bool view;
+	MemoryRegion owner;
+
+	// a secure region that starts out with up to AI_INLINE_SIZE bytes is
+	//   a single arena chunk: the Private, and after it the room for its
+	//   data.  it only needs more memory if it grows.  other regions are
+	//   on the heap, with their data allocated separately.  every Private
+	//   is made by one of these.
+	static Private *create(int size, bool sec)
 	{
+		return ::new(allocate(sec && size <= AI_INLINE_SIZE)) Private(size, sec);
+	}
+
+	static Private *create(const QByteArray &from, bool sec)
+	{
+		return ::new(allocate(sec && from.size() <= AI_INLINE_SIZE)) Private(from, sec);
+	}
+
+	static Private *create(const char *data, int size, bool sec, const MemoryRegion &_owner)
+	{
+		return ::new(allocate(false)) Private(data, size, sec, _owner);
+	}
+
+	// for detaching
+	static Private *create(const Private &from)
+	{
+		return ::new(allocate(from.ai.sec && from.ai.size <= AI_INLINE_SIZE)) Private(from);
+	}
+
+	static void operator delete(void *p)
+	{
+		char *base = (char *)p - private_header_size;
+		int bytes = *(int *)base;
+		if(bytes > 0)
+			secure_free(base, bytes);
+		else
+			free(base);
+	}
+
+	Private(int size, bool sec) : view(false)
+	{
+		ai.ibuf = inlineBuffer();
 		ai_new(&ai, size, sec);
 	}
 
-	Private(const QByteArray &from, bool sec)
+	Private(const QByteArray &from, bool sec) : view(false)
 	{
+		ai.ibuf = inlineBuffer();
 		ai_new(&ai, from.size(), sec);
 		memcpy(ai.data, from.data(), ai.size);
 	}
 
-	Private(const Private &from) : QSharedData(from)
+	Private(const char *data, int size, bool sec, const MemoryRegion &_owner) : view(true), owner(_owner)
 	{
+		ai.sec = sec;
+		ai.size = size;
+		ai.data = size > 0 ? const_cast<char *>(data) : 0;
+		ai.capacity = 0;
+		ai.sbuf = 0;
+		ai.qbuf = 0;
+		ai.ibuf = inlineBuffer();
+	}
+
+	Private(const Private &from) : QSharedData(from), view(false)
+	{
+		ai.ibuf = inlineBuffer();
 		ai_copy(&ai, &from.ai);
 	}
 
 	~Private()
 	{
-		ai_delete(&ai);
+		if(!view)
+			ai_delete(&ai);
+	}
+
+	void own()
+	{
+		if(!view)
+			return;
+
+		alloc_info other;
+		other.ibuf = ai.ibuf;
+		ai_copy(&other, &ai);
+		take(&other);
+		view = false;
+		owner = MemoryRegion();
 	}
 
 	bool resize(int new_size)
 	{
+		own();
 		return ai_resize(&ai, new_size);
 	}
 
+	bool reserve(int size)
+	{
+		own();
+		return ai_reserve(&ai, size);
+	}
+
+	void squeeze()
+	{
+		own();
+		ai_squeeze(&ai);
+	}
+
+	int capacity() const
+	{
+		if(ai.sec)
+			return ai.capacity;
+		return ai.qbuf ? ai.qbuf->capacity() : 0;
+	}
+
 	void setSecure(bool sec)
 	{
 		// if same mode, do nothing
@@ -424,25 +1150,84 @@ public:
 			return;
 
 		alloc_info other;
+		other.ibuf = ai.ibuf;
 		ai_new(&other, ai.size, sec);
 		memcpy(other.data, ai.data, ai.size);
-		ai_delete(&ai);
-		ai = other;
+		if(!view)
+			ai_delete(&ai);
+		take(&other);
+		view = false;
+		owner = MemoryRegion();
+	}
+
+private:
+	// the inline room is after the Private, 16-byte aligned
+	static int inline_offset()
+	{
+		return (int)((sizeof(Private) + 15) & ~(size_t)15);
+	}
+
+	static void *allocate(bool withData)
+	{
+		char *p;
+		if(withData)
+		{
+			int bytes = private_header_size + inline_offset() + AI_INLINE_SIZE + 1;
+			p = (char *)secure_alloc(bytes);
+			*(int *)p = bytes;
+		}
+		else
+		{
+			p = (char *)malloc(private_header_size + sizeof(Private));
+			Q_CHECK_PTR(p);
+			*(int *)p = 0;
+		}
+		return p + private_header_size;
+	}
+
+	// not allocated this way, see create()
+	static void *operator new(size_t size);
+
+	char *inlineBuffer()
+	{
+		char *base = (char *)this - private_header_size;
+		if(*(int *)base == 0)
+			return 0;
+		return (char *)this + inline_offset();
+	}
+
+	// the previous storage must have been released
+	void take(alloc_info *from)
+	{
+		ai = *from;
 	}
 };
 
+} // end namespace QCA
+
+// detaching makes a copy with create() too
+QT_BEGIN_NAMESPACE
+template<>
+QCA::MemoryRegion::Private *QSharedDataPointer<QCA::MemoryRegion::Private>::clone()
+{
+	return QCA::MemoryRegion::Private::create(*d);
+}
+QT_END_NAMESPACE
+
+namespace QCA {
+
 MemoryRegion::MemoryRegion()
 :_secure(false), d(0)
 {
 }
 
 MemoryRegion::MemoryRegion(const char *str)
-:_secure(false), d(new Private(QByteArray::fromRawData(str, strlen(str)), false))
+:_secure(false), d(Private::create(QByteArray::fromRawData(str, strlen(str)), false))
 {
 }
 
 MemoryRegion::MemoryRegion(const QByteArray &from)
-:_secure(false), d(new Private(from, false))
+:_secure(false), d(Private::create(from, false))
 {
 }
 
@@ -478,6 +1263,11 @@ bool MemoryRegion::isSecure() const
 	return _secure;
 }
 
+bool MemoryRegion::isView() const
+{
+	return d && d->view;
+}
+
 QByteArray MemoryRegion::toByteArray() const
 {
 	if(!d)
@@ -491,8 +1281,10 @@ QByteArray MemoryRegion::toByteArray() const
 	}
 	else
 	{
-		if(d->ai.size > 0)
+		if(d->ai.qbuf)
 			return *(d->ai.qbuf);
+		else if(d->ai.size > 0) // a view
+			return QByteArray(d->ai.data, d->ai.size);
 		else
 			return QByteArray((int)0, (char)0);
 	}
@@ -504,12 +1296,12 @@ MemoryRegion::MemoryRegion(bool secure)
 }
 
 MemoryRegion::MemoryRegion(int size, bool secure)
-:_secure(secure), d(new Private(size, secure))
+:_secure(secure), d(Private::create(size, secure))
 {
 }
 
 MemoryRegion::MemoryRegion(const QByteArray &from, bool secure)
-:_secure(secure), d(new Private(from, secure))
+:_secure(secure), d(Private::create(from, secure))
 {
 }
 
@@ -517,6 +1309,7 @@ char *MemoryRegion::data()
 {
 	if(!d)
 		return blank;
+	d->own();
 	return d->ai.data;
 }
 
@@ -536,6 +1329,7 @@ const char *MemoryRegion::constData() const
 
 char & MemoryRegion::at(int index)
 {
+	d->own();
 	return *(d->ai.data + index);
 }
 
@@ -562,7 +1356,7 @@ bool MemoryRegion::resize(int size)
 {
 	if(!d)
 	{
-		d = new Private(size, _secure);
+		d = Private::create(size, _secure);
 		return true;
 	}
 
@@ -572,14 +1366,36 @@ bool MemoryRegion::resize(int size)
 	return d->resize(size);
 }
 
+bool MemoryRegion::reserve(int size)
+{
+	if(!d)
+		d = Private::create(0, _secure);
+
+	return d->reserve(size);
+}
+
+int MemoryRegion::capacity() const
+{
+	if(!d)
+		return 0;
+	return d->capacity();
+}
+
+void MemoryRegion::squeeze()
+{
+	if(!d)
+		return;
+	d->squeeze();
+}
+
 void MemoryRegion::set(const QByteArray &from, bool secure)
 {
 	_secure = secure;
 
 	if(!from.isEmpty())
-		d = new Private(from, secure);
+		d = Private::create(from, secure);
 	else
-		d = new Private(0, secure);
+		d = Private::create(0, secure);
 }
 
 void MemoryRegion::setSecure(bool secure)
@@ -588,13 +1404,51 @@ void MemoryRegion::setSecure(bool secure)
 
 	if(!d)
 	{
-		d = new Private(0, secure);
+		d = Private::create(0, secure);
 		return;
 	}
 
+	// don't detach just to find there is nothing to convert
+	if(d.constData()->ai.sec == secure)
+		return;
+
 	d->setSecure(secure);
 }
 
+MemoryRegion MemoryRegion::mid(int pos, int len) const
+{
+	int total = size();
+	if(pos < 0)
+		pos = 0;
+	if(pos > total)
+		pos = total;
+	if(len < 0 || len > total - pos)
+		len = total - pos;
+
+	if(!d || (pos == 0 && len == total))
+		return *this;
+
+	MemoryRegion r(_secure);
+	r.d = Private::create(d->ai.data + pos, len, d->ai.sec, *this);
+	return r;
+}
+
+//----------------------------------------------------------------------------
+// MemoryView
+//----------------------------------------------------------------------------
+MemoryView::MemoryView(const char *data, int size)
+:MemoryRegion(false)
+{
+	if(size < 0)
+		size = data ? qstrlen(data) : 0;
+	MemoryRegion::d = Private::create(data, size, false, MemoryRegion());
+}
+
+MemoryView::MemoryView(const MemoryRegion &from, int pos, int len)
+:MemoryRegion(from.mid(pos, len))
+{
+}
+
 //----------------------------------------------------------------------------
 // SecureArray
 //----------------------------------------------------------------------------
@@ -658,6 +1512,21 @@ bool SecureArray::resize(int size)
 	return MemoryRegion::resize(size);
 }
 
+bool SecureArray::reserve(int size)
+{
+	return MemoryRegion::reserve(size);
+}
+
+int SecureArray::capacity() const
+{
+	return MemoryRegion::capacity();
+}
+
+void SecureArray::squeeze()
+{
+	MemoryRegion::squeeze();
+}
+
 char & SecureArray::operator[](int index)
 {
 	return at(index);
@@ -0,0 +1,460 @@
+/*
+ * Copyright (C) 2026  Forkworks
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301  USA
+ *
+ */
+
+#include "qca_support.h"
+
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QWaitCondition>
+
+#include <climits>
+
+namespace QCA {
+
+//----------------------------------------------------------------------------
+// ThreadPool
+//----------------------------------------------------------------------------
+class ThreadPool::Private
+{
+public:
+	class Worker : public QThread
+	{
+	public:
+		Private *pool;
+
+		Worker(Private *_pool) : pool(_pool)
+		{
+		}
+
+	protected:
+		virtual void run()
+		{
+			pool->workerLoop(this);
+		}
+	};
+
+	QMutex m;
+	QWaitCondition workAvailable;
+	QWaitCondition idle;
+	QList<QRunnable*> queue[3];
+	QList<Worker*> workers; // alive
+	QList<Worker*> expired; // exited, waiting to be reaped
+	int maxThreads;
+	int expiry;
+	int waiting;
+	int active;
+	int peak;
+	qint64 completed;
+	bool stopping;
+
+	Private()
+	{
+		maxThreads = qMax(QThread::idealThreadCount(), 2);
+		expiry = 30000;
+		waiting = 0;
+		active = 0;
+		peak = 0;
+		completed = 0;
+		stopping = false;
+	}
+
+	int depth() const
+	{
+		return queue[0].count() + queue[1].count() + queue[2].count();
+	}
+
+	QRunnable *takeNext()
+	{
+		for(int n = ThreadPool::HighPriority; n >= ThreadPool::LowPriority; --n)
+		{
+			if(!queue[n].isEmpty())
+				return queue[n].takeFirst();
+		}
+		return 0;
+	}
+
+	// called with m locked
+	void reap();
+	void grow();
+	void workerLoop(Worker *w);
+	void stopAll();
+};
+
+void ThreadPool::Private::reap()
+{
+	// workers put themselves on the expired list as the very last thing
+	//   they do, so waiting on them here is always short
+	while(!expired.isEmpty())
+	{
+		Worker *w = expired.takeFirst();
+		m.unlock();
+		w->wait();
+		delete w;
+		m.lock();
+	}
+}
+
+void ThreadPool::Private::grow()
+{
+	reap();
+	int needed = depth() - waiting;
+	while(needed > 0 && workers.count() < maxThreads)
+	{
+		Worker *w = new Worker(this);
+		workers += w;
+		w->start();
+		--needed;
+	}
+}
+
+void ThreadPool::Private::workerLoop(Worker *w)
+{
+	QMutexLocker locker(&m);
+	while(true)
+	{
+		// shrink if the limit was lowered
+		if(stopping || workers.count() > maxThreads)
+			break;
+
+		QRunnable *r = takeNext();
+		if(!r)
+		{
+			++waiting;
+			bool woke = workAvailable.wait(&m, expiry < 0 ? ULONG_MAX : (unsigned long)expiry);
+			--waiting;
+			if(!woke && depth() == 0)
+				break;
+			continue;
+		}
+
+		++active;
+		bool autoDelete = r->autoDelete();
+		locker.unlock();
+		r->run();
+		if(autoDelete)
+			delete r;
+		locker.relock();
+		--active;
+		++completed;
+
+		if(active == 0 && depth() == 0)
+			idle.wakeAll();
+	}
+
+	workers.removeAll(w);
+	expired += w;
+
+	// we may have consumed a wakeup meant for the work still queued
+	if(depth() > 0)
+		workAvailable.wakeOne();
+	else if(active == 0)
+		idle.wakeAll();
+}
+
+void ThreadPool::Private::stopAll()
+{
+	stopping = true;
+	workAvailable.wakeAll();
+	while(!workers.isEmpty())
+	{
+		Worker *w = workers.first();
+		m.unlock();
+		w->wait();
+		m.lock();
+		reap();
+	}
+	reap();
+	stopping = false;
+}
+
+static QMutex *pool_mutex()
+{
+	static QMutex m;
+	return &m;
+}
+
+static ThreadPool *g_pool = 0;
+
+ThreadPool::ThreadPool()
+{
+	d = new Private;
+}
+
+ThreadPool::~ThreadPool()
+{
+	waitForDone();
+	d->m.lock();
+	d->stopAll();
+	d->m.unlock();
+	delete d;
+}
+
+ThreadPool *ThreadPool::instance()
+{
+	QMutexLocker locker(pool_mutex());
+	if(!g_pool)
+		g_pool = new ThreadPool;
+	return g_pool;
+}
+
+int ThreadPool::maxThreadCount() const
+{
+	QMutexLocker locker(&d->m);
+	return d->maxThreads;
+}
+
+void ThreadPool::setMaxThreadCount(int count)
+{
+	QMutexLocker locker(&d->m);
+	d->maxThreads = qMax(count, 1);
+	d->grow();
+
+	// let surplus idle workers notice the new limit
+	d->workAvailable.wakeAll();
+}
+
+int ThreadPool::expiryTimeout() const
+{
+	QMutexLocker locker(&d->m);
+	return d->expiry;
+}
+
+void ThreadPool::setExpiryTimeout(int msecs)
+{
+	QMutexLocker locker(&d->m);
+	d->expiry = msecs;
+}
+
+int ThreadPool::threadCount() const
+{
+	QMutexLocker locker(&d->m);
+	return d->workers.count();
+}
+
+int ThreadPool::activeThreadCount() const
+{
+	QMutexLocker locker(&d->m);
+	return d->active;
+}
+
+int ThreadPool::queueDepth() const
+{
+	QMutexLocker locker(&d->m);
+	return d->depth();
+}
+
+int ThreadPool::queueDepth(Priority priority) const
+{
+	QMutexLocker locker(&d->m);
+	return d->queue[priority].count();
+}
+
+int ThreadPool::peakQueueDepth() const
+{
+	QMutexLocker locker(&d->m);
+	return d->peak;
+}
+
+qint64 ThreadPool::completedCount() const
+{
+	QMutexLocker locker(&d->m);
+	return d->completed;
+}
+
+void ThreadPool::resetStatistics()
+{
+	QMutexLocker locker(&d->m);
+	d->peak = 0;
+	d->completed = 0;
+}
+
+void ThreadPool::start(QRunnable *runnable, Priority priority)
+{
+	QMutexLocker locker(&d->m);
+	d->queue[priority] += runnable;
+	int depth = d->depth();
+	if(depth > d->peak)
+		d->peak = depth;
+	if(d->waiting > 0)
+		d->workAvailable.wakeOne();
+	d->grow();
+}
+
+bool ThreadPool::tryTake(QRunnable *runnable)
+{
+	QMutexLocker locker(&d->m);
+	for(int n = 0; n < 3; ++n)
+	{
+		if(d->queue[n].removeOne(runnable))
+		{
+			if(d->active == 0 && d->depth() == 0)
+				d->idle.wakeAll();
+			return true;
+		}
+	}
+	return false;
+}
+
+bool ThreadPool::waitForDone(int msecs)
+{
+	QElapsedTimer timer;
+	timer.start();
+	QMutexLocker locker(&d->m);
+	while(d->active > 0 || d->depth() > 0)
+	{
+		if(msecs < 0)
+			d->idle.wait(&d->m);
+		else
+		{
+			qint64 left = msecs - timer.elapsed();
+			if(left <= 0 || !d->idle.wait(&d->m, (unsigned long)left))
+				return d->active == 0 && d->depth() == 0;
+		}
+	}
+	return true;
+}
+
+// called by deinit(), so that no pool thread outlives the plugins or the
+//   library.  a new pool is created on demand if needed again.
+void threadpool_stop()
+{
+	pool_mutex()->lock();
+	ThreadPool *pool = g_pool;
+	g_pool = 0;
+	pool_mutex()->unlock();
+	delete pool;
+}
+
+//----------------------------------------------------------------------------
+// ThreadPoolJob
+//----------------------------------------------------------------------------
+class ThreadPoolJob::Private : public QRunnable
+{
+public:
+	enum State { Idle, Queued, Running, Finished };
+
+	ThreadPoolJob *q;
+	QMutex m;
+	QWaitCondition cond;
+	State state;
+
+	Private(ThreadPoolJob *_q) : q(_q), state(Idle)
+	{
+		setAutoDelete(false);
+	}
+
+	virtual void run()
+	{
+		m.lock();
+		state = Running;
+		m.unlock();
+
+		q->run();
+
+		// emit before waking any waiter, like QThread does, so that a
+		//   wait() that returns means the job is entirely done
+		emit q->finished();
+
+		QMutexLocker locker(&m);
+		state = Finished;
+		cond.wakeAll();
+	}
+};
+
+ThreadPoolJob::ThreadPoolJob(QObject *parent)
+:QObject(parent)
+{
+	d = new Private(this);
+}
+
+ThreadPoolJob::~ThreadPoolJob()
+{
+	// a job that never got to run is simply dropped
+	d->m.lock();
+	bool queued = (d->state == Private::Queued);
+	d->m.unlock();
+	if(!queued || !ThreadPool::instance()->tryTake(d))
+		wait();
+	delete d;
+}
+
+void ThreadPoolJob::start(ThreadPool::Priority priority)
+{
+	QMutexLocker locker(&d->m);
+	if(d->state == Private::Queued || d->state == Private::Running)
+		return;
+	d->state = Private::Queued;
+	ThreadPool::instance()->start(d, priority);
+}
+
+bool ThreadPoolJob::isRunning() const
+{
+	QMutexLocker locker(&d->m);
+	return d->state == Private::Queued || d->state == Private::Running;
+}
+
+bool ThreadPoolJob::isFinished() const
+{
+	QMutexLocker locker(&d->m);
+	return d->state == Private::Finished;
+}
+
+bool ThreadPoolJob::wait(int msecs)
+{
+	QElapsedTimer timer;
+	timer.start();
+
+	d->m.lock();
+	if(d->state == Private::Queued && msecs < 0)
+	{
+		d->m.unlock();
+
+		// not picked up yet, so do the work here rather than block
+		//   a thread that may itself be a pool worker.  this can take
+		//   any amount of time, so a wait with a timeout doesn't
+		if(ThreadPool::instance()->tryTake(d))
+		{
+			d->run();
+			return true;
+		}
+		d->m.lock();
+	}
+
+	bool ret = true;
+	while(d->state == Private::Queued || d->state == Private::Running)
+	{
+		if(msecs < 0)
+			d->cond.wait(&d->m);
+		else
+		{
+			qint64 left = msecs - timer.elapsed();
+			if(left <= 0 || !d->cond.wait(&d->m, (unsigned long)left))
+			{
+				ret = (d->state == Private::Finished);
+				break;
+			}
+		}
+	}
+	d->m.unlock();
+	return ret;
+}
+
+}
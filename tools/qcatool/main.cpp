@@ -2719,6 +2719,7 @@ static void usage()
 	printf(" help|--help|-h                        This help text\n");
 	printf(" version|--version|-v                  Print version information\n");
 	printf(" plugins                               List available plugins\n");
+	printf(" memory                                Show secure memory usage\n");
 	printf(" config [command]\n");
 	printf("   save [provider]                     Save default provider config\n");
 	printf("   edit [provider]                     Edit provider config\n");
@@ -2936,6 +2937,30 @@ int main(int argc, char **argv)
 		return 0;
 	}
 
+	// show secure memory usage
+	if(args[0] == "memory")
+	{
+		if(!QCA::haveSecureMemory())
+			printf("Secure memory is not available.\n");
+
+		QList<QCA::SecureMemoryStatistics> list = QCA::secureMemoryStatistics();
+		foreach(const QCA::SecureMemoryStatistics &s, list)
+		{
+			printf("%s:\n", qPrintable(s.name()));
+			printf("  Size:            %d\n", s.poolSize());
+			printf("  In use:          %d\n", s.inUse());
+			printf("  Peak in use:     %d\n", s.peakInUse());
+			printf("  Allocations:     %lld\n", s.allocations());
+			printf("  Fallbacks:       %d\n", s.fallbacks());
+			if(s.freeRuns() > 0)
+			{
+				printf("  Free ranges:     %d\n", s.freeRuns());
+				printf("  Largest free:    %d\n", s.largestFreeRun());
+			}
+		}
+		return 0;
+	}
+
 	// config stuff
 	if(args[0] == "config")
 	{
@@ -43,6 +43,8 @@ private slots:
     void test1();
     void test2_data();
     void test2();
+    void testLongInput();
+    void testLineBreaks();
 private:
     QCA::Initializer* m_init;
 };
@@ -125,6 +127,67 @@ void Base64UnitTest::test2()
     QCOMPARE( QLatin1String(QCA::base64ToArray(encoded)), raw );
 }
 
+void Base64UnitTest::testLongInput()
+{
+    // every length up to where the vectorized loops start, and beyond
+    QByteArray raw;
+    for(int n = 0; n < 300; ++n)
+    {
+	QCOMPARE( QCA::arrayToBase64(raw), QString::fromLatin1(raw.toBase64()) );
+	QCOMPARE( QCA::base64ToArray(QString::fromLatin1(raw.toBase64())), raw );
+	raw += (char)(n * 13);
+    }
+
+    // a bad character far into the input
+    QCA::Base64 base64Object;
+    QByteArray encoded = raw.toBase64();
+    encoded[200] = '*';
+    QVERIFY( base64Object.decode(encoded).isEmpty() );
+    QCOMPARE( base64Object.ok(), false );
+}
+
+void Base64UnitTest::testLineBreaks()
+{
+    QByteArray raw;
+    for(int n = 0; n < 1000; ++n)
+	raw += (char)(n * 13);
+
+    QCA::Base64 base64Object;
+    base64Object.setLineBreaksEnabled(true);
+    base64Object.setLineBreaksColumn(64);
+
+    // fed in pieces that don't line up with the groups or the lines
+    base64Object.setup(QCA::Encode);
+    base64Object.clear();
+    QByteArray encoded;
+    for(int at = 0; at < raw.size(); at += 7)
+	encoded += base64Object.update(raw.mid(at, 7)).toByteArray();
+    encoded += base64Object.final().toByteArray();
+    QVERIFY( base64Object.ok() );
+
+    QList<QByteArray> lines = encoded.split('\n');
+    QCOMPARE( lines.count(), raw.toBase64().size() / 64 + 1 );
+    for(int n = 0; n < lines.count() - 1; ++n)
+	QCOMPARE( lines[n].size(), 64 );
+    QByteArray joined = encoded;
+    joined.replace('\n', "");
+    QCOMPARE( joined, raw.toBase64() );
+
+    base64Object.setup(QCA::Decode);
+    base64Object.clear();
+    QByteArray decoded;
+    for(int at = 0; at < encoded.size(); at += 11)
+	decoded += base64Object.update(encoded.mid(at, 11)).toByteArray();
+    decoded += base64Object.final().toByteArray();
+    QVERIFY( base64Object.ok() );
+    QCOMPARE( decoded, raw );
+
+    // line breaks are an error if not enabled
+    base64Object.setLineBreaksEnabled(false);
+    QVERIFY( base64Object.decode(encoded).isEmpty() );
+    QCOMPARE( base64Object.ok(), false );
+}
+
 QTEST_MAIN(Base64UnitTest)
 
 #include "base64unittest.moc"
@@ -3191,5 +3191,541 @@ void CipherUnitTest::cast5()
 }
 
 
+void CipherUnitTest::chacha20_data()
+{
+	QTest::addColumn<QString>("plainText");
+	QTest::addColumn<QString>("cipherText");
+	QTest::addColumn<QString>("keyText");
+	QTest::addColumn<QString>("ivText");
+
+	// The IV is the block counter, followed by the nonce
+
+	// RFC 8439, Appendix A.1, test vector #1
+	QTest::newRow("A.1 #1") << QString("00000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000")
+							<< QString("76b8e0ada0f13d90405d6ae55386bd28bdd219b8a08ded1aa836efcc8b770dc7da41597c5157488d7724e03fb8d84a376a43b8f41518a11cc387b669b2ee6586")
+							<< QString("0000000000000000000000000000000000000000000000000000000000000000")
+							<< QString("00000000000000000000000000000000");
+
+	// RFC 8439, section 2.4.2
+	QTest::newRow("2.4.2") << QString("4c616469657320616e642047656e746c656d656e206f662074686520636c617373206f66202739393a204966204920636f756c64206f6666657220796f75206f6e6c79206f6e652074697020666f7220746865206675747572652c2073756e73637265656e20776f756c642062652069742e")
+						   << QString("6e2e359a2568f98041ba0728dd0d6981e97e7aec1d4360c20a27afccfd9fae0bf91b65c5524733ab8f593dabcd62b3571639d624e65152ab8f530c359f0861d807ca0dbf500d6a6156a38e088a22b65e52bc514d16ccf806818ce91ab77937365af90bbf74a35be6b40b8eedf2785e42874d")
+						   << QString("000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f")
+						   << QString("01000000000000000000004a00000000");
+}
+
+void CipherUnitTest::chacha20()
+{
+	QStringList providersToTest;
+	providersToTest.append("default");
+
+	foreach(const QString provider, providersToTest) {
+		if( !QCA::isSupported( "chacha20", provider ) )
+			QWARN( QString( "ChaCha20 not supported for "+provider).toLocal8Bit() );
+		else {
+			QFETCH( QString, plainText );
+			QFETCH( QString, cipherText );
+			QFETCH( QString, keyText );
+			QFETCH( QString, ivText );
+
+			QCA::SymmetricKey key( QCA::hexToArray( keyText ) );
+			QCA::InitializationVector iv( QCA::hexToArray( ivText ) );
+			QCA::Cipher forwardCipher( QString( "chacha20" ),
+									   QCA::Cipher::Stream,
+									   QCA::Cipher::NoPadding,
+									   QCA::Encode,
+									   key,
+									   iv,
+									   provider);
+			QCOMPARE( forwardCipher.blockSize(), 1 );
+			QString update = QCA::arrayToHex( forwardCipher.update( QCA::hexToArray( plainText ) ).toByteArray() );
+			QVERIFY( forwardCipher.ok() );
+			QCOMPARE( update + QCA::arrayToHex( forwardCipher.final().toByteArray() ), cipherText );
+			QVERIFY( forwardCipher.ok() );
+
+			QCA::Cipher reverseCipher( QString( "chacha20" ),
+									   QCA::Cipher::Stream,
+									   QCA::Cipher::NoPadding,
+									   QCA::Decode,
+									   key,
+									   iv,
+									   provider);
+
+			QCOMPARE( QCA::arrayToHex( reverseCipher.update( QCA::hexToArray( cipherText ) ).toByteArray() ), plainText );
+			QVERIFY( reverseCipher.ok() );
+			QCOMPARE( QCA::arrayToHex( reverseCipher.final().toByteArray() ), QString( "" ) );
+			QVERIFY( reverseCipher.ok() );
+		}
+	}
+}
+
+void CipherUnitTest::chacha20CounterLimit()
+{
+	QStringList providersToTest;
+	providersToTest.append("default");
+
+	foreach(const QString provider, providersToTest) {
+		if( !QCA::isSupported( "chacha20", provider ) )
+			QWARN( QString( "ChaCha20 not supported for "+provider).toLocal8Bit() );
+		else {
+			// the last block before the 32-bit counter wraps
+			QCA::SymmetricKey key( QCA::hexToArray( "000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f" ) );
+			QCA::InitializationVector iv( QCA::hexToArray( "ffffffff000000000000004a00000000" ) );
+			QCA::Cipher cipher( QString( "chacha20" ),
+								QCA::Cipher::Stream,
+								QCA::Cipher::NoPadding,
+								QCA::Encode,
+								key,
+								iv,
+								provider);
+			QCOMPARE( cipher.update( QCA::SecureArray( 60 ) ).size(), 60 );
+			QVERIFY( cipher.ok() );
+			QCOMPARE( cipher.update( QCA::SecureArray( 4 ) ).size(), 4 );
+			QVERIFY( cipher.ok() );
+			QCOMPARE( cipher.update( QCA::SecureArray( 1 ) ).size(), 0 );
+			QVERIFY( !cipher.ok() );
+
+			// all at once
+			cipher.setup( QCA::Encode, key, iv );
+			QCOMPARE( cipher.update( QCA::SecureArray( 65 ) ).size(), 0 );
+			QVERIFY( !cipher.ok() );
+			cipher.final();
+			QVERIFY( !cipher.ok() );
+		}
+	}
+}
+
+void CipherUnitTest::chacha20_poly1305_data()
+{
+	QTest::addColumn<QString>("plainText");
+	QTest::addColumn<QString>("payload");
+	QTest::addColumn<QString>("tag");
+	QTest::addColumn<QString>("keyText");
+	QTest::addColumn<QString>("ivText");
+
+	// The long plain text is the one of RFC 8439 section 2.8.2, without
+	// the associated data.  Checked against libsodium.
+	QTest::newRow("short") << QString("4f6820526f6d656d6f21")
+						<< QString("d013c90f6e9025d77ac3")
+						<< QString("9bee87965cc118b33771c4d142bcc6a8")
+						<< QString("808182838485868788898a8b8c8d8e8f909192939495969798999a9b9c9d9e9f")
+						<< QString("070000004041424344454647");
+
+	QTest::newRow("long") << QString("4c616469657320616e642047656e746c656d656e206f662074686520636c617373206f66202739393a204966204920636f756c64206f6666657220796f75206f6e6c79206f6e652074697020666f7220746865206675747572652c2073756e73637265656e20776f756c642062652069742e")
+						<< QString("d31a8d34648e60db7b86afbc53ef7ec2a4aded51296e08fea9e2b5a736ee62d63dbea45e8ca9671282fafb69da92728b1a71de0a9e060b2905d6a5b67ecd3b3692ddbd7f2d778b8c9803aee328091b58fab324e4fad675945585808b4831d7bc3ff4def08e4b7a9de576d26586cec64b6116")
+						<< QString("6a23a4681fd59456aea1d29f82477216")
+						<< QString("808182838485868788898a8b8c8d8e8f909192939495969798999a9b9c9d9e9f")
+						<< QString("070000004041424344454647");
+
+	QTest::newRow("wrongtag") << QString("4f6820526f6d656d6f21")
+						<< QString("d013c90f6e9025d77ac3")
+						<< QString("9bee87965cc118b33771c4d142bcc6a9")
+						<< QString("808182838485868788898a8b8c8d8e8f909192939495969798999a9b9c9d9e9f")
+						<< QString("070000004041424344454647");
+}
+
+void CipherUnitTest::chacha20_poly1305()
+{
+	QStringList providersToTest;
+	providersToTest.append("default");
+
+	foreach (const QString &provider, providersToTest) {
+		if (!QCA::isSupported( "chacha20-poly1305", provider))
+			QWARN(QString("ChaCha20-Poly1305 not supported for " + provider).toLocal8Bit());
+		else {
+			QFETCH(QString, plainText);
+			QFETCH(QString, payload);
+			QFETCH(QString, tag);
+			QFETCH(QString, keyText);
+			QFETCH(QString, ivText);
+
+			QCA::SymmetricKey key(QCA::hexToArray(keyText));
+			QCA::InitializationVector iv(QCA::hexToArray(ivText));
+			QCA::AuthTag authTag(16);
+			QCA::Cipher forwardCipher(QString("chacha20"),
+									  QCA::Cipher::Poly1305,
+									  QCA::Cipher::NoPadding,
+									  QCA::Encode,
+									  key,
+									  iv,
+									  authTag,
+									  provider);
+			QString update = QCA::arrayToHex(forwardCipher.update(QCA::hexToArray(plainText)).toByteArray());
+			QVERIFY(forwardCipher.ok());
+			update += QCA::arrayToHex(forwardCipher.final().toByteArray());
+			authTag = forwardCipher.tag();
+			QEXPECT_FAIL("wrongtag", "It's OK", Continue);
+			QCOMPARE(QCA::arrayToHex(authTag.toByteArray()), tag);
+			QCOMPARE(update, payload);
+			QVERIFY(forwardCipher.ok());
+
+			QCA::Cipher reverseCipher(QString("chacha20"),
+									  QCA::Cipher::Poly1305,
+									  QCA::Cipher::NoPadding,
+									  QCA::Decode,
+									  key,
+									  iv,
+									  QCA::AuthTag(QCA::hexToArray(tag)),
+									  provider);
+
+			// a stream cipher has no output left for final(), which
+			// only checks the tag
+			update = QCA::arrayToHex(reverseCipher.update(QCA::hexToArray(payload)).toByteArray());
+			QVERIFY(reverseCipher.ok());
+			QCOMPARE(update, plainText);
+			reverseCipher.final();
+			QEXPECT_FAIL("wrongtag", "It's OK", Continue);
+			QVERIFY(reverseCipher.ok());
+		}
+	}
+}
+
+void CipherUnitTest::xchacha20_poly1305_data()
+{
+	QTest::addColumn<QString>("plainText");
+	QTest::addColumn<QString>("payload");
+	QTest::addColumn<QString>("tag");
+	QTest::addColumn<QString>("keyText");
+	QTest::addColumn<QString>("ivText");
+
+	// The long plain text is the one of RFC 8439 section 2.8.2, without
+	// the associated data.  Checked against libsodium.
+	QTest::newRow("short") << QString("4f6820526f6d656d6f21")
+						<< QString("be6453a6349d91379433")
+						<< QString("48b9a09f58999ee1ec56c84c629e0555")
+						<< QString("808182838485868788898a8b8c8d8e8f909192939495969798999a9b9c9d9e9f")
+						<< QString("404142434445464748494a4b4c4d4e4f5051525354555657");
+
+	QTest::newRow("long") << QString("4c616469657320616e642047656e746c656d656e206f662074686520636c617373206f66202739393a204966204920636f756c64206f6666657220796f75206f6e6c79206f6e652074697020666f7220746865206675747572652c2073756e73637265656e20776f756c642062652069742e")
+						<< QString("bd6d179d3e83d43b9576579493c0e939572a1700252bfaccbed2902c21396cbb731c7f1b0b4aa6440bf3a82f4eda7e39ae64c6708c54c216cb96b72e1213b4522f8c9ba40db5d945b11b69b982c1bb9e3f3fac2bc369488f76b2383565d3fff921f9664c97637da9768812f615c68b13b52e")
+						<< QString("f7e62efbf45089db18f9c8a3f0e41e5f")
+						<< QString("808182838485868788898a8b8c8d8e8f909192939495969798999a9b9c9d9e9f")
+						<< QString("404142434445464748494a4b4c4d4e4f5051525354555657");
+
+	QTest::newRow("wrongtag") << QString("4f6820526f6d656d6f21")
+						<< QString("be6453a6349d91379433")
+						<< QString("48b9a09f58999ee1ec56c84c629e0556")
+						<< QString("808182838485868788898a8b8c8d8e8f909192939495969798999a9b9c9d9e9f")
+						<< QString("404142434445464748494a4b4c4d4e4f5051525354555657");
+}
+
+void CipherUnitTest::xchacha20_poly1305()
+{
+	QStringList providersToTest;
+	providersToTest.append("default");
+	providersToTest.append("qca-ossl");
+
+	foreach (const QString &provider, providersToTest) {
+		if (!QCA::isSupported( "xchacha20-poly1305", provider))
+			QWARN(QString("XChaCha20-Poly1305 not supported for " + provider).toLocal8Bit());
+		else {
+			QFETCH(QString, plainText);
+			QFETCH(QString, payload);
+			QFETCH(QString, tag);
+			QFETCH(QString, keyText);
+			QFETCH(QString, ivText);
+
+			QCA::SymmetricKey key(QCA::hexToArray(keyText));
+			QCA::InitializationVector iv(QCA::hexToArray(ivText));
+			QCA::AuthTag authTag(16);
+			QCA::Cipher forwardCipher(QString("xchacha20"),
+									  QCA::Cipher::Poly1305,
+									  QCA::Cipher::NoPadding,
+									  QCA::Encode,
+									  key,
+									  iv,
+									  authTag,
+									  provider);
+			QString update = QCA::arrayToHex(forwardCipher.update(QCA::hexToArray(plainText)).toByteArray());
+			QVERIFY(forwardCipher.ok());
+			update += QCA::arrayToHex(forwardCipher.final().toByteArray());
+			authTag = forwardCipher.tag();
+			QEXPECT_FAIL("wrongtag", "It's OK", Continue);
+			QCOMPARE(QCA::arrayToHex(authTag.toByteArray()), tag);
+			QCOMPARE(update, payload);
+			QVERIFY(forwardCipher.ok());
+
+			QCA::Cipher reverseCipher(QString("xchacha20"),
+									  QCA::Cipher::Poly1305,
+									  QCA::Cipher::NoPadding,
+									  QCA::Decode,
+									  key,
+									  iv,
+									  QCA::AuthTag(QCA::hexToArray(tag)),
+									  provider);
+
+			// a stream cipher has no output left for final(), which
+			// only checks the tag
+			update = QCA::arrayToHex(reverseCipher.update(QCA::hexToArray(payload)).toByteArray());
+			QVERIFY(reverseCipher.ok());
+			QCOMPARE(update, plainText);
+			reverseCipher.final();
+			QEXPECT_FAIL("wrongtag", "It's OK", Continue);
+			QVERIFY(reverseCipher.ok());
+		}
+	}
+}
+
+void CipherUnitTest::setIV_data()
+{
+	QTest::addColumn<int>("mode");
+	QTest::addColumn<int>("padding");
+	QTest::addColumn<QString>("ivText");
+	QTest::addColumn<QString>("nextIvText");
+
+	QTest::newRow("cbc-pkcs7") << (int)QCA::Cipher::CBC << (int)QCA::Cipher::PKCS7
+							   << QString("000102030405060708090a0b0c0d0e0f")
+							   << QString("7649abac8119b246cee98e9b12e9197d");
+	QTest::newRow("ctr") << (int)QCA::Cipher::CTR << (int)QCA::Cipher::NoPadding
+						 << QString("f0f1f2f3f4f5f6f7f8f9fafbfcfdfeff")
+						 << QString("0f0e0d0c0b0a09080706050403020100");
+	QTest::newRow("gcm") << (int)QCA::Cipher::GCM << (int)QCA::Cipher::NoPadding
+						 << QString("cafebabefacedbaddecaf888")
+						 << QString("000000000000000000000001");
+}
+
+void CipherUnitTest::setIV()
+{
+	QStringList providersToTest;
+	providersToTest.append("qca-ossl");
+	providersToTest.append("qca-gcrypt");
+	providersToTest.append("qca-botan");
+	providersToTest.append("qca-nss");
+
+	QFETCH(int, mode);
+	QFETCH(int, padding);
+	QFETCH(QString, ivText);
+	QFETCH(QString, nextIvText);
+
+	QCA::Cipher::Mode cipherMode = (QCA::Cipher::Mode)mode;
+	QCA::Cipher::Padding cipherPadding = (QCA::Cipher::Padding)padding;
+	QString type = QCA::Cipher::withAlgorithms("aes128", cipherMode, cipherPadding);
+	QCA::SymmetricKey key(QCA::hexToArray("2b7e151628aed2a6abf7158809cf4f3c"));
+	QCA::InitializationVector iv(QCA::hexToArray(ivText));
+	QCA::InitializationVector nextIv(QCA::hexToArray(nextIvText));
+	QByteArray plainText("the same key, with a new IV for each message");
+
+	foreach (const QString &provider, providersToTest) {
+		if (!QCA::isSupported(type.toLatin1().constData(), provider))
+			QWARN(QString(type + " not supported for " + provider).toLocal8Bit());
+		else {
+			QCA::Cipher freshCipher(QString("aes128"), cipherMode, cipherPadding,
+									QCA::Encode, key, nextIv, QCA::AuthTag(16), provider);
+			QCA::SecureArray expected = freshCipher.update(plainText);
+			expected += freshCipher.final();
+			QVERIFY(freshCipher.ok());
+			QCA::AuthTag expectedTag = freshCipher.tag();
+
+			// after a whole message, and in the middle of one
+			QCA::Cipher forwardCipher(QString("aes128"), cipherMode, cipherPadding,
+									  QCA::Encode, key, iv, QCA::AuthTag(16), provider);
+			forwardCipher.update(plainText);
+			forwardCipher.final();
+			QVERIFY(forwardCipher.ok());
+			for (int n = 0; n < 2; ++n) {
+				forwardCipher.setIV(nextIv, QCA::AuthTag(16));
+				QCA::SecureArray cipherText = forwardCipher.update(plainText);
+				cipherText += forwardCipher.final();
+				QVERIFY(forwardCipher.ok());
+				QCOMPARE(cipherText.toByteArray(), expected.toByteArray());
+				QCOMPARE(forwardCipher.tag().toByteArray(), expectedTag.toByteArray());
+
+				forwardCipher.setIV(iv, QCA::AuthTag(16));
+				forwardCipher.update(plainText.left(20));
+			}
+
+			// a copy made in the middle of a message carries on from
+			// there, or fails, but never starts the message over
+			forwardCipher.setIV(nextIv);
+			{
+				QCA::SecureArray cipherText = forwardCipher.update(plainText.left(16));
+				QCA::Cipher copyCipher(forwardCipher);
+				QCA::SecureArray rest = copyCipher.update(plainText.mid(16));
+				rest += copyCipher.final();
+				if (copyCipher.ok()) {
+					cipherText += rest;
+					QCOMPARE(cipherText.toByteArray(), expected.toByteArray());
+				}
+				else
+					QVERIFY(rest.isEmpty());
+			}
+
+			// the tag keeps its size, and a copy has a context of its
+			// own that outlives the original
+			forwardCipher.setIV(nextIv);
+			{
+				QCA::Cipher copyCipher(forwardCipher);
+				QCA::SecureArray cipherText = copyCipher.update(plainText);
+				cipherText += copyCipher.final();
+				QVERIFY(copyCipher.ok());
+				QCOMPARE(cipherText.toByteArray(), expected.toByteArray());
+			}
+			QCA::SecureArray cipherText = forwardCipher.update(plainText);
+			cipherText += forwardCipher.final();
+			QVERIFY(forwardCipher.ok());
+			QCOMPARE(cipherText.toByteArray(), expected.toByteArray());
+			QCOMPARE(forwardCipher.tag().toByteArray(), expectedTag.toByteArray());
+
+			QCA::Cipher reverseCipher(QString("aes128"), cipherMode, cipherPadding,
+									  QCA::Decode, key, iv, QCA::AuthTag(16), provider);
+			reverseCipher.setIV(nextIv, expectedTag);
+			QCA::SecureArray decrypted = reverseCipher.update(expected);
+			decrypted += reverseCipher.final();
+			QVERIFY(reverseCipher.ok());
+			QCOMPARE(decrypted.toByteArray(), plainText);
+		}
+	}
+}
+
+void CipherUnitTest::parallel_data()
+{
+	QTest::addColumn<int>("mode");
+	QTest::addColumn<QString>("keyText");
+	QTest::addColumn<QString>("ivText");
+
+	QTest::newRow("ctr") << (int)QCA::Cipher::CTR
+						 << QString("2b7e151628aed2a6abf7158809cf4f3c")
+						 << QString("f0f1f2f3f4f5f6f7f8f9fafbfcfdfeff");
+	// the counter carries into every byte of the IV
+	QTest::newRow("ctr carry") << (int)QCA::Cipher::CTR
+							   << QString("2b7e151628aed2a6abf7158809cf4f3c")
+							   << QString("fffffffffffffffffffffffffffffff0");
+	QTest::newRow("gcm") << (int)QCA::Cipher::GCM
+						 << QString("feffe9928665731c6d6a8f9467308308")
+						 << QString("cafebabefacedbaddecaf888");
+	// an IV of other than 96 bits is hashed into the first counter
+	QTest::newRow("gcm long iv") << (int)QCA::Cipher::GCM
+								 << QString("feffe9928665731c6d6a8f9467308308")
+								 << QString("9313225df88406e555909c5aff5269aa6a7a9538534f7da1e4c303d2a318a728c3c0c95156809539fcf0e2429a6b525416aedbf5a0de6a57a637b39b");
+	// this IV hashes to a first counter ending in ffff398b, so the 32 bit
+	// counter wraps 50805 blocks in, inside the piece done in parallel
+	QTest::newRow("gcm counter wrap") << (int)QCA::Cipher::GCM
+									  << QString("feffe9928665731c6d6a8f9467308308")
+									  << QString("cafebabefacedbaddecaf8880000605c");
+}
+
+void CipherUnitTest::parallel()
+{
+	QStringList providersToTest;
+	providersToTest.append("qca-ossl");
+	providersToTest.append("qca-gcrypt");
+	providersToTest.append("qca-botan");
+	providersToTest.append("qca-nss");
+
+	QFETCH(int, mode);
+	QFETCH(QString, keyText);
+	QFETCH(QString, ivText);
+
+	QCA::Cipher::Mode cipherMode = (QCA::Cipher::Mode)mode;
+	QString type = QCA::Cipher::withAlgorithms("aes128", cipherMode, QCA::Cipher::NoPadding);
+	QCA::SymmetricKey key(QCA::hexToArray(keyText));
+	QCA::InitializationVector iv(QCA::hexToArray(ivText));
+
+	// enough for the input to be split, and not a whole number of
+	// blocks
+	QByteArray plainText(3 * 1024 * 1024 + 7, 0);
+	for(int n = 0; n < plainText.size(); ++n)
+		plainText[n] = (char)(n * 7 + (n >> 8));
+
+	foreach (const QString &provider, providersToTest) {
+		if (!QCA::isSupported(type.toLatin1().constData(), provider))
+			QWARN(QString(type + " not supported for " + provider).toLocal8Bit());
+		else {
+			QCA::Cipher forwardCipher(QString("aes128"),
+									  cipherMode,
+									  QCA::Cipher::NoPadding,
+									  QCA::Encode,
+									  key,
+									  iv,
+									  QCA::AuthTag(16),
+									  provider);
+			QCA::SecureArray expected = forwardCipher.update(plainText);
+			expected += forwardCipher.final();
+			QVERIFY(forwardCipher.ok());
+			QCA::AuthTag expectedTag = forwardCipher.tag();
+
+			// uneven pieces, so that the segments start and end in
+			// the middle of blocks
+			QCA::Cipher parallelCipher(QString("aes128"),
+									   cipherMode,
+									   QCA::Cipher::NoPadding,
+									   QCA::Encode,
+									   QCA::SymmetricKey(),
+									   QCA::InitializationVector(),
+									   provider);
+			QVERIFY(!parallelCipher.isParallel());
+			parallelCipher.setParallel(true);
+			QVERIFY(parallelCipher.isParallel());
+			parallelCipher.setup(QCA::Encode, key, iv, QCA::AuthTag(16));
+			QCA::SecureArray cipherText = parallelCipher.update(plainText.left(5));
+			cipherText += parallelCipher.update(plainText.mid(5, 1024 * 1024 + 3));
+			cipherText += parallelCipher.update(plainText.mid(1024 * 1024 + 8));
+			cipherText += parallelCipher.final();
+			QVERIFY(parallelCipher.ok());
+			QCOMPARE(cipherText.toByteArray(), expected.toByteArray());
+			QCOMPARE(parallelCipher.tag().toByteArray(), expectedTag.toByteArray());
+
+			QCA::Cipher reverseCipher(QString("aes128"),
+									  cipherMode,
+									  QCA::Cipher::NoPadding,
+									  QCA::Decode,
+									  QCA::SymmetricKey(),
+									  QCA::InitializationVector(),
+									  provider);
+			reverseCipher.setParallel(true);
+			reverseCipher.setup(QCA::Decode, key, iv, expectedTag);
+			QCA::SecureArray decrypted = reverseCipher.update(cipherText);
+			QVERIFY(reverseCipher.ok());
+			decrypted += reverseCipher.final();
+			QVERIFY(reverseCipher.ok());
+			QCOMPARE(decrypted.toByteArray(), plainText);
+
+			if (cipherMode == QCA::Cipher::GCM) {
+				QCA::AuthTag wrongTag = expectedTag;
+				wrongTag[0] = wrongTag[0] ^ 1;
+				reverseCipher.setup(QCA::Decode, key, iv, wrongTag);
+				reverseCipher.update(cipherText);
+				reverseCipher.final();
+				QVERIFY(!reverseCipher.ok());
+			}
+		}
+	}
+}
+
+void CipherUnitTest::parallelBenchmark_data()
+{
+	QTest::addColumn<int>("mode");
+	QTest::addColumn<bool>("parallel");
+
+	QTest::newRow("ctr") << (int)QCA::Cipher::CTR << false;
+	QTest::newRow("ctr parallel") << (int)QCA::Cipher::CTR << true;
+	QTest::newRow("gcm") << (int)QCA::Cipher::GCM << false;
+	QTest::newRow("gcm parallel") << (int)QCA::Cipher::GCM << true;
+}
+
+void CipherUnitTest::parallelBenchmark()
+{
+	QFETCH(int, mode);
+	QFETCH(bool, parallel);
+
+	QCA::Cipher::Mode cipherMode = (QCA::Cipher::Mode)mode;
+	QString type = QCA::Cipher::withAlgorithms("aes128", cipherMode, QCA::Cipher::NoPadding);
+	if (!QCA::isSupported(type.toLatin1().constData()))
+		QWARN(QString(type + " not supported").toLocal8Bit());
+	else {
+		QCA::SymmetricKey key(QCA::hexToArray("2b7e151628aed2a6abf7158809cf4f3c"));
+		QCA::InitializationVector iv(QCA::hexToArray(cipherMode == QCA::Cipher::CTR ? "f0f1f2f3f4f5f6f7f8f9fafbfcfdfeff" : "cafebabefacedbaddecaf888"));
+		QByteArray plainText(32 * 1024 * 1024, 'a');
+
+		QCA::Cipher cipher(QString("aes128"), cipherMode, QCA::Cipher::NoPadding);
+		cipher.setParallel(parallel);
+		QBENCHMARK {
+			cipher.setup(QCA::Encode, key, iv, QCA::AuthTag(16));
+			cipher.update(plainText);
+			cipher.final();
+		}
+		QVERIFY(cipher.ok());
+	}
+}
+
 
 QTEST_MAIN(CipherUnitTest)
@@ -118,6 +118,22 @@ private slots:
 
 	void cast5_data();
 	void cast5();
+
+	void chacha20_data();
+	void chacha20();
+	void chacha20CounterLimit();
+	void chacha20_poly1305_data();
+	void chacha20_poly1305();
+	void xchacha20_poly1305_data();
+	void xchacha20_poly1305();
+
+	void setIV_data();
+	void setIV();
+
+	void parallel_data();
+	void parallel();
+	void parallelBenchmark_data();
+	void parallelBenchmark();
 private:
 	QCA::Initializer* m_init;
 
@@ -46,6 +46,8 @@ private slots:
     void signverify_message();
     void signverify_message_invalid_data();
     void signverify_message_invalid();
+    void signverify_stream_data();
+    void signverify_stream();
 private:
     QCA::Initializer* m_init;
 
@@ -498,6 +500,101 @@ void CMSut::signverify_message_invalid()
 }
 
 
+void CMSut::signverify_stream_data()
+{
+    QTest::addColumn<int>("format");
+    QTest::addColumn<int>("signMode");
+
+    QTest::newRow("binary message") << (int)QCA::SecureMessage::Binary << (int)QCA::SecureMessage::Message;
+    QTest::newRow("ascii message") << (int)QCA::SecureMessage::Ascii << (int)QCA::SecureMessage::Message;
+    QTest::newRow("binary detached") << (int)QCA::SecureMessage::Binary << (int)QCA::SecureMessage::Detached;
+    QTest::newRow("ascii detached") << (int)QCA::SecureMessage::Ascii << (int)QCA::SecureMessage::Detached;
+}
+
+// Signs data given in many pieces, as the streaming signer sees it
+void CMSut::signverify_stream()
+{
+    QStringList providersToTest;
+    providersToTest.append("qca-ossl");
+
+    QFETCH( int, format );
+    QFETCH( int, signMode );
+
+    foreach(const QString provider, providersToTest) {
+        if( !QCA::isSupported( "cert", provider ) )
+            QWARN( QString( "Certificate not supported for "+provider).toLocal8Bit() );
+        else if( !QCA::isSupported( "cms", provider ) )
+	    QWARN( QString( "CMS not supported for "+provider).toLocal8Bit() );
+	else {
+	    QCA::ConvertResult res;
+	    QCA::SecureArray passPhrase = "start";
+	    QCA::PrivateKey privKey = QCA::PrivateKey::fromPEMFile( "QcaTestClientKey.pem", passPhrase, &res, provider );
+	    QCOMPARE( res, QCA::ConvertGood );
+
+	    QCA::Certificate pubCert = QCA::Certificate::fromPEMFile( "QcaTestClientCert.pem", &res, provider );
+	    QCOMPARE( res, QCA::ConvertGood );
+
+	    QCA::CertificateChain chain;
+	    chain += pubCert;
+	    QCA::SecureMessageKey secMsgKey;
+	    secMsgKey.setX509CertificateChain( chain );
+	    secMsgKey.setX509PrivateKey( privKey );
+
+	    QCA::SecureMessageKeyList privKeyList;
+	    privKeyList += secMsgKey;
+	    QCA::CMS cms2;
+	    cms2.setPrivateKeys( privKeyList );
+
+	    // larger than any buffer on the way, so that output is
+	    // produced before end()
+	    QByteArray testText( 300000, 'q' );
+
+	    QCA::SecureMessage msg2( &cms2 );
+	    msg2.setSigners( privKeyList );
+	    msg2.setFormat( (QCA::SecureMessage::Format)format );
+	    msg2.startSign( (QCA::SecureMessage::SignMode)signMode );
+	    for( int n = 0; n < testText.size(); n += 10000 )
+		msg2.update( testText.mid( n, 10000 ) );
+	    msg2.end();
+	    msg2.waitForFinished(-1);
+	    QVERIFY( msg2.success() );
+
+	    QByteArray signedResult;
+	    if( signMode == QCA::SecureMessage::Detached )
+		signedResult = msg2.signature();
+	    else
+		signedResult = msg2.read();
+	    QCOMPARE( signedResult.isEmpty(), false );
+	    if( format == QCA::SecureMessage::Ascii ) {
+		QVERIFY( signedResult.startsWith( "-----BEGIN PKCS7-----\n" ) );
+		QVERIFY( signedResult.endsWith( "-----END PKCS7-----\n" ) );
+	    }
+
+	    QCA::CMS cms;
+	    QCA::Certificate caCert = QCA::Certificate::fromPEMFile( "QcaTestRootCert.pem", &res, provider );
+	    QCOMPARE( res, QCA::ConvertGood );
+	    QCA::CertificateCollection caCertCollection;
+	    caCertCollection.addCertificate(caCert);
+	    cms.setTrustedCertificates( caCertCollection );
+
+	    QCA::SecureMessage msg( &cms );
+	    msg.setFormat( (QCA::SecureMessage::Format)format );
+	    if( signMode == QCA::SecureMessage::Detached ) {
+		msg.startVerify( signedResult );
+		msg.update( testText );
+	    } else {
+		msg.startVerify( );
+		msg.update( signedResult );
+	    }
+	    msg.end();
+	    msg.waitForFinished(-1);
+	    QVERIFY( msg.wasSigned() );
+	    QVERIFY( msg.success() );
+	    QVERIFY( msg.verifySuccess() );
+	}
+    }
+}
+
 QTEST_MAIN(CMSut)
 
 #include "cms.moc"
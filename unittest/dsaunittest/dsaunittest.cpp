@@ -38,6 +38,7 @@ private slots:
     void initTestCase();
     void cleanupTestCase();
     void testdsa();
+    void testBatchVerify();
 
 private:
     QCA::Initializer* m_init;
@@ -124,6 +125,52 @@ void DSAUnitTest::testdsa()
 	QVERIFY( dsaKey == fromDERkey );
 }
 
+void DSAUnitTest::testBatchVerify()
+{
+	if(!QCA::isSupported("pkey") ||
+	   !QCA::PKey::supportedTypes().contains(QCA::PKey::DSA) ||
+	   !QCA::DLGroup::supportedGroupSets().contains(QCA::DSA_1024))
+	{
+#if QT_VERSION >= 0x050000
+		QSKIP("DSA not supported!");
+#else
+		QSKIP("DSA not supported!", SkipAll);
+#endif
+	}
+
+	QCA::KeyGenerator keygen;
+	QCA::DLGroup group = keygen.createDLGroup(QCA::DSA_1024);
+	QCA::PrivateKey dsaKey = keygen.createDSA( group );
+	QCOMPARE( dsaKey.isNull(), false );
+	QCA::PublicKey pubKey = dsaKey.toPublicKey();
+
+	QList<QCA::VerifyBatchItem> batch;
+	QList<bool> expected;
+	for(int n = 0; n < 24; ++n)
+	{
+		QByteArray message = QByteArray("dsa message ") + QByteArray::number(n);
+		QByteArray sig = dsaKey.signMessage(message, QCA::EMSA1_SHA1);
+		QVERIFY( !sig.isEmpty() );
+		if(n % 4 == 1)
+		{
+			sig[sig.size() / 2] = sig[sig.size() / 2] ^ 0x01;
+			expected += false;
+		}
+		else
+			expected += true;
+		batch += QCA::VerifyBatchItem(pubKey, message, sig, QCA::EMSA1_SHA1);
+	}
+
+	QCOMPARE( QCA::verifyBatch(batch), expected );
+	QCOMPARE( QCA::verifyBatch(batch, 3), expected );
+
+	// DER formatted signatures go through the same path
+	QByteArray derSig = dsaKey.signMessage(QByteArray("der"), QCA::EMSA1_SHA1, QCA::DERSequence);
+	batch.clear();
+	batch += QCA::VerifyBatchItem(pubKey, QByteArray("der"), derSig, QCA::EMSA1_SHA1, QCA::DERSequence);
+	QCOMPARE( QCA::verifyBatch(batch), QList<bool>() << true );
+}
+
 QTEST_MAIN(DSAUnitTest)
 
 #include "dsaunittest.moc"
@@ -0,0 +1,235 @@
+/**
+ * Copyright (C)  2026  Forkworks
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <QtCrypto>
+#include <QtTest/QtTest>
+
+#ifdef QT_STATICPLUGIN
+#include "import_plugins.h"
+#endif
+
+// a sequential device that has nothing to read until it is waited for,
+//   like a socket whose data hasn't arrived yet
+class TrickleDevice : public QIODevice
+{
+public:
+    QByteArray data;
+    int chunk;
+    int arrived;
+
+    TrickleDevice(const QByteArray &_data, int _chunk) : data(_data), chunk(_chunk), arrived(0)
+    {
+    }
+
+    virtual bool isSequential() const
+    {
+	return true;
+    }
+
+    virtual bool waitForReadyRead(int)
+    {
+	if(arrived == data.size())
+	    return false;
+	arrived = qMin(arrived + chunk, data.size());
+	return true;
+    }
+
+protected:
+    virtual qint64 readData(char *out, qint64 maxSize)
+    {
+	qint64 n = qMin(maxSize, (qint64)arrived);
+	memcpy(out, data.constData(), n);
+	data.remove(0, n);
+	arrived -= n;
+	return n;
+    }
+
+    virtual qint64 writeData(const char *, qint64)
+    {
+	return -1;
+    }
+};
+
+class FilterChainUnitTest : public QObject
+{
+  Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void empty();
+    void stages();
+    void taps();
+    void devices();
+    void sequentialDevice();
+    void failure();
+private:
+    QCA::Initializer* m_init;
+    QByteArray m_data;
+};
+
+void FilterChainUnitTest::initTestCase()
+{
+    m_init = new QCA::Initializer;
+    for(int n = 0; n < 100000; ++n)
+	m_data += (char)(n * 31);
+}
+
+void FilterChainUnitTest::cleanupTestCase()
+{
+    delete m_init;
+}
+
+void FilterChainUnitTest::empty()
+{
+    QCA::FilterChain chain;
+    QCOMPARE( chain.count(), 0 );
+    QCOMPARE( chain.process(m_data).toByteArray(), m_data );
+    QVERIFY( chain.ok() );
+}
+
+void FilterChainUnitTest::stages()
+{
+    QCA::Base64 base64;
+    QCA::Hex hex;
+    QByteArray expected = hex.encode(base64.encode(m_data)).toByteArray();
+
+    QCA::FilterChain chain;
+    chain.append(&base64);
+    chain.append(&hex);
+    QCOMPARE( chain.count(), 2 );
+
+    // the padding from Base64::final() has to go through Hex as well
+    chain.clear();
+    QByteArray out;
+    for(int at = 0; at < m_data.size(); at += 1000)
+	out += chain.update(m_data.mid(at, 1000)).toByteArray();
+    out += chain.final().toByteArray();
+    QVERIFY( chain.ok() );
+    QCOMPARE( out, expected );
+
+    // and back
+    QCA::Hex unhex(QCA::Decode);
+    QCA::Base64 unbase64(QCA::Decode);
+    QCA::FilterChain reverse;
+    reverse.append(&unhex);
+    reverse.append(&unbase64);
+    QCOMPARE( reverse.process(out).toByteArray(), m_data );
+    QVERIFY( reverse.ok() );
+}
+
+void FilterChainUnitTest::taps()
+{
+    if(!QCA::isSupported("sha1"))
+    {
+#if QT_VERSION >= 0x050000
+	QSKIP("SHA1 not supported");
+#else
+	QSKIP("SHA1 not supported", SkipAll);
+#endif
+    }
+
+    QCA::Hash input("sha1");
+    QCA::Hash encoded("sha1");
+    QCA::Base64 base64;
+
+    QCA::FilterChain chain;
+    chain.tap(&input);
+    chain.append(&base64);
+    chain.tap(&encoded);
+
+    QByteArray out = chain.process(m_data).toByteArray();
+    QVERIFY( chain.ok() );
+    QCOMPARE( input.final().toByteArray(), QCA::Hash("sha1").hash(m_data).toByteArray() );
+    QCOMPARE( encoded.final().toByteArray(), QCA::Hash("sha1").hash(out).toByteArray() );
+}
+
+void FilterChainUnitTest::devices()
+{
+    QCA::Base64 base64;
+    base64.setLineBreaksEnabled(true);
+    QByteArray expected = base64.encode(m_data).toByteArray();
+
+    QBuffer in(&m_data);
+    in.open(QIODevice::ReadOnly);
+    QByteArray encoded;
+    QBuffer out(&encoded);
+    out.open(QIODevice::WriteOnly);
+
+    QCA::FilterChain chain;
+    chain.append(&base64);
+    QVERIFY( chain.process(&in, &out, 4096) );
+    QCOMPARE( encoded, expected );
+
+    // output may be discarded
+    in.seek(0);
+    QVERIFY( chain.process(&in, 0) );
+}
+
+void FilterChainUnitTest::sequentialDevice()
+{
+    QCA::Base64 base64;
+    QByteArray expected = base64.encode(m_data).toByteArray();
+
+    // every read runs dry before all of the data has arrived
+    TrickleDevice in(m_data, 3000);
+    in.open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+    QByteArray encoded;
+    QBuffer out(&encoded);
+    out.open(QIODevice::WriteOnly);
+
+    QCA::FilterChain chain;
+    chain.append(&base64);
+    QVERIFY( chain.process(&in, &out, 4096) );
+    QCOMPARE( encoded, expected );
+}
+
+void FilterChainUnitTest::failure()
+{
+    QCA::Hex hex(QCA::Decode);
+    QCA::Base64 base64;
+
+    QCA::FilterChain chain;
+    chain.append(&hex);
+    chain.append(&base64);
+
+    chain.clear();
+    QCOMPARE( chain.update(QByteArray("616263")).toByteArray(), QByteArray("YWJj") );
+    QVERIFY( chain.update(QByteArray("zz")).isEmpty() );
+    QCOMPARE( chain.ok(), false );
+
+    // stays failed until cleared
+    QVERIFY( chain.update(QByteArray("6364")).isEmpty() );
+    QVERIFY( chain.final().isEmpty() );
+    QCOMPARE( chain.ok(), false );
+
+    chain.clear();
+    QVERIFY( chain.ok() );
+    QCOMPARE( chain.process(QByteArray("616263")).toByteArray(), QByteArray("YWJj") );
+}
+
+QTEST_MAIN(FilterChainUnitTest)
+
+#include "filterchainunittest.moc"
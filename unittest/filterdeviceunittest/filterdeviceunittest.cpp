@@ -0,0 +1,207 @@
+/**
+ * Copyright (C)  2026  Forkworks
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <QtCrypto>
+#include <QtTest/QtTest>
+
+#ifdef QT_STATICPLUGIN
+#include "import_plugins.h"
+#endif
+
+class FilterDeviceUnitTest : public QObject
+{
+  Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void reading();
+    void reading_data();
+    void writing();
+    void hashing();
+    void failure();
+private:
+    QCA::Initializer* m_init;
+    QByteArray m_data;
+};
+
+void FilterDeviceUnitTest::initTestCase()
+{
+    m_init = new QCA::Initializer;
+    for(int n = 0; n < 100000; ++n)
+	m_data += (char)(n * 31);
+}
+
+void FilterDeviceUnitTest::cleanupTestCase()
+{
+    delete m_init;
+}
+
+void FilterDeviceUnitTest::reading_data()
+{
+    QTest::addColumn<int>("blockSize");
+    QTest::addColumn<bool>("readAhead");
+
+    QTest::newRow("default") << 65536 << false;
+    QTest::newRow("small blocks") << 1000 << false;
+    QTest::newRow("read ahead") << 4096 << true;
+}
+
+void FilterDeviceUnitTest::reading()
+{
+    QFETCH( int, blockSize );
+    QFETCH( bool, readAhead );
+
+    QCA::Base64 base64;
+    QByteArray expected = base64.encode(m_data).toByteArray();
+
+    // only files are read ahead
+    QTemporaryFile in;
+    QVERIFY( in.open() );
+    QCOMPARE( in.write(m_data), qint64(m_data.size()) );
+    in.seek(0);
+
+    QCA::Base64 filter;
+    QCA::FilterDevice dev(&filter, &in);
+    dev.setBlockSize(blockSize);
+    dev.setReadAhead(readAhead);
+    QVERIFY( dev.open(QIODevice::ReadOnly) );
+
+    // odd sized reads, so they straddle the blocks
+    QByteArray out;
+    while(!dev.atEnd())
+	out += dev.read(777);
+    QCOMPARE( out, expected );
+    QVERIFY( dev.ok() );
+    QCOMPARE( dev.bytesAvailable(), qint64(0) );
+    dev.close();
+
+    // the filter starts over on the next open
+    in.seek(0);
+    QVERIFY( dev.open(QIODevice::ReadOnly) );
+    QCOMPARE( dev.readAll(), expected );
+}
+
+void FilterDeviceUnitTest::writing()
+{
+    QCA::Base64 base64;
+    QByteArray expected = base64.encode(m_data).toByteArray();
+
+    QByteArray encoded;
+    QBuffer out(&encoded);
+    out.open(QIODevice::WriteOnly);
+
+    QCA::Base64 filter;
+    QCA::FilterDevice dev(&filter, &out);
+    dev.setBlockSize(4096);
+    QVERIFY( dev.open(QIODevice::WriteOnly) );
+
+    // a mix of writes smaller and larger than a block
+    QCOMPARE( dev.write(m_data.left(10)), qint64(10) );
+    QCOMPARE( dev.write(m_data.mid(10, 10000)), qint64(10000) );
+    for(int at = 10010; at < m_data.size(); at += 100)
+	dev.write(m_data.mid(at, 100));
+
+    // the padding is only written on close
+    dev.close();
+    QVERIFY( dev.ok() );
+    QCOMPARE( encoded, expected );
+}
+
+void FilterDeviceUnitTest::hashing()
+{
+    if(!QCA::isSupported("sha1"))
+    {
+#if QT_VERSION >= 0x050000
+	QSKIP("SHA1 not supported");
+#else
+	QSKIP("SHA1 not supported", SkipAll);
+#endif
+    }
+
+    QByteArray expected = QCA::Hash("sha1").hash(m_data).toByteArray();
+
+    // the data passes through unchanged
+    QTemporaryFile in;
+    QVERIFY( in.open() );
+    QCOMPARE( in.write(m_data), qint64(m_data.size()) );
+    in.seek(0);
+    QCA::HashDevice reader(QCA::Hash("sha1"), &in);
+    reader.setReadAhead(true);
+    QVERIFY( reader.open(QIODevice::ReadOnly) );
+    QCOMPARE( reader.readAll(), m_data );
+    QCOMPARE( reader.final().toByteArray(), expected );
+
+    QByteArray copy;
+    QBuffer out(&copy);
+    out.open(QIODevice::WriteOnly);
+    QCA::HashDevice writer(QCA::Hash("sha1"), &out);
+    QVERIFY( writer.open(QIODevice::WriteOnly) );
+    writer.write(m_data);
+    writer.close();
+    QCOMPARE( copy, m_data );
+    QCOMPARE( writer.final().toByteArray(), expected );
+
+    // small writes are held back, but final() doesn't need a close()
+    //   to see them
+    copy.clear();
+    out.seek(0);
+    QVERIFY( writer.open(QIODevice::WriteOnly) );
+    for(int at = 0; at < m_data.size(); at += 1000)
+	writer.write(m_data.mid(at, 1000));
+    QCOMPARE( writer.final().toByteArray(), expected );
+    QCOMPARE( copy, m_data );
+    writer.close();
+
+    // and Hash itself reading a device
+    in.seek(0);
+    QCA::Hash hash("sha1");
+    hash.update(&in);
+    QCOMPARE( hash.final().toByteArray(), expected );
+}
+
+void FilterDeviceUnitTest::failure()
+{
+    QByteArray data("616263zz6364");
+    QBuffer in(&data);
+    in.open(QIODevice::ReadOnly);
+
+    QCA::Hex filter(QCA::Decode);
+    QCA::FilterDevice dev(&filter, &in);
+    dev.setBlockSize(6);
+    QVERIFY( dev.open(QIODevice::ReadOnly) );
+    QCOMPARE( dev.read(3), QByteArray("abc") );
+    QCOMPARE( dev.read(3), QByteArray() );
+    QCOMPARE( dev.ok(), false );
+    QVERIFY( !dev.errorString().isEmpty() );
+
+    // only one direction at a time
+    dev.close();
+    QCOMPARE( dev.open(QIODevice::ReadWrite), false );
+}
+
+QTEST_MAIN(FilterDeviceUnitTest)
+
+#include "filterdeviceunittest.moc"
@@ -45,6 +45,8 @@ private slots:
     void md5test_data();
     void md5test();
     void md5filetest();
+    void multifiletest();
+    void savestatetest();
     void sha0test_data();
     void sha0test();
     void sha0longtest();
@@ -69,6 +71,16 @@ private slots:
     void whirlpooltest_data();
     void whirlpooltest();
     void whirlpoollongtest();
+    void sha3test_data();
+    void sha3test();
+    void xoftest_data();
+    void xoftest();
+    void treehashtest_data();
+    void treehashtest();
+    void treehashlongtest_data();
+    void treehashlongtest();
+    void treehashBenchmark_data();
+    void treehashBenchmark();
 private:
     QCA::Initializer* m_init;
 };
@@ -264,6 +276,93 @@ void HashUnitTest::md5filetest()
     }
 }
 
+void HashUnitTest::multifiletest()
+{
+    if(!QCA::isSupported("md5") || !QCA::isSupported("sha1"))
+    {
+#if QT_VERSION >= 0x050000
+	QSKIP("MD5 and SHA1 not supported");
+#else
+	QSKIP("MD5 and SHA1 not supported", SkipAll);
+#endif
+    }
+
+    QCOMPARE( QCA::arrayToHex( QCA::Hash("md5").hashFile( "./data/twohundredbytes" ).toByteArray() ),
+	      QString( "b91c1f114d942520ecdf7e84e580cda3" ) );
+    QVERIFY( QCA::Hash("md5").hashFile( "./data/does-not-exist" ).isEmpty() );
+
+    QCA::Hash md5("md5");
+    QCA::Hash sha1("sha1");
+    QVERIFY( QCA::Hash::hashFile( "./data/twohundredbytes", QList<QCA::Hash*>() << &md5 << &sha1 ) );
+    QCOMPARE( QString( QCA::arrayToHex( md5.final().toByteArray() ) ),
+	      QString( "b91c1f114d942520ecdf7e84e580cda3" ) );
+    QCOMPARE( QString( QCA::arrayToHex( sha1.final().toByteArray() ) ),
+	      QString( "d636519dfb18d913acbe69fc3ee5a4c7ac870297" ) );
+
+    // an open file is hashed from its current position
+    QFile f( "./data/twohundredbytes" );
+    QVERIFY( f.open( QIODevice::ReadOnly ) );
+    QByteArray all = f.readAll();
+    f.seek( 100 );
+    QCA::Hash rest("sha1");
+    rest.update( &f );
+    QVERIFY( f.atEnd() );
+    QCOMPARE( rest.final().toByteArray(), QCA::Hash("sha1").hash( all.mid(100) ).toByteArray() );
+}
+
+void HashUnitTest::savestatetest()
+{
+    QStringList providersToTest;
+    providersToTest.append("qca-ossl");
+    providersToTest.append("qca-gcrypt");
+    providersToTest.append("qca-botan");
+    providersToTest.append("qca-nss");
+    providersToTest.append("default");
+
+    QByteArray prefix( 1000, 'h' );
+    QByteArray message1( "first message" );
+    QByteArray message2( 150, 'm' );
+
+    foreach(QString provider, providersToTest) {
+	foreach(QString type, QStringList() << "md5" << "sha1" << "sha256") {
+	    if(!QCA::isSupported(type.toLatin1().constData(), provider))
+		continue;
+
+	    QCA::Hash hash(type, provider);
+	    hash.update( prefix );
+	    QByteArray state = hash.saveState();
+	    if ( state.isEmpty() ) {
+		QWARN( QString( "Saving the state of " + type + " not supported for " + provider ).toLocal8Bit() );
+		continue;
+	    }
+
+	    // continue from the checkpoint with two different messages
+	    hash.update( message1 );
+	    QCOMPARE( hash.final().toByteArray(), QCA::Hash(type, provider).hash( prefix + message1 ).toByteArray() );
+
+	    QCA::Hash resumed(type, provider);
+	    resumed.update( QByteArray( "something else" ) );
+	    QVERIFY( resumed.restoreState( state ) );
+	    resumed.update( message2 );
+	    QCOMPARE( resumed.final().toByteArray(), QCA::Hash(type, provider).hash( prefix + message2 ).toByteArray() );
+
+	    // a state only restores into the same type of hash
+	    QCA::Hash other(type == "md5" ? "sha1" : "md5", provider);
+	    QVERIFY( !other.restoreState( state ) );
+	    QVERIFY( !resumed.restoreState( QByteArray( "garbage" ) ) );
+	    QVERIFY( !resumed.restoreState( state.left( state.size() - 1 ) ) );
+
+	    // the OpenSSL digest structures end with the count of buffered
+	    // bytes, which must not be trusted as it is
+	    if ( provider == "qca-ossl" ) {
+		QByteArray corrupt = state;
+		corrupt.replace( corrupt.size() - 8, 8, QByteArray( 8, '\xff' ) );
+		QVERIFY( !resumed.restoreState( corrupt ) );
+	    }
+	}
+    }
+}
+
 void HashUnitTest::sha0test_data()
 {
     // These are extracted from OpenOffice.org 1.1.2, in sal/workben/t_digest.c
@@ -888,6 +987,254 @@ void HashUnitTest::whirlpoollongtest()
     }
 }
 
+void HashUnitTest::sha3test_data()
+{
+    QTest::addColumn<QString>("hashType");
+    QTest::addColumn<QByteArray>("input");
+    QTest::addColumn<QString>("expectedHash");
+
+    // These are from the NIST examples for FIPS 202
+    QTest::newRow("sha3-224()") << QString("sha3-224") << QByteArray("")
+		<< QString("6b4e03423667dbb73b6e15454f0eb1abd4597f9a1b078e3f5b5a6bc7");
+    QTest::newRow("sha3-224(abc)") << QString("sha3-224") << QByteArray("abc")
+		<< QString("e642824c3f8cf24ad09234ee7d3c766fc9a3a5168d0c94ad73b46fdf");
+    QTest::newRow("sha3-224(200xa3)") << QString("sha3-224") << QByteArray(200, (char)0xa3)
+		<< QString("9376816aba503f72f96ce7eb65ac095deee3be4bf9bbc2a1cb7e11e0");
+    QTest::newRow("sha3-256()") << QString("sha3-256") << QByteArray("")
+		<< QString("a7ffc6f8bf1ed76651c14756a061d662f580ff4de43b49fa82d80a4b80f8434a");
+    QTest::newRow("sha3-256(abc)") << QString("sha3-256") << QByteArray("abc")
+		<< QString("3a985da74fe225b2045c172d6bd390bd855f086e3e9d525b46bfe24511431532");
+    QTest::newRow("sha3-256(200xa3)") << QString("sha3-256") << QByteArray(200, (char)0xa3)
+		<< QString("79f38adec5c20307a98ef76e8324afbfd46cfd81b22e3973c65fa1bd9de31787");
+    QTest::newRow("sha3-384()") << QString("sha3-384") << QByteArray("")
+		<< QString("0c63a75b845e4f7d01107d852e4c2485c51a50aaaa94fc61995e71bbee983a2ac3713831264adb47fb6bd1e058d5f004");
+    QTest::newRow("sha3-384(abc)") << QString("sha3-384") << QByteArray("abc")
+		<< QString("ec01498288516fc926459f58e2c6ad8df9b473cb0fc08c2596da7cf0e49be4b298d88cea927ac7f539f1edf228376d25");
+    QTest::newRow("sha3-384(200xa3)") << QString("sha3-384") << QByteArray(200, (char)0xa3)
+		<< QString("1881de2ca7e41ef95dc4732b8f5f002b189cc1e42b74168ed1732649ce1dbcdd76197a31fd55ee989f2d7050dd473e8f");
+    QTest::newRow("sha3-512()") << QString("sha3-512") << QByteArray("")
+		<< QString("a69f73cca23a9ac5c8b567dc185a756e97c982164fe25859e0d1dcc1475c80a615b2123af1f5f94c11e3e9402c3ac558f500199d95b6d3e301758586281dcd26");
+    QTest::newRow("sha3-512(abc)") << QString("sha3-512") << QByteArray("abc")
+		<< QString("b751850b1a57168a5693cd924b6b096e08f621827444f70d884f5d0240d2712e10e116e9192af3c91a7ec57647e3934057340b4cf408d5a56592f8274eec53f0");
+    QTest::newRow("sha3-512(200xa3)") << QString("sha3-512") << QByteArray(200, (char)0xa3)
+		<< QString("e76dfad22084a8b1467fcf2ffa58361bec7628edf5f3fdc0e4805dc48caeeca81b7c13c30adf52a3659584739a2df46be589c51ca1a4a8416df6545a1ce8ba00");
+    QTest::newRow("shake128()") << QString("shake128") << QByteArray("")
+		<< QString("7f9c2ba4e88f827d616045507605853e");
+    QTest::newRow("shake128(abc)") << QString("shake128") << QByteArray("abc")
+		<< QString("5881092dd818bf5cf8a3ddb793fbcba7");
+    QTest::newRow("shake256()") << QString("shake256") << QByteArray("")
+		<< QString("46b9dd2b0ba88d13233b3feb743eeb243fcd52ea62b81b82b50c27646ed5762f");
+    QTest::newRow("shake256(abc)") << QString("shake256") << QByteArray("abc")
+		<< QString("483366601360a8771c6863080cc4114d8db44530f8f1e1ee4f94ea37e78b5739");
+}
+
+void HashUnitTest::sha3test()
+{
+    QStringList providersToTest;
+    providersToTest.append("default");
+
+    QFETCH(QString, hashType);
+    QFETCH(QByteArray, input);
+    QFETCH(QString, expectedHash);
+
+    foreach(QString provider, providersToTest) {
+	if(!QCA::isSupported(hashType.toLatin1().constData(), provider))
+	    QWARN(QString(hashType+" not supported for "+provider).toLocal8Bit());
+	else {
+	    QString hashResult = QCA::Hash(hashType, provider).hashToString(input);
+	    QCOMPARE( hashResult, expectedHash );
+	}
+    }
+}
+
+void HashUnitTest::xoftest_data()
+{
+    QTest::addColumn<QString>("hashType");
+    QTest::addColumn<QByteArray>("input");
+    QTest::addColumn<int>("outLen");
+    QTest::addColumn<QString>("expectedHash");
+
+    // an empty result means that the hash is not extendable
+    QTest::newRow("shake128(abc, 200)") << QString("shake128") << QByteArray("abc") << 200
+		<< QString("5881092dd818bf5cf8a3ddb793fbcba74097d5c526a6d35f97b83351940f2cc844c50af32acd3f2cdd066568706f509bc1bdde58295dae3f891a9a0fca5783789a41f8611214ce612394df286a62d1a2252aa94db9c538956c717dc2bed4f232a0294c857c730aa16067ac1062f1201fb0d377cfb9cde4c63599b27f3462bba4a0ed296c801f9ff7f57302bb3076ee145f97a32ae68e76ab66c48d51675bd49acc29082f5647584e6aa01b3f5af057805f973ff8ecb8b226ac32ada6f01c1fcd4818cb006aa5b4cd");
+    QTest::newRow("shake128(200xa3, 200)") << QString("shake128") << QByteArray(200, (char)0xa3) << 200
+		<< QString("131ab8d2b594946b9c81333f9bb6e0ce75c3b93104fa3469d3917457385da037cf232ef7164a6d1eb448c8908186ad852d3f85a5cf28da1ab6fe3438171978467f1c05d58c7ef38c284c41f6c2221a76f12ab1c04082660250802294fb87180213fdef5b0ecb7df50ca1f8555be14d32e10f6edcde892c09424b29f597afc270c904556bfcb47a7d40778d390923642b3cbd0579e60908d5a000c1d08b98ef933f806445bf87f8b009ba9e94f7266122ed7ac24e5e266c42a82fa1bbefb7b8db0066e16a85e0493f");
+    QTest::newRow("shake256(abc, 200)") << QString("shake256") << QByteArray("abc") << 200
+		<< QString("483366601360a8771c6863080cc4114d8db44530f8f1e1ee4f94ea37e78b5739d5a15bef186a5386c75744c0527e1faa9f8726e462a12a4feb06bd8801e751e41385141204f329979fd3047a13c5657724ada64d2470157b3cdc288620944d78dbcddbd912993f0913f164fb2ce95131a2d09a3e6d51cbfc622720d7a75c6334e8a2d7ec71a7cc29cf0ea610eeff1a588290a53000faa79932becec0bd3cd0b33a7e5d397fed1ada9442b99903f4dcfd8559ed3950faf40fe6f3b5d710ed3b677513771af6bfe119");
+    QTest::newRow("shake256(200xa3, 200)") << QString("shake256") << QByteArray(200, (char)0xa3) << 200
+		<< QString("cd8a920ed141aa0407a22d59288652e9d9f1a7ee0c1e7c1ca699424da84a904d2d700caae7396ece96604440577da4f3aa22aeb8857f961c4cd8e06f0ae6610b1048a7f64e1074cd629e85ad7566048efc4fb500b486a3309a8f26724c0ed628001a1099422468de726f1061d99eb9e93604d5aa7467d4b1bd6484582a384317d7f47d750b8f5499512bb85a226c4243556e696f6bd072c5aa2d9b69730244b56853d16970ad817e213e470618178001c9fb56c54fefa5fee67d2da524bb3b0b61ef0e9114a92cdb");
+    QTest::newRow("blake3(abc, 100)") << QString("blake3") << QByteArray("abc") << 100
+		<< QString("6437b3ac38465133ffb63b75273a8db548c558465d79db03fd359c6cd5bd9d851fb250ae7393f5d02813b65d521a0d492d9ba09cf7ce7f4cffd900f23374bf0bc08a1fb0b38ed276181ccbd9f7b7edbddf9f86404ad7929605f6ffa3fb1ac87983105f01");
+    QTest::newRow("blake3(3000a, 100)") << QString("blake3") << QByteArray(3000, 'a') << 100
+		<< QString("a012abdd339b966bfbf116187ba42db7a6aea0ca9d47219b0f88efdf99cd1b2edeb2f5dc71e0e94fa9cefe9b9bd526668e70addefdaeea3ad37df807475a701df763da910e4ea867072cd8947f30e957c2bfdfec96c9f339e1563194e18c521fea9a8156");
+    QTest::newRow("sha3-256(abc, 32)") << QString("sha3-256") << QByteArray("abc") << 32
+		<< QString("");
+}
+
+void HashUnitTest::xoftest()
+{
+    QStringList providersToTest;
+    providersToTest.append("default");
+
+    QFETCH(QString, hashType);
+    QFETCH(QByteArray, input);
+    QFETCH(int, outLen);
+    QFETCH(QString, expectedHash);
+
+    foreach(QString provider, providersToTest) {
+	if(!QCA::isSupported(hashType.toLatin1().constData(), provider))
+	    QWARN(QString(hashType+" not supported for "+provider).toLocal8Bit());
+	else {
+	    QCA::Hash xof(hashType, provider);
+	    xof.update(input);
+	    QCOMPARE( QString(QCA::arrayToHex(xof.final(outLen).toByteArray())), expectedHash );
+
+	    // a shorter output is the start of a longer one
+	    xof.clear();
+	    xof.update(input);
+	    QCOMPARE( QString(QCA::arrayToHex(xof.final(outLen / 2).toByteArray())), expectedHash.left(outLen / 2 * 2) );
+	}
+    }
+}
+
+void HashUnitTest::treehashtest_data()
+{
+    QTest::addColumn<QString>("hashType");
+    QTest::addColumn<QByteArray>("input");
+    QTest::addColumn<QString>("expectedHash");
+
+    // BLAKE2b and BLAKE2s from RFC 7693, and checked against the
+    // reference implementations of BLAKE2 and BLAKE3
+    QTest::newRow("blake2b()") << QString("blake2b") << QByteArray("")
+			       << QString("786a02f742015903c6c6fd852552d272912f4740e15847618a86e217f71f5419d25e1031afee585313896444934eb04b903a685b1448b755d56f701afe9be2ce");
+    QTest::newRow("blake2b(abc)") << QString("blake2b") << QByteArray("abc")
+				  << QString("ba80a53f981c4d0d6a2797b69f12f6e94c212f14685ac4b74b12bb6fdbffa2d17d87c5392aab792dc252d5de4533cc9518d38aa8dbf1925ab92386edd4009923");
+    QTest::newRow("blake2b(3000a)") << QString("blake2b") << QByteArray(3000, 'a')
+				    << QString("1bc790515752bdd36ff61ee3f500c0d44840a07ec1516dadecd7255d47ae4bf10c20575b18bd74f34e62508185b8494e23a440491fb5ba685253816ab246c390");
+    QTest::newRow("blake2s()") << QString("blake2s") << QByteArray("")
+			       << QString("69217a3079908094e11121d042354a7c1f55b6482ca1a51e1b250dfd1ed0eef9");
+    QTest::newRow("blake2s(abc)") << QString("blake2s") << QByteArray("abc")
+				  << QString("508c5e8c327c14e2e1a72ba34eeb452f37458b209ed63a294d999b4c86675982");
+    QTest::newRow("blake2s(3000a)") << QString("blake2s") << QByteArray(3000, 'a')
+				    << QString("937a0b67fca84ec93bc8f07c3b2906369403c2c08da6200ec75f085d5e5ad33e");
+    QTest::newRow("blake2bp()") << QString("blake2bp") << QByteArray("")
+				<< QString("b5ef811a8038f70b628fa8b294daae7492b1ebe343a80eaabbf1f6ae664dd67b9d90b0120791eab81dc96985f28849f6a305186a85501b405114bfa678df9380");
+    QTest::newRow("blake2bp(abc)") << QString("blake2bp") << QByteArray("abc")
+				   << QString("b91a6b66ae87526c400b0a8b53774dc65284ad8f6575f8148ff93dff943a6ecd8362130f22d6dae633aa0f91df4ac89aaff31d0f1b923c898e82025dedbdad6e");
+    QTest::newRow("blake2bp(3000a)") << QString("blake2bp") << QByteArray(3000, 'a')
+				     << QString("c6d99535bb4000b72b001f2fa52309410bb1587864cab3569988406c93b4ca4951264b3f70927f34e8938a6a1b23f2ea14a5800227eed3af961ea75ad1b47de4");
+    QTest::newRow("blake3()") << QString("blake3") << QByteArray("")
+			      << QString("af1349b9f5f9a1a6a0404dea36dcc9499bcb25c9adc112b7cc9a93cae41f3262");
+    QTest::newRow("blake3(abc)") << QString("blake3") << QByteArray("abc")
+				 << QString("6437b3ac38465133ffb63b75273a8db548c558465d79db03fd359c6cd5bd9d85");
+    QTest::newRow("blake3(3000a)") << QString("blake3") << QByteArray(3000, 'a')
+				   << QString("a012abdd339b966bfbf116187ba42db7a6aea0ca9d47219b0f88efdf99cd1b2e");
+    // four chunks at once and three on their own, then the last one
+    QTest::newRow("blake3(7173a)") << QString("blake3") << QByteArray(7173, 'a')
+				   << QString("5a7196f8bd5eecc93d0cadc08d90dde3c36f73638b5efc5bbc3ea7463d11f553");
+}
+
+void HashUnitTest::treehashtest()
+{
+    QStringList providersToTest;
+    providersToTest.append("default");
+
+    QFETCH(QString, hashType);
+    QFETCH(QByteArray, input);
+    QFETCH(QString, expectedHash);
+
+    foreach(QString provider, providersToTest) {
+	if(!QCA::isSupported(hashType.toLatin1().constData(), provider))
+	    QWARN(QString(hashType+" not supported for "+provider).toLocal8Bit());
+	else {
+	    QString hashResult = QCA::Hash(hashType, provider).hashToString(input);
+	    QCOMPARE( hashResult, expectedHash );
+	}
+    }
+}
+
+void HashUnitTest::treehashlongtest_data()
+{
+    QTest::addColumn<QString>("hashType");
+    QTest::addColumn<QString>("expectedHash");
+
+    QTest::newRow("blake2b") << QString("blake2b")
+			     << QString("98fb3efb7206fd19ebf69b6f312cf7b64e3b94dbe1a17107913975a793f177e1d077609d7fba363cbba00d05f7aa4e4fa8715d6428104c0a75643b0ff3fd3eaf");
+    QTest::newRow("blake2s") << QString("blake2s")
+			     << QString("bec0c0e6cde5b67acb73b81f79a67a4079ae1c60dac9d2661af18e9f8b50dfa5");
+    QTest::newRow("blake2bp") << QString("blake2bp")
+			      << QString("4fd1b8c1e05baa115dbf00df2eb2d217e935f5332b55a20d018109f6b5e08009711b40ae8ff73cf94017796a5a9675dbd2b8341a13f010eb33563dd2ffbbea5e");
+    QTest::newRow("blake3") << QString("blake3")
+			    << QString("616f575a1b58d4c9797d4217b9730ae5e6eb319d76edef6549b46f4efe31ff8b");
+}
+
+void HashUnitTest::treehashlongtest()
+{
+    QStringList providersToTest;
+    providersToTest.append("default");
+
+    QFETCH(QString, hashType);
+    QFETCH(QString, expectedHash);
+
+    QByteArray fillerString;
+    fillerString.fill('a', 1000);
+
+    foreach(QString provider, providersToTest) {
+	if(!QCA::isSupported(hashType.toLatin1().constData(), provider))
+	    QWARN(QString(hashType+" not supported for "+provider).toLocal8Bit());
+	else {
+	    QCA::Hash treeHash(hashType, provider);
+
+	    // a million a's in small pieces
+	    for (int i=0; i<1000; i++)
+		treeHash.update(fillerString);
+	    QCOMPARE( QString(QCA::arrayToHex(treeHash.final().toByteArray())), expectedHash );
+
+	    // and in one piece, which the parallel hashes split up
+	    treeHash.clear();
+	    treeHash.update(QByteArray(1000000, 'a'));
+	    QCOMPARE( QString(QCA::arrayToHex(treeHash.final().toByteArray())), expectedHash );
+
+	    // and in uneven pieces, that start in the middle of a block
+	    treeHash.clear();
+	    treeHash.update(QByteArray(333, 'a'));
+	    treeHash.update(QByteArray(999000, 'a'));
+	    treeHash.update(QByteArray(667, 'a'));
+	    QCOMPARE( QString(QCA::arrayToHex(treeHash.final().toByteArray())), expectedHash );
+	}
+    }
+}
+
+void HashUnitTest::treehashBenchmark_data()
+{
+    QTest::addColumn<QString>("hashType");
+
+    // sha256 is the baseline that the others are measured against
+    QTest::newRow("sha256") << QString("sha256");
+    QTest::newRow("blake2b") << QString("blake2b");
+    QTest::newRow("blake2s") << QString("blake2s");
+    QTest::newRow("blake2bp") << QString("blake2bp");
+    QTest::newRow("blake3") << QString("blake3");
+    QTest::newRow("sha3-256") << QString("sha3-256");
+}
+
+void HashUnitTest::treehashBenchmark()
+{
+    QFETCH(QString, hashType);
+
+    if(!QCA::isSupported(hashType.toLatin1().constData()))
+	QWARN(QString(hashType+" not supported").toLocal8Bit());
+    else {
+	QCA::Hash hash(hashType);
+	QByteArray data(16 * 1024 * 1024, 'a');
+	QBENCHMARK {
+	    hash.clear();
+	    hash.update(data);
+	    QVERIFY( !hash.final().isEmpty() );
+	}
+    }
+}
+
 
 QTEST_MAIN(HashUnitTest)
 
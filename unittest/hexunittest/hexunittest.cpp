@@ -41,6 +41,7 @@ private slots:
     void testHexString();
     void testIncrementalUpdate();
     void testBrokenInput();
+    void testLongInput();
 private:
     QCA::Initializer* m_init;
 };
@@ -115,6 +116,34 @@ void HexUnitTest::testBrokenInput()
     QCOMPARE(hexObject.ok(), false);
 }
 
+void HexUnitTest::testLongInput()
+{
+    // long enough for the vectorized loops, with a tail left over
+    QByteArray raw;
+    for(int n = 0; n < 1001; ++n)
+	raw += (char)(n * 7);
+
+    QCA::Hex hexObject;
+    QCOMPARE( hexObject.encode(raw).toByteArray(), raw.toHex() );
+    QCOMPARE( hexObject.decode(raw.toHex().toUpper()).toByteArray(), raw );
+
+    // split in the middle of a pair
+    QByteArray hex = raw.toHex();
+    hexObject.setup(QCA::Decode);
+    hexObject.clear();
+    QByteArray out = hexObject.update(hex.left(501)).toByteArray();
+    out += hexObject.update(hex.mid(501, 2)).toByteArray();
+    out += hexObject.update(hex.mid(503)).toByteArray();
+    out += hexObject.final().toByteArray();
+    QVERIFY( hexObject.ok() );
+    QCOMPARE( out, raw );
+
+    // a bad digit far into the input
+    hex[1500] = 'g';
+    QVERIFY( hexObject.decode(hex).isEmpty() );
+    QCOMPARE( hexObject.ok(), false );
+}
+
 QTEST_MAIN(HexUnitTest)
 
 #include "hexunittest.moc"
@@ -30,6 +30,13 @@
 #include "import_plugins.h"
 #endif
 
+// the benchmarks take seconds each and up to 256 MiB, so they are only
+//   run when QCA_BENCHMARKS is set in the environment
+static bool benchmarksEnabled()
+{
+    return !qgetenv("QCA_BENCHMARKS").isEmpty();
+}
+
 class KDFUnitTest : public QObject
 {
     Q_OBJECT
@@ -46,6 +53,21 @@ private slots:
     void pbkdf2Tests();
 	void pbkdf2TimeTest();
     void pbkdf2extraTests();
+    void pbkdf2sha2Tests_data();
+    void pbkdf2sha2Tests();
+    void pbkdf2sha2TimeTest();
+    void pbkdf2AsyncTest();
+    void pbkdf2BatchTest();
+    void scryptTests_data();
+    void scryptTests();
+    void scryptBenchmark_data();
+    void scryptBenchmark();
+    void argon2idTests_data();
+    void argon2idTests();
+    void argon2idBenchmark_data();
+    void argon2idBenchmark();
+    void hkdfTests_data();
+    void hkdfTests();
 private:
     QCA::Initializer* m_init;
 };
@@ -300,6 +322,7 @@ void KDFUnitTest::pbkdf2Tests()
     providersToTest.append("qca-ossl");
     providersToTest.append("qca-gcrypt");
     providersToTest.append("qca-botan");
+    providersToTest.append("default");
 
     QFETCH(QString, secret);
     QFETCH(QString, output);
@@ -330,6 +353,7 @@ void KDFUnitTest::pbkdf2TimeTest()
 	providersToTest.append("qca-ossl");
 	providersToTest.append("qca-botan");
 	providersToTest.append("qca-gcrypt");
+	providersToTest.append("default");
 
 	QCA::SecureArray password("secret");
 	QCA::InitializationVector iv(QByteArray("salt"));
@@ -475,6 +499,479 @@ void KDFUnitTest::pbkdf2extraTests()
     }
 }
 
+void KDFUnitTest::pbkdf2sha2Tests_data()
+{
+    QTest::addColumn<QString>("algorithm");
+    QTest::addColumn<QString>("secret");
+    QTest::addColumn<QString>("output");
+    QTest::addColumn<QString>("salt");
+    QTest::addColumn<unsigned int>("outputLength");
+    QTest::addColumn<unsigned int>("iterationCount");
+
+    // These are from RFC7914, section 11
+    QTest::newRow("sha256 1") << QString("sha256")
+			      << QString("706173737764")
+			      << QString("55ac046e56e3089fec1691c22544b605f94185216dde0465e68b9d57c20dacbc49ca9cccf179b645991664b39d77ef317c71b845b1e30bd509112041d3a19783")
+			      << QString("73616c74")
+			      << static_cast<unsigned int>(64)
+			      << static_cast<unsigned int>(1);
+
+    QTest::newRow("sha256 2") << QString("sha256")
+			      << QString("50617373776f7264")
+			      << QString("4ddcd8f60b98be21830cee5ef22701f9641a4418d04c0414aeff08876b34ab56a1d425a1225833549adb841b51c9b3176a272bdebba1d078478f62b397f33c8d")
+			      << QString("4e61436c")
+			      << static_cast<unsigned int>(64)
+			      << static_cast<unsigned int>(80000);
+
+    // output length not a multiple of the hash length
+    QTest::newRow("sha512") << QString("sha512")
+			    << QString("70617373776f7264")
+			    << QString("afe6c5530785b6cc6b1c6453384731bd5ee432ee549fd42fb6695779ad8a1c5bf59de69c48f774efc4007d5298f9033c0241d5ab69305e7b64eceeb8d834cfec6afdec3c1c23")
+			    << QString("73616c74")
+			    << static_cast<unsigned int>(70)
+			    << static_cast<unsigned int>(1000);
+}
+
+void KDFUnitTest::pbkdf2sha2Tests()
+{
+    QStringList providersToTest;
+    providersToTest.append("qca-ossl");
+    providersToTest.append("qca-gcrypt");
+    providersToTest.append("qca-botan");
+
+    QFETCH(QString, algorithm);
+    QFETCH(QString, secret);
+    QFETCH(QString, output);
+    QFETCH(QString, salt);
+    QFETCH(unsigned int, outputLength);
+    QFETCH(unsigned int, iterationCount);
+
+    QString type = "pbkdf2(" + algorithm + ')';
+    foreach(QString provider, providersToTest) {
+	if(!QCA::isSupported(QStringList(type), provider))
+	    QWARN(QString("PBKDF version 2 with "+algorithm+" not supported for "+provider).toLocal8Bit());
+	else {
+	    QCA::SecureArray password = QCA::hexToArray( secret );
+	    QCA::InitializationVector iv( QCA::hexToArray( salt) );
+	    QCA::SymmetricKey key = QCA::PBKDF2(algorithm, provider).makeKey( password,
+									      iv,
+									      outputLength,
+									      iterationCount);
+	    QCOMPARE( QCA::arrayToHex( key.toByteArray() ), output );
+	}
+    }
+}
+
+void KDFUnitTest::pbkdf2sha2TimeTest()
+{
+	QStringList providersToTest;
+	providersToTest.append("qca-ossl");
+	providersToTest.append("qca-botan");
+	providersToTest.append("qca-gcrypt");
+
+	QCA::SecureArray password("secret");
+	QCA::InitializationVector iv(QByteArray("salt"));
+	// several blocks, which all need the same number of iterations
+	unsigned int outputLength = 100;
+	int timeInterval = 200;
+	unsigned int iterationCount;
+
+	foreach(QString provider, providersToTest) {
+		if(!QCA::isSupported("pbkdf2(sha256)", provider)) {
+			QString warning("PBKDF version 2 with SHA256 not supported for %1");
+			QWARN(warning.arg(provider).toStdString().c_str());
+		} else {
+			QTime timer;
+			timer.start();
+			QCA::SymmetricKey key1(QCA::PBKDF2("sha256", provider).makeKey(password,
+											   iv,
+											   outputLength,
+											   timeInterval,
+											   &iterationCount));
+			// the key is derived within the time, not measured first and
+			//   then derived block by block, which would take about five
+			//   times as long.  the bound leaves room for a loaded machine
+			QVERIFY( timer.elapsed() < 4 * timeInterval );
+			QVERIFY( iterationCount > 0 );
+
+			QCA::SymmetricKey key2(QCA::PBKDF2("sha256", provider).makeKey(password,
+											   iv,
+											   outputLength,
+											   iterationCount));
+
+			QCOMPARE( key1, key2 );
+		}
+	}
+}
+
+void KDFUnitTest::pbkdf2AsyncTest()
+{
+    QStringList providersToTest;
+    providersToTest.append("qca-ossl");
+    providersToTest.append("qca-gcrypt");
+    providersToTest.append("qca-botan");
+    providersToTest.append("default");
+
+    foreach(QString provider, providersToTest) {
+	if(!QCA::isSupported("pbkdf2(sha1)", provider))
+	    QWARN(QString("PBKDF version 2 with SHA1 not supported for "+provider).toLocal8Bit());
+	else {
+	    // RFC3962, Appendix B
+	    QCA::InitializationVector salt(QCA::SecureArray("ATHENA.MIT.EDUraeburn"));
+	    QCA::SecureArray password("password");
+
+	    QList< QFuture<QCA::SymmetricKey> > futures;
+	    for(int n = 0; n < 8; ++n)
+		futures += QCA::makeKeyAsync(QCA::PBKDF2("sha1", provider), password, salt, 32, 1200);
+
+	    foreach(QFuture<QCA::SymmetricKey> f, futures)
+		QCOMPARE( QCA::arrayToHex(f.result().toByteArray()),
+			  QString( "5c08eb61fdf71e4e4ec3cf6ba1f5512ba7e52ddbc5e5142f708a31e2e62b1e13" ) );
+	}
+    }
+}
+
+void KDFUnitTest::pbkdf2BatchTest()
+{
+    QStringList providersToTest;
+    providersToTest.append("qca-ossl");
+    providersToTest.append("qca-gcrypt");
+    providersToTest.append("qca-botan");
+    providersToTest.append("default");
+
+    foreach(QString provider, providersToTest) {
+	if(!QCA::isSupported("pbkdf2(sha1)", provider))
+	    QWARN(QString("PBKDF version 2 with SHA1 not supported for "+provider).toLocal8Bit());
+	else {
+	    // RFC3962, Appendix B
+	    QList<QCA::SecureArray> secrets;
+	    QList<QCA::InitializationVector> salts;
+	    for(int n = 0; n < 8; ++n) {
+		secrets += QCA::SecureArray(n == 5 ? "passwort" : "password");
+		salts += QCA::InitializationVector(QCA::SecureArray("ATHENA.MIT.EDUraeburn"));
+	    }
+
+	    QCA::PBKDF2 kdf("sha1", provider);
+	    QList<QCA::SymmetricKey> keys = kdf.makeKeys(secrets, salts, 32, 1200);
+	    QCOMPARE( keys.count(), 8 );
+	    QCOMPARE( QCA::arrayToHex(keys[0].toByteArray()),
+		      QString( "5c08eb61fdf71e4e4ec3cf6ba1f5512ba7e52ddbc5e5142f708a31e2e62b1e13" ) );
+	    QVERIFY( keys[5] != keys[0] );
+
+	    QList<QCA::SymmetricKey> expected;
+	    for(int n = 0; n < 8; ++n)
+		expected += keys[0];
+	    QList<bool> results = kdf.verifyKeys(secrets, salts, expected, 1200);
+	    QCOMPARE( results.count(), 8 );
+	    for(int n = 0; n < 8; ++n)
+		QCOMPARE( results[n], n != 5 );
+
+	    // mismatched lists
+	    salts.removeLast();
+	    QVERIFY( kdf.makeKeys(secrets, salts, 32, 1200).isEmpty() );
+	    QVERIFY( kdf.verifyKeys(secrets, salts, expected, 1200).isEmpty() );
+	}
+    }
+}
+
+void KDFUnitTest::scryptTests_data()
+{
+    QTest::addColumn<QString>("secret");
+    QTest::addColumn<QString>("salt");
+    QTest::addColumn<unsigned int>("cost");
+    QTest::addColumn<unsigned int>("blockSize");
+    QTest::addColumn<unsigned int>("parallelism");
+    QTest::addColumn<QString>("output");
+
+    // These are from RFC7914, Section 12
+    QTest::newRow("1") << QString("") << QString("")
+		       << static_cast<unsigned int>(16)
+		       << static_cast<unsigned int>(1)
+		       << static_cast<unsigned int>(1)
+		       << QString("77d6576238657b203b19ca42c18a0497f16b4844e3074ae8dfdffa3fede21442fcd0069ded0948f8326a753a0fc81f17e8d3e0fb2e0d3628cf35e20c38d18906");
+
+    QTest::newRow("2") << QString("password") << QString("NaCl")
+		       << static_cast<unsigned int>(1024)
+		       << static_cast<unsigned int>(8)
+		       << static_cast<unsigned int>(16)
+		       << QString("fdbabe1c9d3472007856e7190d01e9fe7c6ad7cbc8237830e77376634b3731622eaf30d92e22a3886ff109279d9830dac727afb94a83ee6d8360cbdfa2cc0640");
+
+    QTest::newRow("3") << QString("pleaseletmein") << QString("SodiumChloride")
+		       << static_cast<unsigned int>(16384)
+		       << static_cast<unsigned int>(8)
+		       << static_cast<unsigned int>(1)
+		       << QString("7023bdcb3afd7348461c06cd81fd38ebfda8fbba904f8e3ea9b543f6545da1f2d5432955613f0fcf62d49705242a9af9e61e85dc0d651e40dfcf017b45575887");
+}
+
+void KDFUnitTest::scryptTests()
+{
+    QStringList providersToTest;
+    providersToTest.append("default");
+
+    QFETCH(QString, secret);
+    QFETCH(QString, salt);
+    QFETCH(unsigned int, cost);
+    QFETCH(unsigned int, blockSize);
+    QFETCH(unsigned int, parallelism);
+    QFETCH(QString, output);
+
+    foreach(QString provider, providersToTest) {
+	if(!QCA::isSupported("scrypt", provider))
+	    QWARN(QString("scrypt not supported for "+provider).toLocal8Bit());
+	else {
+	    QCA::SCRYPT kdf(provider);
+	    kdf.setParameters(cost, blockSize, parallelism);
+	    QCA::SymmetricKey key = kdf.makeKey(QCA::SecureArray(secret.toLatin1()),
+						QCA::InitializationVector(salt.toLatin1()),
+						64);
+	    QCOMPARE( QCA::arrayToHex(key.toByteArray()), output );
+
+	    // again, with the work memory kept from the first key
+	    key = kdf.makeKey(QCA::SecureArray(secret.toLatin1()),
+			      QCA::InitializationVector(salt.toLatin1()),
+			      64);
+	    QCOMPARE( QCA::arrayToHex(key.toByteArray()), output );
+
+	    // the cost has to be a power of two
+	    kdf.setParameters(cost + 1, blockSize, parallelism);
+	    QVERIFY( kdf.makeKey(QCA::SecureArray(secret.toLatin1()),
+				 QCA::InitializationVector(salt.toLatin1()),
+				 64).isEmpty() );
+	}
+    }
+}
+
+void KDFUnitTest::scryptBenchmark_data()
+{
+    QTest::addColumn<unsigned int>("cost");
+    QTest::addColumn<unsigned int>("blockSize");
+    QTest::addColumn<unsigned int>("parallelism");
+
+    QTest::newRow("interactive, 16MiB") << static_cast<unsigned int>(16384)
+					<< static_cast<unsigned int>(8)
+					<< static_cast<unsigned int>(1);
+    QTest::newRow("4 lanes, 64MiB") << static_cast<unsigned int>(16384)
+				    << static_cast<unsigned int>(8)
+				    << static_cast<unsigned int>(4);
+    QTest::newRow("sensitive, 64MiB") << static_cast<unsigned int>(65536)
+				      << static_cast<unsigned int>(8)
+				      << static_cast<unsigned int>(1);
+}
+
+void KDFUnitTest::scryptBenchmark()
+{
+    if(!benchmarksEnabled())
+    {
+#if QT_VERSION >= 0x050000
+	QSKIP("set QCA_BENCHMARKS to run the benchmarks");
+#else
+	QSKIP("set QCA_BENCHMARKS to run the benchmarks", SkipAll);
+#endif
+    }
+
+    if(!QCA::isSupported("scrypt", "default"))
+	QWARN("scrypt not supported for default");
+    else {
+	QFETCH(unsigned int, cost);
+	QFETCH(unsigned int, blockSize);
+	QFETCH(unsigned int, parallelism);
+
+	QCA::SCRYPT kdf("default");
+	kdf.setParameters(cost, blockSize, parallelism);
+	QCA::SecureArray password("password");
+	QCA::InitializationVector salt(QByteArray("NaCl"));
+	QBENCHMARK {
+	    QCOMPARE( kdf.makeKey(password, salt, 32).size(), 32 );
+	}
+    }
+}
+
+void KDFUnitTest::argon2idTests_data()
+{
+    QTest::addColumn<unsigned int>("memoryCost");
+    QTest::addColumn<unsigned int>("timeCost");
+    QTest::addColumn<unsigned int>("lanes");
+    QTest::addColumn<unsigned int>("outputLength");
+    QTest::addColumn<QString>("output");
+
+    // The first is from the test suite of the reference implementation
+    QTest::newRow("64MiB") << static_cast<unsigned int>(65536)
+			   << static_cast<unsigned int>(2)
+			   << static_cast<unsigned int>(1)
+			   << static_cast<unsigned int>(32)
+			   << QString("09316115d5cf24ed5a15a31a3ba326e5cf32edc24702987c02b6566f61913cf7");
+
+    QTest::newRow("4 lanes") << static_cast<unsigned int>(256)
+			     << static_cast<unsigned int>(2)
+			     << static_cast<unsigned int>(4)
+			     << static_cast<unsigned int>(32)
+			     << QString("be29d1c497593959cd701e5ceefe8a6fbda26d9b3892c08cff261e0a94bab2b1");
+
+    QTest::newRow("long key") << static_cast<unsigned int>(1024)
+			      << static_cast<unsigned int>(2)
+			      << static_cast<unsigned int>(2)
+			      << static_cast<unsigned int>(100)
+			      << QString("e8c75dafb5a26e2228bebd1fb2b6102b0008a7e1ddde097d2fd869720b0b4e357d1441c39872a67570ab0379182a01641ca7fc51b0b9f92e64dfea1eb094ea3dffa3c9970bdb0b68459af3343d8de428986ea7313a4a6368c1cf6283b81d409c7b5967ea");
+}
+
+void KDFUnitTest::argon2idTests()
+{
+    QStringList providersToTest;
+    providersToTest.append("default");
+
+    QFETCH(unsigned int, memoryCost);
+    QFETCH(unsigned int, timeCost);
+    QFETCH(unsigned int, lanes);
+    QFETCH(unsigned int, outputLength);
+    QFETCH(QString, output);
+
+    foreach(QString provider, providersToTest) {
+	if(!QCA::isSupported("argon2id", provider))
+	    QWARN(QString("Argon2id not supported for "+provider).toLocal8Bit());
+	else {
+	    QCA::SecureArray password("password");
+	    QCA::InitializationVector salt(QByteArray("somesalt"));
+
+	    QCA::Argon2id kdf(provider);
+	    kdf.setParameters(memoryCost, timeCost, lanes);
+	    QCA::SymmetricKey key = kdf.makeKey(password, salt, outputLength);
+	    QCOMPARE( QCA::arrayToHex(key.toByteArray()), output );
+
+	    // a copy gets work memory of its own
+	    QCA::Argon2id copy = kdf;
+	    QCOMPARE( QCA::arrayToHex(copy.makeKey(password, salt, outputLength).toByteArray()), output );
+
+	    // too little memory for the lanes
+	    kdf.setParameters(8 * lanes - 1, timeCost, lanes);
+	    QVERIFY( kdf.makeKey(password, salt, outputLength).isEmpty() );
+	}
+    }
+}
+
+void KDFUnitTest::argon2idBenchmark_data()
+{
+    QTest::addColumn<unsigned int>("memoryCost");
+    QTest::addColumn<unsigned int>("timeCost");
+    QTest::addColumn<unsigned int>("lanes");
+
+    QTest::newRow("19MiB, 2 passes, 1 lane") << static_cast<unsigned int>(19456)
+					     << static_cast<unsigned int>(2)
+					     << static_cast<unsigned int>(1);
+    QTest::newRow("64MiB, 3 passes, 4 lanes") << static_cast<unsigned int>(65536)
+					      << static_cast<unsigned int>(3)
+					      << static_cast<unsigned int>(4);
+    QTest::newRow("256MiB, 1 pass, 4 lanes") << static_cast<unsigned int>(262144)
+					     << static_cast<unsigned int>(1)
+					     << static_cast<unsigned int>(4);
+}
+
+void KDFUnitTest::argon2idBenchmark()
+{
+    if(!benchmarksEnabled())
+    {
+#if QT_VERSION >= 0x050000
+	QSKIP("set QCA_BENCHMARKS to run the benchmarks");
+#else
+	QSKIP("set QCA_BENCHMARKS to run the benchmarks", SkipAll);
+#endif
+    }
+
+    if(!QCA::isSupported("argon2id", "default"))
+	QWARN("Argon2id not supported for default");
+    else {
+	QFETCH(unsigned int, memoryCost);
+	QFETCH(unsigned int, timeCost);
+	QFETCH(unsigned int, lanes);
+
+	QCA::Argon2id kdf("default");
+	kdf.setParameters(memoryCost, timeCost, lanes);
+	QCA::SecureArray password("password");
+	QCA::InitializationVector salt(QByteArray("somesalt"));
+	QBENCHMARK {
+	    QCOMPARE( kdf.makeKey(password, salt, 32).size(), 32 );
+	}
+    }
+}
+
+void KDFUnitTest::hkdfTests_data()
+{
+    QTest::addColumn<QString>("algorithm");
+    QTest::addColumn<QString>("secret");  // input keying material
+    QTest::addColumn<QString>("salt");
+    QTest::addColumn<QString>("info");
+    QTest::addColumn<QString>("prk");     // the pseudorandom key
+    QTest::addColumn<QString>("output");  // the key you get back
+
+    // These are from RFC5869, Appendix A
+    QTest::newRow("1") << QString("sha256")
+		       << QString("0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b")
+		       << QString("000102030405060708090a0b0c")
+		       << QString("f0f1f2f3f4f5f6f7f8f9")
+		       << QString("077709362c2e32df0ddc3f0dc47bba6390b6c73bb50f9c3122ec844ad7c2b3e5")
+		       << QString("3cb25f25faacd57a90434f64d0362f2a2d2d0a90cf1a5a4c5db02d56ecc4c5bf34007208d5b887185865");
+
+    QTest::newRow("4") << QString("sha1")
+		       << QString("0b0b0b0b0b0b0b0b0b0b0b")
+		       << QString("000102030405060708090a0b0c")
+		       << QString("f0f1f2f3f4f5f6f7f8f9")
+		       << QString("9b6c18c432a7bf8f0e71c8eb88f4b30baa2ba243")
+		       << QString("085a01ea1b10f36933068b56efa5ad81a4f14b822f5b091568a9cdd4f155fda2c22e422478d305f3f896");
+
+    QTest::newRow("7") << QString("sha1")
+		       << QString("0c0c0c0c0c0c0c0c0c0c0c0c0c0c0c0c0c0c0c0c0c0c")
+		       << QString()
+		       << QString()
+		       << QString("2adccada18779e7c2077ad2eb19d3f3e731385dd")
+		       << QString("2c91117204d745f3500d636a62f64f0ab3bae548aa53d423b0d1f27ebba6f5e5673a081d70cce7acfc48");
+}
+
+void KDFUnitTest::hkdfTests()
+{
+    QStringList providersToTest;
+    providersToTest.append("qca-ossl");
+    providersToTest.append("qca-gcrypt");
+    providersToTest.append("qca-botan");
+    providersToTest.append("default");
+
+    QFETCH(QString, algorithm);
+    QFETCH(QString, secret);
+    QFETCH(QString, salt);
+    QFETCH(QString, info);
+    QFETCH(QString, prk);
+    QFETCH(QString, output);
+
+    QString type = "hkdf(" + algorithm + ')';
+    foreach(QString provider, providersToTest) {
+	if(!QCA::isSupported(QStringList(type), provider))
+	    QWARN(QString("HKDF with "+algorithm+" not supported for "+provider).toLocal8Bit());
+	else {
+	    QCA::SecureArray ikm = QCA::hexToArray( secret );
+	    QCA::InitializationVector iv( QCA::hexToArray( salt ) );
+	    QCA::InitializationVector context( QCA::hexToArray( info ) );
+	    unsigned int length = output.length() / 2;
+
+	    QCA::HKDF hkdf(algorithm, provider);
+	    QCOMPARE( QCA::arrayToHex( hkdf.makeKey( ikm, iv, context, length ).toByteArray() ), output );
+
+	    // the pseudorandom key can be expanded many times
+	    QCOMPARE( QCA::arrayToHex( hkdf.extract( ikm, iv ).toByteArray() ), prk );
+	    QCOMPARE( QCA::arrayToHex( hkdf.expand( context, length ).toByteArray() ), output );
+	    QCOMPARE( QCA::arrayToHex( hkdf.expand( context, 16 ).toByteArray() ), output.left(32) );
+
+	    // and it is copied along
+	    QCA::HKDF copy(hkdf);
+	    QCOMPARE( QCA::arrayToHex( copy.expand( context, length ).toByteArray() ), output );
+
+	    QCA::HKDF fresh(algorithm, provider);
+	    fresh.setPrk( QCA::SymmetricKey( QCA::hexToArray( prk ) ) );
+	    QCOMPARE( QCA::arrayToHex( fresh.expand( context, length ).toByteArray() ), output );
+
+	    // at most 255 blocks
+	    QVERIFY( hkdf.expand( context, 255 * prk.length() / 2 + 1 ).isEmpty() );
+	}
+    }
+}
+
 QTEST_MAIN(KDFUnitTest)
 
 #include "kdfunittest.moc"
@@ -44,6 +44,7 @@ private slots:
     void HMACSHA384();
     void HMACSHA512();
     void HMACRMD160();
+    void HMACReuseKey();
 private:
     QCA::Initializer* m_init;
 };
@@ -612,6 +613,59 @@ void MACUnitTest::HMACRMD160()
     }
 }
 
+void MACUnitTest::HMACReuseKey()
+{
+    QStringList providersToTest;
+    providersToTest.append("qca-ossl");
+    providersToTest.append("qca-gcrypt");
+    providersToTest.append("qca-botan");
+    providersToTest.append("qca-nss");
+
+    foreach(const QString provider, providersToTest) {
+        if( !QCA::isSupported( "hmac(sha256)", provider ) )
+            QWARN( QString( "HMAC(SHA256) not supported for "+provider).toLocal8Bit() );
+        else {
+	    QCA::MessageAuthenticationCode hmac( "hmac(sha256)", QCA::SymmetricKey( QCA::SecureArray( "Jefe" ) ), provider );
+	    QCA::SecureArray data1( "what do ya want for nothing?" );
+	    QCA::SecureArray data2( 200, 'x' );
+
+	    // many messages with the same key
+	    for ( int n = 0; n < 3; ++n ) {
+		QCOMPARE( QCA::arrayToHex( hmac.mac( data1 ).toByteArray() ),
+			  QString( "5bdcc146bf60754e6a042426089575c75a003f089d2739839dec58b964ec3843" ) );
+		QCOMPARE( QCA::arrayToHex( hmac.mac( data2 ).toByteArray() ),
+			  QString( "0d92e5bf056d70ae8d2062c69d16e7ece0f1c551fb73a00282c04466cfb61640" ) );
+		QCOMPARE( QCA::arrayToHex( hmac.mac( QCA::SecureArray() ).toByteArray() ),
+			  QString( "923598ca6d64af2a5dba79dcd021a8a0fe5c5f557519adaaf0ad532d4506dd30" ) );
+	    }
+
+	    // clear part way through a message
+	    hmac.clear();
+	    hmac.update( data2 );
+	    hmac.clear();
+	    hmac.update( data1 );
+	    QCOMPARE( QCA::arrayToHex( hmac.final().toByteArray() ),
+		      QString( "5bdcc146bf60754e6a042426089575c75a003f089d2739839dec58b964ec3843" ) );
+
+	    // a copy keeps the key, and the message so far.  Botan can
+	    // only copy the key.
+	    if ( provider == "qca-botan" )
+		continue;
+	    hmac.clear();
+	    hmac.update( QCA::SecureArray( "what do ya " ) );
+	    QCA::MessageAuthenticationCode copy = hmac;
+	    copy.update( QCA::SecureArray( "want for nothing?" ) );
+	    QCOMPARE( QCA::arrayToHex( copy.final().toByteArray() ),
+		      QString( "5bdcc146bf60754e6a042426089575c75a003f089d2739839dec58b964ec3843" ) );
+	    QCOMPARE( QCA::arrayToHex( copy.mac( data2 ).toByteArray() ),
+		      QString( "0d92e5bf056d70ae8d2062c69d16e7ece0f1c551fb73a00282c04466cfb61640" ) );
+	    hmac.update( QCA::SecureArray( "want for nothing?" ) );
+	    QCOMPARE( QCA::arrayToHex( hmac.final().toByteArray() ),
+		      QString( "5bdcc146bf60754e6a042426089575c75a003f089d2739839dec58b964ec3843" ) );
+	}
+    }
+}
+
 QTEST_MAIN(MACUnitTest)
 
 #include "macunittest.moc"
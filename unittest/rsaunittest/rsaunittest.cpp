@@ -39,6 +39,9 @@ private Q_SLOTS:
     void cleanupTestCase();
     void testrsa();
     void testAsymmetricEncryption();
+    void testBatchVerify();
+    void testSignerVerifier();
+    void testAsync();
 
 private:
     QCA::Initializer* m_init;
@@ -194,6 +197,140 @@ void RSAUnitTest::testAsymmetricEncryption()
 	// ---
 }
 
+void RSAUnitTest::testBatchVerify()
+{
+	if(!QCA::isSupported("pkey", "qca-ossl") ||
+	   !QCA::PKey::supportedTypes("qca-ossl").contains(QCA::PKey::RSA)) {
+	    QWARN(QString("RSA not supported").toLocal8Bit());
+#if QT_VERSION >= 0x050000
+	    QSKIP("RSA not supported. skipping");
+#else
+	    QSKIP("RSA not supported. skipping",SkipAll);
+#endif
+	}
+	QCA::PrivateKey privKey1 = QCA::KeyGenerator().createRSA(512, 65537, "qca-ossl");
+	QCA::PrivateKey privKey2 = QCA::KeyGenerator().createRSA(512, 65537, "qca-ossl");
+	QCA::PublicKey pubKey1 = privKey1.toPublicKey();
+	QCA::PublicKey pubKey2 = privKey2.toPublicKey();
+
+	QList<QCA::VerifyBatchItem> batch;
+	QList<bool> expected;
+	for(int n = 0; n < 40; ++n) {
+	    QByteArray message = QByteArray("message number ") + QByteArray::number(n);
+	    QCA::PrivateKey &signer = (n % 3 == 0) ? privKey2 : privKey1;
+	    QCA::PublicKey &verifier = (n % 3 == 0) ? pubKey2 : pubKey1;
+	    QByteArray sig = signer.signMessage(message, QCA::EMSA3_SHA1);
+	    QVERIFY( !sig.isEmpty() );
+
+	    bool good = true;
+	    if(n % 5 == 0) {
+		// wrong message
+		message += 'x';
+		good = false;
+	    }
+	    else if(n % 7 == 0) {
+		// wrong key
+		batch += QCA::VerifyBatchItem((n % 3 == 0) ? pubKey1 : pubKey2, message, sig, QCA::EMSA3_SHA1);
+		expected += false;
+		continue;
+	    }
+	    batch += QCA::VerifyBatchItem(verifier, message, sig, QCA::EMSA3_SHA1);
+	    expected += good;
+	}
+
+	QCOMPARE( QCA::verifyBatch(batch), expected );
+	QCOMPARE( QCA::verifyBatch(batch, 1), expected );
+	QCOMPARE( QCA::verifyBatch(batch, 64), expected );
+	QVERIFY( QCA::verifyBatch(QList<QCA::VerifyBatchItem>()).isEmpty() );
+
+	// the keys given to the batch must still be usable afterwards
+	QByteArray sig = privKey1.signMessage("after", QCA::EMSA3_SHA1);
+	QVERIFY( pubKey1.verifyMessage(QByteArray("after"), sig, QCA::EMSA3_SHA1) );
+}
+
+void RSAUnitTest::testSignerVerifier()
+{
+	if(!QCA::isSupported("pkey", "qca-ossl") ||
+	   !QCA::PKey::supportedTypes("qca-ossl").contains(QCA::PKey::RSA)) {
+	    QWARN(QString("RSA not supported").toLocal8Bit());
+#if QT_VERSION >= 0x050000
+	    QSKIP("RSA not supported. skipping");
+#else
+	    QSKIP("RSA not supported. skipping",SkipAll);
+#endif
+	}
+	QCA::PrivateKey privKey = QCA::KeyGenerator().createRSA(512, 65537, "qca-ossl");
+	QCA::PublicKey pubKey = privKey.toPublicKey();
+
+	QCA::Signer signer(privKey, QCA::EMSA3_SHA1);
+	QCOMPARE( signer.isNull(), false );
+	QCA::Verifier verifier(pubKey, QCA::EMSA3_SHA1);
+	QCOMPARE( verifier.isNull(), false );
+
+	for(int n = 0; n < 20; ++n) {
+	    QByteArray message = QByteArray("message number ") + QByteArray::number(n);
+
+	    // PKCS#1 v1.5 signatures are deterministic
+	    QByteArray sig = signer.signMessage(message);
+	    QCOMPARE( sig, privKey.signMessage(message, QCA::EMSA3_SHA1) );
+	    QVERIFY( verifier.verifyMessage(message, sig) );
+	    QVERIFY( !verifier.verifyMessage(message + "x", sig) );
+
+	    // incremental use
+	    signer.update(message.left(5));
+	    signer.update(message.mid(5));
+	    QCOMPARE( signer.signature(), sig );
+	    verifier.update(message.left(3));
+	    verifier.update(message.mid(3));
+	    QVERIFY( verifier.validSignature(sig) );
+	}
+
+	// copies are independent
+	QCA::Signer copy = signer;
+	signer.update("abc");
+	QCOMPARE( copy.signMessage("def"), privKey.signMessage(QByteArray("def"), QCA::EMSA3_SHA1) );
+	QCOMPARE( signer.signature(), privKey.signMessage(QByteArray("abc"), QCA::EMSA3_SHA1) );
+
+	QCA::Signer nullSigner(QCA::PrivateKey(), QCA::EMSA3_SHA1);
+	QCOMPARE( nullSigner.isNull(), true );
+	QVERIFY( nullSigner.signMessage("abc").isEmpty() );
+	QCA::Verifier nullVerifier(QCA::PublicKey(), QCA::EMSA3_SHA1);
+	QCOMPARE( nullVerifier.isNull(), true );
+	QCOMPARE( nullVerifier.verifyMessage(QByteArray("abc"), QByteArray("abc")), false );
+}
+
+void RSAUnitTest::testAsync()
+{
+	if(!QCA::isSupported("pkey", "qca-ossl") ||
+	   !QCA::PKey::supportedTypes("qca-ossl").contains(QCA::PKey::RSA)) {
+	    QWARN(QString("RSA not supported").toLocal8Bit());
+#if QT_VERSION >= 0x050000
+	    QSKIP("RSA not supported. skipping");
+#else
+	    QSKIP("RSA not supported. skipping",SkipAll);
+#endif
+	}
+	QFuture<QCA::PrivateKey> keyFuture = QCA::createRSAAsync(512, 65537, "qca-ossl");
+	QCA::PrivateKey privKey = keyFuture.result();
+	QCOMPARE( privKey.isNull(), false );
+	QCOMPARE( privKey.isRSA(), true );
+	QCOMPARE( privKey.bitSize(), 512 );
+	QCA::PublicKey pubKey = privKey.toPublicKey();
+
+	QList< QFuture<QByteArray> > sigs;
+	for(int n = 0; n < 10; ++n)
+	    sigs += QCA::signMessageAsync(privKey, QByteArray::number(n), QCA::EMSA3_SHA1);
+
+	QList< QFuture<bool> > checks;
+	for(int n = 0; n < 10; ++n) {
+	    QCOMPARE( sigs[n].result(), privKey.signMessage(QByteArray::number(n), QCA::EMSA3_SHA1) );
+	    checks += QCA::verifyMessageAsync(pubKey, QByteArray::number(n), sigs[n].result(), QCA::EMSA3_SHA1);
+	    checks += QCA::verifyMessageAsync(pubKey, QByteArray::number(n + 1), sigs[n].result(), QCA::EMSA3_SHA1);
+	}
+	for(int n = 0; n < checks.count(); ++n)
+	    QCOMPARE( checks[n].result(), n % 2 == 0 );
+}
+
 QTEST_MAIN(RSAUnitTest)
 
 #include "rsaunittest.moc"
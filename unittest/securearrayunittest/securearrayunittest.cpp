@@ -38,12 +38,52 @@ private slots:
     void initTestCase();
     void cleanupTestCase();
     void testAll();
+    void resizeGrowShrink();
+    void reserveAndSqueeze();
+    void views();
+    void statistics();
+    void threads();
+    void threadsBenchmark();
 
 private:
     QCA::Initializer* m_init;
 };
 
 
+// allocates arrays, keeping every other one for another thread to free
+class ChurnThread : public QThread
+{
+public:
+    int count;
+    QList<QCA::SecureArray> kept;
+    bool ok;
+
+    ChurnThread(int _count) : count(_count), ok(true)
+    {}
+
+protected:
+    virtual void run()
+    {
+	for(int n = 0; n < count; ++n)
+	{
+	    QCA::SecureArray a((n * 37) % 600 + 1);
+	    for(int i = 0; i < a.size(); ++i)
+	    {
+		if(a[i] != 0)
+		    ok = false;
+	    }
+	    a.fill((char)n);
+	    if(n % 2)
+		kept += a;
+	}
+	for(int n = 0; n < kept.count(); ++n)
+	{
+	    if(kept[n][0] != (char)(n * 2 + 1))
+		ok = false;
+	}
+    }
+};
+
 void SecureArrayUnitTest::initTestCase()
 {
     m_init = new QCA::Initializer;
@@ -145,6 +185,213 @@ void SecureArrayUnitTest::testAll()
     QVERIFY( (secureArray[0] == (char)0x63) );
 }
 
+void SecureArrayUnitTest::resizeGrowShrink()
+{
+    // growing and shrinking keep the contents, and zero the rest
+    QCA::SecureArray a(16, 'a');
+    QCA::SecureArray copy = a;
+    a.resize(100);
+    QCOMPARE( a.size(), 100 );
+    QCOMPARE( a.toByteArray().left(16), QByteArray(16, 'a') );
+    QCOMPARE( a.toByteArray().mid(16), QByteArray(84, 0) );
+    QCOMPARE( a.data()[100], (char)0 );
+
+    a.fill('b');
+    a.resize(20);
+    QCOMPARE( a.toByteArray(), QByteArray(20, 'b') );
+    QCOMPARE( a.data()[20], (char)0 );
+    a.resize(64);
+    QCOMPARE( a.toByteArray().mid(20), QByteArray(44, 0) );
+
+    // the shared copy was detached before any of that
+    QCOMPARE( copy.toByteArray(), QByteArray(16, 'a') );
+
+    QCA::MemoryRegion insecure(QByteArray(8, 'c'));
+    QCA::SecureArray converted(insecure);
+    QCOMPARE( converted.toByteArray(), QByteArray(8, 'c') );
+    QCOMPARE( converted.constData()[8], (char)0 );
+}
+
+void SecureArrayUnitTest::reserveAndSqueeze()
+{
+    QCA::SecureArray a;
+    QVERIFY( a.reserve(1000) );
+    QCOMPARE( a.size(), 0 );
+    QVERIFY( a.capacity() >= 1000 );
+    const char *p = a.constData();
+
+    QCA::SecureArray chunk(10, 'x');
+    for(int n = 0; n < 100; ++n)
+	a += chunk;
+    QCOMPARE( a.size(), 1000 );
+    QCOMPARE( a.constData(), p );
+    QCOMPARE( a.toByteArray(), QByteArray(1000, 'x') );
+
+    // shrinking keeps the room, and clears what was cut off
+    a.resize(10);
+    QVERIFY( a.capacity() >= 1000 );
+    a.resize(20);
+    QCOMPARE( a.toByteArray(), QByteArray(10, 'x') + QByteArray(10, 0) );
+
+    a.squeeze();
+    QCOMPARE( a.capacity(), 64 ); // small arrays keep their data inline
+    QCOMPARE( a.toByteArray(), QByteArray(10, 'x') + QByteArray(10, 0) );
+
+    // appending in a loop grows geometrically
+    QCA::SecureArray b;
+    int reallocs = 0;
+    int capacity = b.capacity();
+    for(int n = 0; n < 10000; ++n)
+    {
+	b += chunk;
+	if(b.capacity() != capacity)
+	{
+	    capacity = b.capacity();
+	    ++reallocs;
+	}
+    }
+    QCOMPARE( b.size(), 100000 );
+    QVERIFY( reallocs < 30 );
+    b.squeeze();
+    QCOMPARE( b.capacity(), 100000 );
+    QCOMPARE( b.toByteArray(), QByteArray(100000, 'x') );
+}
+
+void SecureArrayUnitTest::views()
+{
+    QCA::SecureArray a("0123456789");
+    QCA::MemoryRegion part = a.mid(2, 5);
+    QCOMPARE( part.size(), 5 );
+    QVERIFY( part.isSecure() );
+    QVERIFY( part.isView() );
+    QVERIFY( !a.isView() );
+    QCOMPARE( part.toByteArray(), QByteArray("23456") );
+    QCOMPARE( part.constData(), a.constData() + 2 );
+    QCOMPARE( a.mid(8).toByteArray(), QByteArray("89") );
+    QCOMPARE( a.mid(20).size(), 0 );
+
+    // changing either side copies first
+    QCA::SecureArray changed = part;
+    changed[0] = 'x';
+    QCOMPARE( changed.toByteArray(), QByteArray("x3456") );
+    QCOMPARE( changed.constData()[5], (char)0 );
+    QVERIFY( !changed.isView() );
+    QCOMPARE( part.toByteArray(), QByteArray("23456") );
+    a[2] = 'y';
+    QCOMPARE( part.toByteArray(), QByteArray("23456") );
+    QCOMPARE( a.toByteArray(), QByteArray("01y3456789") );
+
+    // the part keeps its memory alive
+    QCA::MemoryRegion tail;
+    {
+	QCA::SecureArray b("abcdef");
+	tail = QCA::MemoryView(b, 3);
+    }
+    QCOMPARE( tail.toByteArray(), QByteArray("def") );
+
+    QByteArray raw("the quick brown fox");
+    QCA::MemoryView view(raw.constData() + 4, 5);
+    QCOMPARE( view.isSecure(), false );
+    QVERIFY( view.isView() );
+    QCOMPARE( view.constData(), raw.constData() + 4 );
+    QCOMPARE( view.toByteArray(), QByteArray("quick") );
+    QCA::SecureArray secured = view;
+    QCOMPARE( secured.toByteArray(), QByteArray("quick") );
+    QVERIFY( secured.constData() != view.constData() );
+    QVERIFY( !secured.isView() );
+}
+
+static QCA::SecureMemoryStatistics findStatistics(const QString &name)
+{
+    foreach(const QCA::SecureMemoryStatistics &s, QCA::secureMemoryStatistics())
+    {
+	if(s.name() == name)
+	    return s;
+    }
+    return QCA::SecureMemoryStatistics();
+}
+
+void SecureArrayUnitTest::statistics()
+{
+    QList<QCA::SecureMemoryStatistics> list = QCA::secureMemoryStatistics();
+    QCOMPARE( list.count(), 2 );
+    QCOMPARE( list[1].name(), QString("arena") );
+
+    QCA::SecureMemoryStatistics before = findStatistics("arena");
+    QCA::SecureArray big(200);
+    QCA::SecureMemoryStatistics after = findStatistics("arena");
+    QVERIFY( after.inUse() >= before.inUse() + 200 );
+    QVERIFY( after.peakInUse() >= after.inUse() );
+    QCOMPARE( after.allocations(), before.allocations() + 1 );
+    QVERIFY( after.poolSize() >= after.inUse() );
+
+    // a small array and its data share a single chunk
+    before = after;
+    QCA::SecureArray small(16);
+    after = findStatistics("arena");
+    QCOMPARE( after.allocations(), before.allocations() + 1 );
+    QCOMPARE( small.capacity(), 64 );
+
+    if(!QCA::haveSecureMemory())
+    {
+#if QT_VERSION >= 0x050000
+	QSKIP("No secure memory pool to grow");
+#else
+	QSKIP("No secure memory pool to grow", SkipSingle);
+#endif
+    }
+
+    QString pool = list[0].name();
+    before = findStatistics(pool);
+    QVERIFY( before.poolSize() > 0 );
+    QVERIFY( before.largestFreeRun() <= before.poolSize() );
+    QVERIFY( QCA::growSecureMemory(256) );
+    after = findStatistics(pool);
+    QVERIFY( after.poolSize() >= before.poolSize() + 256 * 1024 );
+    QVERIFY( after.largestFreeRun() >= 256 * 1024 );
+    QVERIFY( after.freeRuns() >= 1 );
+}
+
+void SecureArrayUnitTest::threads()
+{
+    QList<ChurnThread*> threads;
+    for(int n = 0; n < 4; ++n)
+	threads += new ChurnThread(2000);
+    for(int n = 0; n < threads.count(); ++n)
+	threads[n]->start();
+    for(int n = 0; n < threads.count(); ++n)
+	QVERIFY( threads[n]->wait() );
+
+    // the arrays outlive their threads, and are freed from this one
+    for(int n = 0; n < threads.count(); ++n)
+    {
+	QVERIFY( threads[n]->ok );
+	QCOMPARE( threads[n]->kept.count(), 1000 );
+	QCOMPARE( threads[n]->kept[999][0], (char)1999 );
+	delete threads[n];
+    }
+
+    // memory handed back from exited threads is reusable
+    QCA::SecureArray a(100);
+    QCOMPARE( a[99], (char)0 );
+}
+
+void SecureArrayUnitTest::threadsBenchmark()
+{
+    QBENCHMARK {
+	QList<ChurnThread*> threads;
+	for(int n = 0; n < 4; ++n)
+	    threads += new ChurnThread(20000);
+	for(int n = 0; n < threads.count(); ++n)
+	    threads[n]->start();
+	for(int n = 0; n < threads.count(); ++n)
+	{
+	    threads[n]->wait();
+	    delete threads[n];
+	}
+    }
+}
+
 QTEST_MAIN(SecureArrayUnitTest)
 
 #include "securearrayunittest.moc"
@@ -0,0 +1,226 @@
+/**
+ * Copyright (C)  2026  Forkworks
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <QtCrypto>
+#include <QtTest/QtTest>
+
+#ifdef QT_STATICPLUGIN
+#include "import_plugins.h"
+#endif
+
+class ThreadPoolUnitTest : public QObject
+{
+  Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void runMany();
+    void priorities();
+    void job();
+    void jobRunsInlineWhenQueued();
+private:
+    QCA::Initializer* m_init;
+    int m_maxThreads;
+};
+
+class CountingRunnable : public QRunnable
+{
+public:
+    QMutex *mutex;
+    int *counter;
+
+    CountingRunnable(QMutex *m, int *c) : mutex(m), counter(c)
+    {}
+
+    virtual void run()
+    {
+	QMutexLocker locker(mutex);
+	++(*counter);
+    }
+};
+
+// blocks a worker until released
+class GateRunnable : public QRunnable
+{
+public:
+    QSemaphore started, release;
+
+    virtual void run()
+    {
+	started.release();
+	release.acquire();
+    }
+};
+
+class OrderRunnable : public QRunnable
+{
+public:
+    QMutex *mutex;
+    QStringList *order;
+    QString name;
+
+    OrderRunnable(QMutex *m, QStringList *o, const QString &n) : mutex(m), order(o), name(n)
+    {}
+
+    virtual void run()
+    {
+	QMutexLocker locker(mutex);
+	order->append(name);
+    }
+};
+
+class RecordingJob : public QCA::ThreadPoolJob
+{
+public:
+    QThread *ranIn;
+
+    RecordingJob() : ranIn(0)
+    {}
+
+    ~RecordingJob()
+    {
+	wait();
+    }
+
+protected:
+    virtual void run()
+    {
+	ranIn = QThread::currentThread();
+    }
+};
+
+void ThreadPoolUnitTest::initTestCase()
+{
+    m_init = new QCA::Initializer;
+    m_maxThreads = QCA::ThreadPool::instance()->maxThreadCount();
+}
+
+void ThreadPoolUnitTest::cleanupTestCase()
+{
+    QCA::ThreadPool::instance()->setMaxThreadCount(m_maxThreads);
+    delete m_init;
+}
+
+void ThreadPoolUnitTest::runMany()
+{
+    QCA::ThreadPool *pool = QCA::ThreadPool::instance();
+    QVERIFY( pool->maxThreadCount() >= 2 );
+    QVERIFY( pool->waitForDone() );
+    pool->resetStatistics();
+
+    QMutex mutex;
+    int counter = 0;
+    for(int n = 0; n < 200; ++n)
+	pool->start(new CountingRunnable(&mutex, &counter));
+    QVERIFY( pool->waitForDone() );
+
+    QCOMPARE( counter, 200 );
+    QCOMPARE( pool->completedCount(), qint64(200) );
+    QCOMPARE( pool->queueDepth(), 0 );
+    QCOMPARE( pool->activeThreadCount(), 0 );
+    QVERIFY( pool->threadCount() <= pool->maxThreadCount() );
+}
+
+void ThreadPoolUnitTest::priorities()
+{
+    QCA::ThreadPool *pool = QCA::ThreadPool::instance();
+    QVERIFY( pool->waitForDone() );
+    pool->setMaxThreadCount(1);
+    pool->resetStatistics();
+
+    GateRunnable gate;
+    gate.setAutoDelete(false);
+    pool->start(&gate);
+    gate.started.acquire();
+
+    QMutex mutex;
+    QStringList order;
+    pool->start(new OrderRunnable(&mutex, &order, "low"), QCA::ThreadPool::LowPriority);
+    pool->start(new OrderRunnable(&mutex, &order, "normal"), QCA::ThreadPool::NormalPriority);
+    pool->start(new OrderRunnable(&mutex, &order, "high"), QCA::ThreadPool::HighPriority);
+
+    QCOMPARE( pool->queueDepth(), 3 );
+    QCOMPARE( pool->queueDepth(QCA::ThreadPool::LowPriority), 1 );
+    QCOMPARE( pool->queueDepth(QCA::ThreadPool::HighPriority), 1 );
+    QCOMPARE( pool->activeThreadCount(), 1 );
+    QVERIFY( pool->peakQueueDepth() >= 3 );
+
+    gate.release.release();
+    QVERIFY( pool->waitForDone() );
+    QCOMPARE( order, QStringList() << "high" << "normal" << "low" );
+
+    pool->setMaxThreadCount(m_maxThreads);
+}
+
+void ThreadPoolUnitTest::job()
+{
+    RecordingJob job;
+    QSignalSpy spy(&job, SIGNAL(finished()));
+    QCOMPARE( job.isFinished(), false );
+    job.start();
+    QVERIFY( job.wait() );
+    QCOMPARE( job.isFinished(), true );
+    QCOMPARE( job.isRunning(), false );
+    QCOMPARE( spy.count(), 1 );
+    QVERIFY( job.ranIn != 0 );
+
+    // jobs may be started again
+    job.start(QCA::ThreadPool::HighPriority);
+    QVERIFY( job.wait() );
+    QCOMPARE( spy.count(), 2 );
+}
+
+void ThreadPoolUnitTest::jobRunsInlineWhenQueued()
+{
+    QCA::ThreadPool *pool = QCA::ThreadPool::instance();
+    QVERIFY( pool->waitForDone() );
+    pool->setMaxThreadCount(1);
+
+    GateRunnable gate;
+    gate.setAutoDelete(false);
+    pool->start(&gate);
+    gate.started.acquire();
+
+    // the only worker is busy, so wait() has to do the work itself.
+    //   a wait with a timeout leaves it queued
+    RecordingJob job;
+    job.start();
+    QCOMPARE( job.isRunning(), true );
+    QCOMPARE( job.wait(50), false );
+    QVERIFY( job.ranIn == 0 );
+    QCOMPARE( pool->queueDepth(), 1 );
+    QVERIFY( job.wait() );
+    QCOMPARE( job.ranIn, QThread::currentThread() );
+    QCOMPARE( pool->queueDepth(), 0 );
+
+    gate.release.release();
+    QVERIFY( pool->waitForDone() );
+    pool->setMaxThreadCount(m_maxThreads);
+}
+
+QTEST_MAIN(ThreadPoolUnitTest)
+
+#include "threadpoolunittest.moc"